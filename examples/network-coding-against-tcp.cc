@@ -52,7 +52,8 @@ struct SimulationResults
  * \brief Run Network Coding over UDP simulation
  */
 SimulationResults RunNetworkCodingSimulation(uint32_t packetSize, uint32_t numPackets, 
-                                            uint16_t generationSize, double lossRate)
+                                            uint16_t generationSize, double lossRate,
+                                            bool bbr)
 {
   NS_LOG_INFO ("=== Running Network Coding over UDP Simulation ===");
   
@@ -98,6 +99,12 @@ SimulationResults RunNetworkCodingSimulation(uint32_t packetSize, uint32_t numPa
   // Configure sender and receiver
   senderHelper.ConfigureSender (packetSize, numPackets, generationSize, DataRate ("1Mbps"));
   senderHelper.SetLossRate (lossRate);
+  if (bbr)
+    {
+      // Start at the same rate, then follow the 5 Mbps bottleneck
+      senderHelper.SetAttribute ("RateController",
+                                 TypeIdValue (NetworkCodingBbrRateController::GetTypeId ()));
+    }
   ApplicationContainer senderApp = senderHelper.Install (nodes.Get (0));
   
   receiverHelper.ConfigureReceiver (packetSize, generationSize);
@@ -416,6 +423,7 @@ main (int argc, char *argv[])
   uint16_t generationSize = 8;
   double lossRate = 0.1;
   bool verbose = false;
+  bool bbr = false;
   
   CommandLine cmd (__FILE__);
   cmd.AddValue ("packetSize", "Size of packets to send", packetSize);
@@ -423,6 +431,7 @@ main (int argc, char *argv[])
   cmd.AddValue ("generationSize", "Size of coding generation", generationSize);
   cmd.AddValue ("lossRate", "Packet loss rate", lossRate);
   cmd.AddValue ("verbose", "Enable verbose logging", verbose);
+  cmd.AddValue ("bbr", "Pace the coded sender with the BBR-like rate controller", bbr);
   cmd.Parse (argc, argv);
   
   if (verbose)
@@ -438,9 +447,10 @@ main (int argc, char *argv[])
   std::cout << "  Number of packets: " << numPackets << std::endl;
   std::cout << "  Generation size: " << generationSize << " packets" << std::endl;
   std::cout << "  Packet loss rate: " << (lossRate * 100) << "%" << std::endl;
+  std::cout << "  Coded sender pacing: " << (bbr ? "BBR" : "fixed 1Mbps") << std::endl;
   
   // Run both simulations
-  SimulationResults ncResults = RunNetworkCodingSimulation(packetSize, numPackets, generationSize, lossRate);
+  SimulationResults ncResults = RunNetworkCodingSimulation(packetSize, numPackets, generationSize, lossRate, bbr);
   SimulationResults tcpResults = RunTcpSimulation(packetSize, numPackets, lossRate);
   
   // Print comparison results
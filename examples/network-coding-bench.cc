@@ -0,0 +1,345 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Throughput microbenchmark for the block encoder and decoder.
+ *
+ * For every combination of field, generation size, payload size and
+ * density this measures, in wall-clock time:
+ *  - encode:     GenerateCodedPacket throughput (coded bytes out), or
+ *                GenerateCodedPackets with --encodeBatch packets per call
+ *  - process:    ProcessCodedPacket throughput while decoding a generation
+ *  - decode:     full-generation decode throughput (source bytes recovered,
+ *                including back-substitution and GetDecodedPackets)
+ *  - rank check: time to find that a packet is not innovative
+ *
+ * Results are printed as CSV (default) or JSON, one row per combination,
+ * so runs can be diffed between releases or between region kernels:
+ *
+ *   ./ns3 run "network-coding-bench --format=json --kernel=scalar"
+ *
+ * --regionThreads stripes long row batches over that many threads, e.g.
+ *
+ *   ./ns3 run "network-coding-bench --payloadSizes=9000 --regionThreads=4"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "../model/network-coding-encoder.h"
+#include "../model/network-coding-decoder.h"
+#include "../model/galois-field-simd.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("NetworkCodingBench");
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchResult
+{
+  gf::FieldType field;
+  uint16_t generationSize;
+  uint16_t payloadSize;
+  double density;
+  double encodeMbps;       //!< Coded payload bytes generated per second
+  double processMbps;      //!< Coded payload bytes consumed per second
+  double decodeMbps;       //!< Source bytes recovered per second
+  double packetsPerGeneration; //!< Coded packets needed to decode
+  double rankCheckUs;      //!< Microseconds per non-innovative packet
+};
+
+double
+Seconds (Clock::duration d)
+{
+  return std::chrono::duration<double> (d).count ();
+}
+
+template <class T>
+std::vector<T>
+ParseList (const std::string &list)
+{
+  std::vector<T> values;
+  std::istringstream in (list);
+  std::string item;
+  while (std::getline (in, item, ','))
+    {
+      if (!item.empty ())
+        {
+          double value = std::stod (item);
+          values.push_back (static_cast<T> (value));
+        }
+    }
+  return values;
+}
+
+Ptr<NetworkCodingEncoder>
+MakeEncoder (gf::FieldType field, uint16_t generationSize, uint16_t payloadSize,
+             double density, uint16_t sources)
+{
+  Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> (generationSize, payloadSize);
+  encoder->SetField (field);
+  encoder->SetDensity (density);
+  encoder->AssignStreams (1);
+  std::vector<uint8_t> buffer (payloadSize);
+  for (uint16_t i = 0; i < sources; i++)
+    {
+      for (uint32_t j = 0; j < payloadSize; j++)
+        {
+          buffer[j] = static_cast<uint8_t> (i * 31 + j * 7);
+        }
+      encoder->AddPacket (Create<Packet> (buffer.data (), payloadSize), i);
+    }
+  return encoder;
+}
+
+Ptr<NetworkCodingDecoder>
+MakeDecoder (gf::FieldType field, uint16_t generationSize, uint16_t payloadSize)
+{
+  Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, payloadSize);
+  decoder->SetField (field);
+  return decoder;
+}
+
+BenchResult
+RunBench (gf::FieldType field, uint16_t generationSize, uint16_t payloadSize,
+          double density, uint32_t encodeBatch, double minSeconds)
+{
+  BenchResult result;
+  result.field = field;
+  result.generationSize = generationSize;
+  result.payloadSize = payloadSize;
+  result.density = density;
+
+  Ptr<NetworkCodingEncoder> encoder = MakeEncoder (field, generationSize, payloadSize,
+                                                   density, generationSize);
+
+  // Encoding
+  uint64_t encoded = 0;
+  Clock::duration elapsed = Clock::duration::zero ();
+  Clock::time_point start = Clock::now ();
+  do
+    {
+      if (encodeBatch > 1)
+        {
+          encoded += encoder->GenerateCodedPackets (encodeBatch).size ();
+        }
+      else
+        {
+          encoder->GenerateCodedPacket ();
+          encoded++;
+        }
+      elapsed = Clock::now () - start;
+    }
+  while (Seconds (elapsed) < minSeconds);
+  result.encodeMbps = encoded * payloadSize / Seconds (elapsed) / 1e6;
+
+  // Decoding, from packets generated up front so that only the decoder is
+  // timed. Small fields and sparse codes need a few more than a generation.
+  std::vector<Ptr<Packet>> coded;
+  for (uint32_t i = 0; i < 4u * generationSize + 16; i++)
+    {
+      coded.push_back (encoder->GenerateCodedPacket ());
+    }
+
+  uint64_t processed = 0;
+  uint64_t generations = 0;
+  elapsed = Clock::duration::zero ();
+  while (Seconds (elapsed) < minSeconds)
+    {
+      Ptr<NetworkCodingDecoder> decoder = MakeDecoder (field, generationSize, payloadSize);
+      start = Clock::now ();
+      for (size_t i = 0; i < coded.size () && !decoder->CanDecode (); i++)
+        {
+          decoder->ProcessCodedPacket (coded[i]);
+          processed++;
+        }
+      decoder->GetDecodedPackets ();
+      elapsed += Clock::now () - start;
+      if (!decoder->CanDecode ())
+        {
+          NS_LOG_WARN ("Generation did not decode from " << coded.size () << " packets");
+          break;
+        }
+      generations++;
+    }
+  result.processMbps = processed * payloadSize / Seconds (elapsed) / 1e6;
+  result.decodeMbps = generations * generationSize * payloadSize / Seconds (elapsed) / 1e6;
+  result.packetsPerGeneration = generations ? static_cast<double> (processed) / generations : 0.0;
+
+  // Rank check: a decoder holding the first half of the sources is fed
+  // combinations of exactly those sources, so every packet is reduced to
+  // zero and rejected
+  uint16_t half = std::max<uint16_t> (1, generationSize / 2);
+  Ptr<NetworkCodingEncoder> halfEncoder = MakeEncoder (field, generationSize, payloadSize,
+                                                       density, half);
+  Ptr<NetworkCodingDecoder> decoder = MakeDecoder (field, generationSize, payloadSize);
+  for (uint16_t i = 0; i < half; i++)
+    {
+      decoder->ProcessCodedPacket (halfEncoder->GenerateUncodedPacket (i));
+    }
+  std::vector<Ptr<Packet>> redundant;
+  for (uint32_t i = 0; i < 32; i++)
+    {
+      redundant.push_back (halfEncoder->GenerateCodedPacket ());
+    }
+  uint64_t checked = 0;
+  start = Clock::now ();
+  do
+    {
+      decoder->ProcessCodedPacket (redundant[checked % redundant.size ()]);
+      checked++;
+      elapsed = Clock::now () - start;
+    }
+  while (Seconds (elapsed) < minSeconds);
+  result.rankCheckUs = Seconds (elapsed) / checked * 1e6;
+
+  return result;
+}
+
+void
+PrintCsvHeader (std::ostream &os)
+{
+  os << "kernel,field_bits,generation_size,payload_size,density,"
+     << "encode_mbps,process_mbps,decode_mbps,packets_per_generation,rank_check_us"
+     << std::endl;
+}
+
+void
+PrintCsv (std::ostream &os, const std::string &kernel, const BenchResult &r)
+{
+  os << kernel << "," << r.field << "," << r.generationSize << "," << r.payloadSize << ","
+     << r.density << "," << r.encodeMbps << "," << r.processMbps << "," << r.decodeMbps << ","
+     << r.packetsPerGeneration << "," << r.rankCheckUs << std::endl;
+}
+
+void
+PrintJson (std::ostream &os, const std::string &kernel, const BenchResult &r, bool first)
+{
+  os << (first ? "  " : ",\n  ")
+     << "{\"kernel\": \"" << kernel << "\", \"field_bits\": " << r.field
+     << ", \"generation_size\": " << r.generationSize
+     << ", \"payload_size\": " << r.payloadSize
+     << ", \"density\": " << r.density
+     << ", \"encode_mbps\": " << r.encodeMbps
+     << ", \"process_mbps\": " << r.processMbps
+     << ", \"decode_mbps\": " << r.decodeMbps
+     << ", \"packets_per_generation\": " << r.packetsPerGeneration
+     << ", \"rank_check_us\": " << r.rankCheckUs << "}";
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string generationSizes = "8,16,32,64,128,255";
+  std::string payloadSizes = "64,512,1500,9000";
+  std::string densities = "1.0,0.25,0.05";
+  std::string fields = "8";
+  std::string kernel = "auto";
+  std::string format = "csv";
+  double minSeconds = 0.05;
+  uint32_t encodeBatch = 1;
+  uint32_t regionThreads = 0;
+  uint32_t regionThreshold = gf::GetParallelRegionThreshold ();
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("generationSizes", "Comma-separated generation sizes (1-65535)", generationSizes);
+  cmd.AddValue ("payloadSizes", "Comma-separated payload sizes in bytes", payloadSizes);
+  cmd.AddValue ("densities", "Comma-separated coefficient densities in (0, 1]", densities);
+  cmd.AddValue ("fields", "Comma-separated field sizes in bits (1, 4, 8)", fields);
+  cmd.AddValue ("kernel", "Region kernel: auto, scalar, ssse3, avx2, avx512 or neon", kernel);
+  cmd.AddValue ("format", "Output format: csv or json", format);
+  cmd.AddValue ("minTime", "Minimum measuring time per metric, in seconds", minSeconds);
+  cmd.AddValue ("encodeBatch", "Coded packets generated per encoder call", encodeBatch);
+  cmd.AddValue ("regionThreads", "Threads striped row batches run on (0 disables striping)", regionThreads);
+  cmd.AddValue ("regionThreshold", "Smallest row batch, in bytes, that is striped", regionThreshold);
+  cmd.Parse (argc, argv);
+  gf::SetParallelRegionThreads (regionThreads);
+  gf::SetParallelRegionThreshold (regionThreshold);
+
+  const gf::RegionKernel kernels[] = {gf::KERNEL_AUTO, gf::KERNEL_SCALAR, gf::KERNEL_SSSE3,
+                                      gf::KERNEL_AVX2, gf::KERNEL_AVX512, gf::KERNEL_NEON};
+  bool selected = false;
+  for (gf::RegionKernel k : kernels)
+    {
+      if (kernel == (k == gf::KERNEL_AUTO ? "auto" : gf::GetRegionKernelName (k)))
+        {
+          selected = gf::SelectRegionKernel (k);
+          break;
+        }
+    }
+  if (!selected)
+    {
+      std::cerr << "Region kernel '" << kernel << "' is not available" << std::endl;
+      return 1;
+    }
+  std::string kernelName = gf::GetRegionKernelName (gf::GetRegionKernel ());
+
+  bool json = (format == "json");
+  if (json)
+    {
+      std::cout << "[" << std::endl;
+    }
+  else
+    {
+      PrintCsvHeader (std::cout);
+    }
+
+  bool first = true;
+  for (uint32_t bits : ParseList<uint32_t> (fields))
+    {
+      if (!gf::IsValidField (bits))
+        {
+          std::cerr << "Skipping unsupported field size " << bits << std::endl;
+          continue;
+        }
+      for (uint16_t generationSize : ParseList<uint16_t> (generationSizes))
+        {
+          for (uint16_t payloadSize : ParseList<uint16_t> (payloadSizes))
+            {
+              for (double density : ParseList<double> (densities))
+                {
+                  BenchResult r = RunBench (static_cast<gf::FieldType> (bits), generationSize,
+                                            payloadSize, density, encodeBatch, minSeconds);
+                  if (json)
+                    {
+                      PrintJson (std::cout, kernelName, r, first);
+                    }
+                  else
+                    {
+                      PrintCsv (std::cout, kernelName, r);
+                    }
+                  first = false;
+                }
+            }
+        }
+    }
+
+  if (json)
+    {
+      std::cout << "\n]" << std::endl;
+    }
+  return 0;
+}
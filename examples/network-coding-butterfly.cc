@@ -14,6 +14,8 @@
 #include "../model/network-coding-encoder.h"
 #include "../model/network-coding-decoder.h"
 #include "../model/galois-field.h"
+#include "../model/galois-field-traits.h"
+#include "../model/hop-reliability.h"
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -102,10 +104,11 @@ public:
       m_decoded (false),
       m_lastForwardedIndex (0),
       m_port (0),
-      m_retransmissionTimeout (Seconds(0.5)), // Timeout for hop-by-hop ACKs
-      m_hopSeqCounter (0)
+      m_retransmissionTimeout (Seconds(0.5)) // Timeout for hop-by-hop ACKs
   {
     m_gf = CreateObject<GaloisField> ();
+    m_hopQueue.SetTimeout (m_retransmissionTimeout);
+    m_hopQueue.SetResendCallback (MakeCallback (&ButterflyXORApp::Retransmit, this));
   }
 
   void Setup (uint32_t nodeId, NodeType nodeType, uint16_t port, uint32_t packetSize, 
@@ -205,10 +208,8 @@ private:
   
   // Hop-by-Hop Retransmission scheme members
   Time m_retransmissionTimeout;
-  uint64_t m_hopSeqCounter;
-  std::map<uint64_t, Ptr<Packet>> m_unackedPackets;
-  std::map<uint64_t, EventId> m_retransmissionTimers;
-  std::map<uint64_t, Address> m_unackedDestinations;
+  HopRetransmissionQueue m_hopQueue;            // Packets sent and not yet HOP_ACKed
+  std::map<Address, HopAckTracker> m_hopAcks;   // What each upstream hop sent us
 
   // Network coding objects
   Ptr<NetworkCodingEncoder> m_encoder;
@@ -247,13 +248,8 @@ private:
     if (m_socket) {
       m_socket->Close ();
     }
-    // Cancel all pending retransmission timers
-    for(auto const& [key, val] : m_retransmissionTimers) {
-        Simulator::Cancel(val);
-    }
-    m_retransmissionTimers.clear();
-    m_unackedPackets.clear();
-    m_unackedDestinations.clear();
+    // Drop everything still waiting for a HOP_ACK
+    m_hopQueue.Clear();
   }
 
   void SendPacket (uint32_t seqNum, Address destination)
@@ -308,7 +304,7 @@ private:
       NetworkCodingControlHeader ctrlHeader;
       if (copy->PeekHeader(ctrlHeader) > 0) {
           if (ctrlHeader.GetControlType() == NetworkCodingControlHeader::HOP_ACK) {
-              HandleHopAck(ctrlHeader.GetHopAckSequence());
+              HandleHopAck(ctrlHeader);
           }
           continue; // This was a control packet, so we are done with it.
       }
@@ -385,40 +381,33 @@ private:
 
   void SendHopAck(uint64_t hopSeq, Address destination)
   {
+      HopAckTracker& tracker = m_hopAcks[destination];
+      tracker.Receive(hopSeq);
       NetworkCodingControlHeader header(NetworkCodingControlHeader::HOP_ACK, 0);
-      header.SetHopAckSequence(hopSeq);
+      tracker.FillHopAck(header, hopSeq);
       Ptr<Packet> ackPacket = Create<Packet>(0);
       ackPacket->AddHeader(header);
       m_socket->SendTo(ackPacket, 0, destination);
   }
 
-  void HandleHopAck(uint64_t hopSeq)
+  void HandleHopAck(const NetworkCodingControlHeader& ack)
   {
-      if (m_unackedPackets.count(hopSeq)) {
+      uint32_t acknowledged = m_hopQueue.HandleHopAck(ack);
+      if (acknowledged > 0) {
           std::cout << "[" << Simulator::Now().GetSeconds() << "s] Node " << GetNodeName() 
-                    << " received HOP_ACK for hopSeq=" << hopSeq << std::endl;
-          Simulator::Cancel(m_retransmissionTimers[hopSeq]);
-          m_unackedPackets.erase(hopSeq);
-          m_retransmissionTimers.erase(hopSeq);
-          m_unackedDestinations.erase(hopSeq);
+                    << " received HOP_ACK for hopSeq=" << ack.GetHopAckSequence()
+                    << " (" << acknowledged << " acknowledged)" << std::endl;
       }
   }
 
-  void HandleRetransmissionTimeout(uint64_t hopSeq)
+  // Called by the hop queue for each packet whose timeout expired
+  void Retransmit(Ptr<Packet> packet, const Address& destination)
   {
-      if (m_unackedPackets.count(hopSeq)) {
-          Ptr<Packet> packetToResend = m_unackedPackets[hopSeq]->Copy();
-          Address destination = m_unackedDestinations[hopSeq];
-          
-          std::cout << "[" << Simulator::Now().GetSeconds() << "s] Node " << GetNodeName() 
-                    << " TIMEOUT for hopSeq=" << hopSeq << ". Retransmitting to " << destination << std::endl;
-          
-          m_socket->SendTo(packetToResend, 0, destination);
-          m_packetsSent++; // Count retransmissions
+      std::cout << "[" << Simulator::Now().GetSeconds() << "s] Node " << GetNodeName() 
+                << " TIMEOUT. Retransmitting to " << destination << std::endl;
 
-          // Reschedule the timer
-          m_retransmissionTimers[hopSeq] = Simulator::Schedule(m_retransmissionTimeout, &ButterflyXORApp::HandleRetransmissionTimeout, this, hopSeq);
-      }
+      m_socket->SendTo(packet, 0, destination);
+      m_packetsSent++; // Count retransmissions
   }
 
   void CheckAndStopSimulation()
@@ -492,9 +481,7 @@ private:
     for (uint32_t i = 0; i < m_generationSize; i++) {
       uint32_t packetIdx = startIdx + i;
       if (packetIdx < m_receivedPayloads.size()) {
-        for (size_t j = 0; j < m_packetSize; j++) {
-          xorPayload[j] ^= m_receivedPayloads[packetIdx][j];
-        }
+        gf::Binary::MultiplyAddRegion(xorPayload.data(), m_receivedPayloads[packetIdx].data(), 1, m_packetSize);
       }
     }
 
@@ -541,7 +528,7 @@ private:
 
   void SendWithHopAck(Ptr<Packet> packet, NetworkCodingHeader& header, Address destination)
   {
-    uint64_t hopSeq = ++m_hopSeqCounter;
+    uint64_t hopSeq = m_hopQueue.AllocateSequence();
     header.SetHopSequence(hopSeq);
     packet->AddHeader (header);
 
@@ -549,9 +536,7 @@ private:
       m_packetsSent++;
       
       // Store for potential retransmission
-      m_unackedPackets[hopSeq] = packet;
-      m_unackedDestinations[hopSeq] = destination;
-      m_retransmissionTimers[hopSeq] = Simulator::Schedule(m_retransmissionTimeout, &ButterflyXORApp::HandleRetransmissionTimeout, this, hopSeq);
+      m_hopQueue.Track(hopSeq, packet, destination);
     }
   }
 };
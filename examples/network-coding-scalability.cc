@@ -0,0 +1,747 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Scalability benchmark: N coded flows over M-hop paths of a generated
+ * topology.
+ *
+ * The topology is one of
+ *  - grid:      nodes on a square lattice, linked to their 4 neighbours
+ *  - geometric: nodes dropped uniformly in the unit square and linked
+ *               when closer than --radius (0 picks a radius that keeps
+ *               the graph connected with high probability); leftover
+ *               components are joined by their closest pair of nodes
+ *  - fat-tree:  the k-ary fat tree with at least --nodes nodes; flows
+ *               run between hosts only
+ * and every link is a point-to-point link. Each flow gets a random source,
+ * a destination --hops hops away (or a random one with --hops=0) and a
+ * shortest path between them. Every node on the path runs a
+ * NetworkCodingRelayApplication for the flow, so packets only ever cross
+ * one link at a time and the scenario needs no routing tables.
+ *
+ * One run prints, as a CSV row (default) or JSON object:
+ *  - events per second and wall-clock seconds per simulated second
+ *  - peak resident set size of the process
+ *  - wall time split into coding (encoder, decoder and recoder calls),
+ *    the scheduler (event queue operations) and everything else, which
+ *    is packet handling in the stacks, devices and applications
+ *  - the generations decoded, as a check that the flows got through
+ *
+ *   ./ns3 run "network-coding-scalability --topology=geometric --nodes=2000
+ *              --flows=100 --hops=6"
+ *
+ * --profile=false drops the per-call timers, which cost a few tens of
+ * nanoseconds per scheduler operation and coding call, for the cleanest
+ * events per second. Run it once per point, e.g. from a shell loop over
+ * --nodes, and compare the rows between releases.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "../helper/network-coding-helper.h"
+#include "../model/network-coding-udp-application.h"
+#include "../model/network-coding-relay-application.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include <sys/resource.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("NetworkCodingScalability");
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * \brief Wall-clock time of one component of the run
+ */
+struct ComponentTime
+{
+  uint64_t calls = 0;
+  Clock::duration total {};
+};
+
+ComponentTime g_schedulerTime;
+ComponentTime g_codingTime;
+
+double
+Seconds (Clock::duration d)
+{
+  return std::chrono::duration<double> (d).count ();
+}
+
+} // namespace
+
+namespace ns3 {
+
+/**
+ * \brief Scheduler that times every event queue operation of another one
+ *
+ * The simulator owns its scheduler, so the times go to g_schedulerTime.
+ */
+class ProfilingScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::ProfilingScheduler")
+      .SetParent<Scheduler> ()
+      .SetGroupName ("NetworkCoding")
+      .AddConstructor<ProfilingScheduler> ()
+      .AddAttribute ("Scheduler", "Type of the scheduler that is timed",
+                     TypeIdValue (MapScheduler::GetTypeId ()),
+                     MakeTypeIdAccessor (&ProfilingScheduler::m_schedulerType),
+                     MakeTypeIdChecker ())
+    ;
+    return tid;
+  }
+
+  virtual void Insert (const Event &ev)
+  {
+    Clock::time_point start = Clock::now ();
+    m_scheduler->Insert (ev);
+    Account (start);
+  }
+  virtual bool IsEmpty (void) const
+  {
+    return m_scheduler->IsEmpty ();
+  }
+  virtual Event PeekNext (void) const
+  {
+    return m_scheduler->PeekNext ();
+  }
+  virtual Event RemoveNext (void)
+  {
+    Clock::time_point start = Clock::now ();
+    Event ev = m_scheduler->RemoveNext ();
+    Account (start);
+    return ev;
+  }
+  virtual void Remove (const Event &ev)
+  {
+    Clock::time_point start = Clock::now ();
+    m_scheduler->Remove (ev);
+    Account (start);
+  }
+
+protected:
+  virtual void NotifyConstructionCompleted (void)
+  {
+    Scheduler::NotifyConstructionCompleted ();
+    ObjectFactory factory;
+    factory.SetTypeId (m_schedulerType);
+    m_scheduler = factory.Create<Scheduler> ();
+  }
+
+private:
+  static void Account (Clock::time_point start)
+  {
+    g_schedulerTime.calls++;
+    g_schedulerTime.total += Clock::now () - start;
+  }
+
+  TypeId m_schedulerType;
+  Ptr<Scheduler> m_scheduler;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (ProfilingScheduler);
+
+} // namespace ns3
+
+namespace {
+
+/**
+ * \brief An undirected graph of nodes and links
+ */
+struct Topology
+{
+  uint32_t nodes = 0;
+  std::vector<std::pair<uint32_t, uint32_t>> links;
+  std::vector<uint32_t> endpoints;  //!< Nodes flows may start and end at
+
+  void Link (uint32_t a, uint32_t b)
+  {
+    links.push_back ({a, b});
+  }
+};
+
+Topology
+BuildGrid (uint32_t nodes)
+{
+  Topology topology;
+  topology.nodes = nodes;
+  uint32_t side = static_cast<uint32_t> (std::ceil (std::sqrt (nodes)));
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      if ((i + 1) % side != 0 && i + 1 < nodes)
+        {
+          topology.Link (i, i + 1);
+        }
+      if (i + side < nodes)
+        {
+          topology.Link (i, i + side);
+        }
+      topology.endpoints.push_back (i);
+    }
+  return topology;
+}
+
+/**
+ * \brief Union-find over node indices
+ */
+struct Components
+{
+  std::vector<uint32_t> parent;
+
+  explicit Components (uint32_t n)
+    : parent (n)
+  {
+    std::iota (parent.begin (), parent.end (), 0);
+  }
+  uint32_t Find (uint32_t i)
+  {
+    while (parent[i] != i)
+      {
+        i = parent[i] = parent[parent[i]];
+      }
+    return i;
+  }
+  void Join (uint32_t a, uint32_t b)
+  {
+    parent[Find (a)] = Find (b);
+  }
+};
+
+Topology
+BuildGeometric (uint32_t nodes, double radius, Ptr<UniformRandomVariable> rng)
+{
+  Topology topology;
+  topology.nodes = nodes;
+  if (radius <= 0)
+    {
+      // Just above the connectivity threshold sqrt(ln n / (pi n)), which
+      // keeps the mean degree near 1.5 ln n
+      radius = 1.2 * std::sqrt (std::log (std::max<uint32_t> (nodes, 2)) / (M_PI * nodes));
+    }
+  std::vector<double> x (nodes);
+  std::vector<double> y (nodes);
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      x[i] = rng->GetValue ();
+      y[i] = rng->GetValue ();
+      topology.endpoints.push_back (i);
+    }
+  auto distance = [&x, &y] (uint32_t a, uint32_t b) {
+    return std::hypot (x[a] - x[b], y[a] - y[b]);
+  };
+
+  // Bucket the nodes into cells one radius wide, so only neighbouring
+  // cells are compared
+  uint32_t cells = std::max<uint32_t> (1, static_cast<uint32_t> (1.0 / radius));
+  auto cellOf = [cells] (double v) {
+    return std::min<uint32_t> (cells - 1, static_cast<uint32_t> (v * cells));
+  };
+  std::vector<std::vector<uint32_t>> grid (cells * cells);
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      grid[cellOf (y[i]) * cells + cellOf (x[i])].push_back (i);
+    }
+  Components components (nodes);
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      uint32_t cx = cellOf (x[i]);
+      uint32_t cy = cellOf (y[i]);
+      for (uint32_t ny = (cy ? cy - 1 : 0); ny <= std::min (cy + 1, cells - 1); ny++)
+        {
+          for (uint32_t nx = (cx ? cx - 1 : 0); nx <= std::min (cx + 1, cells - 1); nx++)
+            {
+              for (uint32_t j : grid[ny * cells + nx])
+                {
+                  if (j > i && distance (i, j) < radius)
+                    {
+                      topology.Link (i, j);
+                      components.Join (i, j);
+                    }
+                }
+            }
+        }
+    }
+
+  // Join every other component to the one node 0 is in by the closest pair
+  std::vector<uint32_t> connected;
+  std::unordered_map<uint32_t, std::vector<uint32_t>> members;
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      if (components.Find (i) == components.Find (0))
+        {
+          connected.push_back (i);
+        }
+      else
+        {
+          members[components.Find (i)].push_back (i);
+        }
+    }
+  for (auto &component : members)
+    {
+      std::pair<uint32_t, uint32_t> closest {component.second[0], connected[0]};
+      double best = distance (closest.first, closest.second);
+      for (uint32_t a : component.second)
+        {
+          for (uint32_t b : connected)
+            {
+              if (distance (a, b) < best)
+                {
+                  best = distance (a, b);
+                  closest = {a, b};
+                }
+            }
+        }
+      topology.Link (closest.first, closest.second);
+      connected.insert (connected.end (), component.second.begin (), component.second.end ());
+    }
+  return topology;
+}
+
+Topology
+BuildFatTree (uint32_t nodes)
+{
+  // k pods of k/2 edge and k/2 aggregation switches, (k/2)^2 core
+  // switches and k/2 hosts per edge switch: k^3/4 + 5k^2/4 nodes
+  uint32_t k = 2;
+  while (k * k * k / 4 + 5 * k * k / 4 < nodes)
+    {
+      k += 2;
+    }
+  uint32_t half = k / 2;
+  uint32_t core = half * half;
+  uint32_t hosts = k * k * k / 4;
+
+  Topology topology;
+  topology.nodes = core + k * k + hosts;
+  auto aggregation = [core, k] (uint32_t pod, uint32_t i) {
+    return core + pod * k + i;
+  };
+  auto edge = [core, k, half] (uint32_t pod, uint32_t i) {
+    return core + pod * k + half + i;
+  };
+  uint32_t host = core + k * k;
+  for (uint32_t pod = 0; pod < k; pod++)
+    {
+      for (uint32_t a = 0; a < half; a++)
+        {
+          for (uint32_t c = 0; c < half; c++)
+            {
+              topology.Link (aggregation (pod, a), a * half + c);
+            }
+          for (uint32_t e = 0; e < half; e++)
+            {
+              topology.Link (aggregation (pod, a), edge (pod, e));
+            }
+        }
+      for (uint32_t e = 0; e < half; e++)
+        {
+          for (uint32_t h = 0; h < half; h++)
+            {
+              topology.Link (edge (pod, e), host);
+              topology.endpoints.push_back (host);
+              host++;
+            }
+        }
+    }
+  return topology;
+}
+
+/**
+ * \brief Pick the path of a flow
+ * \param adjacency Neighbours of every node
+ * \param topology The topology, for its endpoints
+ * \param hops Wanted path length; 0 for any, and the longest shorter one
+ *        if no endpoint is that far from the source
+ * \param rng Random variable drawing the endpoints
+ * \return the nodes of a shortest path from source to destination, or an
+ *         empty path if the source reaches no other endpoint
+ */
+std::vector<uint32_t>
+PickPath (const std::vector<std::vector<uint32_t>> &adjacency, const Topology &topology,
+          uint32_t hops, Ptr<UniformRandomVariable> rng)
+{
+  uint32_t source = topology.endpoints[rng->GetInteger (0, topology.endpoints.size () - 1)];
+  std::vector<uint32_t> depth (topology.nodes, UINT32_MAX);
+  std::vector<uint32_t> parent (topology.nodes, UINT32_MAX);
+  std::queue<uint32_t> frontier;
+  depth[source] = 0;
+  frontier.push (source);
+  while (!frontier.empty ())
+    {
+      uint32_t node = frontier.front ();
+      frontier.pop ();
+      if (hops && depth[node] >= hops)
+        {
+          continue;
+        }
+      for (uint32_t next : adjacency[node])
+        {
+          if (depth[next] == UINT32_MAX)
+            {
+              depth[next] = depth[node] + 1;
+              parent[next] = node;
+              frontier.push (next);
+            }
+        }
+    }
+
+  // Candidates are the reachable endpoints at the greatest depth wanted
+  uint32_t target = 0;
+  std::vector<uint32_t> candidates;
+  for (uint32_t node : topology.endpoints)
+    {
+      if (node == source || depth[node] == UINT32_MAX)
+        {
+          continue;
+        }
+      uint32_t d = hops ? depth[node] : 1;
+      if (d > target)
+        {
+          target = d;
+          candidates.clear ();
+        }
+      if (d == target)
+        {
+          candidates.push_back (node);
+        }
+    }
+  std::vector<uint32_t> path;
+  if (candidates.empty ())
+    {
+      return path;
+    }
+  for (uint32_t node = candidates[rng->GetInteger (0, candidates.size () - 1)];
+       node != UINT32_MAX; node = parent[node])
+    {
+      path.push_back (node);
+    }
+  std::reverse (path.begin (), path.end ());
+  return path;
+}
+
+uint64_t
+LinkKey (uint32_t from, uint32_t to)
+{
+  return (static_cast<uint64_t> (from) << 32) | to;
+}
+
+void
+CodingTime (uint32_t generationId, Time duration)
+{
+  g_codingTime.calls++;
+  g_codingTime.total += std::chrono::nanoseconds (duration.GetNanoSeconds ());
+}
+
+/**
+ * \brief Size of the run, for the report
+ */
+struct Scenario
+{
+  std::string topology;
+  uint32_t nodes;
+  uint32_t links;
+  uint32_t flows;
+  double meanHops;
+  uint32_t relays;
+};
+
+/**
+ * \brief Measurements of the run
+ */
+struct Measurements
+{
+  double setupSeconds;
+  double runSeconds;
+  double simSeconds;
+  uint64_t events;
+  long peakRssKb;
+  double codingSeconds;
+  double schedulerSeconds;
+  uint32_t generationsDecoded;
+  uint32_t flowsComplete;
+};
+
+void
+PrintCsv (std::ostream &os, const Scenario &s, const Measurements &m, bool header)
+{
+  double other = m.runSeconds - m.codingSeconds - m.schedulerSeconds;
+  if (header)
+    {
+      os << "topology,nodes,links,flows,mean_hops,relays,setup_s,run_s,sim_s,events,"
+         << "events_per_s,wall_per_sim_s,peak_rss_kb,coding_s,scheduler_s,other_s,"
+         << "generations_decoded,flows_complete" << std::endl;
+    }
+  os << s.topology << "," << s.nodes << "," << s.links << "," << s.flows << "," << s.meanHops << ","
+     << s.relays << "," << m.setupSeconds << "," << m.runSeconds << "," << m.simSeconds << ","
+     << m.events << "," << m.events / m.runSeconds << "," << m.runSeconds / m.simSeconds << ","
+     << m.peakRssKb << "," << m.codingSeconds << "," << m.schedulerSeconds << "," << other << ","
+     << m.generationsDecoded << "," << m.flowsComplete << std::endl;
+}
+
+void
+PrintJson (std::ostream &os, const Scenario &s, const Measurements &m)
+{
+  double other = m.runSeconds - m.codingSeconds - m.schedulerSeconds;
+  os << "{\"topology\": \"" << s.topology << "\", \"nodes\": " << s.nodes
+     << ", \"links\": " << s.links
+     << ", \"flows\": " << s.flows
+     << ", \"mean_hops\": " << s.meanHops
+     << ", \"relays\": " << s.relays
+     << ", \"setup_s\": " << m.setupSeconds
+     << ", \"run_s\": " << m.runSeconds
+     << ", \"sim_s\": " << m.simSeconds
+     << ", \"events\": " << m.events
+     << ", \"events_per_s\": " << m.events / m.runSeconds
+     << ", \"wall_per_sim_s\": " << m.runSeconds / m.simSeconds
+     << ", \"peak_rss_kb\": " << m.peakRssKb
+     << ", \"coding_s\": " << m.codingSeconds
+     << ", \"scheduler_s\": " << m.schedulerSeconds
+     << ", \"other_s\": " << other
+     << ", \"generations_decoded\": " << m.generationsDecoded
+     << ", \"flows_complete\": " << m.flowsComplete << "}" << std::endl;
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string topologyName = "grid";
+  uint32_t nodes = 100;
+  uint32_t flows = 10;
+  uint32_t hops = 4;
+  double radius = 0;
+  std::string linkRate = "100Mbps";
+  std::string linkDelay = "1ms";
+  std::string flowRate = "2Mbps";
+  uint32_t packetSize = 1024;
+  uint16_t generationSize = 16;
+  uint32_t fieldBits = 8;
+  uint32_t numPackets = 256;
+  uint32_t generationsInFlight = 4;
+  double simTime = 10.0;
+  uint32_t run = 1;
+  std::string scheduler = "ns3::MapScheduler";
+  bool profile = true;
+  std::string format = "csv";
+  bool header = true;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("topology", "grid, geometric or fat-tree", topologyName);
+  cmd.AddValue ("nodes", "Number of nodes (at least, for fat-tree)", nodes);
+  cmd.AddValue ("flows", "Number of concurrent coded flows", flows);
+  cmd.AddValue ("hops", "Hops from source to destination of every flow; 0 for random pairs", hops);
+  cmd.AddValue ("radius", "Link radius of the geometric topology; 0 picks one", radius);
+  cmd.AddValue ("linkRate", "Data rate of every link", linkRate);
+  cmd.AddValue ("linkDelay", "Propagation delay of every link", linkDelay);
+  cmd.AddValue ("flowRate", "Sending rate of every flow", flowRate);
+  cmd.AddValue ("packetSize", "Payload bytes per packet", packetSize);
+  cmd.AddValue ("generationSize", "Packets per generation", generationSize);
+  cmd.AddValue ("fieldBits", "Coding field: 1, 4 or 8 bits per symbol", fieldBits);
+  cmd.AddValue ("numPackets", "Source packets sent per flow", numPackets);
+  cmd.AddValue ("generationsInFlight", "MaxGenerationsInFlight of the endpoints", generationsInFlight);
+  cmd.AddValue ("simTime", "Simulated seconds", simTime);
+  cmd.AddValue ("run", "RngRun, picks the topology and the flows", run);
+  cmd.AddValue ("scheduler", "Type of the simulator's event scheduler", scheduler);
+  cmd.AddValue ("profile", "Time coding calls and scheduler operations", profile);
+  cmd.AddValue ("format", "Output format: csv or json", format);
+  cmd.AddValue ("header", "Print the CSV header line", header);
+  cmd.Parse (argc, argv);
+
+  Clock::time_point setupStart = Clock::now ();
+  RngSeedManager::SetRun (run);
+  ObjectFactory schedulerFactory;
+  if (profile)
+    {
+      schedulerFactory.SetTypeId ("ns3::ProfilingScheduler");
+      schedulerFactory.Set ("Scheduler", TypeIdValue (TypeId::LookupByName (scheduler)));
+    }
+  else
+    {
+      schedulerFactory.SetTypeId (scheduler);
+    }
+  Simulator::SetScheduler (schedulerFactory);
+
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (0);
+  Topology topology;
+  if (topologyName == "grid")
+    {
+      topology = BuildGrid (nodes);
+    }
+  else if (topologyName == "geometric")
+    {
+      topology = BuildGeometric (nodes, radius, rng);
+    }
+  else if (topologyName == "fat-tree")
+    {
+      topology = BuildFatTree (nodes);
+    }
+  else
+    {
+      std::cerr << "Unknown topology " << topologyName << std::endl;
+      return 1;
+    }
+  NS_LOG_INFO ("Built " << topologyName << " of " << topology.nodes << " nodes and "
+               << topology.links.size () << " links");
+
+  NodeContainer allNodes;
+  allNodes.Create (topology.nodes);
+  InternetStackHelper internet;
+  internet.Install (allNodes);
+
+  // One /30 per link. The address a node is reached at over a link is
+  // kept per direction, as relays send to the next node on that link.
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue (linkRate));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue (linkDelay));
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+  std::vector<std::vector<uint32_t>> adjacency (topology.nodes);
+  std::unordered_map<uint64_t, Ipv4Address> addresses;
+  for (const auto &link : topology.links)
+    {
+      NetDeviceContainer devices = pointToPoint.Install (allNodes.Get (link.first), allNodes.Get (link.second));
+      Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+      ipv4.NewNetwork ();
+      addresses[LinkKey (link.first, link.second)] = interfaces.GetAddress (1);
+      addresses[LinkKey (link.second, link.first)] = interfaces.GetAddress (0);
+      adjacency[link.first].push_back (link.second);
+      adjacency[link.second].push_back (link.first);
+    }
+
+  // Every flow has its own port, on which all of its relays listen
+  std::vector<Ptr<NetworkCodingUdpApplication>> receivers;
+  uint32_t relays = 0;
+  uint32_t totalHops = 0;
+  for (uint32_t f = 0; f < flows; f++)
+    {
+      std::vector<uint32_t> path = PickPath (adjacency, topology, hops, rng);
+      if (path.size () < 2)
+        {
+          NS_LOG_WARN ("Flow " << f << " found no destination");
+          continue;
+        }
+      uint16_t port = 10000 + f;
+      double start = 1.0 + 0.1 * rng->GetValue ();
+      totalHops += path.size () - 1;
+
+      Address firstHop = InetSocketAddress (addresses[LinkKey (path[0], path[1])], port);
+      Address destination = InetSocketAddress (addresses[LinkKey (path[path.size () - 2], path.back ())], port);
+      NetworkCodingHelper ncHelper (firstHop, port);
+      ncHelper.SetAttribute ("FieldBits", UintegerValue (fieldBits));
+      ncHelper.SetAttribute ("MaxGenerationsInFlight", UintegerValue (generationsInFlight));
+      ncHelper.SetAttribute ("MeasureCodingTime", BooleanValue (profile));
+      ncHelper.ConfigureSender (packetSize, numPackets, generationSize, DataRate (flowRate));
+      ApplicationContainer senderApp = ncHelper.Install (allNodes.Get (path.front ()));
+      NetworkCodingHelper receiverHelper (destination, port);
+      receiverHelper.SetAttribute ("FieldBits", UintegerValue (fieldBits));
+      receiverHelper.SetAttribute ("MaxGenerationsInFlight", UintegerValue (generationsInFlight));
+      receiverHelper.SetAttribute ("MeasureCodingTime", BooleanValue (profile));
+      receiverHelper.ConfigureReceiver (packetSize, generationSize);
+      ApplicationContainer receiverApp = receiverHelper.Install (allNodes.Get (path.back ()));
+      senderApp.Start (Seconds (start));
+      senderApp.Stop (Seconds (simTime));
+      receiverApp.Start (Seconds (0.5));
+      receiverApp.Stop (Seconds (simTime));
+
+      Ptr<NetworkCodingUdpApplication> sender =
+        DynamicCast<NetworkCodingUdpApplication> (senderApp.Get (0));
+      Ptr<NetworkCodingUdpApplication> receiver =
+        DynamicCast<NetworkCodingUdpApplication> (receiverApp.Get (0));
+      sender->TraceConnectWithoutContext ("EncodeTime", MakeCallback (&CodingTime));
+      receiver->TraceConnectWithoutContext ("DecodeTime", MakeCallback (&CodingTime));
+      receivers.push_back (receiver);
+
+      for (size_t i = 1; i + 1 < path.size (); i++)
+        {
+          NetworkCodingRelayHelper relayHelper (InetSocketAddress (addresses[LinkKey (path[i], path[i + 1])], port),
+                                                port);
+          relayHelper.SetAttribute ("PacketSize", UintegerValue (packetSize));
+          relayHelper.SetAttribute ("GenerationSize", UintegerValue (generationSize));
+          relayHelper.SetAttribute ("FieldBits", UintegerValue (fieldBits));
+          relayHelper.SetAttribute ("MeasureCodingTime", BooleanValue (profile));
+          ApplicationContainer relayApp = relayHelper.Install (allNodes.Get (path[i]));
+          relayApp.Start (Seconds (0.5));
+          relayApp.Stop (Seconds (simTime));
+          relayApp.Get (0)->TraceConnectWithoutContext ("RecodeTime", MakeCallback (&CodingTime));
+          relays++;
+        }
+    }
+
+  Scenario scenario {topologyName, topology.nodes, static_cast<uint32_t> (topology.links.size ()),
+                     static_cast<uint32_t> (receivers.size ()),
+                     receivers.empty () ? 0.0 : static_cast<double> (totalHops) / receivers.size (),
+                     relays};
+  Measurements m;
+  m.setupSeconds = Seconds (Clock::now () - setupStart);
+
+  // The scheduler already holds the application starts; only the run is
+  // split into components
+  g_schedulerTime = ComponentTime ();
+  g_codingTime = ComponentTime ();
+  Simulator::Stop (Seconds (simTime));
+  Clock::time_point runStart = Clock::now ();
+  Simulator::Run ();
+  m.runSeconds = Seconds (Clock::now () - runStart);
+  m.simSeconds = Simulator::Now ().GetSeconds ();
+  m.events = Simulator::GetEventCount ();
+
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  m.peakRssKb = usage.ru_maxrss;
+  m.codingSeconds = Seconds (g_codingTime.total);
+  m.schedulerSeconds = Seconds (g_schedulerTime.total);
+  m.generationsDecoded = 0;
+  m.flowsComplete = 0;
+  uint32_t generationsPerFlow = (numPackets + generationSize - 1) / generationSize;
+  for (Ptr<NetworkCodingUdpApplication> receiver : receivers)
+    {
+      m.generationsDecoded += receiver->GetGenerationsDecoded ();
+      if (receiver->GetGenerationsDecoded () >= generationsPerFlow)
+        {
+          m.flowsComplete++;
+        }
+    }
+  Simulator::Destroy ();
+
+  if (format == "json")
+    {
+      PrintJson (std::cout, scenario, m);
+    }
+  else
+    {
+      PrintCsv (std::cout, scenario, m, header);
+    }
+  return 0;
+}
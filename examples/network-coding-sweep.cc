@@ -0,0 +1,457 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Parameter sweep over a point-to-point network coding transfer.
+ *
+ * Every point of the grid (generation size, packet size, error rate, link
+ * data rate, run) is an independent simulation of a sender and a receiver
+ * NetworkCodingUdpApplication across a lossy point-to-point link. The
+ * simulator is a per-process singleton, so points run in forked worker
+ * processes, --jobs at a time. Each worker sends its result row back
+ * over a pipe and the parent writes all rows, in grid order, to one CSV
+ * file with a header line:
+ *
+ *   ./ns3 run "network-coding-sweep --generationSizes=8,16,32
+ *              --errorRates=0,0.05,0.1 --dataRates=5Mbps,50Mbps --jobs=8"
+ *
+ * The grid is the cross product of the lists, or the rows of a CSV file
+ * given with --grid. Its header names any of the columns generationSize,
+ * packetSize, errorRate and dataRate; missing columns take the first value
+ * of the corresponding list. Point i uses RngRun --run + i, so results do
+ * not depend on --jobs.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "../helper/network-coding-helper.h"
+#include "../model/network-coding-udp-application.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("NetworkCodingSweep");
+
+namespace {
+
+/**
+ * \brief One point of the parameter grid
+ */
+struct SweepPoint
+{
+  uint16_t generationSize;
+  uint32_t packetSize;
+  double errorRate;
+  std::string dataRate;
+  uint32_t run;             //!< RngRun of the simulation
+};
+
+/**
+ * \brief Settings shared by every point
+ */
+struct SweepConfig
+{
+  uint32_t numPackets;
+  uint32_t generationsInFlight;
+  double sendFraction;      //!< Application rate as a fraction of the link rate
+  double simTime;           //!< Seconds
+};
+
+template <class T>
+std::vector<T>
+ParseList (const std::string &list)
+{
+  std::vector<T> values;
+  std::istringstream in (list);
+  std::string item;
+  while (std::getline (in, item, ','))
+    {
+      if (!item.empty ())
+        {
+          double value = std::stod (item);
+          values.push_back (static_cast<T> (value));
+        }
+    }
+  return values;
+}
+
+std::vector<std::string>
+SplitList (const std::string &list)
+{
+  std::vector<std::string> values;
+  std::istringstream in (list);
+  std::string item;
+  while (std::getline (in, item, ','))
+    {
+      if (!item.empty ())
+        {
+          values.push_back (item);
+        }
+    }
+  return values;
+}
+
+/**
+ * \brief Read the grid rows of a CSV file
+ * \param path The file, with a header line naming the columns
+ * \param defaults Values of the columns the file leaves out
+ * \param points Filled with one point per data row
+ * \return false if the file cannot be read
+ */
+bool
+ReadGrid (const std::string &path, const SweepPoint &defaults, std::vector<SweepPoint> &points)
+{
+  std::ifstream in (path);
+  std::string line;
+  if (!in || !std::getline (in, line))
+    {
+      return false;
+    }
+  std::vector<std::string> columns = SplitList (line);
+  while (std::getline (in, line))
+    {
+      std::vector<std::string> fields = SplitList (line);
+      if (fields.empty ())
+        {
+          continue;
+        }
+      SweepPoint point = defaults;
+      for (size_t i = 0; i < columns.size () && i < fields.size (); i++)
+        {
+          if (columns[i] == "generationSize")
+            {
+              point.generationSize = std::stoul (fields[i]);
+            }
+          else if (columns[i] == "packetSize")
+            {
+              point.packetSize = std::stoul (fields[i]);
+            }
+          else if (columns[i] == "errorRate")
+            {
+              point.errorRate = std::stod (fields[i]);
+            }
+          else if (columns[i] == "dataRate")
+            {
+              point.dataRate = fields[i];
+            }
+          else
+            {
+              std::cerr << "Ignoring unknown grid column " << columns[i] << std::endl;
+            }
+        }
+      points.push_back (point);
+    }
+  return true;
+}
+
+/**
+ * \brief Receiver-side measurements of one point
+ */
+struct DecodeStats
+{
+  uint32_t generations = 0;
+  double latencySum = 0.0;  //!< Seconds, first packet to full rank
+  Time lastDecode;
+};
+
+void
+GenerationLatency (DecodeStats *stats, uint32_t generationId, Time latency)
+{
+  stats->generations++;
+  stats->latencySum += latency.GetSeconds ();
+  stats->lastDecode = Simulator::Now ();
+}
+
+const char *CSV_HEADER =
+  "generationSize,packetSize,errorRate,dataRate,run,status,packetsSent,"
+  "packetsReceived,innovativePackets,generationsDecoded,goodputMbps,"
+  "meanLatencyMs,wallSeconds";
+
+/**
+ * \brief Simulate one point
+ * \param point The parameters
+ * \param config The shared settings
+ * \return the CSV row of the point, without the trailing newline
+ */
+std::string
+RunPoint (const SweepPoint &point, const SweepConfig &config)
+{
+  auto wallStart = std::chrono::steady_clock::now ();
+  RngSeedManager::SetRun (point.run);
+
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue (point.dataRate));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  NetDeviceContainer devices = pointToPoint.Install (nodes);
+
+  Ptr<RateErrorModel> errorModel = CreateObject<RateErrorModel> ();
+  errorModel->SetAttribute ("ErrorRate", DoubleValue (point.errorRate));
+  errorModel->SetAttribute ("ErrorUnit", StringValue ("ERROR_UNIT_PACKET"));
+  devices.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (errorModel));
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+
+  uint16_t port = 9;
+  DataRate linkRate (point.dataRate);
+  DataRate sendRate (static_cast<uint64_t> (linkRate.GetBitRate () * config.sendFraction));
+  NetworkCodingHelper ncHelper (interfaces.GetAddress (1), port);
+  ncHelper.SetAttribute ("MaxGenerationsInFlight", UintegerValue (config.generationsInFlight));
+  ncHelper.ConfigureSender (point.packetSize, config.numPackets, point.generationSize, sendRate);
+  ApplicationContainer senderApp = ncHelper.Install (nodes.Get (0));
+  ncHelper.ConfigureReceiver (point.packetSize, point.generationSize);
+  ApplicationContainer receiverApp = ncHelper.Install (nodes.Get (1));
+
+  const double start = 1.0;
+  senderApp.Start (Seconds (start));
+  senderApp.Stop (Seconds (config.simTime));
+  receiverApp.Start (Seconds (0.5));
+  receiverApp.Stop (Seconds (config.simTime));
+
+  Ptr<NetworkCodingUdpApplication> sender = DynamicCast<NetworkCodingUdpApplication> (senderApp.Get (0));
+  Ptr<NetworkCodingUdpApplication> receiver = DynamicCast<NetworkCodingUdpApplication> (receiverApp.Get (0));
+  DecodeStats stats;
+  receiver->TraceConnectWithoutContext ("GenerationLatency", MakeBoundCallback (&GenerationLatency, &stats));
+
+  Simulator::Stop (Seconds (config.simTime));
+  Simulator::Run ();
+
+  double elapsed = stats.lastDecode.GetSeconds () - start;
+  double decodedBits = 8.0 * stats.generations * point.generationSize * point.packetSize;
+  double goodput = elapsed > 0 ? decodedBits / elapsed / 1e6 : 0.0;
+  double latency = stats.generations ? 1000.0 * stats.latencySum / stats.generations : 0.0;
+
+  std::ostringstream row;
+  row << point.generationSize << "," << point.packetSize << "," << point.errorRate << ","
+      << point.dataRate << "," << point.run << ",ok," << sender->GetPacketsSent () << ","
+      << receiver->GetPacketsReceived () << "," << receiver->GetInnovativePacketsReceived () << ","
+      << receiver->GetGenerationsDecoded () << "," << goodput << "," << latency << ",";
+  Simulator::Destroy ();
+
+  row << std::chrono::duration<double> (std::chrono::steady_clock::now () - wallStart).count ();
+  return row.str ();
+}
+
+/**
+ * \brief A point running in a worker process
+ */
+struct Worker
+{
+  size_t point;             //!< Index in the grid
+  int fd;                   //!< Read end of the result pipe
+};
+
+/**
+ * \brief Read everything a finished worker wrote
+ * \param fd Read end of its pipe, closed afterwards
+ * \return the row, without the trailing newline
+ */
+std::string
+ReadRow (int fd)
+{
+  std::string row;
+  char buffer[512];
+  ssize_t n;
+  while ((n = read (fd, buffer, sizeof (buffer))) > 0)
+    {
+      row.append (buffer, n);
+    }
+  close (fd);
+  while (!row.empty () && row.back () == '\n')
+    {
+      row.pop_back ();
+    }
+  return row;
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string generationSizes = "8,16,32";
+  std::string packetSizes = "1024";
+  std::string errorRates = "0,0.05,0.1";
+  std::string dataRates = "5Mbps";
+  std::string grid;
+  std::string output = "network-coding-sweep.csv";
+  uint32_t runs = 1;
+  uint32_t firstRun = 1;
+  uint32_t jobs = 0;
+  SweepConfig config;
+  config.numPackets = 1000;
+  config.generationsInFlight = 4;
+  config.sendFraction = 0.9;
+  config.simTime = 30.0;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("generationSizes", "Comma-separated generation sizes", generationSizes);
+  cmd.AddValue ("packetSizes", "Comma-separated packet sizes in bytes", packetSizes);
+  cmd.AddValue ("errorRates", "Comma-separated packet error rates of the link", errorRates);
+  cmd.AddValue ("dataRates", "Comma-separated link data rates, e.g. 5Mbps", dataRates);
+  cmd.AddValue ("grid", "CSV file of grid points, instead of the cross product of the lists", grid);
+  cmd.AddValue ("runs", "Independent runs of every point", runs);
+  cmd.AddValue ("run", "RngRun of the first point", firstRun);
+  cmd.AddValue ("jobs", "Simulations run at once; 0 uses every processor", jobs);
+  cmd.AddValue ("output", "CSV file the results are written to", output);
+  cmd.AddValue ("numPackets", "Source packets sent per point", config.numPackets);
+  cmd.AddValue ("generationsInFlight", "MaxGenerationsInFlight of both applications",
+                config.generationsInFlight);
+  cmd.AddValue ("sendFraction", "Sending rate as a fraction of the link data rate", config.sendFraction);
+  cmd.AddValue ("simTime", "Simulated seconds per point", config.simTime);
+  cmd.Parse (argc, argv);
+
+  std::vector<SweepPoint> base;
+  SweepPoint defaults {ParseList<uint16_t> (generationSizes).at (0), ParseList<uint32_t> (packetSizes).at (0),
+                       ParseList<double> (errorRates).at (0), SplitList (dataRates).at (0), 0};
+  if (!grid.empty ())
+    {
+      if (!ReadGrid (grid, defaults, base))
+        {
+          std::cerr << "Cannot read grid file " << grid << std::endl;
+          return 1;
+        }
+    }
+  else
+    {
+      for (uint16_t generationSize : ParseList<uint16_t> (generationSizes))
+        {
+          for (uint32_t packetSize : ParseList<uint32_t> (packetSizes))
+            {
+              for (double errorRate : ParseList<double> (errorRates))
+                {
+                  for (const std::string &dataRate : SplitList (dataRates))
+                    {
+                      base.push_back ({generationSize, packetSize, errorRate, dataRate, 0});
+                    }
+                }
+            }
+        }
+    }
+
+  std::vector<SweepPoint> points;
+  for (uint32_t r = 0; r < runs; r++)
+    {
+      for (SweepPoint point : base)
+        {
+          point.run = firstRun + points.size ();
+          points.push_back (point);
+        }
+    }
+
+  if (jobs == 0)
+    {
+      long processors = sysconf (_SC_NPROCESSORS_ONLN);
+      jobs = processors > 0 ? processors : 1;
+    }
+  NS_LOG_INFO ("Sweeping " << points.size () << " points, " << jobs << " at a time");
+
+  // Nothing buffered may be flushed twice by the forked workers
+  std::cout.flush ();
+  std::cerr.flush ();
+  fflush (nullptr);
+
+  std::vector<std::string> rows (points.size ());
+  std::map<pid_t, Worker> workers;
+  size_t next = 0;
+  size_t done = 0;
+  while (done < points.size ())
+    {
+      while (workers.size () < jobs && next < points.size ())
+        {
+          int fds[2];
+          if (pipe (fds) != 0)
+            {
+              std::cerr << "pipe failed" << std::endl;
+              return 1;
+            }
+          pid_t pid = fork ();
+          if (pid < 0)
+            {
+              std::cerr << "fork failed" << std::endl;
+              return 1;
+            }
+          if (pid == 0)
+            {
+              // Worker: one simulation, then the row down the pipe
+              close (fds[0]);
+              std::string row = RunPoint (points[next], config) + "\n";
+              ssize_t written = write (fds[1], row.data (), row.size ());
+              close (fds[1]);
+              _exit (written == static_cast<ssize_t> (row.size ()) ? 0 : 1);
+            }
+          close (fds[1]);
+          workers[pid] = {next, fds[0]};
+          next++;
+        }
+
+      int status;
+      pid_t pid = wait (&status);
+      if (pid < 0)
+        {
+          std::cerr << "wait failed" << std::endl;
+          return 1;
+        }
+      auto it = workers.find (pid);
+      if (it == workers.end ())
+        {
+          continue;
+        }
+      const SweepPoint &point = points[it->second.point];
+      std::string row = ReadRow (it->second.fd);
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0 || row.empty ())
+        {
+          // Keep the grid complete, so failures show up in the results
+          std::ostringstream failed;
+          failed << point.generationSize << "," << point.packetSize << "," << point.errorRate << ","
+                 << point.dataRate << "," << point.run << ",failed,,,,,,,";
+          row = failed.str ();
+        }
+      rows[it->second.point] = row;
+      workers.erase (it);
+      done++;
+      NS_LOG_INFO ("Finished point " << done << "/" << points.size () << ": " << row);
+    }
+
+  std::ofstream out (output);
+  out << CSV_HEADER << "\n";
+  for (const std::string &row : rows)
+    {
+      out << row << "\n";
+    }
+  out.close ();
+  std::cout << "Wrote " << rows.size () << " points to " << output << std::endl;
+  return 0;
+}
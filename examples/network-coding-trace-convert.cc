@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Converts a binary trace written by NetworkCodingTraceWriter to CSV, or
+ * summarizes it:
+ *
+ *   ./ns3 run "network-coding-example --traceFile=run.nctr"
+ *   ./ns3 run "network-coding-trace-convert --input=run.nctr --output=run.csv"
+ *   ./ns3 run "network-coding-trace-convert --input=run.nctr --summary"
+ *
+ * The CSV has one line per record: time (seconds), source, type name,
+ * generation (empty if none), value and flags. --type and --source keep
+ * only the records of one type or source.
+ */
+
+#include "ns3/core-module.h"
+#include "../model/network-coding-trace.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <utility>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("NetworkCodingTraceConvert");
+
+namespace {
+
+/**
+ * \brief Totals of the records of one (source, type)
+ */
+struct TypeSummary
+{
+  uint64_t records = 0;
+  int64_t valueSum = 0;
+  int64_t first = 0;    //!< Time of the first record, ns
+  int64_t last = 0;     //!< Time of the last record, ns
+};
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string input;
+  std::string output = "-";
+  std::string type;
+  int32_t source = -1;
+  bool summary = false;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("input", "Binary trace file", input);
+  cmd.AddValue ("output", "CSV file to write, - for standard output", output);
+  cmd.AddValue ("type", "Only convert records of this type, e.g. RANK", type);
+  cmd.AddValue ("source", "Only convert records of this source, -1 for all", source);
+  cmd.AddValue ("summary", "Print record counts per source and type instead of CSV", summary);
+  cmd.Parse (argc, argv);
+
+  NetworkCodingTraceReader reader;
+  if (input.empty () || !reader.Open (input))
+    {
+      std::cerr << "Cannot read trace " << input << std::endl;
+      return 1;
+    }
+
+  std::ofstream file;
+  std::ostream *out = &std::cout;
+  if (!summary && output != "-")
+    {
+      file.open (output);
+      if (!file)
+        {
+          std::cerr << "Cannot create " << output << std::endl;
+          return 1;
+        }
+      out = &file;
+    }
+  if (!summary)
+    {
+      *out << "time,source,type,generation,value,flags\n" << std::fixed << std::setprecision (9);
+    }
+
+  std::map<std::pair<uint16_t, uint8_t>, TypeSummary> totals;
+  NetworkCodingTraceRecord record;
+  uint64_t converted = 0;
+  while (reader.Next (record))
+    {
+      const char *name = NetworkCodingTraceReader::GetTypeName (record.type);
+      if ((source >= 0 && record.source != source) || (!type.empty () && type != name))
+        {
+          continue;
+        }
+      converted++;
+      if (summary)
+        {
+          TypeSummary &total = totals[std::make_pair (record.source, record.type)];
+          if (total.records++ == 0)
+            {
+              total.first = record.time;
+            }
+          total.last = record.time;
+          total.valueSum += record.value;
+          continue;
+        }
+
+      *out << record.time / 1e9 << "," << record.source << "," << name << ",";
+      if (record.generation != NetworkCodingTraceRecord::NO_GENERATION)
+        {
+          *out << record.generation;
+        }
+      *out << "," << record.value << "," << unsigned (record.flags) << "\n";
+    }
+
+  if (summary)
+    {
+      std::cout << reader.GetRecordCount () << " records in " << input << std::endl;
+      std::cout << "source,type,records,meanValue,firstTime,lastTime" << std::endl;
+      for (const auto &entry : totals)
+        {
+          const TypeSummary &total = entry.second;
+          std::cout << entry.first.first << "," << NetworkCodingTraceReader::GetTypeName (entry.first.second)
+                    << "," << total.records << "," << double (total.valueSum) / total.records
+                    << "," << total.first / 1e9 << "," << total.last / 1e9 << std::endl;
+        }
+    }
+  else
+    {
+      out->flush ();
+      NS_LOG_INFO ("Converted " << converted << " of " << reader.GetRecordCount () << " records");
+    }
+  return 0;
+}
@@ -263,7 +263,7 @@ void PrintPacketDetails(const std::string& label, Ptr<Packet> packet, bool showB
   }
   
   // Validate header values to ensure they make sense
-  if (header.GetGenerationSize() == 0 || header.GetGenerationSize() > 255) {
+  if (header.GetGenerationSize() == 0) {
     std::cout << "Invalid network coding header (bad generation size)" << std::endl;
     return;
   }
@@ -173,7 +173,7 @@ public:
       .AddAttribute ("GenerationSize", "The size of each generation",
                     UintegerValue (8),
                     MakeUintegerAccessor (&EncoderVerificationApp::m_generationSize),
-                    MakeUintegerChecker<uint16_t> (1, 255))
+                    MakeUintegerChecker<uint16_t> (1))
       .AddAttribute ("RemoteAddress", "The destination Address",
                     AddressValue (),
                     MakeAddressAccessor (&EncoderVerificationApp::m_peer),
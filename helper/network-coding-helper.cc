@@ -181,6 +181,16 @@ NetworkCodingHelper::SetLossRate (double lossRate)
   m_factory.Set ("LossRate", DoubleValue (lossRate));
 }
 
+void
+NetworkCodingHelper::SetGroupSize (uint32_t receivers)
+{
+  NS_LOG_FUNCTION (this << receivers);
+  
+  NS_ASSERT_MSG (receivers > 0, "A group needs at least one receiver");
+  
+  m_factory.Set ("GroupSize", UintegerValue (receivers));
+}
+
 Ptr<Application>
 NetworkCodingHelper::InstallPriv (Ptr<Node> node) const
 {
@@ -341,4 +351,41 @@ NetworkCodingStatsHelper::GetDecodingRate (void) const
   return static_cast<double> (GetGenerationsDecoded ()) / totalGenerations;
 }
 
+NetworkCodingRelayHelper::NetworkCodingRelayHelper (Address nextHop, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << nextHop << port);
+  
+  m_factory.SetTypeId ("ns3::NetworkCodingRelayApplication");
+  m_factory.Set ("Remote", AddressValue (nextHop));
+  m_factory.Set ("Port", UintegerValue (port));
+}
+
+void
+NetworkCodingRelayHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  NS_LOG_FUNCTION (this << name);
+  m_factory.Set (name, value);
+}
+
+ApplicationContainer
+NetworkCodingRelayHelper::Install (Ptr<Node> node) const
+{
+  NS_LOG_FUNCTION (this << node);
+  Ptr<Application> app = m_factory.Create<NetworkCodingRelayApplication> ();
+  node->AddApplication (app);
+  return ApplicationContainer (app);
+}
+
+ApplicationContainer
+NetworkCodingRelayHelper::Install (NodeContainer nodes) const
+{
+  NS_LOG_FUNCTION (this << nodes.GetN ());
+  ApplicationContainer apps;
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      apps.Add (Install (*i));
+    }
+  return apps;
+}
+
 } // namespace ns3
@@ -28,6 +28,7 @@
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
 #include "../model/network-coding-udp-application.h"
+#include "../model/network-coding-relay-application.h"
 
 namespace ns3 {
 
@@ -117,6 +118,15 @@ public:
    */
   void SetLossRate (double lossRate);
 
+  /**
+   * \brief Serve several receivers with one coded stream
+   * \param receivers Receivers that must acknowledge every generation
+   *
+   * Construct the sender's helper with a multicast group address; the
+   * receivers only use the port and send their feedback to the sender.
+   */
+  void SetGroupSize (uint32_t receivers);
+
 private:
   /**
    * \brief Install a network coding application on the specified node
@@ -206,6 +216,45 @@ private:
   std::vector<Ptr<NetworkCodingUdpApplication>> m_apps;  //!< Applications to collect statistics from
 };
 
+/**
+ * \ingroup network-coding
+ * \brief Helper to install recoding relays on intermediate nodes
+ */
+class NetworkCodingRelayHelper
+{
+public:
+  /**
+   * \brief Create a new NetworkCodingRelayHelper
+   * \param nextHop Address (with port) the relays send recoded packets to
+   * \param port Local port the relays listen on
+   */
+  NetworkCodingRelayHelper (Address nextHop, uint16_t port);
+
+  /**
+   * \brief Set a parameter for the relays to be created
+   * \param name Name of the attribute to set
+   * \param value Value to set the attribute to
+   */
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * \brief Install a relay on a node
+   * \param node The node on which to install the relay
+   * \return Container with the created application
+   */
+  ApplicationContainer Install (Ptr<Node> node) const;
+
+  /**
+   * \brief Install relays on a set of nodes
+   * \param nodes The nodes on which to install the relays
+   * \return Container with the created applications
+   */
+  ApplicationContainer Install (NodeContainer nodes) const;
+
+private:
+  ObjectFactory m_factory;          //!< Factory for creating relays
+};
+
 } // namespace ns3
 
 #endif /* NETWORK_CODING_HELPER_H */
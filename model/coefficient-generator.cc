@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "coefficient-generator.h"
+
+namespace ns3 {
+
+namespace {
+
+uint32_t
+RotateLeft (uint32_t x, int k)
+{
+  return (x << k) | (x >> (32 - k));
+}
+
+uint64_t
+SplitMix64 (uint64_t &x)
+{
+  uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/**
+ * \brief Map 16 random bits to [0, n - 1] without a division
+ */
+uint32_t
+Reduce (uint32_t bits16, uint32_t n)
+{
+  return (bits16 * n) >> 16;
+}
+
+} // unnamed namespace
+
+CoefficientGenerator::CoefficientGenerator (uint32_t seed)
+{
+  // splitmix64 never yields an all-zero xoshiro state
+  uint64_t x = seed;
+  uint64_t a = SplitMix64 (x);
+  uint64_t b = SplitMix64 (x);
+  m_state[0] = static_cast<uint32_t> (a);
+  m_state[1] = static_cast<uint32_t> (a >> 32);
+  m_state[2] = static_cast<uint32_t> (b);
+  m_state[3] = static_cast<uint32_t> (b >> 32);
+}
+
+uint32_t
+CoefficientGenerator::Next (void)
+{
+  const uint32_t result = RotateLeft (m_state[1] * 5, 7) * 9;
+  const uint32_t t = m_state[1] << 9;
+
+  m_state[2] ^= m_state[0];
+  m_state[3] ^= m_state[1];
+  m_state[1] ^= m_state[2];
+  m_state[0] ^= m_state[3];
+  m_state[2] ^= t;
+  m_state[3] = RotateLeft (m_state[3], 11);
+
+  return result;
+}
+
+void
+CoefficientGenerator::Generate (uint32_t seed, uint8_t density, uint8_t *coefficients,
+                                size_t count, gf::FieldType field)
+{
+  CoefficientGenerator rng (seed);
+  const uint32_t maxElement = gf::GetMaxElement (field);
+
+  if (density == DENSE && field != gf::FIELD_BINARY)
+    {
+      // Two coefficients per draw
+      size_t i = 0;
+      for (; i + 1 < count; i += 2)
+        {
+          uint32_t r = rng.Next ();
+          coefficients[i] = 1 + Reduce (r >> 16, maxElement);
+          coefficients[i + 1] = 1 + Reduce (r & 0xffff, maxElement);
+        }
+      if (i < count)
+        {
+          coefficients[i] = 1 + Reduce (rng.Next () >> 16, maxElement);
+        }
+      return;
+    }
+
+  // The high half picks the value, the low half decides whether it is
+  // used. A dense binary code is uniform over {0, 1}.
+  const bool fair = (density == DENSE);
+  bool any = false;
+  for (size_t i = 0; i < count; i++)
+    {
+      uint32_t r = rng.Next ();
+      bool used = fair ? (r & 1) : (Reduce (r & 0xffff, DENSE) < density);
+      if (used)
+        {
+          coefficients[i] = 1 + Reduce (r >> 16, maxElement);
+          any = true;
+        }
+      else
+        {
+          coefficients[i] = 0;
+        }
+    }
+  if (!any && count > 0)
+    {
+      size_t index = rng.Next () % count;
+      coefficients[index] = 1 + Reduce (rng.Next () >> 16, maxElement);
+    }
+}
+
+uint8_t
+CoefficientGenerator::QuantizeDensity (double probability)
+{
+  double scaled = probability * DENSE + 0.5;
+  if (scaled >= DENSE)
+    {
+      return DENSE;
+    }
+  return scaled < 1 ? 1 : static_cast<uint8_t> (scaled);
+}
+
+} // namespace ns3
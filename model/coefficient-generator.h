@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COEFFICIENT_GENERATOR_H
+#define COEFFICIENT_GENERATOR_H
+
+#include "galois-field-traits.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief Deterministic generator for coding coefficients
+ *
+ * A xoshiro128** generator whose state is expanded from a 32-bit seed
+ * with splitmix64. Encoder and decoder obtain the same coefficient vector
+ * from the same seed, so a packet only needs to carry the seed. The
+ * sequence is fixed by this implementation and must not change, since it
+ * is part of the wire format.
+ */
+class CoefficientGenerator
+{
+public:
+  /**
+   * \brief Density value meaning every coefficient is nonzero
+   */
+  static const uint8_t DENSE = 255;
+
+  /**
+   * \brief Create a generator
+   * \param seed The seed carried in the packet header
+   */
+  explicit CoefficientGenerator (uint32_t seed);
+
+  /**
+   * \brief Get the next 32 random bits
+   * \return a uniformly distributed value
+   */
+  uint32_t Next (void);
+
+  /**
+   * \brief Fill a coefficient vector from a seed
+   * \param seed The seed carried in the packet header
+   * \param density Each coefficient is nonzero with probability density / 255
+   * \param coefficients Output buffer
+   * \param count Number of coefficients to generate
+   * \param field Field the coefficients belong to
+   *
+   * Nonzero coefficients are uniform over the nonzero field elements. In
+   * GF(2) the dense setting means each coefficient is 0 or 1 with equal
+   * probability. If a draw comes out all-zero, one coefficient is forced
+   * nonzero so that every coded packet carries information.
+   */
+  static void Generate (uint32_t seed, uint8_t density, uint8_t *coefficients, size_t count,
+                        gf::FieldType field = gf::FIELD_BINARY8);
+
+  /**
+   * \brief Convert a nonzero probability to the density carried in headers
+   * \param probability Probability in (0, 1]
+   * \return the density, at least 1
+   */
+  static uint8_t QuantizeDensity (double probability);
+
+private:
+  uint32_t m_state[4];                     //!< xoshiro128** state
+};
+
+} // namespace ns3
+
+#endif /* COEFFICIENT_GENERATOR_H */
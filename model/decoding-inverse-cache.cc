@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "decoding-inverse-cache.h"
+#include "ns3/assert.h"
+#include <cstring>
+
+namespace ns3 {
+
+// FNV-1a over the rows of a pattern, one coefficient per byte
+static const uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+static const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+DecodingInverseCache::DecodingInverseCache (uint32_t capacity)
+  : m_capacity (capacity),
+    m_hits (0),
+    m_misses (0)
+{
+  NS_ASSERT_MSG (capacity > 0, "An inverse cache needs room for at least one pattern");
+}
+
+uint64_t
+DecodingInverseCache::Begin (uint8_t field, uint16_t generationSize)
+{
+  // Patterns of different fields or sizes must never compare equal
+  const uint8_t shape[] = {field, static_cast<uint8_t> (generationSize >> 8),
+                           static_cast<uint8_t> (generationSize)};
+  return Extend (FNV_OFFSET, shape, sizeof (shape));
+}
+
+uint64_t
+DecodingInverseCache::Extend (uint64_t hash, const uint8_t *coefficients, uint16_t size)
+{
+  for (uint16_t i = 0; i < size; i++)
+    {
+      hash = (hash ^ coefficients[i]) * FNV_PRIME;
+    }
+  return hash;
+}
+
+bool
+DecodingInverseCache::IsKnownPrefix (uint64_t hash) const
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_prefixes.count (hash) > 0;
+}
+
+bool
+DecodingInverseCache::IsKnownRedundant (uint64_t hash) const
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_redundant.count (hash) > 0;
+}
+
+DecodingInverseCache::Inverse
+DecodingInverseCache::Lookup (uint64_t hash, const uint8_t *coefficients, size_t size)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  auto it = m_entries.find (hash);
+  if (it == m_entries.end () || it->second.coefficients.size () != size
+      || std::memcmp (it->second.coefficients.data (), coefficients, size) != 0)
+    {
+      return nullptr;
+    }
+  m_lru.splice (m_lru.begin (), m_lru, it->second.lru);
+  m_hits++;
+  return it->second.inverse;
+}
+
+void
+DecodingInverseCache::Insert (uint64_t hash, const uint8_t *coefficients, size_t size,
+                              Inverse inverse, const std::vector<uint64_t> &prefixes,
+                              const std::vector<uint64_t> &redundant)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  m_misses++;
+  if (m_entries.count (hash) > 0)
+    {
+      // Another decoder inverted the same pattern meanwhile, or two patterns
+      // collide; either way the entry held stays
+      return;
+    }
+  if (m_entries.size () >= m_capacity)
+    {
+      auto victim = m_entries.find (m_lru.back ());
+      Count (m_prefixes, victim->second.prefixes, false);
+      Count (m_redundant, victim->second.redundant, false);
+      m_entries.erase (victim);
+      m_lru.pop_back ();
+    }
+
+  m_lru.push_front (hash);
+  Entry &entry = m_entries[hash];
+  entry.coefficients.assign (coefficients, coefficients + size);
+  entry.inverse = inverse;
+  entry.prefixes = prefixes;
+  entry.redundant = redundant;
+  entry.lru = m_lru.begin ();
+  Count (m_prefixes, prefixes, true);
+  Count (m_redundant, redundant, true);
+}
+
+void
+DecodingInverseCache::Count (std::unordered_map<uint64_t, uint32_t> &known,
+                             const std::vector<uint64_t> &hashes, bool add)
+{
+  for (uint64_t hash : hashes)
+    {
+      if (add)
+        {
+          known[hash]++;
+          continue;
+        }
+      auto it = known.find (hash);
+      if (--it->second == 0)
+        {
+          known.erase (it);
+        }
+    }
+}
+
+uint64_t
+DecodingInverseCache::GetHits (void) const
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_hits;
+}
+
+uint64_t
+DecodingInverseCache::GetMisses (void) const
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_misses;
+}
+
+uint32_t
+DecodingInverseCache::GetSize (void) const
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_entries.size ();
+}
+
+uint32_t
+DecodingInverseCache::GetCapacity (void) const
+{
+  return m_capacity;
+}
+
+} // namespace ns3
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef DECODING_INVERSE_CACHE_H
+#define DECODING_INVERSE_CACHE_H
+
+#include "ns3/simple-ref-count.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief Inverses of coefficient matrices that recur across generations
+ *
+ * When the sender draws the same coefficient rows for every generation,
+ * e.g. with NetworkCodingEncoder::SetRepeatCoefficients, the decoders of
+ * successive generations mostly receive the same matrix and only the
+ * payloads differ. A NetworkCodingDecoder sharing this cache keeps the rows
+ * of such a generation as received and, at full rank, gets their source
+ * packets with one multiplication by the cached inverse instead of running
+ * the elimination over coefficients and payloads again.
+ *
+ * A pattern is the sequence of innovative coefficient rows in the order
+ * they arrived, identified by a 64-bit hash that is extended row by row.
+ * Besides the inverse of every full pattern, the cache knows the hash of
+ * each of its prefixes: a row that extends a known prefix is part of a
+ * basis seen before, so it is innovative without being reduced. The
+ * hashes of rows that arrived redundant in a cached pattern are kept as
+ * well, so they are dropped the same way. Lookup
+ * compares the whole matrix, so a hash collision costs an elimination, not
+ * a wrong decoding. The least recently used pattern is evicted first.
+ *
+ * All methods may be called from several threads at once.
+ */
+class DecodingInverseCache : public SimpleRefCount<DecodingInverseCache>
+{
+public:
+  /**
+   * \brief Row-major inverse of a pattern: row i holds the weights of the
+   *        received rows that sum to source packet i
+   */
+  typedef std::shared_ptr<const std::vector<uint8_t>> Inverse;
+
+  /**
+   * \brief Create an empty cache
+   * \param capacity Number of patterns kept, at least 1
+   */
+  explicit DecodingInverseCache (uint32_t capacity);
+
+  /**
+   * \brief Get the hash of the empty pattern
+   * \param field The coding field
+   * \param generationSize Columns of the coefficient rows
+   * \return the hash rows are appended to
+   */
+  static uint64_t Begin (uint8_t field, uint16_t generationSize);
+
+  /**
+   * \brief Append a coefficient row to a pattern hash
+   * \param hash Hash of the rows before
+   * \param coefficients The row, one coefficient per byte
+   * \param size Coefficients in the row
+   * \return the hash of the longer pattern
+   */
+  static uint64_t Extend (uint64_t hash, const uint8_t *coefficients, uint16_t size);
+
+  /**
+   * \brief Check whether some cached pattern starts with the given rows
+   * \param hash Hash of the rows
+   * \return true if a cached pattern has this prefix
+   */
+  bool IsKnownPrefix (uint64_t hash) const;
+
+  /**
+   * \brief Check whether a row was redundant after the same rows before
+   * \param hash Hash of the rows before extended with the row
+   * \return true if a cached pattern received the row as redundant there
+   */
+  bool IsKnownRedundant (uint64_t hash) const;
+
+  /**
+   * \brief Find the inverse of a full pattern
+   * \param hash Hash of the pattern
+   * \param coefficients The pattern, row-major
+   * \param size Bytes of coefficients
+   * \return the inverse, or nullptr if the pattern is not cached
+   */
+  Inverse Lookup (uint64_t hash, const uint8_t *coefficients, size_t size);
+
+  /**
+   * \brief Add the inverse of a pattern
+   * \param hash Hash of the pattern
+   * \param coefficients The pattern, row-major
+   * \param size Bytes of coefficients
+   * \param inverse Its inverse
+   * \param prefixes Hash after each row of the pattern, the last one being hash
+   * \param redundant Hashes of the redundant rows received with the pattern
+   */
+  void Insert (uint64_t hash, const uint8_t *coefficients, size_t size, Inverse inverse,
+               const std::vector<uint64_t> &prefixes, const std::vector<uint64_t> &redundant);
+
+  /**
+   * \brief Get the number of generations decoded with a cached inverse
+   * \return the hit count
+   */
+  uint64_t GetHits (void) const;
+
+  /**
+   * \brief Get the number of patterns that had to be inverted
+   * \return the number of insertions
+   */
+  uint64_t GetMisses (void) const;
+
+  /**
+   * \brief Get the number of patterns held
+   * \return the count, at most the capacity
+   */
+  uint32_t GetSize (void) const;
+
+  /**
+   * \brief Get the number of patterns the cache keeps
+   * \return the capacity
+   */
+  uint32_t GetCapacity (void) const;
+
+private:
+  /**
+   * \brief Count a pattern's hashes in a known-hash table
+   * \param known The table
+   * \param hashes The pattern's hashes
+   * \param add true to add the pattern, false to remove it
+   */
+  static void Count (std::unordered_map<uint64_t, uint32_t> &known,
+                     const std::vector<uint64_t> &hashes, bool add);
+
+  /**
+   * \brief One cached pattern
+   */
+  struct Entry
+  {
+    std::vector<uint8_t> coefficients;        //!< The pattern, to rule out collisions
+    Inverse inverse;                          //!< Its inverse
+    std::vector<uint64_t> prefixes;           //!< Hashes registered in m_prefixes
+    std::vector<uint64_t> redundant;          //!< Hashes registered in m_redundant
+    std::list<uint64_t>::iterator lru;        //!< Position in m_lru
+  };
+
+  uint32_t m_capacity;                                   //!< Patterns kept
+  std::unordered_map<uint64_t, Entry> m_entries;         //!< Patterns by hash
+  std::list<uint64_t> m_lru;                             //!< Pattern hashes, most recent first
+  std::unordered_map<uint64_t, uint32_t> m_prefixes;     //!< Prefix hash to number of patterns
+  std::unordered_map<uint64_t, uint32_t> m_redundant;    //!< Redundant row hash to number of patterns
+  mutable std::mutex m_mutex;                            //!< Protects everything above
+  uint64_t m_hits;                                       //!< Lookups that found the pattern
+  uint64_t m_misses;                                     //!< Patterns inserted
+};
+
+} // namespace ns3
+
+#endif /* DECODING_INVERSE_CACHE_H */
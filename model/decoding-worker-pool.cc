@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "decoding-worker-pool.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+DecodingWorkerPool::DecodingWorkerPool (uint32_t threads)
+  : m_stopping (false)
+{
+  NS_ASSERT_MSG (threads > 0, "A worker pool needs at least one thread");
+  m_workers.reserve (threads);
+  for (uint32_t i = 0; i < threads; i++)
+    {
+      m_workers.emplace_back (&DecodingWorkerPool::Run, this);
+    }
+}
+
+DecodingWorkerPool::~DecodingWorkerPool ()
+{
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stopping = true;
+  }
+  m_wakeup.notify_all ();
+  for (std::thread &worker : m_workers)
+    {
+      worker.join ();
+    }
+}
+
+std::future<void>
+DecodingWorkerPool::Submit (std::function<void (void)> job)
+{
+  std::packaged_task<void (void)> task (std::move (job));
+  std::future<void> done = task.get_future ();
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_jobs.push_back (std::move (task));
+  }
+  m_wakeup.notify_one ();
+  return done;
+}
+
+uint32_t
+DecodingWorkerPool::GetThreads (void) const
+{
+  return m_workers.size ();
+}
+
+void
+DecodingWorkerPool::Run (void)
+{
+  while (true)
+    {
+      std::packaged_task<void (void)> task;
+      {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_wakeup.wait (lock, [this] { return m_stopping || !m_jobs.empty (); });
+        // Drain the queue before stopping so no future is left unsatisfied
+        if (m_jobs.empty ())
+          {
+            return;
+          }
+        task = std::move (m_jobs.front ());
+        m_jobs.pop_front ();
+      }
+      task ();
+    }
+}
+
+} // namespace ns3
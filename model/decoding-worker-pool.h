@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef DECODING_WORKER_POOL_H
+#define DECODING_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief Fixed set of threads running decoding jobs off the simulator thread
+ *
+ * Jobs are run in submission order by whichever worker is free. A job must
+ * only touch state nobody else uses until it has finished, e.g. the
+ * NetworkCodingDecoder of a generation that no longer receives packets, and
+ * must not call into the simulator, logging or packet code. The returned
+ * future is how the simulator thread collects the result; waiting on it at
+ * a simulated time fixed in advance keeps runs deterministic however long
+ * the job actually takes.
+ */
+class DecodingWorkerPool
+{
+public:
+  /**
+   * \brief Start the workers
+   * \param threads Number of worker threads, at least 1
+   */
+  explicit DecodingWorkerPool (uint32_t threads);
+
+  /**
+   * \brief Finish the queued jobs and join the workers
+   */
+  ~DecodingWorkerPool ();
+
+  DecodingWorkerPool (const DecodingWorkerPool &) = delete;
+  DecodingWorkerPool &operator= (const DecodingWorkerPool &) = delete;
+
+  /**
+   * \brief Queue a job
+   * \param job The work to run on a worker thread
+   * \return a future that becomes ready when the job has run
+   */
+  std::future<void> Submit (std::function<void (void)> job);
+
+  /**
+   * \brief Get the number of worker threads
+   * \return the thread count
+   */
+  uint32_t GetThreads (void) const;
+
+private:
+  /**
+   * \brief Worker loop: run queued jobs until the pool is destroyed
+   */
+  void Run (void);
+
+  std::vector<std::thread> m_workers;                 //!< Worker threads
+  std::deque<std::packaged_task<void (void)>> m_jobs; //!< Jobs not started yet
+  std::mutex m_mutex;                                 //!< Protects m_jobs and m_stopping
+  std::condition_variable m_wakeup;                   //!< Signals new jobs or shutdown
+  bool m_stopping;                                    //!< Set by the destructor
+};
+
+} // namespace ns3
+
+#endif /* DECODING_WORKER_POOL_H */
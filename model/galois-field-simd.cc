@@ -0,0 +1,768 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "galois-field-simd.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define NC_GF_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define NC_GF_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace ns3 {
+namespace gf {
+
+namespace {
+
+/**
+ * Split-nibble product tables. For coefficient c, row c holds
+ * c*0x00..c*0x0f in bytes 0-15 and c*0x00..c*0xf0 in bytes 16-31.
+ */
+struct NibbleTables
+{
+  alignas (64) uint8_t table[256][32];
+};
+
+constexpr NibbleTables
+MakeNibbleTables (void)
+{
+  NibbleTables tables {};
+  for (uint16_t c = 0; c < 256; c++)
+    {
+      for (uint8_t x = 0; x < 16; x++)
+        {
+          tables.table[c][x] = Multiply (c, x);
+          tables.table[c][16 + x] = Multiply (c, x << 4);
+        }
+    }
+  return tables;
+}
+
+// Generated by the compiler, like the log/exp tables they derive from
+constexpr NibbleTables g_nibbleTables = MakeNibbleTables ();
+
+inline const NibbleTables &
+GetNibbleTables (void)
+{
+  return g_nibbleTables;
+}
+
+/**
+ * Split-nibble tables for GF(2^4) with polynomial x^4 + x + 1, where a
+ * byte holds two independent symbols. For coefficient c, row c holds c*x
+ * for each low-nibble symbol x in bytes 0-15 and the same products shifted
+ * into the high nibble in bytes 16-31, so the GF(2^8) kernels apply as is.
+ */
+struct Gf16Tables
+{
+  alignas (64) uint8_t table[16][32];
+  uint8_t product[16][16];
+  uint8_t inverse[16];
+
+  Gf16Tables ()
+  {
+    for (uint8_t c = 0; c < 16; c++)
+      {
+        for (uint8_t x = 0; x < 16; x++)
+          {
+            product[c][x] = SlowMultiply (c, x);
+            table[c][x] = product[c][x];
+            table[c][16 + x] = static_cast<uint8_t> (product[c][x] << 4);
+            if (product[c][x] == 1)
+              {
+                inverse[c] = x;
+              }
+          }
+      }
+    inverse[0] = 0;
+  }
+
+  static uint8_t SlowMultiply (uint8_t a, uint8_t b)
+  {
+    uint8_t p = 0;
+    while (b)
+      {
+        if (b & 1)
+          {
+            p ^= a;
+          }
+        a = (a & 0x8) ? static_cast<uint8_t> (((a << 1) ^ 0x3) & 0xf) : static_cast<uint8_t> (a << 1);
+        b >>= 1;
+      }
+    return p;
+  }
+};
+
+const Gf16Tables &
+GetGf16Tables (void)
+{
+  static const Gf16Tables tables;
+  return tables;
+}
+
+//----------------------------------------------------------------------------
+// Scalar kernels
+//----------------------------------------------------------------------------
+
+void
+ScalarMultiplyAdd (uint8_t *dst, const uint8_t *src, const uint8_t *tbl, size_t len)
+{
+  const uint8_t *lo = tbl;
+  const uint8_t *hi = tbl + 16;
+  for (size_t i = 0; i < len; i++)
+    {
+      dst[i] ^= lo[src[i] & 0x0f] ^ hi[src[i] >> 4];
+    }
+}
+
+void
+ScalarMultiply (uint8_t *dst, const uint8_t *tbl, size_t len)
+{
+  const uint8_t *lo = tbl;
+  const uint8_t *hi = tbl + 16;
+  for (size_t i = 0; i < len; i++)
+    {
+      dst[i] = lo[dst[i] & 0x0f] ^ hi[dst[i] >> 4];
+    }
+}
+
+void
+ScalarAdd (uint8_t *dst, const uint8_t *src, size_t len)
+{
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8)
+    {
+      uint64_t a;
+      uint64_t b;
+      std::memcpy (&a, dst + i, 8);
+      std::memcpy (&b, src + i, 8);
+      a ^= b;
+      std::memcpy (dst + i, &a, 8);
+    }
+  for (; i < len; i++)
+    {
+      dst[i] ^= src[i];
+    }
+}
+
+//----------------------------------------------------------------------------
+// x86 kernels
+//----------------------------------------------------------------------------
+
+#ifdef NC_GF_X86
+
+__attribute__ ((target ("ssse3"))) void
+Ssse3MultiplyAdd (uint8_t *dst, const uint8_t *src, const uint8_t *tbl, size_t len)
+{
+  const __m128i lo = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl));
+  const __m128i hi = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl + 16));
+  const __m128i mask = _mm_set1_epi8 (0x0f);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16)
+    {
+      __m128i s = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (src + i));
+      __m128i d = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (dst + i));
+      __m128i l = _mm_shuffle_epi8 (lo, _mm_and_si128 (s, mask));
+      __m128i h = _mm_shuffle_epi8 (hi, _mm_and_si128 (_mm_srli_epi64 (s, 4), mask));
+      d = _mm_xor_si128 (d, _mm_xor_si128 (l, h));
+      _mm_storeu_si128 (reinterpret_cast<__m128i *> (dst + i), d);
+    }
+  ScalarMultiplyAdd (dst + i, src + i, tbl, len - i);
+}
+
+__attribute__ ((target ("ssse3"))) void
+Ssse3Multiply (uint8_t *dst, const uint8_t *tbl, size_t len)
+{
+  const __m128i lo = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl));
+  const __m128i hi = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl + 16));
+  const __m128i mask = _mm_set1_epi8 (0x0f);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16)
+    {
+      __m128i d = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (dst + i));
+      __m128i l = _mm_shuffle_epi8 (lo, _mm_and_si128 (d, mask));
+      __m128i h = _mm_shuffle_epi8 (hi, _mm_and_si128 (_mm_srli_epi64 (d, 4), mask));
+      _mm_storeu_si128 (reinterpret_cast<__m128i *> (dst + i), _mm_xor_si128 (l, h));
+    }
+  ScalarMultiply (dst + i, tbl, len - i);
+}
+
+__attribute__ ((target ("ssse3"))) void
+Ssse3Add (uint8_t *dst, const uint8_t *src, size_t len)
+{
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16)
+    {
+      __m128i s = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (src + i));
+      __m128i d = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (dst + i));
+      _mm_storeu_si128 (reinterpret_cast<__m128i *> (dst + i), _mm_xor_si128 (d, s));
+    }
+  ScalarAdd (dst + i, src + i, len - i);
+}
+
+__attribute__ ((target ("avx2"))) void
+Avx2MultiplyAdd (uint8_t *dst, const uint8_t *src, const uint8_t *tbl, size_t len)
+{
+  const __m256i lo = _mm256_broadcastsi128_si256 (_mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl)));
+  const __m256i hi = _mm256_broadcastsi128_si256 (_mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl + 16)));
+  const __m256i mask = _mm256_set1_epi8 (0x0f);
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32)
+    {
+      __m256i s = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (src + i));
+      __m256i d = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (dst + i));
+      __m256i l = _mm256_shuffle_epi8 (lo, _mm256_and_si256 (s, mask));
+      __m256i h = _mm256_shuffle_epi8 (hi, _mm256_and_si256 (_mm256_srli_epi64 (s, 4), mask));
+      d = _mm256_xor_si256 (d, _mm256_xor_si256 (l, h));
+      _mm256_storeu_si256 (reinterpret_cast<__m256i *> (dst + i), d);
+    }
+  // The tail and the caller may use legacy SSE encodings, which stall
+  // while the upper halves of the YMM registers are dirty
+  _mm256_zeroupper ();
+  Ssse3MultiplyAdd (dst + i, src + i, tbl, len - i);
+}
+
+__attribute__ ((target ("avx2"))) void
+Avx2Multiply (uint8_t *dst, const uint8_t *tbl, size_t len)
+{
+  const __m256i lo = _mm256_broadcastsi128_si256 (_mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl)));
+  const __m256i hi = _mm256_broadcastsi128_si256 (_mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl + 16)));
+  const __m256i mask = _mm256_set1_epi8 (0x0f);
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32)
+    {
+      __m256i d = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (dst + i));
+      __m256i l = _mm256_shuffle_epi8 (lo, _mm256_and_si256 (d, mask));
+      __m256i h = _mm256_shuffle_epi8 (hi, _mm256_and_si256 (_mm256_srli_epi64 (d, 4), mask));
+      _mm256_storeu_si256 (reinterpret_cast<__m256i *> (dst + i), _mm256_xor_si256 (l, h));
+    }
+  _mm256_zeroupper ();
+  Ssse3Multiply (dst + i, tbl, len - i);
+}
+
+__attribute__ ((target ("avx2"))) void
+Avx2Add (uint8_t *dst, const uint8_t *src, size_t len)
+{
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32)
+    {
+      __m256i s = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (src + i));
+      __m256i d = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (dst + i));
+      _mm256_storeu_si256 (reinterpret_cast<__m256i *> (dst + i), _mm256_xor_si256 (d, s));
+    }
+  _mm256_zeroupper ();
+  Ssse3Add (dst + i, src + i, len - i);
+}
+
+// The all-ones maskz forms below are equivalent to the unmasked intrinsics
+// but avoid a spurious -Wuninitialized from some GCC 12 releases.
+__attribute__ ((target ("avx512f,avx512bw"))) void
+Avx512MultiplyAdd (uint8_t *dst, const uint8_t *src, const uint8_t *tbl, size_t len)
+{
+  const __m512i lo = _mm512_maskz_broadcast_i32x4 (0xffff, _mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl)));
+  const __m512i hi = _mm512_maskz_broadcast_i32x4 (0xffff, _mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl + 16)));
+  const __m512i mask = _mm512_set1_epi8 (0x0f);
+  size_t i = 0;
+  for (; i + 64 <= len; i += 64)
+    {
+      __m512i s = _mm512_loadu_si512 (src + i);
+      __m512i d = _mm512_loadu_si512 (dst + i);
+      __m512i l = _mm512_shuffle_epi8 (lo, _mm512_and_si512 (s, mask));
+      __m512i h = _mm512_shuffle_epi8 (hi, _mm512_and_si512 (_mm512_maskz_srli_epi64 (0xff, s, 4), mask));
+      d = _mm512_xor_si512 (d, _mm512_xor_si512 (l, h));
+      _mm512_storeu_si512 (dst + i, d);
+    }
+  Avx2MultiplyAdd (dst + i, src + i, tbl, len - i);
+}
+
+__attribute__ ((target ("avx512f,avx512bw"))) void
+Avx512Multiply (uint8_t *dst, const uint8_t *tbl, size_t len)
+{
+  const __m512i lo = _mm512_maskz_broadcast_i32x4 (0xffff, _mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl)));
+  const __m512i hi = _mm512_maskz_broadcast_i32x4 (0xffff, _mm_loadu_si128 (reinterpret_cast<const __m128i *> (tbl + 16)));
+  const __m512i mask = _mm512_set1_epi8 (0x0f);
+  size_t i = 0;
+  for (; i + 64 <= len; i += 64)
+    {
+      __m512i d = _mm512_loadu_si512 (dst + i);
+      __m512i l = _mm512_shuffle_epi8 (lo, _mm512_and_si512 (d, mask));
+      __m512i h = _mm512_shuffle_epi8 (hi, _mm512_and_si512 (_mm512_maskz_srli_epi64 (0xff, d, 4), mask));
+      _mm512_storeu_si512 (dst + i, _mm512_xor_si512 (l, h));
+    }
+  Avx2Multiply (dst + i, tbl, len - i);
+}
+
+__attribute__ ((target ("avx512f,avx512bw"))) void
+Avx512Add (uint8_t *dst, const uint8_t *src, size_t len)
+{
+  size_t i = 0;
+  for (; i + 64 <= len; i += 64)
+    {
+      __m512i s = _mm512_loadu_si512 (src + i);
+      __m512i d = _mm512_loadu_si512 (dst + i);
+      _mm512_storeu_si512 (dst + i, _mm512_xor_si512 (d, s));
+    }
+  Avx2Add (dst + i, src + i, len - i);
+}
+
+#endif /* NC_GF_X86 */
+
+//----------------------------------------------------------------------------
+// AArch64 kernels
+//----------------------------------------------------------------------------
+
+#ifdef NC_GF_NEON
+
+void
+NeonMultiplyAdd (uint8_t *dst, const uint8_t *src, const uint8_t *tbl, size_t len)
+{
+  const uint8x16_t lo = vld1q_u8 (tbl);
+  const uint8x16_t hi = vld1q_u8 (tbl + 16);
+  const uint8x16_t mask = vdupq_n_u8 (0x0f);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16)
+    {
+      uint8x16_t s = vld1q_u8 (src + i);
+      uint8x16_t l = vqtbl1q_u8 (lo, vandq_u8 (s, mask));
+      uint8x16_t h = vqtbl1q_u8 (hi, vshrq_n_u8 (s, 4));
+      vst1q_u8 (dst + i, veorq_u8 (vld1q_u8 (dst + i), veorq_u8 (l, h)));
+    }
+  ScalarMultiplyAdd (dst + i, src + i, tbl, len - i);
+}
+
+void
+NeonMultiply (uint8_t *dst, const uint8_t *tbl, size_t len)
+{
+  const uint8x16_t lo = vld1q_u8 (tbl);
+  const uint8x16_t hi = vld1q_u8 (tbl + 16);
+  const uint8x16_t mask = vdupq_n_u8 (0x0f);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16)
+    {
+      uint8x16_t d = vld1q_u8 (dst + i);
+      uint8x16_t l = vqtbl1q_u8 (lo, vandq_u8 (d, mask));
+      uint8x16_t h = vqtbl1q_u8 (hi, vshrq_n_u8 (d, 4));
+      vst1q_u8 (dst + i, veorq_u8 (l, h));
+    }
+  ScalarMultiply (dst + i, tbl, len - i);
+}
+
+void
+NeonAdd (uint8_t *dst, const uint8_t *src, size_t len)
+{
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16)
+    {
+      vst1q_u8 (dst + i, veorq_u8 (vld1q_u8 (dst + i), vld1q_u8 (src + i)));
+    }
+  ScalarAdd (dst + i, src + i, len - i);
+}
+
+#endif /* NC_GF_NEON */
+
+//----------------------------------------------------------------------------
+// Dispatch
+//----------------------------------------------------------------------------
+
+struct KernelTable
+{
+  RegionKernel kernel;
+  void (*multiplyAdd) (uint8_t *, const uint8_t *, const uint8_t *, size_t);
+  void (*multiply) (uint8_t *, const uint8_t *, size_t);
+  void (*add) (uint8_t *, const uint8_t *, size_t);
+};
+
+const KernelTable g_scalarKernels = {KERNEL_SCALAR, &ScalarMultiplyAdd, &ScalarMultiply, &ScalarAdd};
+#ifdef NC_GF_X86
+const KernelTable g_ssse3Kernels = {KERNEL_SSSE3, &Ssse3MultiplyAdd, &Ssse3Multiply, &Ssse3Add};
+const KernelTable g_avx2Kernels = {KERNEL_AVX2, &Avx2MultiplyAdd, &Avx2Multiply, &Avx2Add};
+const KernelTable g_avx512Kernels = {KERNEL_AVX512, &Avx512MultiplyAdd, &Avx512Multiply, &Avx512Add};
+#endif
+#ifdef NC_GF_NEON
+const KernelTable g_neonKernels = {KERNEL_NEON, &NeonMultiplyAdd, &NeonMultiply, &NeonAdd};
+#endif
+
+const KernelTable *
+FindKernels (RegionKernel kernel)
+{
+  switch (kernel)
+    {
+    case KERNEL_SCALAR:
+      return &g_scalarKernels;
+#ifdef NC_GF_X86
+    case KERNEL_SSSE3:
+      return __builtin_cpu_supports ("ssse3") ? &g_ssse3Kernels : nullptr;
+    case KERNEL_AVX2:
+      return __builtin_cpu_supports ("avx2") ? &g_avx2Kernels : nullptr;
+    case KERNEL_AVX512:
+      return (__builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512bw"))
+               ? &g_avx512Kernels : nullptr;
+#endif
+#ifdef NC_GF_NEON
+    case KERNEL_NEON:
+      return &g_neonKernels;
+#endif
+    case KERNEL_AUTO:
+      {
+        static const RegionKernel preference[] = {KERNEL_AVX512, KERNEL_AVX2, KERNEL_SSSE3, KERNEL_NEON};
+        for (RegionKernel candidate : preference)
+          {
+            if (const KernelTable *table = FindKernels (candidate))
+              {
+                return table;
+              }
+          }
+        return &g_scalarKernels;
+      }
+    default:
+      return nullptr;
+    }
+}
+
+std::atomic<const KernelTable *> &
+ActiveKernels (void)
+{
+  static std::atomic<const KernelTable *> active (FindKernels (KERNEL_AUTO));
+  return active;
+}
+
+inline const KernelTable *
+Kernels (void)
+{
+  return ActiveKernels ().load (std::memory_order_relaxed);
+}
+
+/**
+ * Threads that share the stripes of one batch. Workers sleep until a batch
+ * is posted, claim stripes from a shared counter together with the
+ * posting thread and report back; the poster returns once every worker
+ * has checked in, so a batch never outlives the call that posted it.
+ */
+class StripePool
+{
+public:
+  StripePool ()
+    : m_job (nullptr),
+      m_len (0),
+      m_stripe (0),
+      m_stripes (0),
+      m_next (0),
+      m_active (0),
+      m_epoch (0),
+      m_stopping (false)
+  {
+  }
+
+  ~StripePool ()
+  {
+    Stop ();
+  }
+
+  void Resize (uint32_t threads)
+  {
+    std::lock_guard<std::mutex> busy (m_busy);
+    Stop ();
+    m_stopping = false;
+    for (uint32_t i = 1; i < threads; i++)
+      {
+        // A worker may start after the first batch is posted, so it is
+        // told which epoch is current now rather than reading it later
+        m_workers.emplace_back (&StripePool::Work, this, m_epoch);
+      }
+  }
+
+  uint32_t GetThreads (void)
+  {
+    std::lock_guard<std::mutex> busy (m_busy);
+    return m_workers.empty () ? 0 : m_workers.size () + 1;
+  }
+
+  /// \return false if the pool is busy or has no workers
+  bool Run (size_t len, const std::function<void (size_t, size_t)> &job)
+  {
+    std::unique_lock<std::mutex> busy (m_busy, std::try_to_lock);
+    if (!busy.owns_lock () || m_workers.empty ())
+      {
+        return false;
+      }
+    
+    // Stripes stay multiples of the row alignment the kernels like best
+    size_t threads = m_workers.size () + 1;
+    size_t stripe = (len + threads - 1) / threads;
+    stripe = (stripe + 63) & ~static_cast<size_t> (63);
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
+      m_job = &job;
+      m_len = len;
+      m_stripe = stripe;
+      m_stripes = (len + stripe - 1) / stripe;
+      m_next.store (0);
+      m_active = m_workers.size ();
+      m_epoch++;
+    }
+    m_wakeup.notify_all ();
+    RunStripes ();
+    
+    std::unique_lock<std::mutex> lock (m_mutex);
+    m_done.wait (lock, [this] { return m_active == 0; });
+    m_job = nullptr;
+    return true;
+  }
+
+private:
+  void Stop (void)
+  {
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
+      m_stopping = true;
+    }
+    m_wakeup.notify_all ();
+    for (std::thread &worker : m_workers)
+      {
+        worker.join ();
+      }
+    m_workers.clear ();
+  }
+
+  void RunStripes (void)
+  {
+    size_t s;
+    while ((s = m_next.fetch_add (1)) < m_stripes)
+      {
+        size_t begin = s * m_stripe;
+        (*m_job) (begin, std::min (m_len, begin + m_stripe));
+      }
+  }
+
+  void Work (uint64_t seen)
+  {
+    std::unique_lock<std::mutex> lock (m_mutex);
+    while (true)
+      {
+        m_wakeup.wait (lock, [&] { return m_stopping || m_epoch != seen; });
+        if (m_stopping)
+          {
+            return;
+          }
+        seen = m_epoch;
+        lock.unlock ();
+        RunStripes ();
+        lock.lock ();
+        if (--m_active == 0)
+          {
+            m_done.notify_one ();
+          }
+      }
+  }
+
+  std::vector<std::thread> m_workers;
+  std::mutex m_busy;                   // Held by the thread posting a batch
+  std::mutex m_mutex;                  // Protects the batch description
+  std::condition_variable m_wakeup;
+  std::condition_variable m_done;
+  const std::function<void (size_t, size_t)> *m_job;
+  size_t m_len;
+  size_t m_stripe;
+  size_t m_stripes;
+  std::atomic<size_t> m_next;
+  size_t m_active;
+  uint64_t m_epoch;
+  bool m_stopping;
+};
+
+StripePool &
+GetStripePool (void)
+{
+  static StripePool pool;
+  return pool;
+}
+
+std::atomic<size_t> g_parallelThreshold (1 << 20);
+
+} // anonymous namespace
+
+void
+ForEachStripe (size_t len, size_t bytesTouched, const std::function<void (size_t, size_t)> &job)
+{
+  if (bytesTouched < g_parallelThreshold.load (std::memory_order_relaxed)
+      || !GetStripePool ().Run (len, job))
+    {
+      job (0, len);
+    }
+}
+
+void
+SetParallelRegionThreads (uint32_t threads)
+{
+  GetStripePool ().Resize (threads);
+}
+
+uint32_t
+GetParallelRegionThreads (void)
+{
+  return GetStripePool ().GetThreads ();
+}
+
+void
+SetParallelRegionThreshold (size_t bytes)
+{
+  g_parallelThreshold.store (bytes, std::memory_order_relaxed);
+}
+
+size_t
+GetParallelRegionThreshold (void)
+{
+  return g_parallelThreshold.load (std::memory_order_relaxed);
+}
+
+void
+MultiplyAddRegion (uint8_t *dst, const uint8_t *src, uint8_t coeff, size_t len)
+{
+  if (coeff == 0)
+    {
+      return;
+    }
+  if (coeff == 1)
+    {
+      Kernels ()->add (dst, src, len);
+      return;
+    }
+  Kernels ()->multiplyAdd (dst, src, GetNibbleTables ().table[coeff], len);
+}
+
+void
+MultiplyRegion (uint8_t *dst, uint8_t coeff, size_t len)
+{
+  if (coeff == 0)
+    {
+      std::memset (dst, 0, len);
+      return;
+    }
+  if (coeff == 1)
+    {
+      return;
+    }
+  Kernels ()->multiply (dst, GetNibbleTables ().table[coeff], len);
+}
+
+void
+AddRegion (uint8_t *dst, const uint8_t *src, size_t len)
+{
+  Kernels ()->add (dst, src, len);
+}
+
+void
+MultiplyAddRegion4 (uint8_t *dst, const uint8_t *src, uint8_t coeff, size_t len)
+{
+  if (coeff == 0)
+    {
+      return;
+    }
+  if (coeff == 1)
+    {
+      Kernels ()->add (dst, src, len);
+      return;
+    }
+  Kernels ()->multiplyAdd (dst, src, GetGf16Tables ().table[coeff & 0xf], len);
+}
+
+void
+MultiplyRegion4 (uint8_t *dst, uint8_t coeff, size_t len)
+{
+  if (coeff == 0)
+    {
+      std::memset (dst, 0, len);
+      return;
+    }
+  if (coeff == 1)
+    {
+      return;
+    }
+  Kernels ()->multiply (dst, GetGf16Tables ().table[coeff & 0xf], len);
+}
+
+uint8_t
+Multiply4 (uint8_t a, uint8_t b)
+{
+  return GetGf16Tables ().product[a & 0xf][b & 0xf];
+}
+
+uint8_t
+Inverse4 (uint8_t a)
+{
+  return GetGf16Tables ().inverse[a & 0xf];
+}
+
+bool
+SelectRegionKernel (RegionKernel kernel)
+{
+  const KernelTable *table = FindKernels (kernel);
+  if (!table)
+    {
+      return false;
+    }
+  ActiveKernels ().store (table, std::memory_order_relaxed);
+  return true;
+}
+
+RegionKernel
+GetRegionKernel (void)
+{
+  return Kernels ()->kernel;
+}
+
+bool
+IsRegionKernelSupported (RegionKernel kernel)
+{
+  return FindKernels (kernel) != nullptr;
+}
+
+std::string
+GetRegionKernelName (RegionKernel kernel)
+{
+  switch (kernel)
+    {
+    case KERNEL_AUTO:
+      return "auto";
+    case KERNEL_SCALAR:
+      return "scalar";
+    case KERNEL_SSSE3:
+      return "ssse3";
+    case KERNEL_AVX2:
+      return "avx2";
+    case KERNEL_AVX512:
+      return "avx512";
+    case KERNEL_NEON:
+      return "neon";
+    }
+  return "unknown";
+}
+
+} // namespace gf
+} // namespace ns3
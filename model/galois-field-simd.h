@@ -0,0 +1,202 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef GALOIS_FIELD_SIMD_H
+#define GALOIS_FIELD_SIMD_H
+
+#include "galois-field-tables.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief Region (whole-buffer) arithmetic over GF(2^8)
+ *
+ * These functions apply one field operation to every byte of a buffer.
+ * Multiplication uses the split-nibble method: for a coefficient c the
+ * products c*x for all 16 low nibbles and all 16 high nibbles are kept in
+ * two 16-byte tables, so each payload byte costs two table lookups and an
+ * XOR. On x86 the lookups are done 16/32/64 bytes at a time with
+ * SSSE3/AVX2/AVX-512BW byte shuffles and on AArch64 with NEON table
+ * lookups. The implementation is picked once at runtime from the CPU
+ * features and falls back to a portable scalar loop.
+ *
+ * All functions accept unaligned, non-overlapping buffers of any length.
+ *
+ * Batches of row operations over long payloads can optionally be split
+ * into column stripes that run on a small pool of threads, see
+ * SetParallelRegionThreads and ForEachStripe.
+ */
+namespace gf {
+
+/**
+ * \brief Available region kernel implementations
+ */
+enum RegionKernel
+{
+  KERNEL_AUTO,    //!< Best kernel supported by the running CPU
+  KERNEL_SCALAR,  //!< Portable table-driven loop
+  KERNEL_SSSE3,   //!< 128-bit x86 byte shuffles
+  KERNEL_AVX2,    //!< 256-bit x86 byte shuffles
+  KERNEL_AVX512,  //!< 512-bit x86 byte shuffles (AVX-512BW)
+  KERNEL_NEON     //!< 128-bit AArch64 table lookups
+};
+
+/**
+ * \brief Compute dst[i] = dst[i] + coeff * src[i] over GF(2^8)
+ * \param dst Destination buffer, updated in place
+ * \param src Source buffer
+ * \param coeff Field element multiplying the source
+ * \param len Number of bytes in both buffers
+ */
+void MultiplyAddRegion (uint8_t *dst, const uint8_t *src, uint8_t coeff, size_t len);
+
+/**
+ * \brief Compute dst[i] = coeff * dst[i] over GF(2^8)
+ * \param dst Buffer, updated in place
+ * \param coeff Field element multiplying the buffer
+ * \param len Number of bytes in the buffer
+ */
+void MultiplyRegion (uint8_t *dst, uint8_t coeff, size_t len);
+
+/**
+ * \brief Compute dst[i] = dst[i] + src[i] over GF(2^8) (byte-wise XOR)
+ * \param dst Destination buffer, updated in place
+ * \param src Source buffer
+ * \param len Number of bytes in both buffers
+ */
+void AddRegion (uint8_t *dst, const uint8_t *src, size_t len);
+
+/**
+ * \brief Compute dst[i] = dst[i] + coeff * src[i] over GF(2^4)
+ * \param dst Destination buffer, updated in place
+ * \param src Source buffer
+ * \param coeff Field element (0-15) multiplying the source
+ * \param len Number of bytes in both buffers
+ *
+ * Each byte holds two symbols, one per nibble. The same shuffle kernels as
+ * for GF(2^8) are used, with GF(2^4) product tables.
+ */
+void MultiplyAddRegion4 (uint8_t *dst, const uint8_t *src, uint8_t coeff, size_t len);
+
+/**
+ * \brief Compute dst[i] = coeff * dst[i] over GF(2^4), two symbols per byte
+ * \param dst Buffer, updated in place
+ * \param coeff Field element (0-15) multiplying the buffer
+ * \param len Number of bytes in the buffer
+ */
+void MultiplyRegion4 (uint8_t *dst, uint8_t coeff, size_t len);
+
+// Scalar GF(2^8) Multiply, Divide and Inverse are constexpr, see
+// galois-field-tables.h
+
+/**
+ * \brief Multiply two elements of GF(2^4)
+ * \param a First element (0-15)
+ * \param b Second element (0-15)
+ * \return a * b
+ */
+uint8_t Multiply4 (uint8_t a, uint8_t b);
+
+/**
+ * \brief Get the multiplicative inverse in GF(2^4)
+ * \param a A nonzero element (1-15)
+ * \return a^-1 (0 for 0)
+ */
+uint8_t Inverse4 (uint8_t a);
+
+/**
+ * \brief One row operation of a batch
+ *
+ * dst += coeff * src, or dst *= coeff if src is null. The buffers are
+ * payload rows that all have the length given to the batch.
+ */
+struct RegionOp
+{
+  uint8_t *dst;        //!< Row updated in place
+  const uint8_t *src;  //!< Row added to dst, or null to scale dst
+  uint8_t coeff;       //!< Field element
+};
+
+/**
+ * \brief Run a batch of row operations over [0, len), striped if enabled
+ * \param len Length of every row touched by the batch, in bytes
+ * \param bytesTouched Total bytes the batch processes (len times the
+ *        number of operations), to decide whether striping pays off
+ * \param job Called with disjoint [begin, end) byte ranges covering [0, len)
+ *
+ * Field operations on different columns are independent, so a batch can
+ * be applied stripe by stripe as long as every stripe sees all operations
+ * in order. With parallel regions enabled and bytesTouched at least the
+ * threshold, the stripes are shared between the pool and the calling
+ * thread; otherwise job (0, len) is called directly. One batch runs on the
+ * pool at a time, and a batch submitted while it is busy runs on the
+ * calling thread alone.
+ */
+void ForEachStripe (size_t len, size_t bytesTouched,
+                    const std::function<void (size_t, size_t)> &job);
+
+/**
+ * \brief Set the number of threads striped batches run on
+ * \param threads Threads including the caller; 0 or 1 disables striping
+ */
+void SetParallelRegionThreads (uint32_t threads);
+uint32_t GetParallelRegionThreads (void);
+
+/**
+ * \brief Set the smallest batch, in bytes touched, that is striped
+ * \param bytes Threshold; smaller batches never pay the synchronization
+ */
+void SetParallelRegionThreshold (size_t bytes);
+size_t GetParallelRegionThreshold (void);
+
+/**
+ * \brief Force a specific kernel, e.g. to compare implementations
+ * \param kernel The kernel to use; KERNEL_AUTO restores CPU detection
+ * \return false if the kernel is not supported here (selection unchanged)
+ */
+bool SelectRegionKernel (RegionKernel kernel);
+
+/**
+ * \brief Get the kernel currently used by the region functions
+ * \return the active kernel (never KERNEL_AUTO)
+ */
+RegionKernel GetRegionKernel (void);
+
+/**
+ * \brief Check whether a kernel can run on this build and CPU
+ * \param kernel The kernel to check
+ * \return true if the kernel can be selected
+ */
+bool IsRegionKernelSupported (RegionKernel kernel);
+
+/**
+ * \brief Get a printable name for a kernel
+ * \param kernel The kernel
+ * \return the kernel name, e.g. "avx2"
+ */
+std::string GetRegionKernelName (RegionKernel kernel);
+
+} // namespace gf
+} // namespace ns3
+
+#endif /* GALOIS_FIELD_SIMD_H */
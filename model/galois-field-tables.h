@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef GALOIS_FIELD_TABLES_H
+#define GALOIS_FIELD_TABLES_H
+
+#include <cstdint>
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief Compile-time GF(2^8) lookup tables and scalar arithmetic
+ *
+ * The log/exp tables for the module polynomial x^8 + x^4 + x^3 + x^2 + 1
+ * (0x11d) are generated by the compiler, so they live in read-only data
+ * shared by the whole process and cost nothing at startup. The exp table
+ * is stored twice over, so a sum or difference of two logarithms indexes
+ * it directly without a modulo.
+ *
+ * Configuring with NS3_NETWORK_CODING_FULL_MULTIPLY_TABLE replaces the
+ * log/exp multiply by a 64 KiB product table: one load per product
+ * instead of three and a zero test, at the price of more cache. With
+ * clang the table may need a larger -fconstexpr-steps.
+ */
+namespace gf {
+
+/**
+ * \brief Logarithm and doubled exponentiation tables
+ */
+struct LogExpTables
+{
+  uint8_t log[256];    //!< log[a] for a != 0; log[0] is unused
+  uint8_t exp[512];    //!< exp[i] = alpha^(i mod 255)
+};
+
+/**
+ * \brief Build the log/exp tables
+ * \return the tables for the generator alpha = 2
+ */
+constexpr LogExpTables
+MakeLogExpTables (void)
+{
+  LogExpTables tables {};
+  uint16_t x = 1;
+  for (uint16_t i = 0; i < 255; i++)
+    {
+      tables.exp[i] = static_cast<uint8_t> (x);
+      tables.log[x] = static_cast<uint8_t> (i);
+      x <<= 1;
+      if (x & 0x100)
+        {
+          x ^= 0x11d;
+        }
+    }
+  for (uint16_t i = 255; i < 512; i++)
+    {
+      tables.exp[i] = tables.exp[i - 255];
+    }
+  return tables;
+}
+
+/**
+ * \brief The process-wide log/exp tables
+ */
+inline constexpr LogExpTables g_logExpTables = MakeLogExpTables ();
+
+#ifdef NS3_NETWORK_CODING_FULL_MULTIPLY_TABLE
+/**
+ * \brief Full product table, product[a][b] = a * b
+ */
+struct MultiplyTable
+{
+  uint8_t product[256][256];
+};
+
+/**
+ * \brief Build the full product table from the log/exp tables
+ * \return the table
+ */
+constexpr MultiplyTable
+MakeMultiplyTable (void)
+{
+  MultiplyTable table {};
+  for (uint16_t a = 1; a < 256; a++)
+    {
+      for (uint16_t b = 1; b < 256; b++)
+        {
+          table.product[a][b] = g_logExpTables.exp[g_logExpTables.log[a] + g_logExpTables.log[b]];
+        }
+    }
+  return table;
+}
+
+/**
+ * \brief The process-wide product table
+ */
+inline constexpr MultiplyTable g_multiplyTable = MakeMultiplyTable ();
+#endif
+
+/**
+ * \brief Multiply two elements of GF(2^8)
+ * \param a First element
+ * \param b Second element
+ * \return a * b
+ */
+constexpr uint8_t
+Multiply (uint8_t a, uint8_t b)
+{
+#ifdef NS3_NETWORK_CODING_FULL_MULTIPLY_TABLE
+  return g_multiplyTable.product[a][b];
+#else
+  return (a == 0 || b == 0) ? 0 : g_logExpTables.exp[g_logExpTables.log[a] + g_logExpTables.log[b]];
+#endif
+}
+
+/**
+ * \brief Divide two elements of GF(2^8)
+ * \param a Dividend
+ * \param b A nonzero divisor
+ * \return a / b (0 if either is 0)
+ */
+constexpr uint8_t
+Divide (uint8_t a, uint8_t b)
+{
+  return (a == 0 || b == 0) ? 0 : g_logExpTables.exp[g_logExpTables.log[a] + 255 - g_logExpTables.log[b]];
+}
+
+/**
+ * \brief Get the multiplicative inverse in GF(2^8)
+ * \param a A nonzero element
+ * \return a^-1 (0 for 0)
+ */
+constexpr uint8_t
+Inverse (uint8_t a)
+{
+  return a == 0 ? 0 : g_logExpTables.exp[255 - g_logExpTables.log[a]];
+}
+
+} // namespace gf
+} // namespace ns3
+
+#endif /* GALOIS_FIELD_TABLES_H */
@@ -0,0 +1,245 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef GALOIS_FIELD_TRAITS_H
+#define GALOIS_FIELD_TRAITS_H
+
+#include "galois-field-simd.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ns3 {
+namespace gf {
+
+/**
+ * \ingroup network-coding
+ * \brief Finite fields the coding engines can work in
+ *
+ * The value is the number of bits per symbol. Payload bytes hold 8, 2 or
+ * 1 symbols; coefficients hold one symbol per byte in memory and are
+ * packed on the wire.
+ */
+enum FieldType
+{
+  FIELD_BINARY = 1,    //!< GF(2): coefficients are bits, arithmetic is XOR
+  FIELD_BINARY4 = 4,   //!< GF(2^4) with polynomial x^4 + x + 1
+  FIELD_BINARY8 = 8    //!< GF(2^8) with polynomial 0x11d
+};
+
+/**
+ * \ingroup network-coding
+ * \brief GF(2) arithmetic
+ *
+ * The only nonzero coefficient is 1, so every row operation is a plain
+ * word-wide XOR and normalization is a no-op.
+ */
+struct Binary
+{
+  static const FieldType TYPE = FIELD_BINARY;
+  static const uint8_t MAX_ELEMENT = 1;
+
+  static uint8_t Multiply (uint8_t a, uint8_t b)
+  {
+    return a & b;
+  }
+  static uint8_t Inverse (uint8_t a)
+  {
+    return a;
+  }
+  static void MultiplyAddRegion (uint8_t *dst, const uint8_t *src, uint8_t coeff, size_t len)
+  {
+    if (coeff)
+      {
+        AddRegion (dst, src, len);
+      }
+  }
+  static void MultiplyRegion (uint8_t *dst, uint8_t coeff, size_t len)
+  {
+    if (!coeff)
+      {
+        std::memset (dst, 0, len);
+      }
+  }
+};
+
+/**
+ * \ingroup network-coding
+ * \brief GF(2^4) arithmetic, two payload symbols per byte
+ */
+struct Binary4
+{
+  static const FieldType TYPE = FIELD_BINARY4;
+  static const uint8_t MAX_ELEMENT = 15;
+
+  static uint8_t Multiply (uint8_t a, uint8_t b)
+  {
+    return Multiply4 (a, b);
+  }
+  static uint8_t Inverse (uint8_t a)
+  {
+    return Inverse4 (a);
+  }
+  static void MultiplyAddRegion (uint8_t *dst, const uint8_t *src, uint8_t coeff, size_t len)
+  {
+    MultiplyAddRegion4 (dst, src, coeff, len);
+  }
+  static void MultiplyRegion (uint8_t *dst, uint8_t coeff, size_t len)
+  {
+    MultiplyRegion4 (dst, coeff, len);
+  }
+};
+
+/**
+ * \ingroup network-coding
+ * \brief GF(2^8) arithmetic, the same field as GaloisField
+ */
+struct Binary8
+{
+  static const FieldType TYPE = FIELD_BINARY8;
+  static const uint8_t MAX_ELEMENT = 255;
+
+  static uint8_t Multiply (uint8_t a, uint8_t b)
+  {
+    return gf::Multiply (a, b);
+  }
+  static uint8_t Inverse (uint8_t a)
+  {
+    return gf::Inverse (a);
+  }
+  static void MultiplyAddRegion (uint8_t *dst, const uint8_t *src, uint8_t coeff, size_t len)
+  {
+    gf::MultiplyAddRegion (dst, src, coeff, len);
+  }
+  static void MultiplyRegion (uint8_t *dst, uint8_t coeff, size_t len)
+  {
+    gf::MultiplyRegion (dst, coeff, len);
+  }
+};
+
+/**
+ * \brief Apply a batch of row operations to the columns [begin, end)
+ * \param ops The operations, applied in order
+ * \param count Number of operations
+ * \param begin First column
+ * \param end One past the last column
+ */
+template <class Field>
+void
+ApplyRegionOpsRange (const RegionOp *ops, size_t count, size_t begin, size_t end)
+{
+  for (size_t k = 0; k < count; k++)
+    {
+      if (ops[k].src)
+        {
+          Field::MultiplyAddRegion (ops[k].dst + begin, ops[k].src + begin, ops[k].coeff, end - begin);
+        }
+      else
+        {
+          Field::MultiplyRegion (ops[k].dst + begin, ops[k].coeff, end - begin);
+        }
+    }
+}
+
+/**
+ * \brief Apply a batch of row operations in a field
+ * \param ops The operations, applied in order
+ * \param count Number of operations
+ * \param len Length of every row, in bytes
+ *
+ * Long batches are split into column stripes running on the parallel
+ * region threads, see ForEachStripe.
+ */
+template <class Field>
+void
+ApplyRegionOps (const RegionOp *ops, size_t count, size_t len)
+{
+  if (count == 0)
+    {
+      return;
+    }
+  ForEachStripe (len, count * len, [ops, count] (size_t begin, size_t end) {
+    ApplyRegionOpsRange<Field> (ops, count, begin, end);
+  });
+}
+
+/**
+ * \brief Apply a batch of row operations one column block at a time
+ * \param ops The operations, applied in order
+ * \param count Number of operations
+ * \param len Length of every row, in bytes
+ * \param blockSize Columns every operation is applied to before moving on
+ *
+ * All operations run on one block of columns before the next block is
+ * started. If the operations touching one source row are adjacent, that
+ * source block is read once for all its destinations, and the destination
+ * blocks stay in cache across sources as long as they fit together.
+ */
+template <class Field>
+void
+ApplyRegionOps (const RegionOp *ops, size_t count, size_t len, size_t blockSize)
+{
+  if (count == 0)
+    {
+      return;
+    }
+  ForEachStripe (len, count * len, [ops, count, blockSize] (size_t begin, size_t end) {
+    for (size_t block = begin; block < end; block += blockSize)
+      {
+        ApplyRegionOpsRange<Field> (ops, count, block, std::min (end, block + blockSize));
+      }
+  });
+}
+
+/**
+ * \brief Check that a value names a supported field
+ * \param field The value to check
+ * \return true for FIELD_BINARY, FIELD_BINARY4 and FIELD_BINARY8
+ */
+inline bool
+IsValidField (uint8_t field)
+{
+  return field == FIELD_BINARY || field == FIELD_BINARY4 || field == FIELD_BINARY8;
+}
+
+/**
+ * \brief Get the largest element of a field
+ * \param field The field
+ * \return 2^bits - 1
+ */
+inline uint8_t
+GetMaxElement (FieldType field)
+{
+  return static_cast<uint8_t> ((1u << field) - 1);
+}
+
+/**
+ * \brief Get the number of bytes needed for packed coefficients
+ * \param field The field
+ * \param count Number of coefficients
+ * \return ceil (count * bits / 8)
+ */
+inline size_t
+GetPackedSize (FieldType field, size_t count)
+{
+  return (count * field + 7) / 8;
+}
+
+} // namespace gf
+} // namespace ns3
+
+#endif /* GALOIS_FIELD_TRAITS_H */
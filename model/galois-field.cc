@@ -19,6 +19,7 @@
   */
 
   #include "galois-field.h"
+  #include "galois-field-simd.h"
   #include "ns3/log.h"
 
   namespace ns3 {
@@ -38,11 +39,8 @@
   }
 
   GaloisField::GaloisField ()
-    : m_logTable(FIELD_SIZE, 0),
-      m_expTable(2 * FIELD_SIZE, 0)
   {
     NS_LOG_FUNCTION (this);
-    InitTables ();
   }
 
   GaloisField::~GaloisField ()
@@ -50,53 +48,6 @@
     NS_LOG_FUNCTION (this);
   }
 
-  void 
-  GaloisField::InitTables (void)
-  {
-    NS_LOG_FUNCTION (this);
-    
-    // Using primitive polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11d)
-    const uint16_t poly = 0x11d;
-    uint16_t x = 1;
-    
-    // Generate the exponential table
-    for (uint16_t i = 0; i < FIELD_SIZE - 1; i++) {
-      m_expTable[i] = static_cast<uint8_t>(x);
-      
-      // Find log by inverse lookup
-      m_logTable[x] = i;
-      
-      // Multiply by the primitive element
-      x = x << 1;
-      if (x & 0x100) {
-        x = (x ^ poly) & 0xff;
-      }
-    }
-    
-    // Set special case for log[0]
-    m_logTable[0] = 0; // Log of 0 is undefined, but we set it to 0
-    
-    // Extend the exp table for easier computation
-    for (uint16_t i = FIELD_SIZE - 1; i < 2 * FIELD_SIZE - 1; i++) {
-      m_expTable[i] = m_expTable[i - (FIELD_SIZE - 1)];
-    }
-    
-    // Log debug info only once during initialization
-    static bool debugPrinted = false;
-    if (!debugPrinted) {
-      std::cout << "DEBUG: GF Exp table initialized:" << std::endl;
-      for (int i = 0; i < 10; i++) {
-        std::cout << "  Exp[" << i << "] = " << (int)m_expTable[i] << std::endl;
-      }
-      
-      std::cout << "DEBUG: GF Log table initialized:" << std::endl;
-      for (int i = 0; i < 10; i++) {
-        std::cout << "  Log[" << i << "] = " << (int)m_logTable[i] << std::endl;
-      }
-      debugPrinted = true;
-    }
-  }
-
   uint8_t 
   GaloisField::Add (uint8_t a, uint8_t b)
   {
@@ -114,21 +65,7 @@
   uint8_t 
   GaloisField::Multiply (uint8_t a, uint8_t b)
   {
-    // Special case for 0
-    if (a == 0 || b == 0) {
-      return 0;
-    }
-    
-    // Use log/exp for multiplication
-    // a * b = exp(log(a) + log(b))
-    uint16_t sum = m_logTable[a] + m_logTable[b];
-    
-    // Take the modulo for the finite field
-    if (sum >= FIELD_SIZE - 1) {
-      sum = sum % (FIELD_SIZE - 1);
-    }
-    
-    return m_expTable[sum];
+    return gf::Multiply (a, b);
   }
 
   uint8_t 
@@ -139,19 +76,7 @@
       return 0;
     }
     
-    if (a == 0) {
-      return 0;
-    }
-    
-    // a / b = exp(log(a) - log(b))
-    int16_t diff = (int16_t)m_logTable[a] - (int16_t)m_logTable[b];
-    
-    // Ensure the result is non-negative
-    if (diff < 0) {
-      diff += (FIELD_SIZE - 1);
-    }
-    
-    return m_expTable[diff];
+    return gf::Divide (a, b);
   }
 
   uint8_t 
@@ -162,10 +87,25 @@
       return 0;
     }
     
-    // inv(a) = exp(-log(a)) = exp((FIELD_SIZE-1) - log(a))
-    uint16_t index = (FIELD_SIZE - 1) - m_logTable[a];
-    
-    return m_expTable[index];
+    return gf::Inverse (a);
+  }
+
+  void
+  GaloisField::MultiplyAddRegion (uint8_t *dst, const uint8_t *src, uint8_t coeff, size_t len)
+  {
+    gf::MultiplyAddRegion (dst, src, coeff, len);
+  }
+
+  void
+  GaloisField::MultiplyRegion (uint8_t *dst, uint8_t coeff, size_t len)
+  {
+    gf::MultiplyRegion (dst, coeff, len);
+  }
+
+  void
+  GaloisField::AddRegion (uint8_t *dst, const uint8_t *src, size_t len)
+  {
+    gf::AddRegion (dst, src, len);
   }
 
   } // namespace ns3
\ No newline at end of file
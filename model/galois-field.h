@@ -34,6 +34,10 @@ namespace ns3 {
  * for network coding operations. Galois field arithmetic is different from
  * standard integer arithmetic and is essential for ensuring that coded packets
  * can be properly decoded.
+ *
+ * The class is a thin wrapper around the constexpr tables and free
+ * functions of galois-field-tables.h and galois-field-simd.h, which hot
+ * loops should call directly instead of going through a Ptr.
  */
 class GaloisField : public Object
 {
@@ -46,8 +50,6 @@ public:
 
   /**
    * \brief Default constructor for GaloisField
-   *
-   * Initializes the lookup tables used for Galois field operations
    */
   GaloisField ();
 
@@ -82,7 +84,7 @@ public:
    * \param b Second operand
    * \return a * b in GF(2^8)
    *
-   * Multiplication is performed using logarithm tables to improve performance
+   * Multiplication is performed using compile-time logarithm tables
    */
   uint8_t Multiply (uint8_t a, uint8_t b);
 
@@ -103,26 +105,32 @@ public:
    */
   uint8_t Inverse (uint8_t a);
 
-private:
-  /**
-   * \brief Initialize lookup tables for Galois field operations
-   */
-  void InitTables (void);
-
   /**
-   * \brief Field size constant (2^8 = 256)
+   * \brief Multiply a buffer by a constant and add it to another buffer
+   * \param dst Destination buffer, dst[i] += coeff * src[i]
+   * \param src Source buffer
+   * \param coeff Field element multiplying the source
+   * \param len Number of bytes in both buffers
+   *
+   * Uses the vectorized kernels from galois-field-simd.h
    */
-  static const uint16_t FIELD_SIZE = 256; // GF(2^8)
+  void MultiplyAddRegion (uint8_t *dst, const uint8_t *src, uint8_t coeff, size_t len);
 
   /**
-   * \brief Logarithm lookup table
+   * \brief Multiply a buffer by a constant in place
+   * \param dst Buffer, dst[i] = coeff * dst[i]
+   * \param coeff Field element multiplying the buffer
+   * \param len Number of bytes in the buffer
    */
-  std::vector<uint8_t> m_logTable;
+  void MultiplyRegion (uint8_t *dst, uint8_t coeff, size_t len);
 
   /**
-   * \brief Exponentiation lookup table
+   * \brief Add a buffer to another buffer
+   * \param dst Destination buffer, dst[i] += src[i]
+   * \param src Source buffer
+   * \param len Number of bytes in both buffers
    */
-  std::vector<uint8_t> m_expTable;
+  void AddRegion (uint8_t *dst, const uint8_t *src, size_t len);
 };
 
 } // namespace ns3
@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "generation-buffer.h"
+#include "ns3/assert.h"
+#include <cstring>
+#include <new>
+#include <numeric>
+
+namespace ns3 {
+
+GenerationBuffer::GenerationBuffer ()
+  : m_slab (nullptr),
+    m_capacity (0),
+    m_rows (0),
+    m_coefficientSize (0),
+    m_payloadSize (0),
+    m_payloadOffset (0),
+    m_stride (0)
+{
+}
+
+GenerationBuffer::GenerationBuffer (uint32_t rows, uint32_t coefficientSize, uint32_t payloadSize)
+  : GenerationBuffer ()
+{
+  Resize (rows, coefficientSize, payloadSize);
+}
+
+GenerationBuffer::~GenerationBuffer ()
+{
+  if (m_slab)
+    {
+      ::operator delete[] (m_slab, std::align_val_t (ALIGNMENT));
+    }
+}
+
+size_t
+GenerationBuffer::Align (size_t size)
+{
+  return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+void
+GenerationBuffer::Resize (uint32_t rows, uint32_t coefficientSize, uint32_t payloadSize)
+{
+  m_rows = rows;
+  m_coefficientSize = coefficientSize;
+  m_payloadSize = payloadSize;
+  m_payloadOffset = Align (coefficientSize);
+  m_stride = m_payloadOffset + Align (payloadSize);
+
+  size_t needed = m_stride * m_rows;
+  if (needed > m_capacity)
+    {
+      if (m_slab)
+        {
+          ::operator delete[] (m_slab, std::align_val_t (ALIGNMENT));
+        }
+      m_slab = static_cast<uint8_t *> (::operator new[] (needed, std::align_val_t (ALIGNMENT)));
+      m_capacity = needed;
+    }
+
+  m_permutation.resize (m_rows);
+  Clear ();
+}
+
+void
+GenerationBuffer::Clear (void)
+{
+  if (m_slab)
+    {
+      std::memset (m_slab, 0, m_stride * m_rows);
+    }
+  std::iota (m_permutation.begin (), m_permutation.end (), 0);
+}
+
+void
+GenerationBuffer::ZeroRow (uint32_t row)
+{
+  NS_ASSERT (row < m_rows);
+  std::memset (PhysicalRow (row), 0, m_stride);
+}
+
+void
+GenerationBuffer::SwapRows (uint32_t a, uint32_t b)
+{
+  NS_ASSERT (a < m_rows && b < m_rows);
+  std::swap (m_permutation[a], m_permutation[b]);
+}
+
+uint32_t
+GenerationBuffer::GetRows (void) const
+{
+  return m_rows;
+}
+
+uint32_t
+GenerationBuffer::GetCoefficientSize (void) const
+{
+  return m_coefficientSize;
+}
+
+uint32_t
+GenerationBuffer::GetPayloadSize (void) const
+{
+  return m_payloadSize;
+}
+
+size_t
+GenerationBuffer::GetStride (void) const
+{
+  return m_stride;
+}
+
+} // namespace ns3
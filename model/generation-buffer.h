@@ -0,0 +1,175 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef GENERATION_BUFFER_H
+#define GENERATION_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief Contiguous storage for the rows of one generation
+ *
+ * All rows live in a single 64-byte aligned slab. Each row is laid out as
+ * [coefficients | payload]; both sections are padded to a multiple of 64
+ * bytes so that every coefficient vector and every payload starts on a
+ * cache line, which is what the GF region kernels work best on. Either
+ * section may be empty (e.g. an encoder only stores payloads).
+ *
+ * Rows are addressed by logical index. SwapRows only exchanges two entries
+ * of a permutation table, so reordering rows during elimination never
+ * moves row data.
+ */
+class GenerationBuffer
+{
+public:
+  /**
+   * \brief Alignment of the slab and of every row section, in bytes
+   */
+  static const size_t ALIGNMENT = 64;
+
+  /**
+   * \brief Create an empty buffer
+   */
+  GenerationBuffer ();
+
+  /**
+   * \brief Create a buffer with the given shape (contents zeroed)
+   * \param rows Number of rows
+   * \param coefficientSize Bytes in the coefficient section of a row
+   * \param payloadSize Bytes in the payload section of a row
+   */
+  GenerationBuffer (uint32_t rows, uint32_t coefficientSize, uint32_t payloadSize);
+
+  ~GenerationBuffer ();
+
+  GenerationBuffer (const GenerationBuffer &) = delete;
+  GenerationBuffer &operator= (const GenerationBuffer &) = delete;
+
+  /**
+   * \brief Change the shape of the buffer
+   * \param rows Number of rows
+   * \param coefficientSize Bytes in the coefficient section of a row
+   * \param payloadSize Bytes in the payload section of a row
+   *
+   * The slab is only reallocated when it has to grow. All rows are zeroed
+   * and the permutation is reset to the identity.
+   */
+  void Resize (uint32_t rows, uint32_t coefficientSize, uint32_t payloadSize);
+
+  /**
+   * \brief Zero every row and reset the permutation
+   */
+  void Clear (void);
+
+  /**
+   * \brief Zero one row (both sections)
+   * \param row Logical row index
+   */
+  void ZeroRow (uint32_t row);
+
+  /**
+   * \brief Exchange two logical rows without moving their data
+   * \param a Logical row index
+   * \param b Logical row index
+   */
+  void SwapRows (uint32_t a, uint32_t b);
+
+  /**
+   * \brief Get the coefficient section of a row
+   * \param row Logical row index
+   * \return pointer to GetCoefficientSize () bytes, 64-byte aligned
+   */
+  uint8_t *GetCoefficients (uint32_t row);
+  const uint8_t *GetCoefficients (uint32_t row) const;
+
+  /**
+   * \brief Get the payload section of a row
+   * \param row Logical row index
+   * \return pointer to GetPayloadSize () bytes, 64-byte aligned
+   */
+  uint8_t *GetPayload (uint32_t row);
+  const uint8_t *GetPayload (uint32_t row) const;
+
+  uint32_t GetRows (void) const;
+  uint32_t GetCoefficientSize (void) const;
+  uint32_t GetPayloadSize (void) const;
+
+  /**
+   * \brief Get the distance between consecutive physical rows
+   * \return stride in bytes, a multiple of ALIGNMENT
+   */
+  size_t GetStride (void) const;
+
+  /**
+   * \brief Round a size up to a multiple of ALIGNMENT
+   * \param size Size in bytes
+   * \return the padded size
+   */
+  static size_t Align (size_t size);
+
+private:
+  uint8_t *PhysicalRow (uint32_t row) const;
+
+  uint8_t *m_slab;                     //!< Aligned allocation holding all rows
+  size_t m_capacity;                   //!< Allocated bytes in m_slab
+  uint32_t m_rows;                     //!< Number of rows
+  uint32_t m_coefficientSize;          //!< Useful bytes in the coefficient section
+  uint32_t m_payloadSize;              //!< Useful bytes in the payload section
+  size_t m_payloadOffset;              //!< Offset of the payload section in a row
+  size_t m_stride;                     //!< Bytes between physical rows
+  std::vector<uint32_t> m_permutation; //!< Logical to physical row index
+};
+
+inline uint8_t *
+GenerationBuffer::PhysicalRow (uint32_t row) const
+{
+  return m_slab + m_permutation[row] * m_stride;
+}
+
+inline uint8_t *
+GenerationBuffer::GetCoefficients (uint32_t row)
+{
+  return PhysicalRow (row);
+}
+
+inline const uint8_t *
+GenerationBuffer::GetCoefficients (uint32_t row) const
+{
+  return PhysicalRow (row);
+}
+
+inline uint8_t *
+GenerationBuffer::GetPayload (uint32_t row)
+{
+  return PhysicalRow (row) + m_payloadOffset;
+}
+
+inline const uint8_t *
+GenerationBuffer::GetPayload (uint32_t row) const
+{
+  return PhysicalRow (row) + m_payloadOffset;
+}
+
+} // namespace ns3
+
+#endif /* GENERATION_BUFFER_H */
@@ -0,0 +1,374 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "hop-reliability.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("HopReliability");
+
+// Initial ring size; it doubles whenever more packets are in flight
+static const uint32_t INITIAL_RING_SIZE = 64;
+
+HopRetransmissionQueue::HopRetransmissionQueue ()
+  : m_tickNs (0),
+    m_maxRetransmissions (0),
+    m_ring (INITIAL_RING_SIZE),
+    m_nextSequence (1),
+    m_oldest (1),
+    m_outstanding (0),
+    m_retransmitted (0),
+    m_tick (0)
+{
+  for (Entry &entry : m_ring)
+    {
+      entry.sequence = 0;
+    }
+  SetTimeout (Seconds (0.5));
+}
+
+HopRetransmissionQueue::~HopRetransmissionQueue ()
+{
+  Simulator::Cancel (m_tickEvent);
+}
+
+void
+HopRetransmissionQueue::SetTimeout (Time timeout)
+{
+  NS_ASSERT_MSG (timeout.IsStrictlyPositive (), "The retransmission timeout must be positive");
+  NS_ASSERT_MSG (m_outstanding == 0, "Cannot change the timeout with packets outstanding");
+  m_timeout = timeout;
+  m_tickNs = std::max<int64_t> (1, timeout.GetNanoSeconds () / WHEEL_SLOTS);
+  // Expiries land at most timeout / tick + 2 ticks ahead of the next tick
+  m_wheel.assign (timeout.GetNanoSeconds () / m_tickNs + 2, std::vector<uint64_t> ());
+}
+
+Time
+HopRetransmissionQueue::GetTimeout (void) const
+{
+  return m_timeout;
+}
+
+void
+HopRetransmissionQueue::SetMaxRetransmissions (uint32_t retransmissions)
+{
+  m_maxRetransmissions = retransmissions;
+}
+
+void
+HopRetransmissionQueue::SetResendCallback (ResendCallback resend)
+{
+  m_resend = resend;
+}
+
+uint64_t
+HopRetransmissionQueue::AllocateSequence (void)
+{
+  return m_nextSequence++;
+}
+
+HopRetransmissionQueue::Entry &
+HopRetransmissionQueue::Slot (uint64_t sequence)
+{
+  return m_ring[sequence & (m_ring.size () - 1)];
+}
+
+const HopRetransmissionQueue::Entry &
+HopRetransmissionQueue::Slot (uint64_t sequence) const
+{
+  return m_ring[sequence & (m_ring.size () - 1)];
+}
+
+void
+HopRetransmissionQueue::Grow (void)
+{
+  std::vector<Entry> ring (m_ring.size () * 2);
+  for (Entry &entry : ring)
+    {
+      entry.sequence = 0;
+    }
+  for (Entry &entry : m_ring)
+    {
+      if (entry.sequence != 0)
+        {
+          ring[entry.sequence & (ring.size () - 1)] = std::move (entry);
+        }
+    }
+  m_ring.swap (ring);
+  NS_LOG_LOGIC ("Grew the retransmission ring to " << m_ring.size () << " entries");
+}
+
+void
+HopRetransmissionQueue::Track (uint64_t sequence, Ptr<const Packet> packet, const Address &nextHop)
+{
+  NS_ASSERT_MSG (sequence != 0 && sequence < m_nextSequence, "Sequence was not allocated");
+  if (m_outstanding == 0)
+    {
+      m_oldest = sequence;
+    }
+  NS_ASSERT_MSG (sequence >= m_oldest, "Sequences must be tracked in allocation order");
+  while (sequence - m_oldest >= m_ring.size ())
+    {
+      Grow ();
+    }
+
+  Entry &entry = Slot (sequence);
+  NS_ASSERT_MSG (entry.sequence == 0, "Sequence " << sequence << " is already tracked");
+  entry.sequence = sequence;
+  entry.packet = packet;
+  entry.nextHop = nextHop;
+  entry.retransmissions = 0;
+  m_outstanding++;
+
+  if (!m_tickEvent.IsPending ())
+    {
+      int64_t now = Simulator::Now ().GetNanoSeconds ();
+      m_tick = now / m_tickNs + 1;
+      m_tickEvent = Simulator::Schedule (NanoSeconds (m_tick * m_tickNs - now),
+                                         &HopRetransmissionQueue::Tick, this);
+    }
+  Arm (entry);
+}
+
+bool
+HopRetransmissionQueue::IsOutstanding (uint64_t sequence) const
+{
+  return sequence >= m_oldest && sequence - m_oldest < m_ring.size ()
+         && Slot (sequence).sequence == sequence;
+}
+
+void
+HopRetransmissionQueue::Arm (Entry &entry)
+{
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  entry.expiry = (now + m_timeout.GetNanoSeconds () + m_tickNs - 1) / m_tickNs;
+  m_wheel[entry.expiry % m_wheel.size ()].push_back (entry.sequence);
+}
+
+bool
+HopRetransmissionQueue::Acknowledge (uint64_t sequence)
+{
+  if (!IsOutstanding (sequence))
+    {
+      return false;
+    }
+  Entry &entry = Slot (sequence);
+  entry.sequence = 0;
+  entry.packet = nullptr;
+  m_outstanding--;
+  return true;
+}
+
+uint32_t
+HopRetransmissionQueue::HandleHopAck (const NetworkCodingControlHeader &ack)
+{
+  uint64_t sequence = ack.GetHopAckSequence ();
+  uint32_t acknowledged = Acknowledge (sequence) ? 1 : 0;
+  uint64_t bitmap = ack.GetHopAckBitmap ();
+  for (uint64_t below = sequence - 1; bitmap != 0 && below != 0; bitmap >>= 1, below--)
+    {
+      if ((bitmap & 1) && Acknowledge (below))
+        {
+          acknowledged++;
+        }
+    }
+
+  if (m_outstanding == 0)
+    {
+      StopTimer ();
+    }
+  else
+    {
+      while (Slot (m_oldest).sequence != m_oldest)
+        {
+          m_oldest++;
+        }
+    }
+  NS_LOG_LOGIC ("HOP_ACK " << sequence << " acknowledged " << acknowledged
+                << " packets, " << m_outstanding << " outstanding");
+  return acknowledged;
+}
+
+void
+HopRetransmissionQueue::StopTimer (void)
+{
+  Simulator::Cancel (m_tickEvent);
+  for (std::vector<uint64_t> &slot : m_wheel)
+    {
+      slot.clear ();
+    }
+}
+
+void
+HopRetransmissionQueue::Tick (void)
+{
+  uint64_t tick = m_tick++;
+  size_t index = tick % m_wheel.size ();
+  m_expiring.clear ();
+  m_expiring.swap (m_wheel[index]);
+
+  for (uint64_t sequence : m_expiring)
+    {
+      if (!IsOutstanding (sequence))
+        {
+          continue; // Acknowledged since it was armed
+        }
+      Entry &entry = Slot (sequence);
+      if (entry.expiry != tick)
+        {
+          if (entry.expiry > tick && entry.expiry % m_wheel.size () == index)
+            {
+              m_wheel[index].push_back (sequence); // Due in a later turn
+            }
+          continue;
+        }
+
+      if (m_maxRetransmissions != 0 && entry.retransmissions >= m_maxRetransmissions)
+        {
+          NS_LOG_LOGIC ("Giving up hop sequence " << sequence << " after "
+                        << entry.retransmissions << " retransmissions");
+          Acknowledge (sequence);
+          continue;
+        }
+
+      entry.retransmissions++;
+      m_retransmitted++;
+      Arm (entry);
+      Ptr<Packet> copy = entry.packet->Copy ();
+      Address nextHop = entry.nextHop;
+      NS_LOG_LOGIC ("Retransmitting hop sequence " << sequence << " to " << nextHop);
+      if (!m_resend.IsNull ())
+        {
+          m_resend (copy, nextHop); // May track new packets and grow the ring
+        }
+    }
+
+  if (m_outstanding == 0)
+    {
+      StopTimer ();
+      return;
+    }
+  while (Slot (m_oldest).sequence != m_oldest)
+    {
+      m_oldest++;
+    }
+  if (!m_tickEvent.IsPending ()) // Track may have restarted it from the callback
+    {
+      int64_t now = Simulator::Now ().GetNanoSeconds ();
+      m_tickEvent = Simulator::Schedule (NanoSeconds (m_tick * m_tickNs - now),
+                                         &HopRetransmissionQueue::Tick, this);
+    }
+}
+
+void
+HopRetransmissionQueue::Clear (void)
+{
+  for (Entry &entry : m_ring)
+    {
+      entry.sequence = 0;
+      entry.packet = nullptr;
+    }
+  m_outstanding = 0;
+  m_oldest = m_nextSequence;
+  StopTimer ();
+}
+
+uint32_t
+HopRetransmissionQueue::GetOutstanding (void) const
+{
+  return m_outstanding;
+}
+
+uint64_t
+HopRetransmissionQueue::GetRetransmissions (void) const
+{
+  return m_retransmitted;
+}
+
+HopAckTracker::HopAckTracker ()
+  : m_highest (0),
+    m_bitmap (0)
+{
+}
+
+bool
+HopAckTracker::Receive (uint64_t sequence)
+{
+  if (sequence == 0)
+    {
+      return false;
+    }
+  if (sequence > m_highest)
+    {
+      uint64_t shift = sequence - m_highest;
+      if (m_highest == 0 || shift > 64)
+        {
+          m_bitmap = 0;
+        }
+      else if (shift == 64)
+        {
+          m_bitmap = uint64_t (1) << 63;
+        }
+      else
+        {
+          m_bitmap = (m_bitmap << shift) | (uint64_t (1) << (shift - 1));
+        }
+      m_highest = sequence;
+      return true;
+    }
+
+  uint64_t distance = m_highest - sequence;
+  if (distance == 0 || distance > 64)
+    {
+      return false;
+    }
+  uint64_t bit = uint64_t (1) << (distance - 1);
+  if (m_bitmap & bit)
+    {
+      return false;
+    }
+  m_bitmap |= bit;
+  return true;
+}
+
+void
+HopAckTracker::FillHopAck (NetworkCodingControlHeader &ack, uint64_t sequence) const
+{
+  if (sequence <= m_highest && m_highest - sequence <= 64)
+    {
+      ack.SetHopAckSequence (m_highest);
+      ack.SetHopAckBitmap (m_bitmap);
+    }
+  else
+    {
+      ack.SetHopAckSequence (sequence);
+      ack.SetHopAckBitmap (0);
+    }
+}
+
+uint64_t
+HopAckTracker::GetHighestSequence (void) const
+{
+  return m_highest;
+}
+
+} // namespace ns3
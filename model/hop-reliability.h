@@ -0,0 +1,238 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef HOP_RELIABILITY_H
+#define HOP_RELIABILITY_H
+
+#include "ns3/address.h"
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "network-coding-packet.h"
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief Sender side of hop-by-hop reliability: unacknowledged packets
+ *        waiting for a HOP_ACK, retransmitted on timeout
+ *
+ * Packets are kept in a ring indexed by hop sequence, so tracking and
+ * acknowledging are O(1) and allocation free once the ring has grown to
+ * the number of packets in flight. Timeouts go through a hashed timer
+ * wheel of WHEEL_SLOTS slots per timeout, driven by a single simulator
+ * event that only runs while packets are outstanding. A packet is resent
+ * at most one slot (timeout / WHEEL_SLOTS) late, in exchange for one
+ * event per slot instead of one event per packet.
+ */
+class HopRetransmissionQueue
+{
+public:
+  /**
+   * \brief Callback resending a packet to its next hop
+   */
+  typedef Callback<void, Ptr<Packet>, const Address &> ResendCallback;
+
+  /**
+   * \brief Timer wheel slots per retransmission timeout
+   */
+  static const uint32_t WHEEL_SLOTS = 8;
+
+  HopRetransmissionQueue ();
+  ~HopRetransmissionQueue ();
+
+  HopRetransmissionQueue (const HopRetransmissionQueue &) = delete;
+  HopRetransmissionQueue &operator= (const HopRetransmissionQueue &) = delete;
+
+  /**
+   * \brief Set the time after which an unacknowledged packet is resent
+   * \param timeout Retransmission timeout, strictly positive
+   *
+   * The wheel is laid out for the timeout, so it can only be changed while
+   * no packet is outstanding.
+   */
+  void SetTimeout (Time timeout);
+  Time GetTimeout (void) const;
+
+  /**
+   * \brief Set how often a packet is resent before it is given up
+   * \param retransmissions Maximum retransmissions; 0 retries forever
+   */
+  void SetMaxRetransmissions (uint32_t retransmissions);
+
+  /**
+   * \brief Set the callback that puts a retransmission on the wire
+   * \param resend Called with a copy of the packet and its next hop
+   */
+  void SetResendCallback (ResendCallback resend);
+
+  /**
+   * \brief Reserve the hop sequence of the next packet
+   * \return the sequence to stamp into the packet's header, starting at 1
+   */
+  uint64_t AllocateSequence (void);
+
+  /**
+   * \brief Keep a sent packet until it is acknowledged
+   * \param sequence Hop sequence from AllocateSequence, in allocation order
+   * \param packet The packet as sent, headers included
+   * \param nextHop Where it was sent
+   */
+  void Track (uint64_t sequence, Ptr<const Packet> packet, const Address &nextHop);
+
+  /**
+   * \brief Check whether a sequence still waits for its acknowledgment
+   * \param sequence The hop sequence
+   * \return true if it is tracked and unacknowledged
+   */
+  bool IsOutstanding (uint64_t sequence) const;
+
+  /**
+   * \brief Process a HOP_ACK
+   * \param ack The control header; its hop ACK sequence and bitmap are used
+   * \return the number of packets newly acknowledged
+   */
+  uint32_t HandleHopAck (const NetworkCodingControlHeader &ack);
+
+  /**
+   * \brief Forget every outstanding packet and stop the timer
+   */
+  void Clear (void);
+
+  /**
+   * \brief Get the number of packets waiting for an acknowledgment
+   * \return the count
+   */
+  uint32_t GetOutstanding (void) const;
+
+  /**
+   * \brief Get the number of retransmissions so far
+   * \return the count
+   */
+  uint64_t GetRetransmissions (void) const;
+
+private:
+  /**
+   * \brief One packet waiting for its HOP_ACK
+   */
+  struct Entry
+  {
+    uint64_t sequence;          //!< Hop sequence, 0 if the slot is free
+    Ptr<const Packet> packet;   //!< Packet as sent
+    Address nextHop;            //!< Where it goes
+    uint64_t expiry;            //!< Wheel tick at which it is resent
+    uint32_t retransmissions;   //!< Times it has been resent
+  };
+
+  /**
+   * \brief Mark one sequence as acknowledged
+   * \param sequence The hop sequence
+   * \return true if it was outstanding
+   */
+  bool Acknowledge (uint64_t sequence);
+
+  /**
+   * \brief Get the ring slot of a sequence
+   * \param sequence The hop sequence
+   * \return the entry (which may hold another sequence)
+   */
+  Entry &Slot (uint64_t sequence);
+  const Entry &Slot (uint64_t sequence) const;
+
+  /**
+   * \brief Double the ring, keeping every outstanding entry
+   */
+  void Grow (void);
+
+  /**
+   * \brief Put an entry on the timer wheel, one timeout from now
+   * \param entry The entry
+   */
+  void Arm (Entry &entry);
+
+  /**
+   * \brief Drop every wheel slot once nothing is outstanding
+   */
+  void StopTimer (void);
+
+  /**
+   * \brief Resend the packets expiring in the current slot and advance
+   */
+  void Tick (void);
+
+  Time m_timeout;                   //!< Retransmission timeout
+  int64_t m_tickNs;                 //!< Length of a wheel slot, in nanoseconds
+  uint32_t m_maxRetransmissions;    //!< 0 means unlimited
+  ResendCallback m_resend;          //!< Sends retransmissions
+
+  std::vector<Entry> m_ring;        //!< Entry of sequence s at s & (size - 1)
+  uint64_t m_nextSequence;          //!< Next sequence AllocateSequence returns
+  uint64_t m_oldest;                //!< No sequence below this is outstanding
+  uint32_t m_outstanding;           //!< Entries waiting for an acknowledgment
+  uint64_t m_retransmitted;         //!< Retransmissions sent
+
+  std::vector<std::vector<uint64_t>> m_wheel; //!< Sequences expiring per slot
+  std::vector<uint64_t> m_expiring; //!< Slot being processed by Tick
+  uint64_t m_tick;                  //!< Absolute wheel tick the event handles next
+  EventId m_tickEvent;              //!< Pending only while packets are outstanding
+};
+
+/**
+ * \ingroup network-coding
+ * \brief Receiver side of hop-by-hop reliability for one upstream hop
+ *
+ * Remembers the highest hop sequence received and which of the 64 below it
+ * arrived, which is exactly what a HOP_ACK carries.
+ */
+class HopAckTracker
+{
+public:
+  HopAckTracker ();
+
+  /**
+   * \brief Record a received hop sequence
+   * \param sequence The packet's hop sequence
+   * \return false if the sequence had already been received (a duplicate)
+   *         or is too old to tell
+   */
+  bool Receive (uint64_t sequence);
+
+  /**
+   * \brief Fill the HOP_ACK answering a received packet
+   * \param ack The control header to fill
+   * \param sequence Hop sequence of the packet, already passed to Receive
+   *
+   * Normally the ACK carries the highest sequence and the bitmap below it,
+   * which also repeats every recent acknowledgment. A retransmission older
+   * than the bitmap reaches is acknowledged on its own.
+   */
+  void FillHopAck (NetworkCodingControlHeader &ack, uint64_t sequence) const;
+
+  uint64_t GetHighestSequence (void) const;
+
+private:
+  uint64_t m_highest;   //!< Highest hop sequence received, 0 if none
+  uint64_t m_bitmap;    //!< Bit i: m_highest - 1 - i received
+};
+
+} // namespace ns3
+
+#endif /* HOP_RELIABILITY_H */
@@ -0,0 +1,263 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NETWORK_CODING_CODEC_H
+#define NETWORK_CODING_CODEC_H
+
+#include "galois-field-traits.h"
+#include "generation-buffer.h"
+#include <cstring>
+
+namespace ns3 {
+namespace gf {
+
+/**
+ * \ingroup network-coding
+ * \brief Coefficient row arithmetic over a length fixed at compile time
+ *
+ * Coefficient rows are a few dozen bytes, so a call into the region
+ * kernels costs as much as the work. GF(2) rows are plain XOR loops the
+ * compiler unrolls and vectorizes; the other fields still use the region
+ * kernels, which beat any portable loop, but with a constant length.
+ */
+template <class Field>
+struct FixedRow
+{
+  template <uint32_t N>
+  static void MultiplyAdd (uint8_t *dst, const uint8_t *src, uint8_t coeff)
+  {
+    Field::MultiplyAddRegion (dst, src, coeff, N);
+  }
+  template <uint32_t N>
+  static void Multiply (uint8_t *dst, uint8_t coeff)
+  {
+    Field::MultiplyRegion (dst, coeff, N);
+  }
+};
+
+/**
+ * \brief GF(2) coefficient rows, XORed inline
+ */
+template <>
+struct FixedRow<Binary>
+{
+  template <uint32_t N>
+  static void MultiplyAdd (uint8_t *__restrict dst, const uint8_t *__restrict src, uint8_t coeff)
+  {
+    if (coeff)
+      {
+        for (uint32_t i = 0; i < N; i++)
+          {
+            dst[i] ^= src[i];
+          }
+      }
+  }
+  template <uint32_t N>
+  static void Multiply (uint8_t *dst, uint8_t coeff)
+  {
+    if (!coeff)
+      {
+        std::memset (dst, 0, N);
+      }
+  }
+};
+
+/**
+ * \ingroup network-coding
+ * \brief Row arithmetic of the block coders for one configuration
+ * \tparam Field gf::Binary, gf::Binary4 or gf::Binary8
+ * \tparam GenSize Packets per generation, or 0 for any
+ * \tparam SymbolSize Payload bytes per packet, or 0 for any
+ *
+ * NetworkCodingEncoder and NetworkCodingDecoder run their row operations
+ * through the CodecT DispatchCodec picks for their configuration. The
+ * generic CodecT<Field> takes every length at run time. A fixed one makes
+ * the loop bounds over the generation constants, updates whole coefficient
+ * rows with FixedRow instead of the span a row can be nonzero in (the
+ * rows are zero outside it, so the result is the same), and runs payload
+ * operations over the packet rounded up to GenerationBuffer::ALIGNMENT,
+ * so the region kernels never drop to their narrower tails. That padding
+ * belongs to every GenerationBuffer row and only ever mixes with padding.
+ */
+template <class Field, uint16_t GenSize = 0, uint16_t SymbolSize = 0>
+struct CodecT
+{
+  static_assert ((GenSize == 0) == (SymbolSize == 0), "Fix both sizes or neither");
+
+  typedef Field Arithmetic;                          //!< The field
+  static const uint16_t GENERATION_SIZE = GenSize;   //!< 0 if chosen at run time
+  static const uint16_t SYMBOL_SIZE = SymbolSize;    //!< 0 if chosen at run time
+
+  /**
+   * \brief Get the generation size the loops run to
+   * \param generationSize The coder's generation size
+   * \return GenSize, or generationSize for the generic codec
+   */
+  static uint32_t GetGenerationSize (uint32_t generationSize)
+  {
+    return GenSize ? GenSize : generationSize;
+  }
+
+  /**
+   * \brief Get the bytes payload operations run over
+   * \param symbolSize The coder's packet size
+   * \return SymbolSize padded to whole vectors, or symbolSize for the generic codec
+   */
+  static size_t GetPayloadBytes (size_t symbolSize)
+  {
+    return SymbolSize ? PADDED_SYMBOL_SIZE : symbolSize;
+  }
+
+  /**
+   * \brief Compute row += coeff * src over a coefficient row
+   * \param row The row updated
+   * \param src The row added, zero outside [begin, end)
+   * \param coeff Field element
+   * \param begin First column src may be nonzero in
+   * \param end One past the last one
+   */
+  static void MultiplyAddCoefficients (uint8_t *row, const uint8_t *src, uint8_t coeff,
+                                       uint32_t begin, uint32_t end)
+  {
+    if constexpr (GenSize != 0)
+      {
+        FixedRow<Field>::template MultiplyAdd<GenSize> (row, src, coeff);
+      }
+    else
+      {
+        Field::MultiplyAddRegion (row + begin, src + begin, coeff, end - begin);
+      }
+  }
+
+  /**
+   * \brief Compute row *= coeff over a coefficient row
+   * \param row The row, zero outside [begin, end)
+   * \param coeff Field element
+   * \param begin First column the row may be nonzero in
+   * \param end One past the last one
+   */
+  static void MultiplyCoefficients (uint8_t *row, uint8_t coeff, uint32_t begin, uint32_t end)
+  {
+    if constexpr (GenSize != 0)
+      {
+        FixedRow<Field>::template Multiply<GenSize> (row, coeff);
+      }
+    else
+      {
+        Field::MultiplyRegion (row + begin, coeff, end - begin);
+      }
+  }
+
+  /**
+   * \brief Run a batch of payload operations
+   * \param ops The operations, on GenerationBuffer payload rows
+   * \param count Number of operations
+   * \param symbolSize The coder's packet size
+   */
+  static void ApplyPayloadOps (const RegionOp *ops, size_t count, size_t symbolSize)
+  {
+    ApplyRegionOps<Field> (ops, count, GetPayloadBytes (symbolSize));
+  }
+
+  /**
+   * \brief Run a batch of payload operations one column block at a time
+   * \param ops The operations, on GenerationBuffer payload rows
+   * \param count Number of operations
+   * \param symbolSize The coder's packet size
+   * \param blockSize Columns every operation is applied to before moving on
+   */
+  static void ApplyPayloadOps (const RegionOp *ops, size_t count, size_t symbolSize, size_t blockSize)
+  {
+    ApplyRegionOps<Field> (ops, count, GetPayloadBytes (symbolSize), blockSize);
+  }
+
+private:
+  static const size_t PADDED_SYMBOL_SIZE =
+    (SymbolSize + GenerationBuffer::ALIGNMENT - 1) & ~(GenerationBuffer::ALIGNMENT - 1);
+};
+
+/**
+ * \brief Call a function with the fixed CodecT of a configuration, if any
+ * \param generationSize Packets per generation
+ * \param symbolSize Payload bytes per packet
+ * \param function Called with a CodecT<Field, ...> value
+ * \return what function returns
+ *
+ * Generations of 16, 32 or 64 packets of 1024 or 1400 bytes get a fixed
+ * codec, everything else the generic one.
+ */
+template <class Field, class Function>
+auto
+DispatchFixedCodec (uint32_t generationSize, uint32_t symbolSize, Function &function)
+{
+  if (symbolSize == 1024)
+    {
+      switch (generationSize)
+        {
+        case 16:
+          return function (CodecT<Field, 16, 1024> ());
+        case 32:
+          return function (CodecT<Field, 32, 1024> ());
+        case 64:
+          return function (CodecT<Field, 64, 1024> ());
+        }
+    }
+  else if (symbolSize == 1400)
+    {
+      switch (generationSize)
+        {
+        case 16:
+          return function (CodecT<Field, 16, 1400> ());
+        case 32:
+          return function (CodecT<Field, 32, 1400> ());
+        case 64:
+          return function (CodecT<Field, 64, 1400> ());
+        }
+    }
+  return function (CodecT<Field> ());
+}
+
+/**
+ * \brief Call a function with the CodecT of a configuration
+ * \param field The field
+ * \param generationSize Packets per generation
+ * \param symbolSize Payload bytes per packet
+ * \param function Generic callable taking a CodecT by value, e.g.
+ *        [this] (auto codec) { return EliminateRow<decltype (codec)> (); }
+ * \return what function returns
+ */
+template <class Function>
+auto
+DispatchCodec (FieldType field, uint32_t generationSize, uint32_t symbolSize, Function &&function)
+{
+  switch (field)
+    {
+    case FIELD_BINARY:
+      return DispatchFixedCodec<Binary> (generationSize, symbolSize, function);
+    case FIELD_BINARY4:
+      return DispatchFixedCodec<Binary4> (generationSize, symbolSize, function);
+    case FIELD_BINARY8:
+      break;
+    }
+  return DispatchFixedCodec<Binary8> (generationSize, symbolSize, function);
+}
+
+} // namespace gf
+} // namespace ns3
+
+#endif /* NETWORK_CODING_CODEC_H */
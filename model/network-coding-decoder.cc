@@ -22,6 +22,9 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/assert.h"
+#include "ns3/boolean.h"
+#include <algorithm>
+#include <memory>
 
 namespace ns3 {
 
@@ -35,6 +38,16 @@ NetworkCodingDecoder::GetTypeId (void)
     .SetParent<Object> ()
     .SetGroupName ("NetworkCoding")
     .AddConstructor<NetworkCodingDecoder> ()
+    .AddAttribute ("PartialDecoding",
+                   "Report source symbols through SymbolDecoded as soon as their "
+                   "rows are reduced to unit vectors, before full rank",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NetworkCodingDecoder::m_partialDecoding),
+                   MakeBooleanChecker ())
+    .AddTraceSource ("SymbolDecoded",
+                     "A source symbol became known while packets were processed",
+                     MakeTraceSourceAccessor (&NetworkCodingDecoder::m_symbolDecodedTrace),
+                     "ns3::NetworkCodingDecoder::SymbolTracedCallback")
   ;
   return tid;
 }
@@ -43,14 +56,25 @@ NetworkCodingDecoder::NetworkCodingDecoder ()
   : m_generationSize (8),
     m_packetSize (1024),
     m_currentGeneration (0),
-    m_decoded (false)
+    m_decoded (false),
+    m_rank (0),
+    m_codedPivots (0),
+    m_deferred (false),
+    m_reduced (true),
+    m_epoch (1),
+    m_partialDecoding (false),
+    m_solvedSymbols (0),
+    m_field (gf::FIELD_BINARY8),
+    m_blocked (false),
+    m_tileSize (0),
+    m_rawRows (false),
+    m_patternHash (0),
+    m_storePattern (false)
 {
   NS_LOG_FUNCTION (this);
-  m_gf = CreateObject<GaloisField> ();
   NS_ASSERT_MSG (m_generationSize > 0 && m_packetSize > 0, "Invalid generation or packet size");
   // Initialize the coefficient matrix and coded payload storage
-  m_coefficients.resize (m_generationSize, std::vector<uint8_t> (m_generationSize, 0));
-  m_codedPayloads.resize (m_generationSize, std::vector<uint8_t> (m_packetSize, 0));
+  AllocateMatrix ();
   NS_LOG_INFO ("Decoder created");
 }
 
@@ -58,22 +82,30 @@ NetworkCodingDecoder::NetworkCodingDecoder (uint16_t generationSize, uint16_t pa
   : m_generationSize (generationSize),
     m_packetSize (packetSize),
     m_currentGeneration (0),
-    m_decoded (false)
+    m_decoded (false),
+    m_rank (0),
+    m_codedPivots (0),
+    m_deferred (false),
+    m_reduced (true),
+    m_epoch (1),
+    m_partialDecoding (false),
+    m_solvedSymbols (0),
+    m_field (gf::FIELD_BINARY8),
+    m_blocked (false),
+    m_tileSize (0),
+    m_rawRows (false),
+    m_patternHash (0),
+    m_storePattern (false)
 {
   NS_LOG_FUNCTION (this << generationSize << packetSize);
   
-  // Create GaloisField first
-  m_gf = CreateObject<GaloisField> ();
-  NS_ASSERT_MSG(m_gf, "Failed to create GaloisField");
-  
   // Validate parameters
-  NS_ASSERT_MSG (m_generationSize > 0 && m_generationSize <= 255, "Invalid generation size");
+  NS_ASSERT_MSG (m_generationSize > 0, "Invalid generation size");
   NS_ASSERT_MSG (m_packetSize > 0, "Invalid packet size");
   
   // Initialize the coefficient matrix and coded payload storage
   try {
-    m_coefficients.resize (m_generationSize, std::vector<uint8_t> (m_generationSize, 0));
-    m_codedPayloads.resize (m_generationSize, std::vector<uint8_t> (m_packetSize, 0));
+    AllocateMatrix ();
   } catch (const std::exception& e) {
     NS_FATAL_ERROR("Failed to allocate decoder matrices: " << e.what());
   }
@@ -97,8 +129,7 @@ NetworkCodingDecoder::SetGenerationSize (uint16_t generationSize)
       m_generationSize = generationSize;
       
       // Resize the coefficient matrix and coded payload storage
-      m_coefficients.resize (m_generationSize, std::vector<uint8_t> (m_generationSize, 0));
-      m_codedPayloads.resize (m_generationSize, std::vector<uint8_t> (m_packetSize, 0));
+      AllocateMatrix ();
       
       // Reset decoder state
       m_decoded = false;
@@ -122,11 +153,9 @@ NetworkCodingDecoder::SetPacketSize (uint16_t packetSize)
     {
       m_packetSize = packetSize;
       
-      // Resize the coded payload storage
-      for (auto& payload : m_codedPayloads)
-        {
-          payload.resize (m_packetSize, 0);
-        }
+      // Resize the coded payload storage; rows already held would no longer
+      // match their payloads, so start the generation over
+      AllocateMatrix ();
       
       // Reset decoder state
       m_decoded = false;
@@ -157,7 +186,7 @@ NetworkCodingDecoder::ProcessCodedPacket (Ptr<const Packet> packet)
       return false;
     }
   
-  // Make a copy of the packet
+  // Packet copies share the byte buffer, so this does not copy the payload
   Ptr<Packet> packetCopy = packet->Copy ();
   
   // Extract the network coding header
@@ -173,6 +202,25 @@ NetworkCodingDecoder::ProcessCodedPacket (Ptr<const Packet> packet)
     return false;
   }
   
+  return ProcessCodedPacket (packetCopy, header);
+}
+
+bool
+NetworkCodingDecoder::ProcessCodedPacket (Ptr<const Packet> payload, const NetworkCodingHeader &header)
+{
+  NS_LOG_FUNCTION (this << payload << header.GetGenerationId ());
+  
+  if (!payload) {
+    NS_LOG_ERROR("Null packet received");
+    return false;
+  }
+  
+  if (m_decoded)
+    {
+      NS_LOG_INFO ("Generation already decoded, ignoring packet");
+      return false;
+    }
+  
   // Check if the packet belongs to the current generation
   if (header.GetGenerationId () != m_currentGeneration)
     {
@@ -181,6 +229,13 @@ NetworkCodingDecoder::ProcessCodedPacket (Ptr<const Packet> packet)
       return false;
     }
   
+  if (header.GetField () != m_field)
+    {
+      NS_LOG_WARN ("Packet coded in GF(2^" << header.GetField () << ") but decoder uses GF(2^"
+                   << m_field << ")");
+      return false;
+    }
+  
   // Get the coding coefficients
   const std::vector<uint8_t>& coefficients = header.GetCoefficients ();
   if (coefficients.empty()) {
@@ -188,67 +243,112 @@ NetworkCodingDecoder::ProcessCodedPacket (Ptr<const Packet> packet)
     return false;
   }
   
-  // Pad coefficients to generation size if needed
-  std::vector<uint8_t> paddedCoeffs(m_generationSize, 0);
-  for (size_t i = 0; i < std::min(coefficients.size(), (size_t)m_generationSize); i++) {
-    paddedCoeffs[i] = coefficients[i];
-  }
-  
-  // Check if the packet is innovative before storing
-  if (!IsInnovative(paddedCoeffs)) {
-    NS_LOG_INFO("Received non-innovative (redundant) packet.");
-    return false;
-  }
+  uint32_t usable = std::min (coefficients.size (), (size_t)m_generationSize);
   
-  // Check packet payload size
-  if (packetCopy->GetSize () != m_packetSize)
+  // A row that continues a cached pattern is stored as it came; the first
+  // one that does not sends the rows held through the elimination
+  bool inPattern = false;
+  uint64_t patternHash = 0;
+  if (m_rawRows && (CanDecode () || !UsesInverseCache ()))
     {
-      NS_LOG_WARN ("Packet size mismatch: expected " << m_packetSize 
-                    << " but got " << packetCopy->GetSize ());
-      // Handle size mismatch gracefully
+      if (CanDecode ())
+        {
+          NS_LOG_INFO ("Matrix already has full rank, ignoring packet");
+          return false;
+        }
+      ReplayRawRows ();
+    }
+  if (UsesInverseCache () && !CanDecode () && m_patternPrefixes.size () == m_rank)
+    {
+      patternHash = StagePatternRow (coefficients, usable);
+      if (m_rawRows)
+        {
+          if (m_inverseCache->IsKnownPrefix (patternHash))
+            {
+              return StoreRawRow (payload, patternHash);
+            }
+          if (m_inverseCache->IsKnownRedundant (patternHash))
+            {
+              NS_LOG_INFO ("Received non-innovative packet of a cached pattern");
+              return false;
+            }
+          NS_LOG_INFO ("Coefficients leave the cached patterns at rank " << m_rank);
+          ReplayRawRows ();
+          patternHash = StagePatternRow (coefficients, usable);
+        }
+      inPattern = true;
     }
   
-  // Extract the payload
-  std::vector<uint8_t> payload(m_packetSize, 0);
-  uint32_t actualSize = std::min(packetCopy->GetSize(), (uint32_t)m_packetSize);
-  if (actualSize > 0) {
-    packetCopy->CopyData(payload.data(), actualSize);
-  }
-  
-  // Find an empty row to store this packet
-  bool stored = false;
-  for (size_t i = 0; i < m_generationSize; i++)
+  // Systematic packets carry a unit vector e_j. If column j already holds
+  // e_j the packet is redundant, which is known before touching the payload.
+  // A coded pivot row in column j is not e_j yet, so e_j is reduced normally.
+  int32_t unitColumn = -1;
+  for (uint32_t j = 0; j < usable; j++)
     {
-      // Check if the row is empty (all zeros)
-      bool rowEmpty = true;
-      for (size_t j = 0; j < m_generationSize; j++)
+      if (coefficients[j] != 0)
         {
-          if (m_coefficients[i][j] != 0)
+          if (unitColumn >= 0)
             {
-              rowEmpty = false;
+              unitColumn = -1;
               break;
             }
+          unitColumn = j;
         }
-      
-      if (rowEmpty)
+    }
+  if (unitColumn >= 0 && HasPivot (unitColumn))
+    {
+      if (m_rowEnd[unitColumn] == unitColumn + 1u)
         {
-          // Store the coefficients and payload
-          m_coefficients[i] = paddedCoeffs;
-          m_codedPayloads[i] = payload;
-          stored = true;
-          
-          NS_LOG_INFO ("Stored innovative coded packet in row " << i);
-          break;
+          NS_LOG_INFO ("Received duplicate uncoded packet for column " << unitColumn);
+          return false;
         }
+      unitColumn = -1;
     }
   
-  if (!stored) {
-    NS_LOG_WARN("No empty row available for packet storage, though it was innovative. This shouldn't happen.");
-    return false;
+  // Stage the row in the scratch slot, padding coefficients to the
+  // generation size if needed
+  m_matrix.ZeroRow (m_generationSize);
+  uint8_t *rowCoeffs = m_matrix.GetCoefficients (m_generationSize);
+  std::copy_n (coefficients.begin (), usable, rowCoeffs);
+  
+  // Check packet payload size
+  if (payload->GetSize () != m_packetSize)
+    {
+      NS_LOG_WARN ("Packet size mismatch: expected " << m_packetSize 
+                    << " but got " << payload->GetSize ());
+      // Handle size mismatch gracefully
+    }
+  
+  // Extract the payload straight into the row; this is its only copy
+  uint32_t actualSize = std::min(payload->GetSize(), (uint32_t)m_packetSize);
+  if (actualSize > 0) {
+    payload->CopyData(m_matrix.GetPayload (m_generationSize), actualSize);
   }
   
-  // Check if we can decode now
-  if (CanDecode ())
+  // Reduce against the rows we hold; innovativeness falls out of the reduction
+  bool innovative = gf::DispatchCodec (m_field, m_generationSize, m_packetSize, [this, unitColumn] (auto codec) {
+    typedef decltype (codec) Codec;
+    return (unitColumn >= 0) ? InsertUnitRow<Codec> (unitColumn) : EliminateRow<Codec> ();
+  });
+  if (!innovative)
+    {
+      NS_LOG_INFO("Received non-innovative (redundant) packet.");
+      if (inPattern)
+        {
+          m_patternRedundant.push_back (patternHash);
+        }
+      return false;
+    }
+  if (inPattern)
+    {
+      m_patternHash = patternHash;
+      m_patternPrefixes.push_back (patternHash);
+      m_storePattern = CanDecode ();
+    }
+  
+  // The last innovative packet completes the decoding, unless the caller
+  // wants to run the final substitution itself
+  if (CanDecode () && m_reduced)
     {
       NS_LOG_INFO ("Matrix has full rank, decoding generation " << m_currentGeneration);
       DecodeGeneration ();
@@ -257,102 +357,578 @@ NetworkCodingDecoder::ProcessCodedPacket (Ptr<const Packet> packet)
   return true;
 }
 
+template <class Codec>
 bool
-NetworkCodingDecoder::IsInnovative(const std::vector<uint8_t>& newCoeffs) const
-{
-    if (m_decoded) return false;
-
-    std::vector<std::vector<uint8_t>> tempMatrix = m_coefficients;
-    
-    // Find an empty row to test the new coefficients
-    int emptyRow = -1;
-    for (size_t i = 0; i < m_generationSize; ++i) {
-        bool rowEmpty = true;
-        for (uint8_t val : tempMatrix[i]) {
-            if (val != 0) {
-                rowEmpty = false;
-                break;
+NetworkCodingDecoder::EliminateRow (void)
+{
+  NS_LOG_FUNCTION (this);
+  typedef typename Codec::Arithmetic Field;
+  
+  const uint32_t scratch = Codec::GetGenerationSize (m_generationSize);
+  uint8_t *coefficients = m_matrix.GetCoefficients (scratch);
+  uint8_t *payload = m_matrix.GetPayload (scratch);
+  
+  // Only the span of the row that can be nonzero is visited; sparse codes
+  // touch few columns and pivot rows record where their own span ends
+  uint32_t begin = 0;
+  uint32_t end = scratch;
+  while (begin < end && coefficients[begin] == 0)
+    {
+      begin++;
+    }
+  while (end > begin && coefficients[end - 1] == 0)
+    {
+      end--;
+    }
+  
+  // Forward reduction: cancel every column that already has a pivot, in
+  // column order. A pivot row for column j is normalized, zero before
+  // column j and may extend the span of the row being reduced; it only
+  // changes columns after j, so every column is final when visited. (With
+  // immediate substitution pivot rows are also zero in all other pivot
+  // columns, so each subtraction clears exactly one entry.)
+  // Payload updates are only collected here: a packet that reduces to zero
+  // never has its payload touched, and the rest run as one batch
+  m_payloadOps.clear ();
+  int32_t lead = -1;
+  for (uint32_t j = begin; j < end; j++)
+    {
+      uint8_t factor = coefficients[j];
+      if (factor == 0)
+        {
+          continue;
+        }
+      if (!HasPivot (j))
+        {
+          if (lead < 0)
+            {
+              lead = j;
             }
+          continue;
+        }
+      uint32_t pivotEnd = m_rowEnd[j];
+      Codec::MultiplyAddCoefficients (coefficients, m_matrix.GetCoefficients (j), factor, j, pivotEnd);
+      m_payloadOps.push_back ({payload, m_matrix.GetPayload (j), factor});
+      end = std::max (end, pivotEnd);
+    }
+  
+  if (lead < 0)
+    {
+      // Reduced to zero: linear combination of what we already have
+      return false;
+    }
+  while (coefficients[end - 1] == 0)
+    {
+      end--;
+    }
+  
+  // Normalize the new pivot to 1
+  uint8_t pivotInv = Field::Inverse (coefficients[lead]);
+  if (pivotInv != 1)
+    {
+      Codec::MultiplyCoefficients (coefficients, pivotInv, lead, end);
+      m_payloadOps.push_back ({payload, nullptr, pivotInv});
+    }
+  
+  StorePivotRow<Codec> (lead, end);
+  m_codedPivots++;
+  
+  NS_LOG_INFO ("Stored innovative coded packet as pivot for column " << lead
+               << ", rank " << m_rank << "/" << m_generationSize);
+  
+  return true;
+}
+
+template <class Codec>
+bool
+NetworkCodingDecoder::InsertUnitRow (uint32_t column)
+{
+  NS_LOG_FUNCTION (this << column);
+  typedef typename Codec::Arithmetic Field;
+  
+  const uint32_t scratch = Codec::GetGenerationSize (m_generationSize);
+  uint8_t *coefficients = m_matrix.GetCoefficients (scratch);
+  
+  // Uncoded packets have coefficient 1 and need no arithmetic at all
+  m_payloadOps.clear ();
+  if (coefficients[column] != 1)
+    {
+      uint8_t pivotInv = Field::Inverse (coefficients[column]);
+      coefficients[column] = 1;
+      m_payloadOps.push_back ({m_matrix.GetPayload (scratch), nullptr, pivotInv});
+    }
+  
+  StorePivotRow<Codec> (column, column + 1);
+  
+  NS_LOG_INFO ("Stored uncoded packet as pivot for column " << column
+               << ", rank " << m_rank << "/" << m_generationSize);
+  
+  return true;
+}
+
+template <class Codec>
+void
+NetworkCodingDecoder::StorePivotRow (uint32_t lead, uint32_t end)
+{
+  const uint32_t scratch = Codec::GetGenerationSize (m_generationSize);
+  const uint8_t *coefficients = m_matrix.GetCoefficients (scratch);
+  const uint8_t *payload = m_matrix.GetPayload (scratch);
+  
+  // Back-substitution: clear the new pivot column from the existing rows.
+  // Rows with a pivot after the lead are zero there, as are rows whose
+  // span ends before it. Rows stored from unit vectors are zero outside
+  // their own column, so there is nothing to clear until a coded row has
+  // been stored. Deferred substitution leaves this to BackSubstitute.
+  if (m_deferred)
+    {
+      m_reduced = false;
+    }
+  for (uint32_t i = 0; m_reduced && m_codedPivots > 0 && i < lead; i++)
+    {
+      if (!HasPivot (i) || m_rowEnd[i] <= lead)
+        {
+          continue;
         }
-        if (rowEmpty) {
-            emptyRow = i;
-            break;
+      uint8_t *rowCoeffs = m_matrix.GetCoefficients (i);
+      uint8_t factor = rowCoeffs[lead];
+      if (factor != 0)
+        {
+          Codec::MultiplyAddCoefficients (rowCoeffs, coefficients, factor, lead, end);
+          m_payloadOps.push_back ({m_matrix.GetPayload (i), payload, factor});
+          m_rowEnd[i] = std::max<uint32_t> (m_rowEnd[i], end);
+          if (m_partialDecoding)
+            {
+              m_touchedRows.push_back (i);
+            }
         }
     }
+  
+  // Run the payload work of the whole packet: its own reduction and
+  // normalization first, then the substitution into the other rows
+  ApplyPayloadOps<Codec> ();
+  
+  // Move the scratch row into its pivot slot; the buffer only swaps indices
+  m_matrix.SwapRows (lead, scratch);
+  m_pivotEpoch[lead] = m_epoch;
+  m_rowEnd[lead] = end;
+  m_rank++;
+  
+  if (m_partialDecoding)
+    {
+      m_touchedRows.push_back (lead);
+      ReportSolvedSymbols ();
+    }
+}
 
-    if (emptyRow == -1) {
-        // Matrix is already full, but not decoded. New packet can't be innovative.
-        return false;
+void
+NetworkCodingDecoder::ReportSolvedSymbols (void)
+{
+  // A pivot row is zero before its pivot, so it is the unit vector e_i iff
+  // nothing after column i is left; its payload is then source packet i.
+  // Rows the packet did not change cannot have become unit vectors.
+  for (uint16_t row : m_touchedRows)
+    {
+      const uint8_t *coefficients = m_matrix.GetCoefficients (row);
+      uint32_t end = m_rowEnd[row];
+      while (end > row + 1u && coefficients[end - 1] == 0)
+        {
+          end--;
+        }
+      m_rowEnd[row] = end;
+      if (end != row + 1u || m_solvedEpoch[row] == m_epoch)
+        {
+          continue;
+        }
+      m_solvedEpoch[row] = m_epoch;
+      m_solvedSymbols++;
+      NS_LOG_INFO ("Source symbol " << row << " of generation " << m_currentGeneration
+                   << " decoded at rank " << m_rank);
+      m_symbolDecodedTrace (m_currentGeneration, row,
+                            Create<Packet> (m_matrix.GetPayload (row), m_packetSize));
     }
+  m_touchedRows.clear ();
+}
 
-    tempMatrix[emptyRow] = newCoeffs;
+void
+NetworkCodingDecoder::SetPartialDecoding (bool partial)
+{
+  m_partialDecoding = partial;
+}
 
-    // Check if rank increases
-    return CalculateRank(tempMatrix) > GetRank();
+bool
+NetworkCodingDecoder::GetPartialDecoding (void) const
+{
+  return m_partialDecoding;
 }
 
 bool
-NetworkCodingDecoder::CanDecode (void) const
+NetworkCodingDecoder::IsSymbolDecoded (uint16_t index) const
 {
-  // Can decode if the coefficient matrix has full rank
-  return GetRank () == m_generationSize;
+  NS_ASSERT (index < m_generationSize);
+  return m_decoded || m_solvedEpoch[index] == m_epoch;
 }
 
 uint16_t
-NetworkCodingDecoder::GetRank (void) const
+NetworkCodingDecoder::GetDecodedSymbolCount (void) const
 {
-  return CalculateRank (m_coefficients);
+  return m_decoded ? m_generationSize : m_solvedSymbols;
 }
 
-uint16_t
-NetworkCodingDecoder::CalculateRank (const std::vector<std::vector<uint8_t>>& matrix_const) const
+Ptr<Packet>
+NetworkCodingDecoder::GetDecodedSymbol (uint16_t index) const
+{
+  if (!IsSymbolDecoded (index))
+    {
+      return nullptr;
+    }
+  return Create<Packet> (m_matrix.GetPayload (index), m_packetSize);
+}
+
+template <class Codec>
+void
+NetworkCodingDecoder::BackSubstitute (void)
+{
+  // Walk the pivots from the last column down. By the time column j is
+  // cleared from the rows above, row j has lost every later column and is
+  // a unit vector, so only one coefficient changes per row and the work is
+  // all in the payloads. Those are collected and run as one batch.
+  m_payloadOps.clear ();
+  for (uint32_t j = Codec::GetGenerationSize (m_generationSize); j-- > 0; )
+    {
+      const uint8_t *pivotPayload = m_matrix.GetPayload (j);
+      for (uint32_t i = 0; i < j; i++)
+        {
+          if (m_rowEnd[i] <= j)
+            {
+              continue;
+            }
+          uint8_t *rowCoeffs = m_matrix.GetCoefficients (i);
+          uint8_t factor = rowCoeffs[j];
+          if (factor != 0)
+            {
+              rowCoeffs[j] = 0;
+              m_payloadOps.push_back ({m_matrix.GetPayload (i), pivotPayload, factor});
+            }
+        }
+      m_rowEnd[j] = j + 1;
+    }
+  ApplyPayloadOps<Codec> ();
+  m_reduced = true;
+}
+
+template <class Codec>
+void
+NetworkCodingDecoder::ApplyPayloadOps (void)
+{
+  if (UsesBlockedElimination ())
+    {
+      // The scratch row's operations are logged before it becomes a pivot
+      // row, and a redundant row never gets here, so the log never refers
+      // to a row that is overwritten before it runs
+      m_blockedOps.insert (m_blockedOps.end (), m_payloadOps.begin (), m_payloadOps.end ());
+      if (m_blockedOps.size () >= MAX_BLOCKED_OPS)
+        {
+          FlushBlockedOps<Codec> ();
+        }
+    }
+  else
+    {
+      FlushBlockedOps<Codec> ();
+      Codec::ApplyPayloadOps (m_payloadOps.data (), m_payloadOps.size (), m_packetSize);
+    }
+  m_payloadOps.clear ();
+}
+
+template <class Codec>
+void
+NetworkCodingDecoder::FlushBlockedOps (void)
+{
+  if (!m_blockedOps.empty ())
+    {
+      Codec::ApplyPayloadOps (m_blockedOps.data (), m_blockedOps.size (), m_packetSize, m_tileSize);
+      m_blockedOps.clear ();
+    }
+}
+
+bool
+NetworkCodingDecoder::UsesBlockedElimination (void) const
 {
-  // Copy the coefficient matrix to avoid modifying it
-  std::vector<std::vector<uint8_t>> matrix = matrix_const;
+  return m_blocked && !m_partialDecoding;
+}
+
+void
+NetworkCodingDecoder::Solve (void)
+{
+  // No logging here: this may run on a worker thread
+  if (!CanDecode ())
+    {
+      return;
+    }
+  if (m_inverse)
+    {
+      switch (m_field)
+        {
+        case gf::FIELD_BINARY:
+          ApplyInverse<gf::Binary> ();
+          break;
+        case gf::FIELD_BINARY4:
+          ApplyInverse<gf::Binary4> ();
+          break;
+        case gf::FIELD_BINARY8:
+          ApplyInverse<gf::Binary8> ();
+          break;
+        }
+    }
+  gf::DispatchCodec (m_field, m_generationSize, m_packetSize, [this] (auto codec) {
+    typedef decltype (codec) Codec;
+    if (!m_reduced)
+      {
+        BackSubstitute<Codec> ();
+      }
+    FlushBlockedOps<Codec> ();
+  });
+  if (m_storePattern)
+    {
+      m_storePattern = false;
+      switch (m_field)
+        {
+        case gf::FIELD_BINARY:
+          StorePattern<gf::Binary> ();
+          break;
+        case gf::FIELD_BINARY4:
+          StorePattern<gf::Binary4> ();
+          break;
+        case gf::FIELD_BINARY8:
+          StorePattern<gf::Binary8> ();
+          break;
+        }
+    }
+}
+
+void
+NetworkCodingDecoder::SetInverseCache (Ptr<DecodingInverseCache> cache)
+{
+  NS_LOG_FUNCTION (this << cache);
+  if (cache != m_inverseCache)
+    {
+      m_inverseCache = cache;
+      AllocateMatrix ();
+      m_decoded = false;
+      m_decodedPackets.clear ();
+    }
+}
+
+Ptr<DecodingInverseCache>
+NetworkCodingDecoder::GetInverseCache (void) const
+{
+  return m_inverseCache;
+}
+
+bool
+NetworkCodingDecoder::UsesInverseCache (void) const
+{
+  return m_inverseCache && !m_partialDecoding;
+}
+
+uint64_t
+NetworkCodingDecoder::StagePatternRow (const std::vector<uint8_t> &coefficients, uint32_t usable)
+{
+  uint8_t *row = &m_patternCoefficients[static_cast<size_t> (m_rank) * m_generationSize];
+  std::fill_n (row, m_generationSize, 0);
+  std::copy_n (coefficients.begin (), usable, row);
+  return DecodingInverseCache::Extend (m_patternHash, row, m_generationSize);
+}
+
+bool
+NetworkCodingDecoder::StoreRawRow (Ptr<const Packet> payload, uint64_t patternHash)
+{
+  NS_LOG_FUNCTION (this << patternHash);
   
-  // Use Gaussian elimination to calculate the rank
-  uint16_t rank = 0;
+  // A prefix of a basis is linearly independent, so the row is innovative
+  // without being reduced; its payload is needed as it came
+  uint8_t *row = m_received.GetPayload (m_rank);
+  uint32_t size = std::min (payload->GetSize (), (uint32_t)m_packetSize);
+  payload->CopyData (row, size);
+  std::fill (row + size, row + m_packetSize, 0);
+  m_patternHash = patternHash;
+  m_patternPrefixes.push_back (patternHash);
+  m_rank++;
+  if (!CanDecode ())
+    {
+      return true;
+    }
   
-  // For each column (potential pivot)
-  for (size_t j = 0; j < m_generationSize; j++)
+  m_inverse = m_inverseCache->Lookup (patternHash, m_patternCoefficients.data (),
+                                      m_patternCoefficients.size ());
+  if (!m_inverse)
     {
-      // Find a row with a non-zero entry in this column
-      size_t pivotRow = rank;
-      while (pivotRow < m_generationSize && matrix[pivotRow][j] == 0)
+      // Every prefix matched but the whole matrix does not: a hash collision
+      NS_LOG_WARN ("Pattern of generation " << m_currentGeneration << " collides with a cached one");
+      bool innovative = ReplayRawRows ();
+      m_storePattern = CanDecode ();
+      if (CanDecode () && m_reduced)
         {
-          pivotRow++;
+          DecodeGeneration ();
         }
-      
-      if (pivotRow < m_generationSize)
+      return innovative;
+    }
+  
+  NS_LOG_INFO ("Generation " << m_currentGeneration << " matches a cached pattern");
+  if (!m_deferred)
+    {
+      DecodeGeneration ();
+    }
+  return true;
+}
+
+bool
+NetworkCodingDecoder::ReplayRawRows (void)
+{
+  NS_LOG_FUNCTION (this << m_rank);
+  
+  // Feed the rows held through the elimination in their arrival order,
+  // compacting the pattern over any that turn out to be redundant
+  uint16_t rows = m_rank;
+  ResetMatrix ();
+  m_rawRows = false;
+  bool innovative = false;
+  for (uint16_t k = 0; k < rows; k++)
+    {
+      const uint8_t *coefficients = &m_patternCoefficients[static_cast<size_t> (k) * m_generationSize];
+      uint16_t slot = m_rank;
+      m_matrix.ZeroRow (m_generationSize);
+      std::copy_n (coefficients, m_generationSize, m_matrix.GetCoefficients (m_generationSize));
+      std::copy_n (m_received.GetPayload (k), m_packetSize, m_matrix.GetPayload (m_generationSize));
+      innovative = ReduceStagedRow ();
+      if (!innovative)
+        {
+          continue;
+        }
+      uint8_t *row = &m_patternCoefficients[static_cast<size_t> (slot) * m_generationSize];
+      if (slot != k)
         {
-          // Found a pivot, swap rows if necessary
-          if (pivotRow != rank)
+          std::copy_n (coefficients, m_generationSize, row);
+        }
+      m_patternHash = DecodingInverseCache::Extend (m_patternHash, row, m_generationSize);
+      m_patternPrefixes.push_back (m_patternHash);
+    }
+  return innovative;
+}
+
+bool
+NetworkCodingDecoder::ReduceStagedRow (void)
+{
+  return gf::DispatchCodec (m_field, m_generationSize, m_packetSize, [this] (auto codec) {
+    return EliminateRow<decltype (codec)> ();
+  });
+}
+
+template <class Field>
+void
+NetworkCodingDecoder::ApplyInverse (void)
+{
+  // Source packet i is the sum of the received rows weighted by row i of
+  // the inverse; the zeroed rows receive the product as one batch
+  const uint8_t *inverse = m_inverse->data ();
+  m_payloadOps.clear ();
+  for (uint32_t i = 0; i < m_generationSize; i++)
+    {
+      m_matrix.ZeroRow (i);
+      m_matrix.GetCoefficients (i)[i] = 1;
+      uint8_t *payload = m_matrix.GetPayload (i);
+      const uint8_t *weights = inverse + static_cast<size_t> (i) * m_generationSize;
+      for (uint32_t j = 0; j < m_generationSize; j++)
+        {
+          if (weights[j] != 0)
             {
-              std::swap (matrix[rank], matrix[pivotRow]);
+              m_payloadOps.push_back ({payload, m_received.GetPayload (j), weights[j]});
             }
-          
-          // Zero out entries below the pivot
-          for (size_t i = rank + 1; i < m_generationSize; i++)
+        }
+      m_pivotEpoch[i] = m_epoch;
+      m_rowEnd[i] = i + 1;
+    }
+  gf::ApplyRegionOps<Field> (m_payloadOps.data (), m_payloadOps.size (), m_packetSize, m_tileSize);
+  m_payloadOps.clear ();
+  m_inverse = nullptr;
+  m_rawRows = false;
+  m_reduced = true;
+}
+
+template <class Field>
+void
+NetworkCodingDecoder::StorePattern (void)
+{
+  // Gauss-Jordan on [pattern | identity] over the coefficients alone; the
+  // pattern has full rank, so every column finds a pivot
+  const uint32_t size = m_generationSize;
+  std::vector<uint8_t> work (m_patternCoefficients);
+  auto inverse = std::make_shared<std::vector<uint8_t>> (static_cast<size_t> (size) * size, 0);
+  uint8_t *result = inverse->data ();
+  for (uint32_t i = 0; i < size; i++)
+    {
+      result[static_cast<size_t> (i) * size + i] = 1;
+    }
+  for (uint32_t column = 0; column < size; column++)
+    {
+      uint32_t pivot = column;
+      while (pivot < size && work[static_cast<size_t> (pivot) * size + column] == 0)
+        {
+          pivot++;
+        }
+      if (pivot == size)
+        {
+          return;
+        }
+      uint8_t *pivotRow = &work[static_cast<size_t> (column) * size];
+      uint8_t *pivotResult = result + static_cast<size_t> (column) * size;
+      if (pivot != column)
+        {
+          std::swap_ranges (pivotRow, pivotRow + size, &work[static_cast<size_t> (pivot) * size]);
+          std::swap_ranges (pivotResult, pivotResult + size, result + static_cast<size_t> (pivot) * size);
+        }
+      uint8_t scale = Field::Inverse (pivotRow[column]);
+      if (scale != 1)
+        {
+          Field::MultiplyRegion (pivotRow, scale, size);
+          Field::MultiplyRegion (pivotResult, scale, size);
+        }
+      for (uint32_t row = 0; row < size; row++)
+        {
+          uint8_t factor = work[static_cast<size_t> (row) * size + column];
+          if (row != column && factor != 0)
             {
-              if (matrix[i][j] != 0)
-                {
-                  // Calculate the factor to zero out this entry
-                  uint8_t factor = m_gf->Divide (matrix[i][j], matrix[rank][j]);
-                  
-                  // Zero out the entry and all others in this row
-                  for (size_t k = j; k < m_generationSize; k++)
-                    {
-                      uint8_t product = m_gf->Multiply (factor, matrix[rank][k]);
-                      matrix[i][k] = m_gf->Subtract (matrix[i][k], product);
-                    }
-                }
+              Field::MultiplyAddRegion (&work[static_cast<size_t> (row) * size], pivotRow, factor, size);
+              Field::MultiplyAddRegion (result + static_cast<size_t> (row) * size, pivotResult, factor, size);
             }
-          
-          rank++;
         }
     }
-  
-  return rank;
+  m_inverseCache->Insert (m_patternHash, m_patternCoefficients.data (), m_patternCoefficients.size (),
+                          inverse, m_patternPrefixes, m_patternRedundant);
+}
+
+void
+NetworkCodingDecoder::SetDeferredSubstitution (bool deferred)
+{
+  m_deferred = deferred;
+}
+
+bool
+NetworkCodingDecoder::GetDeferredSubstitution (void) const
+{
+  return m_deferred;
+}
+
+bool
+NetworkCodingDecoder::CanDecode (void) const
+{
+  // Can decode if the coefficient matrix has full rank
+  return GetRank () == m_generationSize;
+}
+
+uint16_t
+NetworkCodingDecoder::GetRank (void) const
+{
+  return m_rank;
 }
 
 void
@@ -370,90 +946,19 @@ NetworkCodingDecoder::DecodeGeneration (void)
     return;
   }
   
-  // Make copies of the coefficient matrix and coded payloads for Gaussian elimination
-  std::vector<std::vector<uint8_t>> coeffMatrix = m_coefficients;
-  std::vector<std::vector<uint8_t>> payloadMatrix = m_codedPayloads;
+  // With full rank every column has a pivot and, once substituted, the
+  // matrix is the identity, so row i holds source packet i.
+  Solve ();
+  m_decodedPackets.clear();
+  m_decodedPackets.reserve(m_generationSize);
   
-  try {
-    // Step 1: Forward elimination to get reduced row echelon form
-    for (size_t i = 0; i < m_generationSize; i++)
-      {
-        // Find pivot
-        size_t pivotRow = i;
-        for (size_t j = i + 1; j < m_generationSize; j++) {
-          if (coeffMatrix[j][i] != 0) {
-            pivotRow = j;
-            break;
-          }
-        }
-        
-        // Check if pivot is non-zero
-        if (coeffMatrix[pivotRow][i] == 0) {
-          NS_LOG_ERROR("Matrix is singular at row " << i);
-          return;
-        }
-        
-        // Swap rows if needed
-        if (pivotRow != i) {
-          std::swap(coeffMatrix[i], coeffMatrix[pivotRow]);
-          std::swap(payloadMatrix[i], payloadMatrix[pivotRow]);
-        }
-        
-        // Normalize pivot row
-        uint8_t pivot = coeffMatrix[i][i];
-        if (pivot == 0) {
-          NS_LOG_ERROR("Zero pivot encountered");
-          return;
-        }
-        
-        uint8_t pivotInv = m_gf->Inverse(pivot);
-        
-        // Normalize coefficient row
-        for (size_t j = 0; j < m_generationSize; j++) {
-          coeffMatrix[i][j] = m_gf->Multiply(coeffMatrix[i][j], pivotInv);
-        }
-        
-        // Normalize payload row
-        for (size_t j = 0; j < m_packetSize; j++) {
-          payloadMatrix[i][j] = m_gf->Multiply(payloadMatrix[i][j], pivotInv);
-        }
-        
-        // Eliminate column in other rows
-        for (size_t j = 0; j < m_generationSize; j++) {
-          if (j != i && coeffMatrix[j][i] != 0) {
-            uint8_t factor = coeffMatrix[j][i];
-            
-            // Eliminate coefficients
-            for (size_t k = 0; k < m_generationSize; k++) {
-              uint8_t product = m_gf->Multiply(factor, coeffMatrix[i][k]);
-              coeffMatrix[j][k] = m_gf->Subtract(coeffMatrix[j][k], product);
-            }
-            
-            // Eliminate payload
-            for (size_t k = 0; k < m_packetSize; k++) {
-              uint8_t product = m_gf->Multiply(factor, payloadMatrix[i][k]);
-              payloadMatrix[j][k] = m_gf->Subtract(payloadMatrix[j][k], product);
-            }
-          }
-        }
-      }
-    
-    // Create packets from the decoded data
-    m_decodedPackets.clear();
-    m_decodedPackets.reserve(m_generationSize);
-    
-    for (size_t i = 0; i < m_generationSize; i++) {
-      Ptr<Packet> packet = Create<Packet>(payloadMatrix[i].data(), m_packetSize);
-      m_decodedPackets.push_back(packet);
-    }
-    
-    m_decoded = true;
-    NS_LOG_INFO ("Successfully decoded generation " << m_currentGeneration);
-    
-  } catch (const std::exception& e) {
-    NS_LOG_ERROR("Exception during decoding: " << e.what());
-    m_decoded = false;
+  for (size_t i = 0; i < m_generationSize; i++) {
+    Ptr<Packet> packet = Create<Packet>(m_matrix.GetPayload (i), m_packetSize);
+    m_decodedPackets.push_back(packet);
   }
+  
+  m_decoded = true;
+  NS_LOG_INFO ("Successfully decoded generation " << m_currentGeneration);
 }
 
 std::vector<Ptr<Packet>>
@@ -496,19 +1001,18 @@ void
 NetworkCodingDecoder::NextGeneration (void)
 {
   NS_LOG_FUNCTION (this);
+  SetCurrentGenerationId (m_currentGeneration + 1);
+}
+
+void
+NetworkCodingDecoder::SetCurrentGenerationId (uint32_t generationId)
+{
+  NS_LOG_FUNCTION (this << generationId);
   
-  m_currentGeneration++;
+  m_currentGeneration = generationId;
   
   // Reset the coefficient matrix and coded payloads
-  for (auto& row : m_coefficients)
-    {
-      std::fill (row.begin (), row.end (), 0);
-    }
-  
-  for (auto& payload : m_codedPayloads)
-    {
-      std::fill (payload.begin (), payload.end (), 0);
-    }
+  ResetMatrix ();
   
   // Reset decoder state
   m_decoded = false;
@@ -518,6 +1022,96 @@ NetworkCodingDecoder::NextGeneration (void)
   NS_LOG_INFO ("Moving to generation " << m_currentGeneration);
 }
 
+void
+NetworkCodingDecoder::AllocateMatrix (void)
+{
+  // One row per pivot column plus a scratch row for the incoming packet
+  m_matrix.Resize (m_generationSize + 1, m_generationSize, m_packetSize);
+  m_pivotEpoch.assign (m_generationSize, 0);
+  m_epoch = 1;
+  m_rowEnd.assign (m_generationSize, 0);
+  m_solvedEpoch.assign (m_generationSize, 0);
+  m_solvedSymbols = 0;
+  m_rank = 0;
+  m_codedPivots = 0;
+  m_reduced = true;
+  // Columns per tile, so the blocks of all rows in one tile stay in L2.
+  // Splitting a row in fewer than two tiles does not pay for the logging.
+  size_t tile = GenerationBuffer::Align (ELIMINATION_CACHE_BYTES / (m_generationSize + 1u));
+  if (tile < MIN_TILE_BYTES)
+    {
+      tile = MIN_TILE_BYTES;
+    }
+  m_blocked = 2 * tile <= m_packetSize;
+  m_tileSize = m_blocked ? tile : m_packetSize;
+  m_blockedOps.clear ();
+  if (m_inverseCache)
+    {
+      m_received.Resize (m_generationSize, 0, m_packetSize);
+      m_patternCoefficients.assign (static_cast<size_t> (m_generationSize) * m_generationSize, 0);
+    }
+  ResetPattern ();
+}
+
+void
+NetworkCodingDecoder::ResetMatrix (void)
+{
+  // Rows without a pivot are never read and the scratch row is cleared
+  // before use, so only the pivot bookkeeping has to be reset
+  if (++m_epoch == 0)
+    {
+      // Stamps from 2^32 generations ago would match again
+      std::fill (m_pivotEpoch.begin (), m_pivotEpoch.end (), 0);
+      std::fill (m_solvedEpoch.begin (), m_solvedEpoch.end (), 0);
+      m_epoch = 1;
+    }
+  m_solvedSymbols = 0;
+  m_rank = 0;
+  m_codedPivots = 0;
+  m_reduced = true;
+  m_blockedOps.clear ();
+  ResetPattern ();
+}
+
+void
+NetworkCodingDecoder::ResetPattern (void)
+{
+  m_rawRows = UsesInverseCache ();
+  m_patternHash = DecodingInverseCache::Begin (m_field, m_generationSize);
+  m_patternPrefixes.clear ();
+  m_patternRedundant.clear ();
+  m_inverse = nullptr;
+  m_storePattern = false;
+}
+
+bool
+NetworkCodingDecoder::HasPivot (uint32_t column) const
+{
+  return m_pivotEpoch[column] == m_epoch;
+}
+
+void
+NetworkCodingDecoder::SetField (gf::FieldType field)
+{
+  NS_LOG_FUNCTION (this << field);
+  NS_ASSERT_MSG (gf::IsValidField (field), "Unsupported field");
+  
+  if (field != m_field)
+    {
+      // Rows reduced in another field are meaningless
+      m_field = field;
+      ResetMatrix ();
+      m_decoded = false;
+      m_decodedPackets.clear ();
+    }
+}
+
+gf::FieldType
+NetworkCodingDecoder::GetField (void) const
+{
+  return m_field;
+}
+
 uint32_t
 NetworkCodingDecoder::GetCurrentGenerationId (void) const
 {
@@ -23,8 +23,12 @@
 
 #include "ns3/object.h"
 #include "ns3/packet.h"
+#include "ns3/traced-callback.h"
 #include "network-coding-packet.h"
-#include "galois-field.h"
+#include "galois-field-traits.h"
+#include "generation-buffer.h"
+#include "network-coding-codec.h"
+#include "decoding-inverse-cache.h"
 #include <vector>
 #include <set>
 
@@ -32,11 +36,45 @@ namespace ns3 {
 
 /**
  * \ingroup network-coding
- * \brief Network coding decoder for linear coding in GF(2^8)
+ * \brief Network coding decoder for linear coding in GF(2^8), GF(2^4) or GF(2)
  *
  * This class decodes network-coded packets using Gaussian elimination
- * in GF(2^8). It collects coded packets until the decoding matrix has 
- * full rank, then recovers the original packets.
+ * in the field chosen with SetField (GF(2^8) by default). Elimination is progressive: every received packet is
+ * reduced against the pivot rows already held (coefficients and payload
+ * together) and, if it is innovative, becomes a new pivot row that is
+ * immediately back-substituted into the others. The stored rows are thus
+ * always in reduced row echelon form, the rank is a plain counter and the
+ * generation is decoded as soon as the last innovative packet arrives.
+ *
+ * Each pivot row remembers the last column it is nonzero in, so rows of
+ * sparse codes are only reduced over the columns they touch.
+ *
+ * With deferred substitution the rows are only kept in row echelon form
+ * while packets arrive, and the back-substitution runs once in Solve after
+ * the last innovative packet. Solve touches nothing but this decoder, so
+ * decoders of different generations can be solved on worker threads.
+ *
+ * With partial decoding, every row that has been reduced to a unit vector
+ * e_i is reported right away through the SymbolDecoded trace: source
+ * packet i is known before the generation reaches full rank, and stays
+ * known if it never does.
+ *
+ * With an inverse cache shared by the decoders of several generations, rows
+ * whose coefficients repeat a pattern an earlier generation was decoded
+ * from are stored as received, without any elimination. At full rank the
+ * source packets are the cached inverse times those rows, a single batch of
+ * payload operations. The first row that leaves the known patterns puts the
+ * rows held through the usual elimination, and the inverse of the matrix
+ * finally received is added to the cache.
+ *
+ * Generations whose rows are well beyond ELIMINATION_CACHE_BYTES, e.g.
+ * hundreds of long packets of the up to 65535 a generation may hold, keep
+ * the coefficient elimination progressive but log its payload operations
+ * instead of running them per packet, which would stream every row through
+ * the cache each time. The log runs one column tile at a time, the tile
+ * narrow enough for the blocks of all rows to stay in cache, whenever it
+ * grows long and when the generation is solved. Partial decoding needs
+ * current payloads and turns this off.
  */
 class NetworkCodingDecoder : public Object
 {
@@ -88,43 +126,354 @@ public:
    */
   uint16_t GetPacketSize (void) const;
 
+  /**
+   * \brief Set the finite field used for decoding
+   * \param field Must match the encoder; changing it restarts the generation
+   */
+  void SetField (gf::FieldType field);
+  gf::FieldType GetField (void) const;
+
+  /**
+   * \brief Process a received coded packet
+   * \param packet The packet, starting with its NetworkCodingHeader
+   * \return true if the packet was innovative
+   */
   bool ProcessCodedPacket (Ptr<const Packet> packet);
+
+  /**
+   * \brief Process a coded packet whose header has already been parsed
+   * \param payload The coded payload, without the NetworkCodingHeader
+   * \param header The header that came with the payload
+   * \return true if the packet was innovative
+   *
+   * Callers that already looked at the header (e.g. to route it to the
+   * right generation) use this to avoid parsing it twice. The payload is
+   * read once, straight into the decoder's row storage.
+   */
+  bool ProcessCodedPacket (Ptr<const Packet> payload, const NetworkCodingHeader &header);
   bool CanDecode (void) const;
   uint16_t GetRank (void) const;
   
+  /**
+   * \brief Postpone back-substitution until the generation has full rank
+   * \param deferred true to leave the final substitution to Solve
+   *
+   * With deferred substitution reaching full rank does not decode the
+   * generation; Solve or GetDecodedPackets has to be called.
+   */
+  void SetDeferredSubstitution (bool deferred);
+  bool GetDeferredSubstitution (void) const;
+
+  /**
+   * \brief Reduce a full-rank matrix to the identity
+   *
+   * Needed only with deferred substitution, otherwise a no-op. Does not
+   * create packets or touch simulator state, so it may run on another
+   * thread as long as nothing else uses this decoder meanwhile.
+   */
+  void Solve (void);
+
+  /**
+   * \brief Report source symbols as soon as they are uniquely determined
+   * \param partial true to look for unit rows after every innovative packet
+   *
+   * Only the rows a packet changed are checked, at the cost of one pass over
+   * their coefficients.
+   */
+  void SetPartialDecoding (bool partial);
+  bool GetPartialDecoding (void) const;
+
+  /**
+   * \brief Share the inverses of recurring coefficient matrices
+   * \param cache The cache, or nullptr to always eliminate; changing it
+   *        restarts the generation
+   *
+   * Ignored while partial decoding is on, which needs the reduced rows.
+   */
+  void SetInverseCache (Ptr<DecodingInverseCache> cache);
+  Ptr<DecodingInverseCache> GetInverseCache (void) const;
+
+  /**
+   * \brief Check whether one source symbol is known
+   * \param index Index of the source packet in the generation
+   * \return true once the generation is decoded or, with partial decoding,
+   *         once the symbol's row was reduced to a unit vector
+   */
+  bool IsSymbolDecoded (uint16_t index) const;
+
+  /**
+   * \brief Get the number of source symbols known so far
+   * \return the generation size once decoded, else the symbols found by
+   *         partial decoding
+   */
+  uint16_t GetDecodedSymbolCount (void) const;
+
+  /**
+   * \brief Get one source packet, decoded or not yet the whole generation
+   * \param index Index of the source packet in the generation
+   * \return the packet, or nullptr if IsSymbolDecoded (index) is false
+   */
+  Ptr<Packet> GetDecodedSymbol (uint16_t index) const;
+
+  /**
+   * \brief TracedCallback signature for a source symbol becoming known
+   * \param [in] generationId The generation
+   * \param [in] index Index of the source packet in the generation
+   * \param [in] symbol The source packet
+   */
+  typedef void (*SymbolTracedCallback) (uint32_t generationId, uint16_t index,
+                                        Ptr<const Packet> symbol);
+
   std::vector<Ptr<Packet>> GetDecodedPackets (void);
   std::set<uint32_t> GetMissingPackets (void) const;
 
   void NextGeneration (void);
+
+  /**
+   * \brief Drop the current generation and start decoding another one
+   * \param generationId The generation to decode next
+   */
+  void SetCurrentGenerationId (uint32_t generationId);
   uint32_t GetCurrentGenerationId (void) const;
 
 private:
   void DecodeGeneration (void);
-  uint16_t CalculateRank (const std::vector<std::vector<uint8_t>>& matrix) const;
-  bool IsInnovative(const std::vector<uint8_t>& newCoeffs) const;
+
+  /**
+   * \brief Reduce the row staged in the scratch slot and store it if innovative
+   * \return true if the row increased the rank
+   *
+   * Codec is a gf::CodecT that selects the arithmetic and, for the common
+   * configurations, fixes the sizes; gf::DispatchCodec instantiates them
+   * in the .cc file and picks one per packet from m_field and the sizes.
+   */
+  template <class Codec>
+  bool EliminateRow (void);
+
+  /**
+   * \brief Store the unit-vector row staged in the scratch slot
+   * \param column The only nonzero column of the row, which has no pivot yet
+   *
+   * Systematic (uncoded) packets need no forward reduction. They are only
+   * normalized, and back-substitution is skipped while every pivot row
+   * held is itself a unit vector.
+   *
+   * \return always true, the row is innovative by construction
+   */
+  template <class Codec>
+  bool InsertUnitRow (uint32_t column);
+
+  /**
+   * \brief Back-substitute the normalized scratch row and make it the pivot
+   * \param lead Pivot column of the scratch row
+   * \param end One past the last nonzero coefficient of the scratch row
+   */
+  template <class Codec>
+  void StorePivotRow (uint32_t lead, uint32_t end);
+
+  /**
+   * \brief Clear every pivot column from the rows above it
+   */
+  template <class Codec>
+  void BackSubstitute (void);
+
+  /**
+   * \brief Run the payload operations collected for the current step
+   *
+   * With blocked elimination they are appended to m_blockedOps instead.
+   */
+  template <class Codec>
+  void ApplyPayloadOps (void);
+
+  /**
+   * \brief Run the logged payload operations tile by tile
+   */
+  template <class Codec>
+  void FlushBlockedOps (void);
+
+  /**
+   * \brief Check whether payload operations are logged for tiled execution
+   * \return true for rows beyond the cache budget, without partial decoding
+   */
+  bool UsesBlockedElimination (void) const;
+
+  /**
+   * \brief Check whether packets are matched against the inverse cache
+   * \return true with a cache and without partial decoding
+   */
+  bool UsesInverseCache (void) const;
+
+  /**
+   * \brief Write a packet's coefficients as the next row of the pattern
+   * \param coefficients The coefficients from the header
+   * \param usable How many of them belong to the generation
+   * \return the pattern hash with the row appended
+   */
+  uint64_t StagePatternRow (const std::vector<uint8_t> &coefficients, uint32_t usable);
+
+  /**
+   * \brief Keep a packet that extends a cached pattern as received
+   * \param payload The coded payload
+   * \param patternHash Hash of the pattern including the packet's row
+   * \return true if the packet was innovative
+   */
+  bool StoreRawRow (Ptr<const Packet> payload, uint64_t patternHash);
+
+  /**
+   * \brief Eliminate the rows stored as received and stop storing them so
+   * \return true if the last of them was innovative
+   */
+  bool ReplayRawRows (void);
+
+  /**
+   * \brief Reduce the row staged in the scratch slot in the current field
+   * \return true if the row increased the rank
+   */
+  bool ReduceStagedRow (void);
+
+  /**
+   * \brief Decode the rows stored as received with the cached inverse
+   */
+  template <class Field>
+  void ApplyInverse (void);
+
+  /**
+   * \brief Invert the pattern of this generation and add it to the cache
+   */
+  template <class Field>
+  void StorePattern (void);
+
+  /**
+   * \brief Report the rows of m_touchedRows that are now unit vectors
+   *
+   * Also tightens m_rowEnd of every row checked to its last nonzero column.
+   */
+  void ReportSolvedSymbols (void);
+
+  /**
+   * \brief Size the row storage for the current generation and packet size
+   */
+  void AllocateMatrix (void);
+
+  /**
+   * \brief Forget all stored rows
+   *
+   * Constant time: the pivot stamps of the previous generation simply stop
+   * matching m_epoch, so a reused decoder does not touch its rows again.
+   */
+  void ResetMatrix (void);
+
+  /**
+   * \brief Start an empty pattern for the next rows
+   */
+  void ResetPattern (void);
+
+  /**
+   * \brief Check whether a column has a pivot row in this generation
+   * \param column Column index
+   * \return true if row column holds a pivot row
+   */
+  bool HasPivot (uint32_t column) const;
+
+  /**
+   * \brief Bytes of payload rows one tile of blocked elimination spans
+   */
+  static const size_t ELIMINATION_CACHE_BYTES = 1024 * 1024;
+
+  /**
+   * \brief Narrowest tile; below it the per-operation cost dominates
+   */
+  static const size_t MIN_TILE_BYTES = 512;
+
+  /**
+   * \brief Logged operations at which blocked elimination runs the log
+   */
+  static const size_t MAX_BLOCKED_OPS = 1 << 14;
 
   uint16_t m_generationSize;
   uint16_t m_packetSize;
   uint32_t m_currentGeneration;            //!< Current generation ID
   bool m_decoded;
+  uint16_t m_rank;                         //!< Number of pivot rows held
+  uint16_t m_codedPivots;                  //!< Pivot rows that came from coded packets
+  bool m_deferred;                         //!< Back-substitute only once, in Solve
+  bool m_reduced;                          //!< Pivot rows are zero in all other pivot columns
+  uint32_t m_epoch;                        //!< Stamp of the current generation's pivots
+  bool m_partialDecoding;                  //!< Report unit rows as they appear
+  uint16_t m_solvedSymbols;                //!< Unit rows reported in this generation
 
   std::set<uint32_t> m_receivedSequences;
   
-  Ptr<GaloisField> m_gf;
+  gf::FieldType m_field;                   //!< Field the packets are coded in
   /**
-   * \brief Coefficient matrix (row-major order)
+   * \brief Coefficient matrix and coded payloads, one [coefficients | payload] row each
+   *
+   * Row i holds the pivot row whose leading coefficient is in column i,
+   * normalized to 1; it is only meaningful if HasPivot (i). Row
+   * m_generationSize is scratch space for the packet being processed.
    */
-  std::vector<std::vector<uint8_t>> m_coefficients;
-  
+  GenerationBuffer m_matrix;
+
   /**
-   * \brief Coded payloads corresponding to coefficient rows
+   * \brief Epoch in which column i last received a pivot row
+   *
+   * Column i has a pivot row iff m_pivotEpoch[i] == m_epoch.
    */
-  std::vector<std::vector<uint8_t>> m_codedPayloads;
+  std::vector<uint32_t> m_pivotEpoch;
+
+  /**
+   * \brief One past the last column pivot row i may be nonzero in
+   *
+   * A pivot row is zero before its pivot, so [i, m_rowEnd[i]) bounds
+   * every nonzero coefficient of the row.
+   */
+  std::vector<uint16_t> m_rowEnd;
+
+  /**
+   * \brief Epoch in which row i was reported as a unit vector
+   */
+  std::vector<uint32_t> m_solvedEpoch;
+
+  /**
+   * \brief Rows changed by the current packet, checked by ReportSolvedSymbols
+   */
+  std::vector<uint16_t> m_touchedRows;
+
+  /**
+   * \brief Payload row operations collected for the current step
+   *
+   * Coefficients are reduced eagerly, since they decide what happens next;
+   * the payload work is batched so that long payloads can be striped over
+   * the parallel region threads (gf::ForEachStripe).
+   */
+  std::vector<gf::RegionOp> m_payloadOps;
+
+  bool m_blocked;                          //!< Rows span at least two tiles
+  size_t m_tileSize;                       //!< Payload columns per tile of blocked elimination
+  std::vector<gf::RegionOp> m_blockedOps;  //!< Payload operations not run yet, in order
   
   /**
    * \brief Vector of decoded packets
    */
   std::vector<Ptr<Packet>> m_decodedPackets;
+
+  TracedCallback<uint32_t, uint16_t, Ptr<const Packet>> m_symbolDecodedTrace;
+
+  Ptr<DecodingInverseCache> m_inverseCache; //!< Shared with other decoders, may be null
+  bool m_rawRows;                          //!< Rows are stored as received, not eliminated
+  uint64_t m_patternHash;                  //!< Hash of the innovative rows so far
+  std::vector<uint64_t> m_patternPrefixes; //!< m_patternHash after each innovative row
+  std::vector<uint64_t> m_patternRedundant; //!< Pattern hash with each redundant row appended
+  /**
+   * \brief Coefficients of the innovative packets as received, row-major
+   *
+   * Row k belongs to the k-th innovative packet; the next packet is staged
+   * in row m_rank.
+   */
+  std::vector<uint8_t> m_patternCoefficients;
+  GenerationBuffer m_received;             //!< Payloads of the rows stored as received
+  DecodingInverseCache::Inverse m_inverse; //!< Cached inverse Solve applies, if any
+  bool m_storePattern;                     //!< Solve adds the pattern to the cache
 };
 
 } // namespace ns3
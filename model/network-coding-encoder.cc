@@ -1,7 +1,7 @@
 #include "network-coding-encoder.h"
 #include "ns3/log.h"
-#include "galois-field.h"
-#include <random>
+#include "ns3/double.h"
+#include "coefficient-generator.h"
 
 namespace ns3 {
 
@@ -15,6 +15,13 @@ NetworkCodingEncoder::GetTypeId (void)
     .SetParent<Object> ()
     .SetGroupName ("NetworkCoding")
     .AddConstructor<NetworkCodingEncoder> ()
+    .AddAttribute ("Density",
+                   "Probability that each coding coefficient is nonzero; headers "
+                   "carry it in steps of 1/255, the smallest density there is",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&NetworkCodingEncoder::SetDensity,
+                                       &NetworkCodingEncoder::GetDensity),
+                   MakeDoubleChecker<double> (1.0 / CoefficientGenerator::DENSE, 1.0))
   ;
   return tid;
 }
@@ -23,25 +30,42 @@ NetworkCodingEncoder::NetworkCodingEncoder ()
   : m_generationSize (8),
     m_packetSize (1024),
     m_currentGeneration (0),
-    m_galoisField (CreateObject<GaloisField>())
+    m_systematic (false),
+    m_systematicSent (0),
+    m_packetsGenerated (0),
+    m_coefficientFormat (NetworkCodingHeader::SEEDED_COEFFICIENTS),
+    m_density (1.0),
+    m_repeatCoefficients (false),
+    m_field (gf::FIELD_BINARY8)
 {
   NS_LOG_FUNCTION (this);
+  m_seedRng = CreateObject<UniformRandomVariable> ();
+  m_sources.Resize (m_generationSize, 0, m_packetSize);
+  m_coded.Resize (1, 0, m_packetSize);
 }
 
 NetworkCodingEncoder::NetworkCodingEncoder (uint16_t generationSize, uint16_t packetSize)
   : m_generationSize (generationSize),
     m_packetSize (packetSize),
-    m_currentGeneration (0)
+    m_currentGeneration (0),
+    m_systematic (false),
+    m_systematicSent (0),
+    m_packetsGenerated (0),
+    m_coefficientFormat (NetworkCodingHeader::SEEDED_COEFFICIENTS),
+    m_density (1.0),
+    m_repeatCoefficients (false),
+    m_field (gf::FIELD_BINARY8)
 {
   NS_LOG_FUNCTION (this << generationSize << packetSize);
-  m_galoisField = CreateObject<GaloisField>();
+  m_seedRng = CreateObject<UniformRandomVariable> ();
+  m_sources.Resize (m_generationSize, 0, m_packetSize);
+  m_coded.Resize (1, 0, m_packetSize);
 }
 
 NetworkCodingEncoder::~NetworkCodingEncoder ()
 {
   NS_LOG_FUNCTION (this);
-  // Clean up by removing all references
-  m_generationPackets.clear();
+  m_sourceRows.clear();
 }
 
 uint16_t
@@ -55,6 +79,8 @@ NetworkCodingEncoder::SetGenerationSize (uint16_t generationSize)
 {
   NS_LOG_FUNCTION (this << generationSize);
   m_generationSize = generationSize;
+  m_sources.Resize (m_generationSize, 0, m_packetSize);
+  m_sourceRows.clear();
 }
 
 uint16_t
@@ -68,6 +94,9 @@ NetworkCodingEncoder::SetPacketSize (uint16_t packetSize)
 {
   NS_LOG_FUNCTION (this << packetSize);
   m_packetSize = packetSize;
+  m_sources.Resize (m_generationSize, 0, m_packetSize);
+  m_coded.Resize (1, 0, m_packetSize);
+  m_sourceRows.clear();
 }
 
 bool
@@ -82,45 +111,27 @@ NetworkCodingEncoder::AddPacket (Ptr<const Packet> packet, uint32_t seqNum)
       return false;
     }
   
-  if (m_generationPackets.size() >= m_generationSize)
+  if (m_sourceRows.size() >= m_generationSize)
     {
       NS_LOG_WARN ("Cannot add packet: generation is full");
       return false;
     }
   
-  if (m_generationPackets.find(seqNum) != m_generationPackets.end())
+  if (m_sourceRows.find(seqNum) != m_sourceRows.end())
     {
       NS_LOG_WARN ("Packet with sequence number " << seqNum << " already exists");
       return false;
     }
   
-  // Create a new packet with exact size (simplifies memory management)
-  Ptr<Packet> newPacket;
-  
-  if (packet->GetSize() == m_packetSize)
-    {
-      // Same size, just copy
-      newPacket = packet->Copy();
-    }
-  else
-    {
-      // Create a buffer for data
-      uint8_t *buffer = new uint8_t[m_packetSize];
-      memset(buffer, 0, m_packetSize); // Zero-fill
-      
-      // Copy available data (handles truncation or padding)
-      uint32_t copySize = std::min(packet->GetSize(), (uint32_t)m_packetSize);
-      packet->CopyData(buffer, copySize);
-      
-      // Create packet from buffer
-      newPacket = Create<Packet>(buffer, m_packetSize);
-      
-      // IMPORTANT: Delete buffer after creating packet
-      delete[] buffer;
-    }
+  // Copy the payload into the next free row (handles truncation or padding)
+  uint32_t row = m_sourceRows.size();
+  uint8_t *payload = m_sources.GetPayload(row);
+  uint32_t copySize = std::min(packet->GetSize(), (uint32_t)m_packetSize);
+  packet->CopyData(payload, copySize);
+  memset(payload + copySize, 0, m_packetSize - copySize); // Zero-fill
   
   // Store the packet
-  m_generationPackets[seqNum] = newPacket;
+  m_sourceRows[seqNum] = row;
   
   NS_LOG_INFO ("Added packet with sequence number " << seqNum << " to generation " 
                << m_currentGeneration);
@@ -128,88 +139,272 @@ NetworkCodingEncoder::AddPacket (Ptr<const Packet> packet, uint32_t seqNum)
   return true;
 }
 
-// FIXED: Use proper Galois field arithmetic in GenerateCodedPacket
+template <class Codec>
+void
+NetworkCodingEncoder::CombineSources (uint32_t count)
+{
+  const uint32_t generationSize = Codec::GetGenerationSize (m_generationSize);
+  // Coefficient positions follow sequence number order. The operations are
+  // grouped by source row and run as one blocked batch, so every block of
+  // a source payload is loaded once for all count outputs; long payloads
+  // can also be striped over threads
+  m_combineOps.clear ();
+  size_t packetIndex = 0;
+  for (auto& pair : m_sourceRows)
+    {
+      if (packetIndex >= generationSize)
+        {
+          break;
+        }
+      const uint8_t *source = m_sources.GetPayload (pair.second);
+      for (uint32_t i = 0; i < count; i++)
+        {
+          uint8_t coefficient = m_batchCoefficients[i * generationSize + packetIndex];
+          if (coefficient != 0)
+            {
+              // output += coeff * source over the whole payload
+              m_combineOps.push_back ({m_coded.GetPayload (i), source, coefficient});
+            }
+        }
+      packetIndex++;
+    }
+  
+  // Columns per block, so the output blocks and one source block stay in L2
+  size_t block = GenerationBuffer::Align (COMBINE_CACHE_BYTES / (count + 1));
+  Codec::ApplyPayloadOps (m_combineOps.data (), m_combineOps.size (), m_packetSize, block);
+}
+
 Ptr<Packet>
 NetworkCodingEncoder::GenerateCodedPacket (void)
 {
-  NS_LOG_FUNCTION (this);
+  return GenerateCodedPacket (m_currentGeneration);
+}
+
+Ptr<Packet>
+NetworkCodingEncoder::GenerateCodedPacket (uint32_t generationId)
+{
+  std::vector<Ptr<Packet>> packets = GenerateCodedPackets (1, generationId);
+  return packets.empty () ? nullptr : packets.front ();
+}
+
+std::vector<Ptr<Packet>>
+NetworkCodingEncoder::GenerateCodedPackets (uint32_t count)
+{
+  return GenerateCodedPackets (count, m_currentGeneration);
+}
+
+std::vector<Ptr<Packet>>
+NetworkCodingEncoder::GenerateCodedPackets (uint32_t count, uint32_t generationId)
+{
+  NS_LOG_FUNCTION (this << count << generationId);
+  
+  std::vector<Ptr<Packet>> packets;
   
   // Validation
-  if (m_generationPackets.empty())
+  if (m_sourceRows.empty())
     {
       NS_LOG_WARN ("Cannot generate coded packet: no packets in generation");
-      return nullptr;
+      return packets;
+    }
+  if (count == 0)
+    {
+      return packets;
     }
   
-  // Generate random coefficients
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::uniform_int_distribution<uint8_t> dis(1, 255); // Avoid zero coefficients
-  
-  std::vector<uint8_t> coefficients(m_generationSize, 0);
-  
-  // Set coefficients for packets we actually have
-  size_t packetIndex = 0;
-  for (auto& pair : m_generationPackets)
+  // Draw the coefficients for the packets we actually have from a fresh
+  // seed per coded packet; the rest of the generation gets zero
+  uint16_t sources = std::min<size_t> (m_sourceRows.size(), m_generationSize);
+  uint8_t density = CoefficientGenerator::QuantizeDensity (m_density);
+  std::vector<uint32_t> seeds (count);
+  m_batchCoefficients.assign (static_cast<size_t> (count) * m_generationSize, 0);
+  for (uint32_t i = 0; i < count; i++)
     {
-      if (packetIndex < m_generationSize)
+      if (m_repeatCoefficients)
+        {
+          // Spread consecutive indices over the seed space
+          uint64_t index = m_packetsGenerated + 1 + i;
+          seeds[i] = static_cast<uint32_t> ((index * 0x9E3779B97F4A7C15ULL) >> 32);
+        }
+      else
         {
-          coefficients[packetIndex] = dis(gen);
-          packetIndex++;
+          seeds[i] = m_seedRng->GetInteger (0, 0xFFFFFFFF);
         }
+      CoefficientGenerator::Generate (seeds[i], density, &m_batchCoefficients[i * m_generationSize],
+                                      sources, m_field);
     }
   
-  // FIXED: Create coded payload using PROPER Galois field arithmetic
-  std::vector<uint8_t> codedPayload(m_packetSize, 0);
+  // Accumulate the coded payloads in reusable aligned rows
+  if (m_coded.GetRows () < count)
+    {
+      m_coded.Resize (count, 0, m_packetSize);
+    }
+  else
+    {
+      for (uint32_t i = 0; i < count; i++)
+        {
+          m_coded.ZeroRow (i);
+        }
+    }
+  gf::DispatchCodec (m_field, m_generationSize, m_packetSize, [this, count] (auto codec) {
+    CombineSources<decltype (codec)> (count);
+  });
   
-  packetIndex = 0;
-  for (auto& pair : m_generationPackets)
+  packets.reserve (count);
+  for (uint32_t i = 0; i < count; i++)
     {
-      if (packetIndex < m_generationSize && coefficients[packetIndex] != 0)
+      // Create the coded packet
+      Ptr<Packet> codedPacket = Create<Packet>(m_coded.GetPayload (i), m_packetSize);
+      
+      // Create and add header
+      NetworkCodingHeader header;
+      header.SetHopSequence(++m_packetsGenerated);
+      header.SetGenerationId(generationId);
+      header.SetGenerationSize(m_generationSize);
+      header.SetField(m_field);
+      if (m_coefficientFormat == NetworkCodingHeader::SEEDED_COEFFICIENTS)
         {
-          // Extract packet data
-          std::vector<uint8_t> packetData(m_packetSize);
-          pair.second->CopyData(packetData.data(), m_packetSize);
-          
-          // FIXED: Use proper Galois field operations
-          uint8_t coeff = coefficients[packetIndex];
-          for (size_t i = 0; i < m_packetSize; i++)
-            {
-              // Use Galois field multiplication and addition
-              uint8_t product = m_galoisField->Multiply(coeff, packetData[i]);
-              codedPayload[i] = m_galoisField->Add(codedPayload[i], product);
-            }
+          header.SetCoefficientSeed(seeds[i], sources, density);
         }
-      packetIndex++;
+      else
+        {
+          const uint8_t *coefficients = &m_batchCoefficients[i * m_generationSize];
+          header.SetCoefficients(std::vector<uint8_t> (coefficients, coefficients + m_generationSize));
+        }
+      
+      codedPacket->AddHeader(header);
+      packets.push_back (codedPacket);
     }
   
-  // Create the coded packet
-  Ptr<Packet> codedPacket = Create<Packet>(codedPayload.data(), m_packetSize);
+  NS_LOG_INFO ("Generated " << count << " coded packets for generation " << generationId 
+               << " with " << m_sourceRows.size() << " source packets");
   
-  // Create and add header
-  NetworkCodingHeader header;
-  header.SetGenerationId(m_currentGeneration);
-  header.SetGenerationSize(m_generationSize);
-  header.SetCoefficients(coefficients);
+  return packets;
+}
+
+Ptr<Packet>
+NetworkCodingEncoder::GeneratePacket (void)
+{
+  return GeneratePacket (m_currentGeneration);
+}
+
+Ptr<Packet>
+NetworkCodingEncoder::GeneratePacket (uint32_t generationId)
+{
+  NS_LOG_FUNCTION (this << generationId);
   
-  codedPacket->AddHeader(header);
+  if (m_systematic && m_systematicSent < m_sourceRows.size())
+    {
+      auto it = m_sourceRows.begin();
+      std::advance(it, m_systematicSent);
+      m_systematicSent++;
+      return GenerateUncodedPacket(it->first, generationId);
+    }
   
-  NS_LOG_INFO ("Generated coded packet for generation " << m_currentGeneration 
-               << " with " << m_generationPackets.size() << " source packets");
+  return GenerateCodedPacket(generationId);
+}
+
+std::vector<Ptr<Packet>>
+NetworkCodingEncoder::GeneratePackets (uint32_t count, uint32_t generationId)
+{
+  NS_LOG_FUNCTION (this << count << generationId);
   
-  return codedPacket;
+  std::vector<Ptr<Packet>> packets;
+  while (packets.size () < count && m_systematic && m_systematicSent < m_sourceRows.size())
+    {
+      packets.push_back (GeneratePacket (generationId));
+    }
+  if (packets.size () < count)
+    {
+      std::vector<Ptr<Packet>> coded = GenerateCodedPackets (count - packets.size (), generationId);
+      packets.insert (packets.end (), coded.begin (), coded.end ());
+    }
+  return packets;
+}
+
+void
+NetworkCodingEncoder::SetSystematic (bool systematic)
+{
+  NS_LOG_FUNCTION (this << systematic);
+  m_systematic = systematic;
+}
+
+bool
+NetworkCodingEncoder::IsSystematic (void) const
+{
+  return m_systematic;
+}
+
+void
+NetworkCodingEncoder::SetField (gf::FieldType field)
+{
+  NS_LOG_FUNCTION (this << field);
+  NS_ASSERT_MSG (gf::IsValidField (field), "Unsupported field");
+  m_field = field;
+}
+
+gf::FieldType
+NetworkCodingEncoder::GetField (void) const
+{
+  return m_field;
+}
+
+void
+NetworkCodingEncoder::SetDensity (double density)
+{
+  NS_LOG_FUNCTION (this << density);
+  NS_ASSERT_MSG (density > 0.0 && density <= 1.0, "Density must be in (0, 1]");
+  m_density = density;
+}
+
+double
+NetworkCodingEncoder::GetDensity (void) const
+{
+  return m_density;
+}
+
+void
+NetworkCodingEncoder::SetRepeatCoefficients (bool repeat)
+{
+  NS_LOG_FUNCTION (this << repeat);
+  m_repeatCoefficients = repeat;
+}
+
+bool
+NetworkCodingEncoder::GetRepeatCoefficients (void) const
+{
+  return m_repeatCoefficients;
+}
+
+void
+NetworkCodingEncoder::SetCoefficientFormat (NetworkCodingHeader::CoefficientFormat format)
+{
+  NS_LOG_FUNCTION (this << format);
+  m_coefficientFormat = format;
+}
+
+NetworkCodingHeader::CoefficientFormat
+NetworkCodingEncoder::GetCoefficientFormat (void) const
+{
+  return m_coefficientFormat;
+}
+
+int64_t
+NetworkCodingEncoder::AssignStreams (int64_t stream)
+{
+  m_seedRng->SetStream (stream);
+  return 1;
 }
 
 bool
 NetworkCodingEncoder::IsGenerationComplete (void) const
 {
-  return m_generationPackets.size() >= m_generationSize;
+  return m_sourceRows.size() >= m_generationSize;
 }
 
 uint32_t
 NetworkCodingEncoder::GetPacketCount (void) const
 {
-  return m_generationPackets.size();
+  return m_sourceRows.size();
 }
 
 void
@@ -218,11 +413,19 @@ NetworkCodingEncoder::NextGeneration (void)
   NS_LOG_FUNCTION (this);
   
   m_currentGeneration++;
-  m_generationPackets.clear();
+  m_sourceRows.clear();
+  m_systematicSent = 0;
+  m_packetsGenerated = 0;
   
   NS_LOG_INFO ("Moving to generation " << m_currentGeneration);
 }
 
+uint64_t
+NetworkCodingEncoder::GetPacketsGenerated (void) const
+{
+  return m_packetsGenerated;
+}
+
 uint32_t
 NetworkCodingEncoder::GetCurrentGenerationId (void) const
 {
@@ -234,7 +437,7 @@ NetworkCodingEncoder::GetSequenceNumbers (void) const
 {
   std::set<uint32_t> seqNums;
   
-  for (const auto& pair : m_generationPackets)
+  for (const auto& pair : m_sourceRows)
     {
       seqNums.insert(pair.first);
     }
@@ -245,29 +448,37 @@ NetworkCodingEncoder::GetSequenceNumbers (void) const
 Ptr<Packet>
 NetworkCodingEncoder::GenerateUncodedPacket (uint32_t seqNum)
 {
-  NS_LOG_FUNCTION (this << seqNum);
+  return GenerateUncodedPacket (seqNum, m_currentGeneration);
+}
+
+Ptr<Packet>
+NetworkCodingEncoder::GenerateUncodedPacket (uint32_t seqNum, uint32_t generationId)
+{
+  NS_LOG_FUNCTION (this << seqNum << generationId);
   
-  auto it = m_generationPackets.find(seqNum);
-  if (it == m_generationPackets.end())
+  auto it = m_sourceRows.find(seqNum);
+  if (it == m_sourceRows.end())
     {
       NS_LOG_WARN ("Cannot generate uncoded packet: sequence number " << seqNum << " not found");
       return nullptr;
     }
   
-  // Create a copy of the packet
-  Ptr<Packet> packet = it->second->Copy();
+  // Create a packet from the stored payload
+  Ptr<Packet> packet = Create<Packet>(m_sources.GetPayload(it->second), m_packetSize);
   
   // Create header
   NetworkCodingHeader header;
-  header.SetGenerationId(m_currentGeneration);
+  header.SetHopSequence(++m_packetsGenerated);
+  header.SetGenerationId(generationId);
   header.SetGenerationSize(m_generationSize);
+  header.SetField(m_field);
   
   // Set up identity coefficients
   std::vector<uint8_t> coefficients(m_generationSize, 0);
   
   // Find position of this packet in the generation
   size_t position = 0;
-  for (auto it2 = m_generationPackets.begin(); it2 != m_generationPackets.end(); ++it2)
+  for (auto it2 = m_sourceRows.begin(); it2 != m_sourceRows.end(); ++it2)
     {
       if (it2->first == seqNum)
         {
@@ -3,10 +3,14 @@
 
 #include "ns3/object.h"
 #include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
 #include "network-coding-packet.h" 
-#include "galois-field.h"
+#include "galois-field-traits.h"
+#include "generation-buffer.h"
+#include "network-coding-codec.h"
 #include <map>
 #include <set>
+#include <vector>
 
 namespace ns3 {
 
@@ -29,19 +33,171 @@ public:
   Ptr<Packet> GenerateCodedPacket (void);
   Ptr<Packet> GenerateUncodedPacket (uint32_t seqNum);
 
+  /**
+   * \brief Generate a coded packet stamped with a given generation ID
+   * \param generationId Generation ID written into the header
+   * \return the packet, or nullptr if the generation is empty
+   *
+   * For senders that number generations themselves; the header is built
+   * with the final ID, so the packet never has to be re-headed.
+   */
+  Ptr<Packet> GenerateCodedPacket (uint32_t generationId);
+
+  /**
+   * \brief Generate an uncoded packet stamped with a given generation ID
+   * \param seqNum Sequence number of the source packet
+   * \param generationId Generation ID written into the header
+   * \return the packet, or nullptr if seqNum is not in the generation
+   */
+  Ptr<Packet> GenerateUncodedPacket (uint32_t seqNum, uint32_t generationId);
+
+  /**
+   * \brief Generate several coded packets in one sweep over the sources
+   * \param count Number of packets
+   * \return the packets, empty if the generation is empty
+   *
+   * Same packets as count calls to GenerateCodedPacket, but the count x g
+   * coefficient block is multiplied with the source payloads in column
+   * blocks, so every source byte is loaded once for all outputs. Used for
+   * the first transmission of a generation and for repair bursts.
+   */
+  std::vector<Ptr<Packet>> GenerateCodedPackets (uint32_t count);
+
+  /**
+   * \brief Generate several coded packets stamped with a given generation ID
+   * \param count Number of packets
+   * \param generationId Generation ID written into the headers
+   * \return the packets, empty if the generation is empty
+   */
+  std::vector<Ptr<Packet>> GenerateCodedPackets (uint32_t count, uint32_t generationId);
+
+  /**
+   * \brief Generate the next packet to transmit for the current generation
+   * \return the packet, or nullptr if the generation is empty
+   *
+   * In systematic mode the source packets are first sent uncoded, in
+   * sequence number order and with identity coefficients; every call after
+   * that returns a coded repair packet. Otherwise this is the same as
+   * GenerateCodedPacket.
+   */
+  Ptr<Packet> GeneratePacket (void);
+
+  /**
+   * \brief Generate the next packet, stamped with a given generation ID
+   * \param generationId Generation ID written into the header
+   * \return the packet, or nullptr if the generation is empty
+   */
+  Ptr<Packet> GeneratePacket (uint32_t generationId);
+
+  /**
+   * \brief Generate the next count packets to transmit
+   * \param count Number of packets
+   * \param generationId Generation ID written into the headers
+   * \return the packets, in transmission order
+   *
+   * Same as count calls to GeneratePacket; the coded part is generated with
+   * GenerateCodedPackets.
+   */
+  std::vector<Ptr<Packet>> GeneratePackets (uint32_t count, uint32_t generationId);
+
+  void SetSystematic (bool systematic);
+  bool IsSystematic (void) const;
+
+  /**
+   * \brief Set the finite field used for coding
+   * \param field GF(2), GF(2^4) or GF(2^8) (default)
+   *
+   * Smaller fields code faster at the cost of more linearly dependent
+   * packets; in GF(2) coding is pure XOR. The decoder must use the same field.
+   */
+  void SetField (gf::FieldType field);
+  gf::FieldType GetField (void) const;
+
+  /**
+   * \brief Set the probability that a coding coefficient is nonzero
+   * \param density Probability in (0, 1]; 1 gives dense codes
+   *
+   * Sparse codes trade some extra packets for encoding and decoding work
+   * roughly proportional to the density.
+   */
+  void SetDensity (double density);
+  double GetDensity (void) const;
+
+  /**
+   * \brief Draw the same coefficients for every generation
+   * \param repeat true to derive coded packet k's coefficients from k alone
+   *
+   * Coded packet k of every generation then carries the same coefficient
+   * row, so receivers that lose the same packets get the same matrix and a
+   * DecodingInverseCache can skip the elimination. The code is as good as
+   * with fresh seeds within a generation.
+   */
+  void SetRepeatCoefficients (bool repeat);
+  bool GetRepeatCoefficients (void) const;
+
+  /**
+   * \brief Choose how coded packets carry their coefficients
+   * \param format Seeded (default, constant header size) or explicit
+   */
+  void SetCoefficientFormat (NetworkCodingHeader::CoefficientFormat format);
+  NetworkCodingHeader::CoefficientFormat GetCoefficientFormat (void) const;
+
+  /**
+   * \brief Assign a fixed random variable stream number
+   * \param stream First stream index to use
+   * \return the number of streams assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
   bool IsGenerationComplete (void) const;
   uint32_t GetPacketCount (void) const;
+
+  /**
+   * \brief Get the number of packets generated for the current generation
+   * \return the count, coded and uncoded
+   *
+   * Every generated packet carries its 1-based index in this count as the
+   * header hop sequence, so a receiver can tell how many were sent.
+   */
+  uint64_t GetPacketsGenerated (void) const;
   void NextGeneration (void);
   uint32_t GetCurrentGenerationId (void) const;
   std::set<uint32_t> GetSequenceNumbers (void) const;
 
 private:
+  /**
+   * \brief Bytes of output and source blocks CombineSources keeps in cache
+   */
+  static const size_t COMBINE_CACHE_BYTES = 256 * 1024;
+
+  /**
+   * \brief Accumulate the coefficient-weighted source payloads
+   * \param count Number of outputs; output i is built in row i of m_coded from
+   *        the coefficients at m_batchCoefficients[i * m_generationSize]
+   *
+   * The output rows must be zeroed. Codec is the gf::CodecT
+   * gf::DispatchCodec picks for the field and sizes.
+   */
+  template <class Codec>
+  void CombineSources (uint32_t count);
+
   uint16_t m_generationSize;
   uint16_t m_packetSize;
   uint32_t m_currentGeneration;
+  bool m_systematic;                        //!< Send source packets uncoded first
+  uint32_t m_systematicSent;                //!< Uncoded packets sent in this generation
+  uint64_t m_packetsGenerated;              //!< Packets generated in this generation
+  NetworkCodingHeader::CoefficientFormat m_coefficientFormat;
+  double m_density;                         //!< Probability of a nonzero coefficient
+  bool m_repeatCoefficients;                //!< Seed coded packets by their index only
+  gf::FieldType m_field;                    //!< Field the packets are coded in
+  Ptr<UniformRandomVariable> m_seedRng;    //!< Draws one coefficient seed per coded packet
   
-  std::map<uint32_t, Ptr<Packet>> m_generationPackets;
-  Ptr<GaloisField> m_galoisField;
+  GenerationBuffer m_sources;              //!< Source payloads, one row per packet
+  std::map<uint32_t, uint32_t> m_sourceRows; //!< Sequence number to row in m_sources
+  GenerationBuffer m_coded;                //!< Scratch rows the coded payloads are built in
+  std::vector<uint8_t> m_batchCoefficients; //!< Coefficients of the packets being coded, row-major
+  std::vector<gf::RegionOp> m_combineOps; //!< Row operations of the packets being coded
 };
 
 } // namespace ns3
@@ -20,11 +20,13 @@
 
 #include "network-coding-packet.h"
 #include "ns3/log.h"
+#include "ns3/assert.h"
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("NetworkCodingPacket");
 NS_OBJECT_ENSURE_REGISTERED (NetworkCodingHeader);
+NS_OBJECT_ENSURE_REGISTERED (NetworkCodingWindowHeader);
 NS_OBJECT_ENSURE_REGISTERED (NetworkCodingControlHeader);
 
 //----------------------------------------------------------------------------
@@ -51,6 +53,10 @@ NetworkCodingHeader::GetInstanceTypeId (void) const
 NetworkCodingHeader::NetworkCodingHeader ()
   : m_generationId (0),
     m_generationSize (0),
+    m_format (EXPLICIT_COEFFICIENTS),
+    m_seed (0),
+    m_density (CoefficientGenerator::DENSE),
+    m_field (gf::FIELD_BINARY8),
     m_hopSequence(0)
 {
 }
@@ -86,9 +92,50 @@ NetworkCodingHeader::GetGenerationSize (void) const
 void 
 NetworkCodingHeader::SetCoefficients (const std::vector<uint8_t>& coeffs)
 {
+  m_format = EXPLICIT_COEFFICIENTS;
   m_coefficients = coeffs;
 }
 
+void 
+NetworkCodingHeader::SetCoefficientSeed (uint32_t seed, uint16_t count, uint8_t density)
+{
+  m_format = SEEDED_COEFFICIENTS;
+  m_seed = seed;
+  m_density = density;
+  m_coefficients.assign (count, 0);
+  CoefficientGenerator::Generate (seed, density, m_coefficients.data (), count, m_field);
+}
+
+void 
+NetworkCodingHeader::SetField (gf::FieldType field)
+{
+  m_field = field;
+}
+
+gf::FieldType 
+NetworkCodingHeader::GetField (void) const
+{
+  return m_field;
+}
+
+NetworkCodingHeader::CoefficientFormat 
+NetworkCodingHeader::GetCoefficientFormat (void) const
+{
+  return m_format;
+}
+
+uint32_t 
+NetworkCodingHeader::GetCoefficientSeed (void) const
+{
+  return m_seed;
+}
+
+uint8_t 
+NetworkCodingHeader::GetCoefficientDensity (void) const
+{
+  return m_density;
+}
+
 const std::vector<uint8_t>& 
 NetworkCodingHeader::GetCoefficients (void) const
 {
@@ -121,21 +168,60 @@ NetworkCodingHeader::Serialize (Buffer::Iterator start) const
   // Write generation size (2 bytes)  
   start.WriteHtonU16 (m_generationSize);
   
+  // Write coefficient format and field (1 byte each)
+  start.WriteU8 (static_cast<uint8_t> (m_format));
+  start.WriteU8 (static_cast<uint8_t> (m_field));
+  
   // Write number of coefficients (2 bytes)
   start.WriteHtonU16 (static_cast<uint16_t>(m_coefficients.size()));
   
-  // Write coefficients (pad to generation size)
-  for (size_t i = 0; i < m_generationSize; i++)
+  if (m_format == SEEDED_COEFFICIENTS)
+    {
+      // Write seed (4 bytes) and density (1 byte)
+      start.WriteHtonU32 (m_seed);
+      start.WriteU8 (m_density);
+      return;
+    }
+  
+  if (m_field == gf::FIELD_BINARY8)
     {
-      if (i < m_coefficients.size())
+      // Write coefficients (pad to generation size)
+      for (size_t i = 0; i < m_generationSize; i++)
         {
-          start.WriteU8 (m_coefficients[i]);
+          if (i < m_coefficients.size())
+            {
+              start.WriteU8 (m_coefficients[i]);
+            }
+          else
+            {
+              start.WriteU8 (0);  // Pad with zeros
+            }
         }
-      else
+      return;
+    }
+  
+  // Smaller fields pack 8 / bits coefficients per byte, first one in the
+  // low bits (pad to generation size)
+  const uint32_t bits = m_field;
+  const uint8_t mask = gf::GetMaxElement (m_field);
+  uint8_t byte = 0;
+  uint32_t used = 0;
+  for (size_t i = 0; i < m_generationSize; i++)
+    {
+      uint8_t c = (i < m_coefficients.size ()) ? (m_coefficients[i] & mask) : 0;
+      byte |= c << used;
+      used += bits;
+      if (used == 8)
         {
-          start.WriteU8 (0);  // Pad with zeros
+          start.WriteU8 (byte);
+          byte = 0;
+          used = 0;
         }
     }
+  if (used > 0)
+    {
+      start.WriteU8 (byte);
+    }
 }
 
 uint32_t 
@@ -152,37 +238,86 @@ NetworkCodingHeader::Deserialize (Buffer::Iterator start)
   // Read generation size
   m_generationSize = start.ReadNtohU16 ();
   
+  // Read coefficient format and field
+  uint8_t format = start.ReadU8 ();
+  uint8_t field = start.ReadU8 ();
+  
   // Read number of coefficients
   uint16_t numCoeffs = start.ReadNtohU16 ();
   
   // Validate
+  if (m_generationSize == 0)
+    {
+      NS_LOG_ERROR ("Invalid generation size: " << m_generationSize);
+      return 0;
+    }
+  
+  if (!gf::IsValidField (field))
+    {
+      NS_LOG_ERROR ("Unknown field: " << static_cast<uint32_t> (field));
+      return 0;
+    }
+  m_field = static_cast<gf::FieldType> (field);
+  
+  if (format == SEEDED_COEFFICIENTS)
+    {
+      if (numCoeffs > m_generationSize)
+        {
+          NS_LOG_ERROR ("Too many seeded coefficients: " << numCoeffs);
+          return 0;
+        }
+      if (start.GetRemainingSize () < 5)
+        {
+          NS_LOG_ERROR ("Buffer underrun while reading the coefficient seed");
+          return 0;
+        }
+      m_format = SEEDED_COEFFICIENTS;
+      m_seed = start.ReadNtohU32 ();
+      m_density = start.ReadU8 ();
+      
+      // Regenerate the coefficients, padded to the generation size
+      m_coefficients.assign (m_generationSize, 0);
+      CoefficientGenerator::Generate (m_seed, m_density, m_coefficients.data (), numCoeffs, m_field);
+      return GetSerializedSize ();
+    }
+  
+  if (format != EXPLICIT_COEFFICIENTS)
+    {
+      NS_LOG_ERROR ("Unknown coefficient format: " << static_cast<uint32_t> (format));
+      return 0;
+    }
+  m_format = EXPLICIT_COEFFICIENTS;
+  
   if (numCoeffs != m_generationSize)
     {
       NS_LOG_ERROR ("Coefficient count mismatch: expected " << m_generationSize << " but got " << numCoeffs);
       return 0;
     }
   
-  if (m_generationSize == 0 || m_generationSize > 255) 
+  // Read coefficients, unpacking them to one per byte
+  if (start.GetRemainingSize () < gf::GetPackedSize (m_field, m_generationSize))
     {
-      NS_LOG_ERROR ("Invalid generation size: " << m_generationSize);
+      NS_LOG_ERROR ("Buffer underrun while reading coefficients");
       return 0;
     }
   
-  // Read coefficients
   m_coefficients.clear ();
   m_coefficients.reserve (m_generationSize);
   
+  const uint32_t bits = m_field;
+  const uint8_t mask = gf::GetMaxElement (m_field);
+  uint8_t byte = 0;
+  uint32_t left = 0;
   for (uint16_t i = 0; i < m_generationSize; i++)
     {
-      if (start.GetRemainingSize () > 0)
+      if (left == 0)
         {
-          m_coefficients.push_back (start.ReadU8 ());
-        }
-      else
-        {
-          NS_LOG_ERROR ("Buffer underrun while reading coefficients");
-          return 0;
+          byte = start.ReadU8 ();
+          left = 8;
         }
+      m_coefficients.push_back (byte & mask);
+      byte = (bits < 8) ? (byte >> bits) : 0;
+      left -= bits;
     }
   
   return GetSerializedSize ();
@@ -191,9 +326,16 @@ NetworkCodingHeader::Deserialize (Buffer::Iterator start)
 uint32_t 
 NetworkCodingHeader::GetSerializedSize (void) const
 {
-  // 8 (hop) + 4 (genId) + 2 (genSize) + 2 (numCoeffs) + N (coeffs)
-  // The number of coefficients written is always equal to the generation size due to padding.
-  return 8 + 4 + 2 + 2 + m_generationSize;
+  if (m_format == SEEDED_COEFFICIENTS)
+    {
+      // 8 (hop) + 4 (genId) + 2 (genSize) + 1 (format) + 1 (field) + 2 (numCoeffs)
+      // + 4 (seed) + 1 (density)
+      return 8 + 4 + 2 + 1 + 1 + 2 + 4 + 1;
+    }
+  // 8 (hop) + 4 (genId) + 2 (genSize) + 1 (format) + 1 (field) + 2 (numCoeffs) + N (coeffs)
+  // The number of coefficients written is always equal to the generation size due to padding,
+  // packed to bits / 8 bytes each.
+  return 8 + 4 + 2 + 1 + 1 + 2 + gf::GetPackedSize (m_field, m_generationSize);
 }
 
 void 
@@ -202,6 +344,138 @@ NetworkCodingHeader::Print (std::ostream &os) const
   os << "HopSeq: " << m_hopSequence
      << " Generation ID: " << m_generationId
      << " Generation Size: " << m_generationSize
+     << " Field: GF(2^" << static_cast<uint32_t> (m_field) << ")";
+  if (m_format == SEEDED_COEFFICIENTS)
+    {
+      os << " Seed: " << m_seed
+         << " Density: " << static_cast<uint32_t> (m_density);
+    }
+  os << " Coefficients: [";
+  
+  for (size_t i = 0; i < m_coefficients.size (); i++)
+    {
+      os << static_cast<uint32_t> (m_coefficients[i]);
+      if (i < m_coefficients.size () - 1)
+        {
+          os << ", ";
+        }
+    }
+  
+  os << "]";
+}
+
+//----------------------------------------------------------------------------
+// NetworkCodingWindowHeader Implementation
+//----------------------------------------------------------------------------
+
+TypeId 
+NetworkCodingWindowHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NetworkCodingWindowHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("NetworkCoding")
+    .AddConstructor<NetworkCodingWindowHeader> ()
+  ;
+  return tid;
+}
+
+TypeId 
+NetworkCodingWindowHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+NetworkCodingWindowHeader::NetworkCodingWindowHeader ()
+  : m_windowStart (0)
+{
+}
+
+NetworkCodingWindowHeader::~NetworkCodingWindowHeader ()
+{
+}
+
+void 
+NetworkCodingWindowHeader::SetWindow (uint32_t start, const std::vector<uint8_t>& coeffs)
+{
+  NS_ASSERT_MSG (coeffs.size () <= 0xFFFF, "Coding window too large");
+  m_windowStart = start;
+  m_coefficients = coeffs;
+}
+
+uint32_t 
+NetworkCodingWindowHeader::GetWindowStart (void) const
+{
+  return m_windowStart;
+}
+
+uint32_t 
+NetworkCodingWindowHeader::GetWindowEnd (void) const
+{
+  return m_windowStart + m_coefficients.size ();
+}
+
+const std::vector<uint8_t>& 
+NetworkCodingWindowHeader::GetCoefficients (void) const
+{
+  return m_coefficients;
+}
+
+void 
+NetworkCodingWindowHeader::Serialize (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION (this);
+  
+  // Window start and end (4 bytes each), then one coefficient per packet
+  start.WriteHtonU32 (m_windowStart);
+  start.WriteHtonU32 (GetWindowEnd ());
+  for (uint8_t c : m_coefficients)
+    {
+      start.WriteU8 (c);
+    }
+}
+
+uint32_t 
+NetworkCodingWindowHeader::Deserialize (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION (this);
+  
+  m_windowStart = start.ReadNtohU32 ();
+  uint32_t windowEnd = start.ReadNtohU32 ();
+  
+  // Validate
+  if (windowEnd < m_windowStart || windowEnd - m_windowStart > 0xFFFF)
+    {
+      NS_LOG_ERROR ("Invalid coding window [" << m_windowStart << ", " << windowEnd << ")");
+      return 0;
+    }
+  
+  uint32_t span = windowEnd - m_windowStart;
+  if (start.GetRemainingSize () < span)
+    {
+      NS_LOG_ERROR ("Buffer underrun while reading coefficients");
+      return 0;
+    }
+  
+  m_coefficients.resize (span);
+  for (uint32_t i = 0; i < span; i++)
+    {
+      m_coefficients[i] = start.ReadU8 ();
+    }
+  
+  return GetSerializedSize ();
+}
+
+uint32_t 
+NetworkCodingWindowHeader::GetSerializedSize (void) const
+{
+  // 4 (start) + 4 (end) + N (coeffs)
+  return 4 + 4 + m_coefficients.size ();
+}
+
+void 
+NetworkCodingWindowHeader::Print (std::ostream &os) const
+{
+  os << "Window: [" << m_windowStart << ", " << GetWindowEnd () << ")"
      << " Coefficients: [";
   
   for (size_t i = 0; i < m_coefficients.size (); i++)
@@ -240,14 +514,20 @@ NetworkCodingControlHeader::GetInstanceTypeId (void) const
 NetworkCodingControlHeader::NetworkCodingControlHeader ()
   : m_controlType (REQUEST_UNCODED),
     m_generationId (0),
-    m_hopAckSequence(0)
+    m_hopAckSequence(0),
+    m_hopAckBitmap (0),
+    m_rank (0),
+    m_packetsReceived (0)
 {
 }
 
 NetworkCodingControlHeader::NetworkCodingControlHeader (ControlType type, uint32_t genId)
   : m_controlType (type),
     m_generationId (genId),
-    m_hopAckSequence(0)
+    m_hopAckSequence(0),
+    m_hopAckBitmap (0),
+    m_rank (0),
+    m_packetsReceived (0)
 {
 }
 
@@ -303,11 +583,49 @@ NetworkCodingControlHeader::GetHopAckSequence() const
   return m_hopAckSequence;
 }
 
+void
+NetworkCodingControlHeader::SetHopAckBitmap (uint64_t bitmap)
+{
+  m_hopAckBitmap = bitmap;
+}
+
+uint64_t
+NetworkCodingControlHeader::GetHopAckBitmap (void) const
+{
+  return m_hopAckBitmap;
+}
+
+void
+NetworkCodingControlHeader::SetRank (uint16_t rank)
+{
+  m_rank = rank;
+}
+
+uint16_t
+NetworkCodingControlHeader::GetRank (void) const
+{
+  return m_rank;
+}
+
+void
+NetworkCodingControlHeader::SetPacketsReceived (uint32_t count)
+{
+  m_packetsReceived = count;
+}
+
+uint32_t
+NetworkCodingControlHeader::GetPacketsReceived (void) const
+{
+  return m_packetsReceived;
+}
+
 uint32_t 
 NetworkCodingControlHeader::GetSerializedSize (void) const
 {
-  // Control Type + Generation ID + Hop Ack Seq + Num Seq Nums + Seq Nums
-  return sizeof (uint8_t) + sizeof (uint32_t) + sizeof(uint64_t) + sizeof (uint16_t) + m_sequenceNumbers.size () * sizeof (uint32_t);
+  // Control Type + Generation ID + Hop Ack Seq + Hop Ack Bitmap + Rank
+  // + Packets Received + Num Seq Nums + Seq Nums
+  return sizeof (uint8_t) + sizeof (uint32_t) + 2 * sizeof(uint64_t) + sizeof (uint16_t)
+         + sizeof (uint32_t) + sizeof (uint16_t) + m_sequenceNumbers.size () * sizeof (uint32_t);
 }
 
 void 
@@ -319,8 +637,13 @@ NetworkCodingControlHeader::Serialize (Buffer::Iterator start) const
   // Write generation ID
   start.WriteHtonU32 (m_generationId);
 
-  // Write hop ack sequence
+  // Write hop ack sequence and the selective acknowledgments below it
   start.WriteHtonU64 (m_hopAckSequence);
+  start.WriteHtonU64 (m_hopAckBitmap);
+
+  // Write rank feedback
+  start.WriteHtonU16 (m_rank);
+  start.WriteHtonU32 (m_packetsReceived);
   
   // Write number of sequence numbers
   start.WriteHtonU16 (static_cast<uint16_t> (m_sequenceNumbers.size ()));
@@ -341,8 +664,13 @@ NetworkCodingControlHeader::Deserialize (Buffer::Iterator start)
   // Read generation ID
   m_generationId = start.ReadNtohU32 ();
 
-  // Read hop ack sequence
+  // Read hop ack sequence and the selective acknowledgments below it
   m_hopAckSequence = start.ReadNtohU64();
+  m_hopAckBitmap = start.ReadNtohU64 ();
+
+  // Read rank feedback
+  m_rank = start.ReadNtohU16 ();
+  m_packetsReceived = start.ReadNtohU32 ();
   
   // Read number of sequence numbers
   uint16_t numSeqNums = start.ReadNtohU16 ();
@@ -390,9 +718,12 @@ NetworkCodingControlHeader::Print (std::ostream &os) const
 
   os << "Control Type: " << typeStr;
   if (m_controlType == HOP_ACK) {
-    os << " HopAckSeq: " << m_hopAckSequence;
+    os << " HopAckSeq: " << m_hopAckSequence
+       << " HopAckBitmap: 0x" << std::hex << m_hopAckBitmap << std::dec;
   } else {
     os << " Generation ID: " << m_generationId
+       << " Rank: " << m_rank
+       << " Received: " << m_packetsReceived
        << " Sequence Numbers: [";
     
     for (auto it = m_sequenceNumbers.begin(); it != m_sequenceNumbers.end(); ++it) {
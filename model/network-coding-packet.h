@@ -22,6 +22,7 @@
 #define NETWORK_CODING_PACKET_H
 
 #include "ns3/header.h"
+#include "coefficient-generator.h"
 #include <vector>
 #include <set>
 
@@ -35,10 +36,26 @@ namespace ns3 {
  * - Generation ID: to identify which generation the packet belongs to
  * - Generation Size: number of packets in the generation
  * - Coding Coefficients: the coefficients used to encode the packet
+ *
+ * The coefficients are carried either explicitly, one symbol per packet of
+ * the generation packed into bytes, or as a 32-bit seed and a density from
+ * which both ends regenerate them with CoefficientGenerator. A format byte
+ * tells the two apart; relays that recode must use the explicit format
+ * because their coefficients are not the output of the generator. A field
+ * byte names the finite field the packet was coded in.
  */
 class NetworkCodingHeader : public Header
 {
 public:
+  /**
+   * \brief How the coding coefficients are carried
+   */
+  enum CoefficientFormat
+  {
+    EXPLICIT_COEFFICIENTS = 0, //!< One symbol per packet of the generation
+    SEEDED_COEFFICIENTS = 1    //!< Seed and density for CoefficientGenerator
+  };
+
   /**
    * \brief Get the TypeId
    * \return the TypeId for this class
@@ -117,6 +134,29 @@ public:
   void SetCoefficients (const std::vector<uint8_t>& coeffs);
   const std::vector<uint8_t>& GetCoefficients (void) const;
 
+  /**
+   * \brief Carry the coefficients as a seed instead of a vector
+   * \param seed Seed for CoefficientGenerator
+   * \param count Number of coefficients to generate; the rest are zero
+   * \param density Nonzero probability of each coefficient, in 1/255 units
+   *
+   * GetCoefficients returns the regenerated vector on both ends. The
+   * field must be set first.
+   */
+  void SetCoefficientSeed (uint32_t seed, uint16_t count,
+                           uint8_t density = CoefficientGenerator::DENSE);
+
+  CoefficientFormat GetCoefficientFormat (void) const;
+
+  /**
+   * \brief Set the field the packet is coded in
+   * \param field The field (GF(2^8) by default)
+   */
+  void SetField (gf::FieldType field);
+  gf::FieldType GetField (void) const;
+  uint32_t GetCoefficientSeed (void) const;
+  uint8_t GetCoefficientDensity (void) const;
+
   void SetHopSequence(uint64_t seq);
   uint64_t GetHopSequence() const;
 
@@ -124,9 +164,75 @@ private:
   uint32_t m_generationId;
   uint16_t m_generationSize;
   std::vector<uint8_t> m_coefficients;
+  CoefficientFormat m_format;
+  uint32_t m_seed;                         //!< Seed, in the seeded format
+  uint8_t m_density;                       //!< Density, in the seeded format
+  gf::FieldType m_field;                   //!< Field of the coefficients and payload
   uint64_t m_hopSequence; // Unique ID for hop-by-hop retransmissions
 };
 
+/**
+ * \ingroup network-coding
+ * \brief Header for sliding-window coded packets
+ *
+ * Instead of a generation ID this header carries the sender's coding
+ * window [start, end) in source sequence numbers and one coefficient per
+ * source packet in the window. The window start also tells the receiver
+ * that packets before it will never be coded again.
+ */
+class NetworkCodingWindowHeader : public Header
+{
+public:
+  /**
+   * \brief Get the TypeId
+   * \return the TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Default constructor
+   */
+  NetworkCodingWindowHeader ();
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~NetworkCodingWindowHeader ();
+
+  virtual TypeId GetInstanceTypeId (void) const override;
+  virtual uint32_t GetSerializedSize (void) const override;
+  virtual void Serialize (Buffer::Iterator start) const override;
+  virtual uint32_t Deserialize (Buffer::Iterator start) override;
+  virtual void Print (std::ostream &os) const override;
+
+  /**
+   * \brief Set the coding window and its coefficients
+   * \param start Sequence number of the first source packet in the window
+   * \param coeffs One coefficient per source packet, starting at start
+   *
+   * The window end is start + coeffs.size ().
+   */
+  void SetWindow (uint32_t start, const std::vector<uint8_t>& coeffs);
+
+  /**
+   * \brief Get the first sequence number in the window
+   * \return the window start
+   */
+  uint32_t GetWindowStart (void) const;
+
+  /**
+   * \brief Get the sequence number one past the last one in the window
+   * \return the window end
+   */
+  uint32_t GetWindowEnd (void) const;
+
+  const std::vector<uint8_t>& GetCoefficients (void) const;
+
+private:
+  uint32_t m_windowStart;
+  std::vector<uint8_t> m_coefficients;
+};
+
 /**
  * \ingroup network-coding
  * \brief Header for network coding control packets (rerequest missing packets)
@@ -223,11 +329,45 @@ public:
   void SetHopAckSequence(uint64_t seq);
   uint64_t GetHopAckSequence() const;
 
+  /**
+   * \brief Set which hop sequences just below the hop ACK sequence arrived
+   * \param bitmap Bit i set means hop sequence GetHopAckSequence () - 1 - i
+   *        was received
+   *
+   * A HOP_ACK then acknowledges up to 65 packets at once, so losing one
+   * ACK, or acknowledging in batches, does not cause retransmissions.
+   */
+  void SetHopAckBitmap (uint64_t bitmap);
+  uint64_t GetHopAckBitmap (void) const;
+
+  /**
+   * \brief Set the rank the receiver has reached for the generation
+   * \param rank Number of linearly independent packets received
+   *
+   * Carried by ACKNOWLEDGE and INNOVATIVE_ACK so the sender can size its
+   * repair burst to what is actually missing.
+   */
+  void SetRank (uint16_t rank);
+  uint16_t GetRank (void) const;
+
+  /**
+   * \brief Set the number of packets received for the generation
+   * \param count Packets received, innovative or not
+   *
+   * Together with the hop ACK sequence (the highest hop sequence seen)
+   * this lets the sender estimate the loss rate of the path.
+   */
+  void SetPacketsReceived (uint32_t count);
+  uint32_t GetPacketsReceived (void) const;
+
 private:
   ControlType m_controlType;
   uint32_t m_generationId;
   std::vector<uint32_t> m_sequenceNumbers;
   uint64_t m_hopAckSequence; // Sequence number for HOP_ACK
+  uint64_t m_hopAckBitmap;   //!< Hop sequences received below m_hopAckSequence
+  uint16_t m_rank;           //!< Receiver rank for the generation
+  uint32_t m_packetsReceived; //!< Packets received for the generation
 };
 
 } // namespace ns3
@@ -0,0 +1,350 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "network-coding-rate-controller.h"
+#include "ns3/assert.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NetworkCodingRateController");
+NS_OBJECT_ENSURE_REGISTERED (NetworkCodingRateController);
+NS_OBJECT_ENSURE_REGISTERED (NetworkCodingBbrRateController);
+
+// PROBE_BW gains, one round each: probe, drain what the probe queued, cruise
+static const double PROBE_BW_GAINS[] = {1.25, 0.75, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+static const uint32_t PROBE_BW_PHASES = sizeof (PROBE_BW_GAINS) / sizeof (PROBE_BW_GAINS[0]);
+
+// STARTUP ends after this many rounds without the estimate growing by 25%
+static const uint32_t FULL_BANDWIDTH_ROUNDS = 3;
+
+TypeId
+NetworkCodingRateController::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NetworkCodingRateController")
+    .SetParent<Object> ()
+    .SetGroupName ("NetworkCoding")
+    .AddConstructor<NetworkCodingRateController> ()
+    .AddTraceSource ("PacingRate", "The rate packets are sent at",
+                     MakeTraceSourceAccessor (&NetworkCodingRateController::m_pacingRate),
+                     "ns3::TracedValueCallback::DataRate")
+  ;
+  return tid;
+}
+
+NetworkCodingRateController::NetworkCodingRateController ()
+  : m_packetSize (1024),
+    m_pacingRate (DataRate ("1Mbps"))
+{
+  NS_LOG_FUNCTION (this);
+}
+
+NetworkCodingRateController::~NetworkCodingRateController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+NetworkCodingRateController::Start (DataRate rate, uint32_t packetSize)
+{
+  NS_LOG_FUNCTION (this << rate << packetSize);
+  m_packetSize = packetSize;
+  m_pacingRate = rate;
+}
+
+void
+NetworkCodingRateController::OnFeedback (const RateSample &sample)
+{
+}
+
+void
+NetworkCodingRateController::OnTimeout (void)
+{
+}
+
+DataRate
+NetworkCodingRateController::GetPacingRate (void) const
+{
+  return m_pacingRate;
+}
+
+Time
+NetworkCodingRateController::GetSendInterval (void) const
+{
+  DataRate rate = m_pacingRate;
+  NS_ASSERT_MSG (rate.GetBitRate () > 0, "The pacing rate must be positive");
+  return Seconds (m_packetSize * 8 / static_cast<double> (rate.GetBitRate ()));
+}
+
+TypeId
+NetworkCodingBbrRateController::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NetworkCodingBbrRateController")
+    .SetParent<NetworkCodingRateController> ()
+    .SetGroupName ("NetworkCoding")
+    .AddConstructor<NetworkCodingBbrRateController> ()
+    .AddAttribute ("StartupGain",
+                   "Pacing gain while searching for the bottleneck bandwidth; "
+                   "its inverse drains the queue afterwards",
+                   DoubleValue (2.885),
+                   MakeDoubleAccessor (&NetworkCodingBbrRateController::m_startupGain),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("BandwidthWindow",
+                   "Round trips over which the largest delivery rate is kept",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&NetworkCodingBbrRateController::m_bandwidthWindow),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MinRttWindow",
+                   "How long the smallest RTT is trusted before it is measured again",
+                   TimeValue (Seconds (10)),
+                   MakeTimeAccessor (&NetworkCodingBbrRateController::m_minRttWindow),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("ProbeRttDuration",
+                   "Shortest time the rate is halved to measure the RTT again",
+                   TimeValue (MilliSeconds (200)),
+                   MakeTimeAccessor (&NetworkCodingBbrRateController::m_probeRttDuration),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("MinRate", "Lowest pacing rate",
+                   DataRateValue (DataRate ("100kbps")),
+                   MakeDataRateAccessor (&NetworkCodingBbrRateController::m_minRate),
+                   MakeDataRateChecker ())
+  ;
+  return tid;
+}
+
+NetworkCodingBbrRateController::NetworkCodingBbrRateController ()
+  : m_startupGain (2.885),
+    m_bandwidthWindow (10),
+    m_minRttWindow (Seconds (10)),
+    m_probeRttDuration (MilliSeconds (200)),
+    m_minRate (DataRate ("100kbps")),
+    m_state (STARTUP),
+    m_fullBandwidthRounds (0),
+    m_filledPipe (false),
+    m_cycleIndex (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+NetworkCodingBbrRateController::~NetworkCodingBbrRateController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+NetworkCodingBbrRateController::Start (DataRate rate, uint32_t packetSize)
+{
+  NS_LOG_FUNCTION (this << rate << packetSize);
+  NetworkCodingRateController::Start (rate, packetSize);
+  m_initialRate = rate;
+  m_samples.clear ();
+  m_minRtt = Seconds (0);
+  m_minRttStamp = Simulator::Now ();
+  m_probeRtt = Seconds (0);
+  m_lastRtt = Seconds (0);
+  m_roundStart = Simulator::Now ();
+  m_fullBandwidth = DataRate (0);
+  m_fullBandwidthRounds = 0;
+  m_filledPipe = false;
+  EnterState (STARTUP);
+  UpdatePacingRate ();
+}
+
+void
+NetworkCodingBbrRateController::OnFeedback (const RateSample &sample)
+{
+  NS_LOG_FUNCTION (this << sample.rtt << sample.deliveryRate << sample.appLimited);
+  Time now = Simulator::Now ();
+
+  if (sample.rtt.IsStrictlyPositive ())
+    {
+      m_lastRtt = sample.rtt;
+      if (m_minRtt.IsZero () || sample.rtt <= m_minRtt)
+        {
+          m_minRtt = sample.rtt;
+          m_minRttStamp = now;
+        }
+      if (m_state == PROBE_RTT && (m_probeRtt.IsZero () || sample.rtt < m_probeRtt))
+        {
+          m_probeRtt = sample.rtt;
+        }
+    }
+
+  // An idle sender delivers less than the path can carry; such samples
+  // may only raise the estimate
+  if (sample.deliveryRate.GetBitRate () > 0
+      && (!sample.appLimited || sample.deliveryRate.GetBitRate () >= GetBandwidth ().GetBitRate ()))
+    {
+      m_samples.emplace_back (now, sample.deliveryRate);
+    }
+  Time window = GetRound () * static_cast<int64_t> (m_bandwidthWindow);
+  while (m_samples.size () > 1 && now - m_samples.front ().first > window)
+    {
+      m_samples.pop_front ();
+    }
+
+  switch (m_state)
+    {
+    case STARTUP:
+      if (!m_samples.empty () && now - m_roundStart >= GetRound ())
+        {
+          m_roundStart = now;
+          DataRate bandwidth = GetBandwidth ();
+          if (bandwidth.GetBitRate () >= 1.25 * m_fullBandwidth.GetBitRate ())
+            {
+              m_fullBandwidth = bandwidth;
+              m_fullBandwidthRounds = 0;
+            }
+          else if (++m_fullBandwidthRounds >= FULL_BANDWIDTH_ROUNDS)
+            {
+              m_filledPipe = true;
+              EnterState (DRAIN);
+            }
+        }
+      break;
+    case DRAIN:
+      // The queue STARTUP built is gone once the RTT is back near its minimum
+      if (m_lastRtt.GetSeconds () <= 1.25 * m_minRtt.GetSeconds ()
+          || now - m_stateStart >= GetRound () * static_cast<int64_t> (3))
+        {
+          EnterState (PROBE_BW);
+        }
+      break;
+    case PROBE_BW:
+      if (now - m_stateStart >= GetRound ())
+        {
+          m_cycleIndex = (m_cycleIndex + 1) % PROBE_BW_PHASES;
+          m_stateStart = now;
+        }
+      break;
+    case PROBE_RTT:
+      if (now - m_stateStart >= std::max (m_probeRttDuration, GetRound ()))
+        {
+          if (m_probeRtt.IsStrictlyPositive ())
+            {
+              m_minRtt = m_probeRtt;
+            }
+          m_minRttStamp = now;
+          EnterState (m_filledPipe ? PROBE_BW : STARTUP);
+        }
+      break;
+    }
+
+  if (m_state != PROBE_RTT && !m_minRtt.IsZero () && now - m_minRttStamp > m_minRttWindow)
+    {
+      EnterState (PROBE_RTT);
+    }
+  UpdatePacingRate ();
+}
+
+void
+NetworkCodingBbrRateController::OnTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Feedback stopped altogether, so the estimate is stale: restart from
+  // half of it until new samples arrive
+  m_initialRate = DataRate (std::max<uint64_t> (m_minRate.GetBitRate (), GetBandwidth ().GetBitRate () / 2));
+  m_samples.clear ();
+  UpdatePacingRate ();
+}
+
+NetworkCodingBbrRateController::State
+NetworkCodingBbrRateController::GetState (void) const
+{
+  return m_state;
+}
+
+DataRate
+NetworkCodingBbrRateController::GetBandwidth (void) const
+{
+  if (m_samples.empty ())
+    {
+      return m_initialRate;
+    }
+  DataRate bandwidth = m_samples.front ().second;
+  for (const auto &sample : m_samples)
+    {
+      if (sample.second.GetBitRate () > bandwidth.GetBitRate ())
+        {
+          bandwidth = sample.second;
+        }
+    }
+  return bandwidth;
+}
+
+Time
+NetworkCodingBbrRateController::GetMinRtt (void) const
+{
+  return m_minRtt;
+}
+
+void
+NetworkCodingBbrRateController::EnterState (State state)
+{
+  NS_LOG_INFO ("State " << m_state << " -> " << state << " at bandwidth " << GetBandwidth ()
+               << ", min RTT " << m_minRtt);
+  m_state = state;
+  m_stateStart = Simulator::Now ();
+  if (state == PROBE_BW)
+    {
+      // Cruise first; the probe comes once the drained queue has settled
+      m_cycleIndex = 2;
+    }
+  else if (state == PROBE_RTT)
+    {
+      m_probeRtt = Seconds (0);
+    }
+}
+
+double
+NetworkCodingBbrRateController::GetGain (void) const
+{
+  switch (m_state)
+    {
+    case STARTUP:
+      return m_startupGain;
+    case DRAIN:
+      return 1.0 / m_startupGain;
+    case PROBE_BW:
+      return PROBE_BW_GAINS[m_cycleIndex];
+    case PROBE_RTT:
+      return 0.5;
+    }
+  return 1.0;
+}
+
+Time
+NetworkCodingBbrRateController::GetRound (void) const
+{
+  return m_minRtt.IsZero () ? Seconds (1) : m_minRtt;
+}
+
+void
+NetworkCodingBbrRateController::UpdatePacingRate (void)
+{
+  // Until the first delivery sample there is nothing to apply a gain to
+  double gain = m_samples.empty () ? 1.0 : GetGain ();
+  uint64_t rate = static_cast<uint64_t> (gain * GetBandwidth ().GetBitRate ());
+  m_pacingRate = DataRate (std::max<uint64_t> (rate, m_minRate.GetBitRate ()));
+}
+
+} // namespace ns3
@@ -0,0 +1,208 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NETWORK_CODING_RATE_CONTROLLER_H
+#define NETWORK_CODING_RATE_CONTROLLER_H
+
+#include "ns3/object.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-value.h"
+#include <deque>
+#include <utility>
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief Paces the packets of a NetworkCodingUdpApplication sender
+ *
+ * The sender asks the controller for the interval to the next packet and
+ * tells it about every ACK it gets back. This base class keeps the rate it
+ * was started with, i.e. the application's DataRate; subclasses adjust it
+ * from the feedback, the way NetworkCodingBbrRateController does.
+ */
+class NetworkCodingRateController : public Object
+{
+public:
+  /**
+   * \brief What one ACK tells about the path
+   */
+  struct RateSample
+  {
+    Time rtt;               //!< From sending the newest packet the receiver saw to its ACK
+    DataRate deliveryRate;  //!< Rate packets reached the receiver since its previous ACK, 0 if unknown
+    double loss;            //!< The sender's loss estimate
+    bool appLimited;        //!< The sender ran out of packets during the interval
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  NetworkCodingRateController ();
+  virtual ~NetworkCodingRateController ();
+
+  /**
+   * \brief Start pacing a new transfer
+   * \param rate The initial rate, normally the application's DataRate
+   * \param packetSize Payload bytes per packet
+   */
+  virtual void Start (DataRate rate, uint32_t packetSize);
+
+  /**
+   * \brief Take the feedback of an ACK into account
+   * \param sample What the ACK tells
+   */
+  virtual void OnFeedback (const RateSample &sample);
+
+  /**
+   * \brief A generation timed out without any feedback
+   */
+  virtual void OnTimeout (void);
+
+  /**
+   * \brief Get the rate packets are currently sent at
+   * \return the pacing rate
+   */
+  DataRate GetPacingRate (void) const;
+
+  /**
+   * \brief Get the time between two packets at the pacing rate
+   * \return the send interval
+   */
+  Time GetSendInterval (void) const;
+
+protected:
+  uint32_t m_packetSize;                 //!< Payload bytes per packet
+  TracedValue<DataRate> m_pacingRate;    //!< Set by subclasses
+};
+
+/**
+ * \ingroup network-coding
+ * \brief Model-based pacing after BBR
+ *
+ * Paces at a gain times the bottleneck bandwidth, estimated as the largest
+ * delivery rate seen over the last BandwidthWindow round trips, and keeps
+ * the smallest RTT of the last MinRttWindow. STARTUP grows the rate by
+ * StartupGain per round until the estimate stops growing by 25% for three
+ * rounds, DRAIN empties the queue that built up, PROBE_BW cycles the gain
+ * through 1.25, 0.75 and six rounds of 1 to find more bandwidth, and
+ * PROBE_RTT halves the rate for ProbeRttDuration when the minimum RTT has
+ * not been seen for MinRttWindow.
+ *
+ * Loss does not slow the sender down: coding redundancy repairs random
+ * loss, and a rate above the bottleneck shows up as a delivery rate below
+ * the pacing rate before it shows up as loss. Samples from intervals in
+ * which the sender ran out of packets only raise the estimate.
+ */
+class NetworkCodingBbrRateController : public NetworkCodingRateController
+{
+public:
+  /**
+   * \brief Controller states
+   */
+  enum State
+  {
+    STARTUP,
+    DRAIN,
+    PROBE_BW,
+    PROBE_RTT
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  NetworkCodingBbrRateController ();
+  virtual ~NetworkCodingBbrRateController ();
+
+  virtual void Start (DataRate rate, uint32_t packetSize);
+  virtual void OnFeedback (const RateSample &sample);
+  virtual void OnTimeout (void);
+
+  /**
+   * \brief Get the current state
+   * \return the state
+   */
+  State GetState (void) const;
+
+  /**
+   * \brief Get the bottleneck bandwidth estimate
+   * \return the largest recent delivery rate, or the initial rate before any
+   */
+  DataRate GetBandwidth (void) const;
+
+  /**
+   * \brief Get the minimum RTT estimate
+   * \return the smallest recent RTT, zero before any feedback
+   */
+  Time GetMinRtt (void) const;
+
+private:
+  /**
+   * \brief Switch state
+   * \param state The new state
+   */
+  void EnterState (State state);
+
+  /**
+   * \brief Get the pacing gain of the current state and cycle phase
+   * \return the gain
+   */
+  double GetGain (void) const;
+
+  /**
+   * \brief Get the length of a round
+   * \return the minimum RTT, or a second before it is known
+   */
+  Time GetRound (void) const;
+
+  /**
+   * \brief Set the pacing rate from the gain and the bandwidth estimate
+   */
+  void UpdatePacingRate (void);
+
+  double m_startupGain;                  //!< Gain of STARTUP, inverted in DRAIN
+  uint32_t m_bandwidthWindow;            //!< Rounds the bandwidth filter spans
+  Time m_minRttWindow;                   //!< How long a minimum RTT stays valid
+  Time m_probeRttDuration;               //!< Shortest PROBE_RTT
+  DataRate m_minRate;                    //!< Lowest pacing rate
+
+  State m_state;                         //!< Current state
+  Time m_stateStart;                     //!< When the state was entered
+  DataRate m_initialRate;                //!< Estimate before any delivery sample
+  std::deque<std::pair<Time, DataRate>> m_samples; //!< Delivery rates of the filter window
+  Time m_minRtt;                         //!< Smallest RTT of the window
+  Time m_minRttStamp;                    //!< When m_minRtt was measured
+  Time m_probeRtt;                       //!< Smallest RTT seen in PROBE_RTT
+  Time m_lastRtt;                        //!< Most recent RTT sample
+  Time m_roundStart;                     //!< Start of the current round
+  DataRate m_fullBandwidth;              //!< Estimate at the last 25% growth
+  uint32_t m_fullBandwidthRounds;        //!< Rounds since then
+  bool m_filledPipe;                     //!< STARTUP has ended
+  uint32_t m_cycleIndex;                 //!< Phase of the PROBE_BW gain cycle
+};
+
+} // namespace ns3
+
+#endif /* NETWORK_CODING_RATE_CONTROLLER_H */
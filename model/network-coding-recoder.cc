@@ -0,0 +1,329 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "network-coding-recoder.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NetworkCodingRecoder");
+NS_OBJECT_ENSURE_REGISTERED (NetworkCodingRecoder);
+
+TypeId
+NetworkCodingRecoder::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NetworkCodingRecoder")
+    .SetParent<Object> ()
+    .SetGroupName ("NetworkCoding")
+    .AddConstructor<NetworkCodingRecoder> ()
+  ;
+  return tid;
+}
+
+NetworkCodingRecoder::NetworkCodingRecoder ()
+  : NetworkCodingRecoder (8, 1024)
+{
+}
+
+NetworkCodingRecoder::NetworkCodingRecoder (uint16_t generationSize, uint16_t packetSize)
+  : m_generationSize (generationSize),
+    m_packetSize (packetSize),
+    m_generationId (0),
+    m_field (gf::FIELD_BINARY8),
+    m_rank (0),
+    m_highestSequence (0)
+{
+  NS_LOG_FUNCTION (this << generationSize << packetSize);
+  NS_ASSERT_MSG (m_generationSize > 0, "Invalid generation size");
+  NS_ASSERT_MSG (m_packetSize > 0, "Invalid packet size");
+  
+  m_rows.Resize (m_generationSize + 1, m_generationSize, m_packetSize);
+  m_hasPivot.assign (m_generationSize, false);
+  m_weights.assign (m_generationSize, 0);
+  m_rng = CreateObject<UniformRandomVariable> ();
+}
+
+NetworkCodingRecoder::~NetworkCodingRecoder ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint16_t
+NetworkCodingRecoder::GetGenerationSize (void) const
+{
+  return m_generationSize;
+}
+
+uint16_t
+NetworkCodingRecoder::GetPacketSize (void) const
+{
+  return m_packetSize;
+}
+
+void
+NetworkCodingRecoder::SetField (gf::FieldType field)
+{
+  NS_LOG_FUNCTION (this << field);
+  NS_ASSERT_MSG (gf::IsValidField (field), "Unsupported field");
+  
+  if (field != m_field)
+    {
+      m_field = field;
+      Reset (m_generationId);
+    }
+}
+
+gf::FieldType
+NetworkCodingRecoder::GetField (void) const
+{
+  return m_field;
+}
+
+void
+NetworkCodingRecoder::Reset (uint32_t generationId)
+{
+  NS_LOG_FUNCTION (this << generationId);
+  
+  // Rows without a pivot are never read, so only the bookkeeping is reset
+  m_generationId = generationId;
+  std::fill (m_hasPivot.begin (), m_hasPivot.end (), false);
+  m_rank = 0;
+  m_highestSequence = 0;
+}
+
+uint32_t
+NetworkCodingRecoder::GetGenerationId (void) const
+{
+  return m_generationId;
+}
+
+bool
+NetworkCodingRecoder::ProcessCodedPacket (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  
+  if (!packet)
+    {
+      NS_LOG_ERROR ("Null packet received");
+      return false;
+    }
+  
+  Ptr<Packet> payload = packet->Copy ();
+  NetworkCodingHeader header;
+  if (payload->RemoveHeader (header) == 0)
+    {
+      NS_LOG_ERROR ("Failed to remove network coding header");
+      return false;
+    }
+  
+  return ProcessCodedPacket (payload, header);
+}
+
+bool
+NetworkCodingRecoder::ProcessCodedPacket (Ptr<const Packet> payload, const NetworkCodingHeader &header)
+{
+  NS_LOG_FUNCTION (this << payload << header.GetGenerationId ());
+  
+  if (header.GetGenerationId () != m_generationId)
+    {
+      NS_LOG_WARN ("Packet belongs to generation " << header.GetGenerationId ()
+                   << " but recoder holds generation " << m_generationId);
+      return false;
+    }
+  if (header.GetField () != m_field || header.GetGenerationSize () != m_generationSize)
+    {
+      NS_LOG_WARN ("Packet does not match the recoder's field or generation size");
+      return false;
+    }
+  m_highestSequence = std::max (m_highestSequence, header.GetHopSequence ());
+  if (m_rank == m_generationSize)
+    {
+      NS_LOG_INFO ("Generation " << m_generationId << " already at full rank");
+      return false;
+    }
+  
+  // Stage the row in the scratch slot
+  const std::vector<uint8_t> &coefficients = header.GetCoefficients ();
+  const uint32_t scratch = m_generationSize;
+  m_rows.ZeroRow (scratch);
+  std::copy_n (coefficients.begin (), std::min (coefficients.size (), (size_t)m_generationSize),
+               m_rows.GetCoefficients (scratch));
+  uint32_t copySize = std::min (payload->GetSize (), (uint32_t)m_packetSize);
+  payload->CopyData (m_rows.GetPayload (scratch), copySize);
+  
+  switch (m_field)
+    {
+    case gf::FIELD_BINARY:
+      return ReduceRow<gf::Binary> ();
+    case gf::FIELD_BINARY4:
+      return ReduceRow<gf::Binary4> ();
+    case gf::FIELD_BINARY8:
+      return ReduceRow<gf::Binary8> ();
+    }
+  return false;
+}
+
+template <class Field>
+bool
+NetworkCodingRecoder::ReduceRow (void)
+{
+  const uint32_t scratch = m_generationSize;
+  uint8_t *coefficients = m_rows.GetCoefficients (scratch);
+  uint8_t *payload = m_rows.GetPayload (scratch);
+  
+  // Cancel the pivot columns in increasing order. A stored row for column
+  // j is zero before j, so it only changes columns that are still to come
+  // and the result is zero in every pivot column.
+  int32_t lead = -1;
+  for (uint32_t j = 0; j < m_generationSize; j++)
+    {
+      uint8_t factor = coefficients[j];
+      if (factor == 0)
+        {
+          continue;
+        }
+      if (!m_hasPivot[j])
+        {
+          if (lead < 0)
+            {
+              lead = j;
+            }
+          continue;
+        }
+      Field::MultiplyAddRegion (coefficients + j, m_rows.GetCoefficients (j) + j,
+                                factor, m_generationSize - j);
+      Field::MultiplyAddRegion (payload, m_rows.GetPayload (j), factor, m_packetSize);
+    }
+  
+  if (lead < 0)
+    {
+      NS_LOG_INFO ("Dropping non-innovative packet for generation " << m_generationId);
+      return false;
+    }
+  
+  // Normalize so that later reductions can use the entry as the factor
+  uint8_t pivotInv = Field::Inverse (coefficients[lead]);
+  Field::MultiplyRegion (coefficients + lead, pivotInv, m_generationSize - lead);
+  Field::MultiplyRegion (payload, pivotInv, m_packetSize);
+  
+  m_rows.SwapRows (lead, scratch);
+  m_hasPivot[lead] = true;
+  m_rank++;
+  
+  NS_LOG_INFO ("Stored innovative packet for column " << lead << ", rank "
+               << m_rank << "/" << m_generationSize);
+  return true;
+}
+
+template <class Field>
+void
+NetworkCodingRecoder::CombineRows (void)
+{
+  const uint32_t scratch = m_generationSize;
+  m_rows.ZeroRow (scratch);
+  uint8_t *coefficients = m_rows.GetCoefficients (scratch);
+  uint8_t *payload = m_rows.GetPayload (scratch);
+  
+  // Uniform over the whole field: in GF(2) nonzero-only weights would
+  // always send the same sum. An all-zero draw, as likely as 1/2 at rank 1
+  // in GF(2), is redrawn rather than sent as an empty packet.
+  bool nonZero = false;
+  while (!nonZero)
+    {
+      for (uint32_t j = 0; j < m_generationSize; j++)
+        {
+          m_weights[j] = m_hasPivot[j] ? static_cast<uint8_t> (m_rng->GetInteger (0, Field::MAX_ELEMENT)) : 0;
+          nonZero = nonZero || m_weights[j] != 0;
+        }
+    }
+  
+  for (uint32_t j = 0; j < m_generationSize; j++)
+    {
+      uint8_t weight = m_weights[j];
+      if (weight == 0)
+        {
+          continue;
+        }
+      Field::MultiplyAddRegion (coefficients + j, m_rows.GetCoefficients (j) + j,
+                                weight, m_generationSize - j);
+      Field::MultiplyAddRegion (payload, m_rows.GetPayload (j), weight, m_packetSize);
+    }
+}
+
+Ptr<Packet>
+NetworkCodingRecoder::GenerateRecodedPacket (void)
+{
+  NS_LOG_FUNCTION (this);
+  
+  if (m_rank == 0)
+    {
+      NS_LOG_WARN ("Cannot recode: nothing stored for generation " << m_generationId);
+      return nullptr;
+    }
+  
+  switch (m_field)
+    {
+    case gf::FIELD_BINARY:
+      CombineRows<gf::Binary> ();
+      break;
+    case gf::FIELD_BINARY4:
+      CombineRows<gf::Binary4> ();
+      break;
+    case gf::FIELD_BINARY8:
+      CombineRows<gf::Binary8> ();
+      break;
+    }
+  
+  const uint32_t scratch = m_generationSize;
+  const uint8_t *coefficients = m_rows.GetCoefficients (scratch);
+  Ptr<Packet> packet = Create<Packet> (m_rows.GetPayload (scratch), m_packetSize);
+  
+  // The combined coefficients cannot be regenerated from a seed
+  NetworkCodingHeader header;
+  header.SetGenerationId (m_generationId);
+  header.SetGenerationSize (m_generationSize);
+  header.SetField (m_field);
+  header.SetCoefficients (std::vector<uint8_t> (coefficients, coefficients + m_generationSize));
+  header.SetHopSequence (m_highestSequence);
+  packet->AddHeader (header);
+  
+  return packet;
+}
+
+uint16_t
+NetworkCodingRecoder::GetRank (void) const
+{
+  return m_rank;
+}
+
+bool
+NetworkCodingRecoder::IsFullRank (void) const
+{
+  return m_rank == m_generationSize;
+}
+
+int64_t
+NetworkCodingRecoder::AssignStreams (int64_t stream)
+{
+  m_rng->SetStream (stream);
+  return 1;
+}
+
+} // namespace ns3
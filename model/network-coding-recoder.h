@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NETWORK_CODING_RECODER_H
+#define NETWORK_CODING_RECODER_H
+
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+#include "network-coding-packet.h"
+#include "galois-field-traits.h"
+#include "generation-buffer.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief Recoder for one generation at an intermediate node
+ *
+ * A recoder stores the coded packets it receives for a generation and
+ * sends fresh random linear combinations of them, without decoding. The
+ * rows are kept partially reduced: every stored row is zero in the pivot
+ * columns of the rows stored before it, so rank is checked incrementally
+ * and non-innovative packets are dropped at the relay instead of being
+ * forwarded. No back-substitution is done, which is all a decoder needs
+ * on top of this.
+ *
+ * Storage is bounded by the generation size: at most one row per source
+ * packet is ever held.
+ *
+ * Recoded packets carry the highest hop sequence received for the
+ * generation, i.e. the index of the newest packet the sender made for it,
+ * so receivers behind relays report the same packet indices a direct
+ * receiver would.
+ */
+class NetworkCodingRecoder : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  NetworkCodingRecoder ();
+
+  /**
+   * \brief Create a recoder for generation 0
+   * \param generationSize Source packets per generation
+   * \param packetSize Payload bytes per packet
+   */
+  NetworkCodingRecoder (uint16_t generationSize, uint16_t packetSize);
+  virtual ~NetworkCodingRecoder ();
+
+  uint16_t GetGenerationSize (void) const;
+  uint16_t GetPacketSize (void) const;
+
+  /**
+   * \brief Set the finite field of the packets; must match the encoder
+   * \param field GF(2), GF(2^4) or GF(2^8) (default)
+   */
+  void SetField (gf::FieldType field);
+  gf::FieldType GetField (void) const;
+
+  /**
+   * \brief Drop everything held and start recoding another generation
+   * \param generationId The new generation
+   */
+  void Reset (uint32_t generationId);
+  uint32_t GetGenerationId (void) const;
+
+  /**
+   * \brief Store a received coded packet if it is innovative
+   * \param packet The packet, starting with its NetworkCodingHeader
+   * \return true if the packet increased the rank
+   */
+  bool ProcessCodedPacket (Ptr<const Packet> packet);
+
+  /**
+   * \brief Store a coded packet whose header has already been parsed
+   * \param payload The coded payload, without the NetworkCodingHeader
+   * \param header The header that came with the payload
+   * \return true if the packet increased the rank
+   */
+  bool ProcessCodedPacket (Ptr<const Packet> payload, const NetworkCodingHeader &header);
+
+  /**
+   * \brief Generate a random combination of the packets held
+   * \return the packet with explicit coefficients, or nullptr if nothing is held
+   */
+  Ptr<Packet> GenerateRecodedPacket (void);
+
+  uint16_t GetRank (void) const;
+  bool IsFullRank (void) const;
+
+  /**
+   * \brief Assign a fixed random variable stream number
+   * \param stream First stream index to use
+   * \return the number of streams assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+private:
+  /**
+   * \brief Reduce the scratch row against the stored rows and store it
+   * \return true if the row was innovative
+   */
+  template <class Field>
+  bool ReduceRow (void);
+
+  /**
+   * \brief Build a random combination of the stored rows in the scratch row
+   *
+   * The weights are never all zero, so every combination carries something.
+   */
+  template <class Field>
+  void CombineRows (void);
+
+  uint16_t m_generationSize;
+  uint16_t m_packetSize;
+  uint32_t m_generationId;
+  gf::FieldType m_field;                //!< Field the packets are coded in
+  uint16_t m_rank;
+  uint64_t m_highestSequence;           //!< Highest hop sequence received for the generation
+  GenerationBuffer m_rows;              //!< Row j holds the pivot for column j; row g is scratch
+  std::vector<bool> m_hasPivot;         //!< Whether column j has a stored row
+  std::vector<uint8_t> m_weights;       //!< Recoding weight of every stored row
+  Ptr<UniformRandomVariable> m_rng;     //!< Draws the recoding coefficients
+};
+
+} // namespace ns3
+
+#endif /* NETWORK_CODING_RECODER_H */
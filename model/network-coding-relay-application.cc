@@ -0,0 +1,381 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "network-coding-relay-application.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/socket-factory.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NetworkCodingRelayApplication");
+NS_OBJECT_ENSURE_REGISTERED (NetworkCodingRelayApplication);
+
+namespace {
+
+/// Acknowledged generations remembered, so late packets for them are not
+/// forwarded again
+const uint32_t ACKED_HISTORY = 1024;
+
+} // anonymous namespace
+
+TypeId
+NetworkCodingRelayApplication::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NetworkCodingRelayApplication")
+    .SetParent<Application> ()
+    .SetGroupName ("NetworkCoding")
+    .AddConstructor<NetworkCodingRelayApplication> ()
+    .AddAttribute ("Port", "The port to receive coded packets on",
+                   UintegerValue (9),
+                   MakeUintegerAccessor (&NetworkCodingRelayApplication::m_port),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("Remote", "The address of the next hop",
+                   AddressValue (),
+                   MakeAddressAccessor (&NetworkCodingRelayApplication::m_peer),
+                   MakeAddressChecker ())
+    .AddAttribute ("PacketSize", "The size of coded payloads",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&NetworkCodingRelayApplication::m_packetSize),
+                   MakeUintegerChecker<uint16_t> (1, 65507))
+    .AddAttribute ("GenerationSize", "The size of each generation",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&NetworkCodingRelayApplication::m_generationSize),
+                   MakeUintegerChecker<uint16_t> (1))
+    .AddAttribute ("FieldBits",
+                   "Bits per symbol of the coding field: 1 for GF(2), "
+                   "4 for GF(2^4) or 8 for GF(2^8)",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&NetworkCodingRelayApplication::m_fieldBits),
+                   MakeUintegerChecker<uint8_t> (1, 8))
+    .AddAttribute ("MaxGenerations",
+                   "The number of generations buffered at once",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&NetworkCodingRelayApplication::m_maxGenerations),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Redundancy",
+                   "Recoded packets sent for every coded packet received on a "
+                   "generation not yet acknowledged",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&NetworkCodingRelayApplication::m_redundancy),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("MeasureCodingTime",
+                   "Time every recoder call on the wall clock and report it "
+                   "through the RecodeTime trace",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NetworkCodingRelayApplication::m_measureCodingTime),
+                   MakeBooleanChecker ())
+    .AddTraceSource ("Tx", "A recoded packet is sent",
+                     MakeTraceSourceAccessor (&NetworkCodingRelayApplication::m_txTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("Rx", "A packet is received",
+                     MakeTraceSourceAccessor (&NetworkCodingRelayApplication::m_rxTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("Drop", "A non-innovative or stale packet is not stored",
+                     MakeTraceSourceAccessor (&NetworkCodingRelayApplication::m_dropTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("RecodeTime",
+                     "Wall-clock time spent recoding each coded packet received, "
+                     "with MeasureCodingTime",
+                     MakeTraceSourceAccessor (&NetworkCodingRelayApplication::m_recodeTimeTrace),
+                     "ns3::NetworkCodingUdpApplication::GenerationTimeTracedCallback")
+  ;
+  return tid;
+}
+
+NetworkCodingRelayApplication::NetworkCodingRelayApplication ()
+  : m_socket (nullptr),
+    m_port (9),
+    m_packetSize (1024),
+    m_generationSize (8),
+    m_fieldBits (8),
+    m_maxGenerations (4),
+    m_redundancy (1.0),
+    m_credit (0.0),
+    m_measureCodingTime (false),
+    m_releasedBelow (0),
+    m_packetsReceived (0),
+    m_packetsForwarded (0),
+    m_packetsDropped (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+NetworkCodingRelayApplication::~NetworkCodingRelayApplication ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+NetworkCodingRelayApplication::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_socket = nullptr;
+  m_recoders.clear ();
+  m_acked.clear ();
+  Application::DoDispose ();
+}
+
+void
+NetworkCodingRelayApplication::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_UNLESS (gf::IsValidField (m_fieldBits), "FieldBits must be 1, 4 or 8");
+  
+  m_recoders.clear ();
+  m_acked.clear ();
+  m_releasedBelow = 0;
+  m_credit = 0.0;
+  
+  if (!m_socket)
+    {
+      m_socket = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
+      if (Inet6SocketAddress::IsMatchingType (m_peer))
+        {
+          m_socket->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), m_port));
+        }
+      else
+        {
+          m_socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), m_port));
+        }
+    }
+  
+  m_socket->SetRecvCallback (MakeCallback (&NetworkCodingRelayApplication::HandleRead, this));
+}
+
+void
+NetworkCodingRelayApplication::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  
+  if (m_socket)
+    {
+      m_socket->Close ();
+      m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket>> ());
+    }
+  
+  NS_LOG_INFO ("Relay stopped. Received: " << m_packetsReceived
+               << ", forwarded: " << m_packetsForwarded
+               << ", dropped: " << m_packetsDropped);
+}
+
+void
+NetworkCodingRelayApplication::HandleRead (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  
+  Ptr<Packet> packet;
+  Address from;
+  while ((packet = socket->RecvFrom (from)))
+    {
+      if (packet->GetSize () == 0)
+        {
+          break;
+        }
+      m_packetsReceived++;
+      m_rxTrace (packet);
+      
+      // ACKs and rank reports start with 0xFFFFFFFF followed by a control
+      // header, as sent by NetworkCodingUdpApplication receivers
+      uint8_t marker[4];
+      if (packet->GetSize () > 4 && packet->CopyData (marker, 4) == 4
+          && marker[0] == 0xFF && marker[1] == 0xFF && marker[2] == 0xFF && marker[3] == 0xFF)
+        {
+          HandleAck (packet);
+        }
+      else
+        {
+          HandleCodedPacket (packet, from);
+        }
+    }
+}
+
+void
+NetworkCodingRelayApplication::HandleCodedPacket (Ptr<Packet> packet, const Address &from)
+{
+  NS_LOG_FUNCTION (this << packet << from);
+  
+  Ptr<const Packet> received = packet->Copy ();
+  NetworkCodingHeader header;
+  if (packet->RemoveHeader (header) == 0)
+    {
+      NS_LOG_WARN ("Dropping packet without a network coding header");
+      m_packetsDropped++;
+      m_dropTrace (received);
+      return;
+    }
+  m_upstream = from;
+  
+  uint32_t generationId = header.GetGenerationId ();
+  Ptr<NetworkCodingRecoder> recoder = GetRecoder (generationId);
+  if (!recoder)
+    {
+      m_packetsDropped++;
+      m_dropTrace (received);
+      return;
+    }
+  
+  // The recoded packets are built before any is sent, so the timing
+  // covers the coding alone
+  std::chrono::steady_clock::time_point start;
+  if (m_measureCodingTime)
+    {
+      start = std::chrono::steady_clock::now ();
+    }
+  bool innovative = recoder->ProcessCodedPacket (packet, header);
+  
+  // Non-innovative packets still earn transmissions: once this hop holds
+  // full rank, the sender's repairs for losses further down are all
+  // non-innovative here, and fresh combinations are what repairs them.
+  // The redundancy can be fractional, in which case the remainder is
+  // carried over.
+  std::vector<Ptr<Packet>> recoded;
+  m_credit += m_redundancy;
+  while (m_credit >= 1.0)
+    {
+      m_credit -= 1.0;
+      Ptr<Packet> next = recoder->GenerateRecodedPacket ();
+      if (next)
+        {
+          recoded.push_back (next);
+        }
+    }
+  if (m_measureCodingTime)
+    {
+      auto elapsed = std::chrono::steady_clock::now () - start;
+      m_recodeTimeTrace (generationId,
+                         NanoSeconds (std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count ()));
+    }
+  
+  if (!innovative)
+    {
+      m_packetsDropped++;
+      m_dropTrace (received);
+    }
+  for (Ptr<Packet> next : recoded)
+    {
+      if (m_socket->SendTo (next, 0, m_peer) > 0)
+        {
+          m_packetsForwarded++;
+          m_txTrace (next);
+        }
+    }
+}
+
+void
+NetworkCodingRelayApplication::HandleAck (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  
+  Ptr<Packet> control = packet->Copy ();
+  control->RemoveAtStart (4);
+  NetworkCodingControlHeader feedback;
+  if (control->PeekHeader (feedback) == 0)
+    {
+      return;
+    }
+  uint32_t generationId = feedback.GetGenerationId ();
+  
+  // A decoded generation needs no buffer space any more, and packets still
+  // on their way for it are not forwarded. Senders with several
+  // generations in flight ACK out of order, so only this one is released;
+  // rank reports are just passed on.
+  if (feedback.GetControlType () == NetworkCodingControlHeader::ACKNOWLEDGE)
+    {
+      m_recoders.erase (generationId);
+      m_acked.insert (generationId);
+      if (m_acked.size () > ACKED_HISTORY)
+        {
+          m_acked.erase (m_acked.begin ());
+        }
+    }
+  
+  if (!m_upstream.IsInvalid () && m_socket->SendTo (packet, 0, m_upstream) > 0)
+    {
+      NS_LOG_INFO ("Passed feedback for generation " << generationId << " upstream");
+    }
+}
+
+Ptr<NetworkCodingRecoder>
+NetworkCodingRelayApplication::GetRecoder (uint32_t generationId)
+{
+  auto it = m_recoders.find (generationId);
+  if (it != m_recoders.end ())
+    {
+      return it->second;
+    }
+  if (generationId < m_releasedBelow || m_acked.count (generationId) > 0)
+    {
+      NS_LOG_INFO ("Generation " << generationId << " was already released");
+      return nullptr;
+    }
+  
+  // Make room by evicting the oldest generation; its recoder is reused
+  Ptr<NetworkCodingRecoder> recoder;
+  if (m_recoders.size () >= m_maxGenerations)
+    {
+      auto oldest = m_recoders.begin ();
+      if (oldest->first > generationId)
+        {
+          return nullptr;
+        }
+      NS_LOG_INFO ("Evicting generation " << oldest->first);
+      recoder = oldest->second;
+      m_releasedBelow = oldest->first + 1;
+      m_recoders.erase (oldest);
+      m_acked.erase (m_acked.begin (), m_acked.lower_bound (m_releasedBelow));
+      recoder->Reset (generationId);
+    }
+  else
+    {
+      recoder = CreateObject<NetworkCodingRecoder> (m_generationSize, m_packetSize);
+      recoder->SetField (static_cast<gf::FieldType> (m_fieldBits));
+      recoder->Reset (generationId);
+    }
+  m_recoders[generationId] = recoder;
+  return recoder;
+}
+
+uint32_t
+NetworkCodingRelayApplication::GetPacketsReceived (void) const
+{
+  return m_packetsReceived;
+}
+
+uint32_t
+NetworkCodingRelayApplication::GetPacketsForwarded (void) const
+{
+  return m_packetsForwarded;
+}
+
+uint32_t
+NetworkCodingRelayApplication::GetPacketsDropped (void) const
+{
+  return m_packetsDropped;
+}
+
+} // namespace ns3
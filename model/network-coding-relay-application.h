@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NETWORK_CODING_RELAY_APPLICATION_H
+#define NETWORK_CODING_RELAY_APPLICATION_H
+
+#include "ns3/application.h"
+#include "ns3/socket.h"
+#include "ns3/address.h"
+#include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+#include "network-coding-recoder.h"
+#include <map>
+#include <set>
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief A UDP relay that recodes network-coded packets
+ *
+ * The relay listens on a port for packets from a NetworkCodingUdpApplication
+ * sender (or another relay), keeps a NetworkCodingRecoder per generation and,
+ * for every coded packet of a generation not yet acknowledged, sends fresh
+ * random combinations of what it holds to the next hop. Non-innovative
+ * packets are not stored, but are still answered, so repairs for losses
+ * past the relay get through once it has full rank. ACKs and rank reports
+ * coming back from downstream are passed on to the last upstream hop; ACKs
+ * release the acknowledged generation.
+ *
+ * At most MaxGenerations recoders are kept; a packet for a newer
+ * generation evicts the oldest one.
+ *
+ * With MeasureCodingTime the wall-clock time the recoder spends on every
+ * coded packet, absorbing it and building what is sent for it, is
+ * reported through the RecodeTime trace.
+ */
+class NetworkCodingRelayApplication : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  NetworkCodingRelayApplication ();
+  virtual ~NetworkCodingRelayApplication ();
+
+  uint32_t GetPacketsReceived (void) const;
+  uint32_t GetPacketsForwarded (void) const;
+  uint32_t GetPacketsDropped (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  void HandleRead (Ptr<Socket> socket);
+  void HandleCodedPacket (Ptr<Packet> packet, const Address &from);
+  void HandleAck (Ptr<Packet> packet);
+
+  /**
+   * \brief Find or create the recoder for a generation
+   * \param generationId The generation
+   * \return the recoder, or nullptr if the generation is already released
+   */
+  Ptr<NetworkCodingRecoder> GetRecoder (uint32_t generationId);
+
+  Ptr<Socket> m_socket;
+  uint16_t m_port;                      //!< Local port to listen on
+  Address m_peer;                       //!< Next hop
+  Address m_upstream;                   //!< Last hop coded packets came from
+
+  // Configuration
+  uint16_t m_packetSize;
+  uint16_t m_generationSize;
+  uint8_t m_fieldBits;                  //!< Bits per symbol of the coding field
+  uint32_t m_maxGenerations;            //!< Recoders kept at once
+  double m_redundancy;                  //!< Recoded packets sent per packet received
+  double m_credit;                      //!< Fractional packets owed downstream
+  bool m_measureCodingTime;             //!< Time recoder calls on the wall clock
+
+  // State
+  std::map<uint32_t, Ptr<NetworkCodingRecoder>> m_recoders; //!< Generation to recoder
+  uint32_t m_releasedBelow;             //!< Generations below this were evicted
+  std::set<uint32_t> m_acked;           //!< Acknowledged generations at or above m_releasedBelow
+  uint32_t m_packetsReceived;
+  uint32_t m_packetsForwarded;
+  uint32_t m_packetsDropped;
+
+  // Tracing
+  TracedCallback<Ptr<const Packet>> m_txTrace;
+  TracedCallback<Ptr<const Packet>> m_rxTrace;
+  TracedCallback<Ptr<const Packet>> m_dropTrace;
+  TracedCallback<uint32_t, Time> m_recodeTimeTrace;  //!< Wall clock per coded packet received
+};
+
+} // namespace ns3
+
+#endif /* NETWORK_CODING_RELAY_APPLICATION_H */
@@ -0,0 +1,588 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "network-coding-trace.h"
+#include "network-coding-udp-application.h"
+#include "network-coding-relay-application.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NetworkCodingTrace");
+NS_OBJECT_ENSURE_REGISTERED (NetworkCodingTraceWriter);
+
+namespace {
+
+/**
+ * \brief Start of every trace file
+ */
+struct TraceFileHeader
+{
+  char magic[4];        //!< "NCTR"
+  uint16_t version;     //!< TRACE_VERSION
+  uint16_t recordSize;  //!< sizeof (NetworkCodingTraceRecord)
+  uint64_t records;     //!< Filled in on close, 0 before
+};
+
+static_assert (sizeof (TraceFileHeader) == 16, "The trace header must stay 16 bytes");
+
+const char TRACE_MAGIC[4] = {'N', 'C', 'T', 'R'};
+const uint16_t TRACE_VERSION = 1;
+
+// Records the reader fetches per read from the file
+const size_t READ_AHEAD = 4096;
+
+TraceFileHeader
+MakeHeader (uint64_t records)
+{
+  TraceFileHeader header;
+  std::memcpy (header.magic, TRACE_MAGIC, sizeof (header.magic));
+  header.version = TRACE_VERSION;
+  header.recordSize = sizeof (NetworkCodingTraceRecord);
+  header.records = records;
+  return header;
+}
+
+/**
+ * \brief Write a whole region at the file position, retrying short writes
+ * \return false on error
+ */
+bool
+WriteAll (int fd, const void *data, size_t size)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *> (data);
+  while (size > 0)
+    {
+      ssize_t n = ::write (fd, bytes, size);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          return false;
+        }
+      bytes += n;
+      size -= n;
+    }
+  return true;
+}
+
+} // namespace
+
+TypeId
+NetworkCodingTraceWriter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NetworkCodingTraceWriter")
+    .SetParent<Object> ()
+    .SetGroupName ("NetworkCoding")
+    .AddConstructor<NetworkCodingTraceWriter> ()
+    .AddAttribute ("BufferRecords",
+                   "Records per write buffer, and the initial size of a mapped file",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&NetworkCodingTraceWriter::m_bufferRecords),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("BufferCount",
+                   "Full buffers waiting for the writer thread before Write blocks",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&NetworkCodingTraceWriter::m_bufferCount),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MemoryMapped",
+                   "Store records in a memory-mapped file instead of writing buffers "
+                   "from a background thread",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NetworkCodingTraceWriter::m_memoryMapped),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+NetworkCodingTraceWriter::NetworkCodingTraceWriter ()
+  : m_bufferRecords (65536),
+    m_bufferCount (4),
+    m_memoryMapped (false),
+    m_fd (-1),
+    m_mapping (false),
+    m_records (0),
+    m_stopping (false),
+    m_failed (false),
+    m_mapBase (nullptr),
+    m_map (nullptr),
+    m_mapRecords (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+NetworkCodingTraceWriter::~NetworkCodingTraceWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+void
+NetworkCodingTraceWriter::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+  Object::DoDispose ();
+}
+
+bool
+NetworkCodingTraceWriter::Open (const std::string &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+
+  m_fd = ::open (filename.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (m_fd < 0)
+    {
+      NS_LOG_ERROR ("Cannot create trace file " << filename << ": " << std::strerror (errno));
+      return false;
+    }
+  TraceFileHeader header = MakeHeader (0);
+  if (!WriteAll (m_fd, &header, sizeof (header)))
+    {
+      NS_LOG_ERROR ("Cannot write trace file " << filename << ": " << std::strerror (errno));
+      ::close (m_fd);
+      m_fd = -1;
+      return false;
+    }
+  m_records = 0;
+  m_failed = false;
+  m_mapping = m_memoryMapped;
+
+  if (m_mapping)
+    {
+      if (!GrowMapping ())
+        {
+          NS_LOG_ERROR ("Cannot map trace file " << filename << ": " << std::strerror (errno));
+          ::close (m_fd);
+          m_fd = -1;
+          return false;
+        }
+    }
+  else
+    {
+      m_current.clear ();
+      m_current.reserve (m_bufferRecords);
+      m_stopping = false;
+      m_thread = std::thread (&NetworkCodingTraceWriter::Run, this);
+    }
+  return true;
+}
+
+bool
+NetworkCodingTraceWriter::IsOpen (void) const
+{
+  return m_fd >= 0;
+}
+
+void
+NetworkCodingTraceWriter::Close (void)
+{
+  if (m_fd < 0)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+
+  if (m_mapping)
+    {
+      if (m_mapBase != nullptr)
+        {
+          ::munmap (m_mapBase, sizeof (TraceFileHeader) + m_mapRecords * sizeof (NetworkCodingTraceRecord));
+        }
+      m_mapBase = nullptr;
+      m_map = nullptr;
+      m_mapRecords = 0;
+      // Drop the space mapped ahead but never used
+      if (::ftruncate (m_fd, sizeof (TraceFileHeader) + m_records * sizeof (NetworkCodingTraceRecord)) != 0)
+        {
+          m_failed = true;
+        }
+    }
+  else
+    {
+      if (!m_current.empty ())
+        {
+          QueueBuffer ();
+        }
+      {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        m_stopping = true;
+      }
+      m_wakeup.notify_one ();
+      m_thread.join ();
+      m_spare.clear ();
+    }
+
+  TraceFileHeader header = MakeHeader (m_records);
+  if (::pwrite (m_fd, &header, sizeof (header), 0) != static_cast<ssize_t> (sizeof (header)))
+    {
+      m_failed = true;
+    }
+  ::close (m_fd);
+  m_fd = -1;
+  if (m_failed)
+    {
+      NS_LOG_ERROR ("Writing the trace failed; it is incomplete");
+    }
+  NS_LOG_INFO ("Closed trace with " << m_records << " records");
+}
+
+void
+NetworkCodingTraceWriter::Write (const NetworkCodingTraceRecord &record)
+{
+  if (m_fd < 0)
+    {
+      return;
+    }
+  if (m_mapping)
+    {
+      if (m_failed || (m_records == m_mapRecords && !GrowMapping ()))
+        {
+          return;
+        }
+      m_map[m_records++] = record;
+      return;
+    }
+
+  m_current.push_back (record);
+  m_records++;
+  if (m_current.size () >= m_bufferRecords)
+    {
+      QueueBuffer ();
+    }
+}
+
+void
+NetworkCodingTraceWriter::Write (uint8_t type, uint16_t source, uint32_t generation,
+                                 int64_t value, uint8_t flags)
+{
+  NetworkCodingTraceRecord record;
+  record.time = Simulator::Now ().GetNanoSeconds ();
+  record.value = value;
+  record.generation = generation;
+  record.source = source;
+  record.type = type;
+  record.flags = flags;
+  Write (record);
+}
+
+uint64_t
+NetworkCodingTraceWriter::GetRecordCount (void) const
+{
+  return m_records;
+}
+
+void
+NetworkCodingTraceWriter::QueueBuffer (void)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  m_written.wait (lock, [this] { return m_full.size () < m_bufferCount || m_failed; });
+  if (m_failed)
+    {
+      m_current.clear ();
+      return;
+    }
+  m_full.push_back (std::move (m_current));
+  if (!m_spare.empty ())
+    {
+      m_current = std::move (m_spare.back ());
+      m_spare.pop_back ();
+    }
+  else
+    {
+      m_current = std::vector<NetworkCodingTraceRecord> ();
+      m_current.reserve (m_bufferRecords);
+    }
+  lock.unlock ();
+  m_wakeup.notify_one ();
+}
+
+void
+NetworkCodingTraceWriter::Run (void)
+{
+  // No logging here: this is not the simulator thread
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (true)
+    {
+      m_wakeup.wait (lock, [this] { return !m_full.empty () || m_stopping; });
+      if (m_full.empty ())
+        {
+          return;
+        }
+      std::vector<NetworkCodingTraceRecord> buffer = std::move (m_full.front ());
+      m_full.pop_front ();
+      bool failed = m_failed;
+      lock.unlock ();
+
+      if (!failed)
+        {
+          failed = !WriteAll (m_fd, buffer.data (), buffer.size () * sizeof (NetworkCodingTraceRecord));
+        }
+      buffer.clear ();
+
+      lock.lock ();
+      m_failed = m_failed || failed;
+      m_spare.push_back (std::move (buffer));
+      m_written.notify_one ();
+    }
+}
+
+bool
+NetworkCodingTraceWriter::GrowMapping (void)
+{
+  uint64_t records = m_mapRecords == 0 ? m_bufferRecords : 2 * m_mapRecords;
+  size_t oldSize = sizeof (TraceFileHeader) + m_mapRecords * sizeof (NetworkCodingTraceRecord);
+  size_t newSize = sizeof (TraceFileHeader) + records * sizeof (NetworkCodingTraceRecord);
+
+  if (m_mapBase != nullptr)
+    {
+      ::munmap (m_mapBase, oldSize);
+      m_mapBase = nullptr;
+      m_map = nullptr;
+    }
+  void *base = MAP_FAILED;
+  if (::ftruncate (m_fd, newSize) == 0)
+    {
+      base = ::mmap (nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    }
+  if (base == MAP_FAILED)
+    {
+      if (!m_failed)
+        {
+          NS_LOG_ERROR ("Cannot extend the mapped trace to " << newSize << " bytes");
+        }
+      m_failed = true;
+      m_mapRecords = 0;
+      // Keep what was stored; Close truncates the file to it
+      return false;
+    }
+  m_mapBase = static_cast<uint8_t *> (base);
+  m_map = reinterpret_cast<NetworkCodingTraceRecord *> (m_mapBase + sizeof (TraceFileHeader));
+  m_mapRecords = records;
+  NS_LOG_LOGIC ("Mapped " << records << " trace records");
+  return true;
+}
+
+NetworkCodingTraceWriter::Sink *
+NetworkCodingTraceWriter::AddSink (uint16_t source)
+{
+  m_sinks.push_back ({this, source});
+  return &m_sinks.back ();
+}
+
+void
+NetworkCodingTraceWriter::Connect (Ptr<NetworkCodingUdpApplication> app, uint16_t source)
+{
+  NS_LOG_FUNCTION (this << app << source);
+  Sink *sink = AddSink (source);
+  app->TraceConnectWithoutContext ("Tx", MakeBoundCallback (&TraceTx, sink));
+  app->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&TraceRx, sink));
+  app->TraceConnectWithoutContext ("Decoding", MakeBoundCallback (&TraceDecoding, sink));
+  app->TraceConnectWithoutContext ("GenerationLatency", MakeBoundCallback (&TraceLatency, sink));
+  app->TraceConnectWithoutContext ("Rank", MakeBoundCallback (&TraceRank, sink));
+  app->TraceConnectWithoutContext ("EncodeTime", MakeBoundCallback (&TraceEncodeTime, sink));
+  app->TraceConnectWithoutContext ("DecodeTime", MakeBoundCallback (&TraceDecodeTime, sink));
+  app->TraceConnectWithoutContext ("SymbolDecoded", MakeBoundCallback (&TraceSymbol, sink));
+}
+
+void
+NetworkCodingTraceWriter::Connect (Ptr<NetworkCodingRelayApplication> app, uint16_t source)
+{
+  NS_LOG_FUNCTION (this << app << source);
+  Sink *sink = AddSink (source);
+  app->TraceConnectWithoutContext ("Tx", MakeBoundCallback (&TraceTx, sink));
+  app->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&TraceRx, sink));
+  app->TraceConnectWithoutContext ("Drop", MakeBoundCallback (&TraceDrop, sink));
+}
+
+void
+NetworkCodingTraceWriter::TraceTx (Sink *sink, Ptr<const Packet> packet)
+{
+  sink->writer->Write (NetworkCodingTraceRecord::TX, sink->source,
+                       NetworkCodingTraceRecord::NO_GENERATION, packet->GetSize ());
+}
+
+void
+NetworkCodingTraceWriter::TraceRx (Sink *sink, Ptr<const Packet> packet)
+{
+  sink->writer->Write (NetworkCodingTraceRecord::RX, sink->source,
+                       NetworkCodingTraceRecord::NO_GENERATION, packet->GetSize ());
+}
+
+void
+NetworkCodingTraceWriter::TraceDrop (Sink *sink, Ptr<const Packet> packet)
+{
+  sink->writer->Write (NetworkCodingTraceRecord::DROP, sink->source,
+                       NetworkCodingTraceRecord::NO_GENERATION, packet->GetSize ());
+}
+
+void
+NetworkCodingTraceWriter::TraceDecoding (Sink *sink, bool success, uint32_t decoded)
+{
+  sink->writer->Write (NetworkCodingTraceRecord::DECODING, sink->source,
+                       NetworkCodingTraceRecord::NO_GENERATION, decoded, success ? 1 : 0);
+}
+
+void
+NetworkCodingTraceWriter::TraceLatency (Sink *sink, uint32_t generationId, Time latency)
+{
+  sink->writer->Write (NetworkCodingTraceRecord::GENERATION_LATENCY, sink->source,
+                       generationId, latency.GetNanoSeconds ());
+}
+
+void
+NetworkCodingTraceWriter::TraceRank (Sink *sink, uint32_t generationId, uint16_t rank, bool innovative)
+{
+  sink->writer->Write (NetworkCodingTraceRecord::RANK, sink->source,
+                       generationId, rank, innovative ? 1 : 0);
+}
+
+void
+NetworkCodingTraceWriter::TraceEncodeTime (Sink *sink, uint32_t generationId, Time elapsed)
+{
+  sink->writer->Write (NetworkCodingTraceRecord::ENCODE_TIME, sink->source,
+                       generationId, elapsed.GetNanoSeconds ());
+}
+
+void
+NetworkCodingTraceWriter::TraceDecodeTime (Sink *sink, uint32_t generationId, Time elapsed)
+{
+  sink->writer->Write (NetworkCodingTraceRecord::DECODE_TIME, sink->source,
+                       generationId, elapsed.GetNanoSeconds ());
+}
+
+void
+NetworkCodingTraceWriter::TraceSymbol (Sink *sink, uint32_t generationId, uint16_t index,
+                                       Ptr<const Packet> symbol)
+{
+  sink->writer->Write (NetworkCodingTraceRecord::SYMBOL_DECODED, sink->source,
+                       generationId, index);
+}
+
+NetworkCodingTraceReader::NetworkCodingTraceReader ()
+  : m_records (0),
+    m_read (0),
+    m_next (0)
+{
+}
+
+bool
+NetworkCodingTraceReader::Open (const std::string &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  m_in.close ();
+  m_in.clear ();
+  m_records = 0;
+  m_read = 0;
+  m_buffer.clear ();
+  m_next = 0;
+
+  m_in.open (filename, std::ios::binary);
+  TraceFileHeader header;
+  if (!m_in || !m_in.read (reinterpret_cast<char *> (&header), sizeof (header)))
+    {
+      NS_LOG_ERROR ("Cannot read trace file " << filename);
+      return false;
+    }
+  if (std::memcmp (header.magic, TRACE_MAGIC, sizeof (header.magic)) != 0
+      || header.version != TRACE_VERSION
+      || header.recordSize != sizeof (NetworkCodingTraceRecord))
+    {
+      NS_LOG_ERROR (filename << " is not a version " << TRACE_VERSION << " trace of this byte order");
+      return false;
+    }
+
+  m_in.seekg (0, std::ios::end);
+  uint64_t complete = (static_cast<uint64_t> (m_in.tellg ()) - sizeof (header))
+                      / sizeof (NetworkCodingTraceRecord);
+  m_in.seekg (sizeof (header), std::ios::beg);
+  // A count of 0 means the writer never closed the file
+  m_records = header.records != 0 ? std::min (header.records, complete) : complete;
+  return true;
+}
+
+uint64_t
+NetworkCodingTraceReader::GetRecordCount (void) const
+{
+  return m_records;
+}
+
+bool
+NetworkCodingTraceReader::Next (NetworkCodingTraceRecord &record)
+{
+  if (m_read >= m_records)
+    {
+      return false;
+    }
+  if (m_next == m_buffer.size ())
+    {
+      size_t count = std::min<uint64_t> (READ_AHEAD, m_records - m_read);
+      m_buffer.resize (count);
+      if (!m_in.read (reinterpret_cast<char *> (m_buffer.data ()), count * sizeof (NetworkCodingTraceRecord)))
+        {
+          m_records = m_read;
+          return false;
+        }
+      m_next = 0;
+    }
+  record = m_buffer[m_next++];
+  m_read++;
+  return true;
+}
+
+const char *
+NetworkCodingTraceReader::GetTypeName (uint8_t type)
+{
+  switch (type)
+    {
+    case NetworkCodingTraceRecord::TX:
+      return "TX";
+    case NetworkCodingTraceRecord::RX:
+      return "RX";
+    case NetworkCodingTraceRecord::DROP:
+      return "DROP";
+    case NetworkCodingTraceRecord::DECODING:
+      return "DECODING";
+    case NetworkCodingTraceRecord::GENERATION_LATENCY:
+      return "GENERATION_LATENCY";
+    case NetworkCodingTraceRecord::RANK:
+      return "RANK";
+    case NetworkCodingTraceRecord::ENCODE_TIME:
+      return "ENCODE_TIME";
+    case NetworkCodingTraceRecord::DECODE_TIME:
+      return "DECODE_TIME";
+    case NetworkCodingTraceRecord::SYMBOL_DECODED:
+      return "SYMBOL_DECODED";
+    default:
+      return "UNKNOWN";
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NETWORK_CODING_TRACE_H
+#define NETWORK_CODING_TRACE_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ns3 {
+
+class NetworkCodingUdpApplication;
+class NetworkCodingRelayApplication;
+
+/**
+ * \ingroup network-coding
+ * \brief One fixed-width event of a binary network coding trace
+ *
+ * Records are stored in host byte order, exactly as laid out here.
+ */
+struct NetworkCodingTraceRecord
+{
+  /**
+   * \brief What a record describes, and so what its value holds
+   */
+  enum Type : uint8_t
+  {
+    TX = 0,                 //!< Packet sent; value is its size in bytes
+    RX = 1,                 //!< Packet received; value is its size in bytes
+    DROP = 2,               //!< Packet dropped by a relay; value is its size in bytes
+    DECODING = 3,           //!< Decoding attempt; value is the generations decoded, flags 1 on success
+    GENERATION_LATENCY = 4, //!< Generation decoded; value is first packet to full rank, in ns
+    RANK = 5,               //!< Coded packet processed; value is the rank, flags 1 if innovative
+    ENCODE_TIME = 6,        //!< Wall clock spent coding a packet sent, in ns
+    DECODE_TIME = 7,        //!< Wall clock spent decoding a packet received, in ns
+    SYMBOL_DECODED = 8      //!< Source packet solved early; value is its index
+  };
+
+  /**
+   * \brief Generation of records that have none, e.g. TX and RX
+   */
+  static const uint32_t NO_GENERATION = 0xFFFFFFFF;
+
+  int64_t time;         //!< Simulation time, in nanoseconds
+  int64_t value;        //!< Meaning depends on type
+  uint32_t generation;  //!< Generation ID, or NO_GENERATION
+  uint16_t source;      //!< Identifier given when the trace source was connected
+  uint8_t type;         //!< A Type
+  uint8_t flags;        //!< Meaning depends on type
+};
+
+static_assert (sizeof (NetworkCodingTraceRecord) == 24, "Trace records must stay 24 bytes");
+
+/**
+ * \ingroup network-coding
+ * \brief Streams trace records to a compact binary file
+ *
+ * A replacement for printing every packet event as text: each event costs
+ * one 24-byte record copied into a buffer. Full buffers are written by a
+ * background thread, so the simulator only waits on the disk when
+ * BufferCount buffers are already queued. With MemoryMapped the file is
+ * mapped instead and records are stored straight into it, leaving the
+ * writing to the kernel.
+ *
+ * The file is a 16-byte header ("NCTR", version, record size, record
+ * count) followed by the records in the order they were written. The
+ * count is filled in by Close; a trace that was never closed is read up to
+ * its last complete record. NetworkCodingTraceReader reads the file back
+ * and the network-coding-trace-convert example turns it into CSV.
+ */
+class NetworkCodingTraceWriter : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  NetworkCodingTraceWriter ();
+  virtual ~NetworkCodingTraceWriter ();
+
+  /**
+   * \brief Create the trace file, replacing any existing one
+   * \param filename Path of the file
+   * \return false if it cannot be created
+   */
+  bool Open (const std::string &filename);
+
+  /**
+   * \brief Write everything buffered, fill in the header and close the file
+   */
+  void Close (void);
+
+  /**
+   * \brief Check whether a trace file is open
+   * \return true between a successful Open and Close
+   */
+  bool IsOpen (void) const;
+
+  /**
+   * \brief Append a record
+   * \param record The record
+   */
+  void Write (const NetworkCodingTraceRecord &record);
+
+  /**
+   * \brief Append a record stamped with the current simulation time
+   * \param type Record type
+   * \param source Source identifier
+   * \param generation Generation ID, or NO_GENERATION
+   * \param value Type-dependent value
+   * \param flags Type-dependent flags
+   */
+  void Write (uint8_t type, uint16_t source, uint32_t generation, int64_t value, uint8_t flags = 0);
+
+  /**
+   * \brief Record the trace sources of an endpoint application
+   * \param app The application
+   * \param source Identifier stored in the application's records
+   *
+   * Covers Tx, Rx, Decoding, GenerationLatency, Rank, EncodeTime,
+   * DecodeTime and SymbolDecoded.
+   */
+  void Connect (Ptr<NetworkCodingUdpApplication> app, uint16_t source);
+
+  /**
+   * \brief Record the trace sources of a relay
+   * \param app The relay
+   * \param source Identifier stored in the relay's records
+   *
+   * Covers Tx, Rx and Drop.
+   */
+  void Connect (Ptr<NetworkCodingRelayApplication> app, uint16_t source);
+
+  /**
+   * \brief Get the number of records written since Open
+   * \return the count
+   */
+  uint64_t GetRecordCount (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Trace sink context: the writer and the source identifier
+   */
+  struct Sink
+  {
+    NetworkCodingTraceWriter *writer; //!< Where records go
+    uint16_t source;                  //!< Identifier of the connected object
+  };
+
+  /**
+   * \brief Get a sink for a source identifier
+   * \param source The identifier
+   * \return a sink that lives as long as the writer
+   */
+  Sink *AddSink (uint16_t source);
+
+  static void TraceTx (Sink *sink, Ptr<const Packet> packet);
+  static void TraceRx (Sink *sink, Ptr<const Packet> packet);
+  static void TraceDrop (Sink *sink, Ptr<const Packet> packet);
+  static void TraceDecoding (Sink *sink, bool success, uint32_t decoded);
+  static void TraceLatency (Sink *sink, uint32_t generationId, Time latency);
+  static void TraceRank (Sink *sink, uint32_t generationId, uint16_t rank, bool innovative);
+  static void TraceEncodeTime (Sink *sink, uint32_t generationId, Time elapsed);
+  static void TraceDecodeTime (Sink *sink, uint32_t generationId, Time elapsed);
+  static void TraceSymbol (Sink *sink, uint32_t generationId, uint16_t index, Ptr<const Packet> symbol);
+
+  /**
+   * \brief Hand the current buffer to the background thread
+   */
+  void QueueBuffer (void);
+
+  /**
+   * \brief Background thread: write queued buffers until Close
+   */
+  void Run (void);
+
+  /**
+   * \brief Make room for more records in the mapped file
+   * \return false if the file cannot be extended
+   */
+  bool GrowMapping (void);
+
+  uint32_t m_bufferRecords;           //!< Records per buffer, or per mapping step
+  uint32_t m_bufferCount;             //!< Buffers queued before Write blocks
+  bool m_memoryMapped;                //!< Map the file instead of writing it
+
+  int m_fd;                           //!< The trace file, -1 when closed
+  bool m_mapping;                     //!< MemoryMapped when the file was opened
+  uint64_t m_records;                 //!< Records written since Open
+  std::deque<Sink> m_sinks;           //!< Stable addresses for bound callbacks
+
+  std::vector<NetworkCodingTraceRecord> m_current; //!< Buffer being filled
+  std::deque<std::vector<NetworkCodingTraceRecord>> m_full; //!< Waiting for the thread
+  std::vector<std::vector<NetworkCodingTraceRecord>> m_spare; //!< Written, for reuse
+  std::thread m_thread;               //!< Writes m_full
+  std::mutex m_mutex;                 //!< Protects m_full, m_spare, m_stopping, m_failed
+  std::condition_variable m_wakeup;   //!< Signals queued buffers or Close
+  std::condition_variable m_written;  //!< Signals a buffer was written
+  bool m_stopping;                    //!< Set by Close
+  bool m_failed;                      //!< A write failed; further records are dropped
+
+  uint8_t *m_mapBase;                 //!< Mapped file, header included, with MemoryMapped
+  NetworkCodingTraceRecord *m_map;    //!< Records in the mapping
+  uint64_t m_mapRecords;              //!< Records the mapping holds
+};
+
+/**
+ * \ingroup network-coding
+ * \brief Reads a trace written by NetworkCodingTraceWriter
+ */
+class NetworkCodingTraceReader
+{
+public:
+  NetworkCodingTraceReader ();
+
+  /**
+   * \brief Open a trace file
+   * \param filename Path of the file
+   * \return false if it cannot be read or is not a trace
+   */
+  bool Open (const std::string &filename);
+
+  /**
+   * \brief Get the number of complete records in the file
+   * \return the count
+   */
+  uint64_t GetRecordCount (void) const;
+
+  /**
+   * \brief Read the next record
+   * \param record Filled with the record
+   * \return false once every record was read
+   */
+  bool Next (NetworkCodingTraceRecord &record);
+
+  /**
+   * \brief Get the name of a record type
+   * \param type The type
+   * \return its name, e.g. "RANK"
+   */
+  static const char *GetTypeName (uint8_t type);
+
+private:
+  std::ifstream m_in;                         //!< The trace file
+  uint64_t m_records;                         //!< Complete records in the file
+  uint64_t m_read;                            //!< Records returned so far
+  std::vector<NetworkCodingTraceRecord> m_buffer; //!< Records read ahead
+  size_t m_next;                              //!< Next record of m_buffer
+};
+
+} // namespace ns3
+
+#endif /* NETWORK_CODING_TRACE_H */
@@ -19,6 +19,7 @@
 #include "network-coding-udp-application.h"
 #include "network-coding-packet.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/simulator.h"
 #include "ns3/socket.h"
 #include "ns3/socket-factory.h"
@@ -28,15 +29,33 @@
 #include "ns3/double.h"
 #include "ns3/string.h"
 #include "ns3/boolean.h"
+#include "ns3/nstime.h"
+#include "ns3/object-factory.h"
+#include "ns3/type-id.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/inet6-socket-address.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <random>
+#include <sstream>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("NetworkCodingUdpApplication");
 NS_OBJECT_ENSURE_REGISTERED (NetworkCodingUdpApplication);
 
+namespace {
+
+/// Control packets (ACKs and rank reports) start with this marker, which
+/// the hop sequence at the front of a coded packet never reaches
+const uint8_t CONTROL_MARKER[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+
+/// Weight of a new sample in the smoothed loss estimate
+const double LOSS_ESTIMATE_WEIGHT = 0.25;
+
+} // anonymous namespace
+
 TypeId
 NetworkCodingUdpApplication::GetTypeId (void)
 {
@@ -59,7 +78,7 @@ NetworkCodingUdpApplication::GetTypeId (void)
     .AddAttribute ("GenerationSize", "The size of each generation",
                    UintegerValue (8),
                    MakeUintegerAccessor (&NetworkCodingUdpApplication::m_generationSize),
-                   MakeUintegerChecker<uint16_t> (1, 255))
+                   MakeUintegerChecker<uint16_t> (1))
     .AddAttribute ("DataRate", "The data rate to use",
                    DataRateValue (DataRate ("1Mbps")),
                    MakeDataRateAccessor (&NetworkCodingUdpApplication::m_dataRate),
@@ -68,6 +87,121 @@ NetworkCodingUdpApplication::GetTypeId (void)
                    DoubleValue (0.0),
                    MakeDoubleAccessor (&NetworkCodingUdpApplication::m_lossRate),
                    MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("Systematic",
+                   "Send the source packets of a generation uncoded first and "
+                   "only code the repair packets",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NetworkCodingUdpApplication::m_systematic),
+                   MakeBooleanChecker ())
+    .AddAttribute ("FieldBits",
+                   "Bits per symbol of the coding field: 1 for GF(2), "
+                   "4 for GF(2^4) or 8 for GF(2^8)",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&NetworkCodingUdpApplication::m_fieldBits),
+                   MakeUintegerChecker<uint8_t> (1, 8))
+    .AddAttribute ("MaxGenerationsInFlight",
+                   "The number of generations the sender keeps open and the "
+                   "receiver decodes at once; 1 is stop-and-wait per generation",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&NetworkCodingUdpApplication::m_maxGenerationsInFlight),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ReceiveGenerations",
+                   "The number of generations a receiver decodes at once; 0 uses "
+                   "MaxGenerationsInFlight. A larger table keeps generations whose "
+                   "packets arrive out of order, e.g. over several paths",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&NetworkCodingUdpApplication::m_receiveGenerations),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxDecoderMemory",
+                   "Upper bound in bytes on the row storage of the generations a "
+                   "receiver decodes at once, on top of ReceiveGenerations; 0 for "
+                   "no bound. One generation is always kept",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&NetworkCodingUdpApplication::m_maxDecoderMemory),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("DecodedHistory",
+                   "The number of decoded generation IDs a receiver remembers to "
+                   "ACK packets that arrive after decoding",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&NetworkCodingUdpApplication::m_decodedHistory),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FeedbackDelay",
+                   "How long the receiver waits without packets of an undecoded "
+                   "generation before it reports its rank; zero disables rank "
+                   "reports, leaving only the sender timeout",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&NetworkCodingUdpApplication::m_feedbackDelay),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("RepairMargin",
+                   "Repair packets sent on top of the rank the receiver is missing",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&NetworkCodingUdpApplication::m_repairMargin),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AdaptiveRedundancy",
+                   "Add redundancy to the first round of every generation from "
+                   "the loss rate estimated from receiver feedback",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&NetworkCodingUdpApplication::m_adaptiveRedundancy),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxRedundancy",
+                   "Upper bound on the proactive redundancy, as a fraction of "
+                   "the generation size",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&NetworkCodingUdpApplication::m_maxRedundancy),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("DecoderThreads",
+                   "Worker threads that run the final back-substitution of "
+                   "full-rank generations; 0 decodes inline on the simulator thread",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&NetworkCodingUdpApplication::m_decoderThreads),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("GroupSize",
+                   "Receivers that must acknowledge every generation. With Remote "
+                   "set to a multicast group, one coded stream serves them all and "
+                   "repairs cover the largest rank deficit among them",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&NetworkCodingUdpApplication::m_groupSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("DecodeLatency",
+                   "Simulated time after reaching full rank at which a generation "
+                   "solved by the worker pool is delivered; results are always "
+                   "collected at that time, which keeps runs deterministic",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&NetworkCodingUdpApplication::m_decodeLatency),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("MeasureCodingTime",
+                   "Time every encoder and decoder call on the wall clock and "
+                   "report it through the EncodeTime and DecodeTime traces",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NetworkCodingUdpApplication::m_measureCodingTime),
+                   MakeBooleanChecker ())
+    .AddAttribute ("RateController",
+                   "Type of the NetworkCodingRateController pacing the sender. The "
+                   "base type keeps DataRate; ns3::NetworkCodingBbrRateController "
+                   "starts from DataRate and follows the bottleneck the ACKs show",
+                   TypeIdValue (NetworkCodingRateController::GetTypeId ()),
+                   MakeTypeIdAccessor (&NetworkCodingUdpApplication::m_rateControllerType),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("PartialDecoding",
+                   "Deliver source packets through SymbolDecoded as soon as they "
+                   "are solved, so a generation that never reaches full rank "
+                   "still yields what was already determined",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NetworkCodingUdpApplication::m_partialDecoding),
+                   MakeBooleanChecker ())
+    .AddAttribute ("RepeatCoefficients",
+                   "Give coded packet k of every generation the same coefficients, "
+                   "so receivers losing the same packets see the same matrix",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NetworkCodingUdpApplication::m_repeatCoefficients),
+                   MakeBooleanChecker ())
+    .AddAttribute ("InverseCacheSize",
+                   "Coefficient patterns whose inverses the receiver's decoders "
+                   "share, so a generation repeating one skips the elimination; "
+                   "0 disables the cache. Pays off with RepeatCoefficients",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&NetworkCodingUdpApplication::m_inverseCacheSize),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("Tx", "A new packet is sent",
                      MakeTraceSourceAccessor (&NetworkCodingUdpApplication::m_txTrace),
                      "ns3::Packet::TracedCallback")
@@ -77,6 +211,32 @@ NetworkCodingUdpApplication::GetTypeId (void)
     .AddTraceSource ("Decoding", "A generation decoding attempt",
                      MakeTraceSourceAccessor (&NetworkCodingUdpApplication::m_decodingTrace),
                      "ns3::TracedValueCallback::BoolUint32")
+    .AddTraceSource ("GenerationLatency",
+                     "Simulated time from the first packet of a generation to full rank",
+                     MakeTraceSourceAccessor (&NetworkCodingUdpApplication::m_generationLatencyTrace),
+                     "ns3::NetworkCodingUdpApplication::GenerationTimeTracedCallback")
+    .AddTraceSource ("Rank", "A coded packet was given to a decoder",
+                     MakeTraceSourceAccessor (&NetworkCodingUdpApplication::m_rankTrace),
+                     "ns3::NetworkCodingUdpApplication::RankTracedCallback")
+    .AddTraceSource ("EncodeTime",
+                     "Wall-clock time spent coding each packet sent, with MeasureCodingTime",
+                     MakeTraceSourceAccessor (&NetworkCodingUdpApplication::m_encodeTimeTrace),
+                     "ns3::NetworkCodingUdpApplication::GenerationTimeTracedCallback")
+    .AddTraceSource ("DecodeTime",
+                     "Wall-clock time spent decoding each packet received, with MeasureCodingTime",
+                     MakeTraceSourceAccessor (&NetworkCodingUdpApplication::m_decodeTimeTrace),
+                     "ns3::NetworkCodingUdpApplication::GenerationTimeTracedCallback")
+    .AddTraceSource ("InnovativePackets", "Coded packets that raised a decoder's rank",
+                     MakeTraceSourceAccessor (&NetworkCodingUdpApplication::m_innovativePacketsReceived),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("NonInnovativePackets",
+                     "Coded packets that did not, including those of decoded generations",
+                     MakeTraceSourceAccessor (&NetworkCodingUdpApplication::m_nonInnovativePacketsReceived),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("SymbolDecoded",
+                     "A source packet was solved by an arriving packet, with PartialDecoding",
+                     MakeTraceSourceAccessor (&NetworkCodingUdpApplication::m_symbolDecodedTrace),
+                     "ns3::NetworkCodingDecoder::SymbolTracedCallback")
   ;
   return tid;
 }
@@ -89,23 +249,37 @@ NetworkCodingUdpApplication::NetworkCodingUdpApplication ()
     m_generationSize (8),
     m_dataRate (DataRate ("1Mbps")),
     m_lossRate (0.0),
+    m_systematic (false),
+    m_fieldBits (8),
+    m_maxGenerationsInFlight (1),
+    m_feedbackDelay (MilliSeconds (100)),
+    m_repairMargin (1),
+    m_adaptiveRedundancy (true),
+    m_maxRedundancy (1.0),
+    m_decoderThreads (0),
+    m_groupSize (1),
+    m_decodeLatency (Seconds (0)),
+    m_measureCodingTime (false),
+    m_partialDecoding (false),
+    m_receiveGenerations (0),
+    m_maxDecoderMemory (0),
+    m_decodedHistory (1024),
+    m_rateControllerType (NetworkCodingRateController::GetTypeId ()),
+    m_repeatCoefficients (false),
+    m_inverseCacheSize (0),
     m_running (false),
     m_packetsSent (0),
     m_packetsReceived (0),
     m_innovativePacketsReceived (0),
+    m_nonInnovativePacketsReceived (0),
     m_generationsDecoded (0),
-    m_nextSeq (0),
-    m_encoder (nullptr),
-    m_decoder (nullptr),
-    m_currentGeneration (0),
-    m_generationPacketCount (0),
-    m_currentGenerationSent (0),
-    m_packetsInCurrentGeneration (0),
-    m_waitingForGenerationAck (false),
+    m_nextGenerationToOpen (0),
+    m_nextGenerationToServe (0),
+    m_lossEstimate (0.0),
+    m_sendIndex (0),
+    m_appLimitedIndex (0),
     m_generationTimeout (Seconds (2.0)),
-    m_maxRetransmissions (5),
-    m_retransmissionCount (0),
-    m_galoisField (CreateObject<GaloisField>())
+    m_maxRetransmissions (5)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -120,11 +294,23 @@ NetworkCodingUdpApplication::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_socket = nullptr;
-  m_encoder = nullptr;
-  m_decoder = nullptr;
-  m_galoisField = nullptr;
   Simulator::Cancel (m_sendEvent);
-  Simulator::Cancel (m_retransmissionTimer);
+  for (auto &entry : m_inFlight)
+    {
+      Simulator::Cancel (entry.second.timer);
+    }
+  m_inFlight.clear ();
+  for (auto &entry : m_receiving)
+    {
+      Simulator::Cancel (entry.second.feedbackTimer);
+    }
+  m_receiving.clear ();
+  m_receiveLru.clear ();
+  WaitForPendingDecodes ();
+  m_pendingDecodes.clear ();
+  m_workerPool.reset ();
+  m_inverseCache = nullptr;
+  m_rateController = nullptr;
   Application::DoDispose ();
 }
 
@@ -132,32 +318,43 @@ void
 NetworkCodingUdpApplication::StartApplication (void)
 {
   NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_UNLESS (gf::IsValidField (m_fieldBits), "FieldBits must be 1, 4 or 8");
   
   m_running = true;
   m_packetsSent = 0;
   m_packetsReceived = 0;
   m_innovativePacketsReceived = 0;
+  m_nonInnovativePacketsReceived = 0;
   m_generationsDecoded = 0;
-  m_nextSeq = 0;
-  m_currentGeneration = 0;
-  m_generationPacketCount = 0;
-  m_currentGenerationSent = 0;
-  m_packetsInCurrentGeneration = 0;
-  m_waitingForGenerationAck = false;
-  m_retransmissionCount = 0;
-  
-  // Initialize REAL encoder and decoder
-  NS_LOG_INFO ("Initializing REAL encoder/decoder with generation size " << m_generationSize 
-               << " and packet size " << m_packetSize);
-  
-  m_encoder = CreateObject<NetworkCodingEncoder> (m_generationSize, m_packetSize);
-  m_decoder = CreateObject<NetworkCodingDecoder> (m_generationSize, m_packetSize);
-  
-  if (!m_encoder || !m_decoder) {
-    NS_FATAL_ERROR ("Failed to create REAL encoder or decoder");
+  m_inFlight.clear ();
+  m_nextGenerationToOpen = 0;
+  m_nextGenerationToServe = 0;
+  m_lossEstimate = 0.0;
+  m_receiverLoss.clear ();
+  m_deliveryReferences.clear ();
+  m_sendIndex = 0;
+  m_appLimitedIndex = 0;
+  m_lastFeedback = Simulator::Now ();
+  m_receiving.clear ();
+  m_receiveLru.clear ();
+  m_decodedGenerations.clear ();
+  m_decodedOrder.clear ();
+  WaitForPendingDecodes ();
+  m_pendingDecodes.clear ();
+  if (m_decoderThreads > 0 && !m_workerPool) {
+    m_workerPool = std::make_unique<DecodingWorkerPool> (m_decoderThreads);
   }
-  
-  NS_LOG_INFO ("REAL Network Coding encoder and decoder initialized successfully");
+  if (m_inverseCacheSize == 0) {
+    m_inverseCache = nullptr;
+  } else if (!m_inverseCache || m_inverseCache->GetCapacity () != m_inverseCacheSize) {
+    m_inverseCache = Create<DecodingInverseCache> (m_inverseCacheSize);
+  }
+  if (!m_rateController) {
+    ObjectFactory factory;
+    factory.SetTypeId (m_rateControllerType);
+    m_rateController = factory.Create<NetworkCodingRateController> ();
+  }
+  m_rateController->Start (m_dataRate, m_packetSize);
 
   if (!m_socket) {
     m_socket = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
@@ -174,12 +371,12 @@ NetworkCodingUdpApplication::StartApplication (void)
         m_socket->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), local.GetPort ()));
       }
     } else {
-      NS_LOG_INFO ("Setting up as REAL NETWORK CODING SENDER");
+      NS_LOG_INFO ("Setting up as REAL NETWORK CODING SENDER with up to "
+                   << m_maxGenerationsInFlight << " generations in flight");
       m_socket->Bind ();
       
       if (m_numPackets > 0) {
-        // FIXED: Generate packets per generation instead of all at once
-        GenerateOriginalPackets();
+        OpenGenerations ();
         ScheduleNext ();
       }
     }
@@ -188,46 +385,70 @@ NetworkCodingUdpApplication::StartApplication (void)
   m_socket->SetRecvCallback (MakeCallback (&NetworkCodingUdpApplication::HandleRead, this));
 }
 
-// FIXED: Generate original packets per generation
+uint32_t
+NetworkCodingUdpApplication::GetTotalGenerations (void) const
+{
+  return (m_numPackets + m_generationSize - 1) / m_generationSize;
+}
+
+uint32_t
+NetworkCodingUdpApplication::GetPacketsInGeneration (uint32_t generationId) const
+{
+  // Only the last generation can be partial
+  uint32_t startPacket = generationId * m_generationSize;
+  return std::min<uint32_t> (m_generationSize, m_numPackets - startPacket);
+}
+
 void
-NetworkCodingUdpApplication::GenerateOriginalPackets (void)
+NetworkCodingUdpApplication::OpenGenerations (void)
 {
   NS_LOG_FUNCTION (this);
   
-  if (!m_encoder) {
-    NS_LOG_ERROR ("No encoder available for generating original packets");
-    return;
-  }
-  
-  NS_LOG_INFO ("Setting up encoder for generation-based packet creation...");
-  
-  // DON'T add all packets at once - add them per generation
-  // Just add the first generation initially
-  AddPacketsToCurrentGeneration(0);  // Start with generation 0
-  
-  NS_LOG_INFO ("Encoder prepared for generation-based coding");
+  // Keep the window full; every generation gets its own encoder
+  uint32_t totalGenerations = GetTotalGenerations ();
+  while (m_inFlight.size () < m_maxGenerationsInFlight && m_nextGenerationToOpen < totalGenerations)
+    {
+      uint32_t generationId = m_nextGenerationToOpen++;
+      SendGeneration &state = m_inFlight[generationId];
+      state.encoder = AcquireEncoder ();
+      state.packetsSent = 0;
+      state.retransmissions = 0;
+      state.receivers.clear ();
+      state.sent.clear ();
+      AddPacketsToGeneration (generationId, state.encoder);
+      
+      // Send enough in the first round to survive the expected losses, so
+      // most generations decode without waiting for feedback
+      uint32_t packets = GetPacketsInGeneration (generationId);
+      uint32_t redundancy = 0;
+      if (m_adaptiveRedundancy && m_lossEstimate > 0.0)
+        {
+          double expected = packets * m_lossEstimate / (1.0 - std::min (m_lossEstimate, 0.99));
+          redundancy = static_cast<uint32_t> (std::ceil (std::min (expected, packets * m_maxRedundancy)));
+        }
+      state.roundEnd = packets + redundancy;
+      
+      NS_LOG_INFO ("Opened generation " << generationId << " with " << redundancy
+                   << " redundant packets, " << m_inFlight.size () << " in flight");
+    }
 }
 
 // FIXED: Add packets for specific generation to encoder
 void
-NetworkCodingUdpApplication::AddPacketsToCurrentGeneration (uint32_t generationId)
+NetworkCodingUdpApplication::AddPacketsToGeneration (uint32_t generationId,
+                                                     Ptr<NetworkCodingEncoder> encoder)
 {
   NS_LOG_FUNCTION (this << generationId);
   
-  if (!m_encoder) {
-    NS_LOG_ERROR ("No encoder available");
-    return;
-  }
-  
   uint32_t startPacket = generationId * m_generationSize;
-  uint32_t endPacket = std::min(startPacket + m_generationSize, m_numPackets);
+  uint32_t endPacket = startPacket + GetPacketsInGeneration (generationId);
   
   NS_LOG_INFO ("Adding packets " << startPacket << "-" << (endPacket-1) 
                << " to encoder for generation " << generationId);
   
+  std::vector<uint8_t> data(m_packetSize);
   for (uint32_t i = startPacket; i < endPacket; i++) {
     // Create REAL packet data with identifiable pattern
-    std::vector<uint8_t> data(m_packetSize);
     for (uint32_t j = 0; j < m_packetSize; j++) {
       data[j] = (uint8_t)((i * 123 + j * 7) % 256);  // Same pattern as before
     }
@@ -236,12 +457,7 @@ NetworkCodingUdpApplication::AddPacketsToCurrentGeneration (uint32_t generationI
     
     // Add to encoder with LOCAL sequence number (0, 1, 2, ...)
     uint32_t localSeq = i - startPacket;
-    bool added = m_encoder->AddPacket(originalPacket, localSeq);
-    
-    if (added) {
-      NS_LOG_INFO ("Added packet " << i << " (local_seq=" << localSeq 
-                   << ") to encoder for generation " << generationId);
-    } else {
+    if (!encoder->AddPacket(originalPacket, localSeq)) {
       NS_LOG_ERROR ("Failed to add packet " << i << " to encoder");
     }
   }
@@ -255,7 +471,15 @@ NetworkCodingUdpApplication::StopApplication (void)
   m_running = false;
   
   Simulator::Cancel (m_sendEvent);
-  Simulator::Cancel (m_retransmissionTimer);
+  for (auto &entry : m_inFlight)
+    {
+      Simulator::Cancel (entry.second.timer);
+    }
+  for (auto &entry : m_receiving)
+    {
+      Simulator::Cancel (entry.second.feedbackTimer);
+    }
+  WaitForPendingDecodes ();
   
   if (m_socket) {
     m_socket->Close ();
@@ -289,45 +513,17 @@ NetworkCodingUdpApplication::HandleRead (Ptr<Socket> socket)
     
     // Check if this is an ACK packet
     if (IsAckPacket (packet)) {
-      HandleAck (packet);
+      HandleAck (packet, from);
       continue;
     }
     
     // Process as REAL coded packet
-    bool isInnovative = ProcessRealCodedPacket (packet);
-    
-    if (isInnovative) {
+    if (ProcessRealCodedPacket (packet, from)) {
       m_innovativePacketsReceived++;
-      m_generationPacketCount++;
       NS_LOG_INFO ("Received INNOVATIVE coded packet. Total innovative: " 
-                   << m_innovativePacketsReceived 
-                   << ", Generation packets: " << m_generationPacketCount);
-      
-      // Check if we can decode the current generation
-      if (m_decoder && m_decoder->CanDecode()) {
-        m_generationsDecoded++;
-        m_decodingTrace (true, m_generationsDecoded);
-        
-        // REAL DECODING HAPPENED!
-        auto decodedPackets = m_decoder->GetDecodedPackets();
-        
-        NS_LOG_INFO ("*** GENERATION " << m_currentGeneration 
-                     << " SUCCESSFULLY DECODED! ***");
-        NS_LOG_INFO ("Recovered " << decodedPackets.size() << " original packets");
-        
-        // Verify decoded packets
-        VerifyDecodedPackets(decodedPackets, m_currentGeneration);
-        
-        // Send ACK to sender
-        SendAck (m_currentGeneration, from);
-        
-        // FIXED: Don't advance generation here - let ProcessRealCodedPacket handle it
-        // Reset packet count for current generation
-        m_generationPacketCount = 0;
-        
-        // FIXED: Don't create new decoder here - let ProcessRealCodedPacket manage it
-      }
+                   << m_innovativePacketsReceived);
     } else {
+      m_nonInnovativePacketsReceived++;
       NS_LOG_INFO ("Received NON-INNOVATIVE coded packet (redundant)");
     }
   }
@@ -335,78 +531,275 @@ NetworkCodingUdpApplication::HandleRead (Ptr<Socket> socket)
 
 // FIXED: Process REAL coded packets using decoder
 bool
-NetworkCodingUdpApplication::ProcessRealCodedPacket (Ptr<Packet> packet)
+NetworkCodingUdpApplication::ProcessRealCodedPacket (Ptr<Packet> packet, const Address &from)
 {
-  NS_LOG_FUNCTION (this << packet);
+  NS_LOG_FUNCTION (this << packet << from);
   
-  if (!m_decoder) {
-    NS_LOG_ERROR ("No decoder available");
-    return false;
-  }
-  
-  // Make a copy to extract header
-  Ptr<Packet> packetCopy = packet->Copy();
-  
-  // Extract network coding header
+  // Parse the header once and hand it to the decoder with the payload
   NetworkCodingHeader header;
   try {
-    packetCopy->RemoveHeader(header);
+    packet->RemoveHeader(header);
   } catch (...) {
     NS_LOG_ERROR ("Failed to extract network coding header from received packet");
     return false;
   }
   
   uint32_t generationId = header.GetGenerationId();
-  const std::vector<uint8_t>& coefficients = header.GetCoefficients();
-  
-  NS_LOG_INFO ("Processing REAL coded packet for generation " << generationId 
-               << " with coefficients [");
-  for (size_t i = 0; i < coefficients.size(); i++) {
-    std::cout << (int)coefficients[i];
-    if (i < coefficients.size() - 1) std::cout << ",";
-  }
-  std::cout << "]" << std::endl;
-  
-  // CRITICAL FIX: Handle generation transitions properly
-  if (generationId != m_currentGeneration) {
-    if (generationId > m_currentGeneration) {
-      // Advance to the new generation
-      NS_LOG_INFO ("Advancing receiver from generation " << m_currentGeneration 
-                   << " to generation " << generationId);
-      
-      // Move to the correct generation
-      while (m_currentGeneration < generationId) {
-        m_currentGeneration++;
-        m_generationPacketCount = 0;
-        
-        // Create fresh decoder for the new generation
-        m_decoder = CreateObject<NetworkCodingDecoder> (m_generationSize, m_packetSize);
-        
-        // Advance decoder's internal generation counter
-        for (uint32_t i = 0; i < m_currentGeneration; i++) {
-          m_decoder->NextGeneration();
-        }
-      }
-      
-      NS_LOG_INFO ("Receiver now at generation " << m_currentGeneration);
+  
+  NS_LOG_INFO ("Processing REAL coded packet for generation " << generationId);
+  
+  // A packet for a generation we already decoded means our ACK was lost
+  // or is still on its way
+  if (m_decodedGenerations.count (generationId)) {
+    NS_LOG_INFO ("Generation " << generationId << " already decoded, ACKing again");
+    SendAck (generationId, from);
+    return false;
+  }
+  if (m_pendingDecodes.count (generationId)) {
+    NS_LOG_INFO ("Generation " << generationId << " is being solved, ignoring packet");
+    return false;
+  }
+  
+  ReceiveGeneration *state = GetReceiveGeneration (generationId);
+  if (!state) {
+    return false;
+  }
+  state->packetsReceived++;
+  state->highestSequence = std::max (state->highestSequence, header.GetHopSequence ());
+  state->sender = from;
+  
+  // Use REAL decoder to process coded packet
+  Ptr<NetworkCodingDecoder> decoder = state->decoder;
+  bool innovative;
+  if (m_measureCodingTime) {
+    auto start = std::chrono::steady_clock::now ();
+    innovative = decoder->ProcessCodedPacket (packet, header);
+    auto elapsed = std::chrono::steady_clock::now () - start;
+    m_decodeTimeTrace (generationId, NanoSeconds (std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count ()));
+  } else {
+    innovative = decoder->ProcessCodedPacket (packet, header);
+  }
+  m_rankTrace (generationId, decoder->GetRank (), innovative);
+  
+  NS_LOG_INFO ("Decoder for generation " << generationId << " processed packet: innovative = "
+               << innovative << ", rank = " << decoder->GetRank ());
+  
+  if (innovative && decoder->CanDecode ()) {
+    Simulator::Cancel (state->feedbackTimer);
+    m_generationLatencyTrace (generationId, Simulator::Now () - state->firstPacket);
+    if (m_workerPool) {
+      // Hand the back-substitution to a worker and collect it at a fixed
+      // simulated time. The worker only gets a raw pointer: Ptr reference
+      // counts are not atomic, and the Ptr kept here holds the decoder.
+      PendingDecode &pending = m_pendingDecodes[generationId];
+      pending.generation = *state;
+      NetworkCodingDecoder *solver = PeekPointer (decoder);
+      pending.solved = m_workerPool->Submit ([solver] () { solver->Solve (); });
+      Simulator::Schedule (m_decodeLatency, &NetworkCodingUdpApplication::FinishPendingDecode,
+                           this, generationId);
     } else {
-      // Old generation packet - ignore
-      NS_LOG_INFO ("Received packet from old generation " << generationId 
-                   << " (current " << m_currentGeneration << "), ignoring");
-      return false;
+      CompleteGeneration (generationId, *state);
     }
+    EraseReceiveGeneration (generationId);
+  } else if (!m_feedbackDelay.IsZero ()) {
+    // Report the rank once this generation has been quiet for a while,
+    // i.e. when the sender has finished its round and is waiting
+    Simulator::Cancel (state->feedbackTimer);
+    state->feedbackTimer = Simulator::Schedule (m_feedbackDelay,
+                                                &NetworkCodingUdpApplication::SendRankReport,
+                                                this, generationId);
   }
   
-  // Use REAL decoder to process coded packet
-  bool innovative = m_decoder->ProcessCodedPacket(packet);
+  return innovative;
+}
+
+NetworkCodingUdpApplication::ReceiveGeneration *
+NetworkCodingUdpApplication::GetReceiveGeneration (uint32_t generationId)
+{
+  auto it = m_receiving.find (generationId);
+  if (it != m_receiving.end ()) {
+    // Most recently heard from goes first
+    m_receiveLru.splice (m_receiveLru.begin (), m_receiveLru, it->second.lru);
+    return &it->second;
+  }
   
-  NS_LOG_INFO ("Decoder processed packet: innovative = " << innovative 
-               << ", can decode = " << m_decoder->CanDecode());
+  // Make room by count and by memory. Generations being solved by the pool
+  // still hold their rows, so they count against the memory bound.
+  uint64_t decoderBytes = static_cast<uint64_t> (m_generationSize + 1)
+    * (GenerationBuffer::Align (m_generationSize) + GenerationBuffer::Align (m_packetSize));
+  if (m_inverseCache) {
+    // Rows kept as received for the cache, and their coefficients
+    decoderBytes += static_cast<uint64_t> (m_generationSize)
+      * (GenerationBuffer::Align (m_packetSize) + m_generationSize);
+  }
+  while (!m_receiving.empty ()
+         && (m_receiving.size () >= GetReceiveWindow ()
+             || (m_maxDecoderMemory > 0
+                 && (m_receiving.size () + m_pendingDecodes.size () + 1) * decoderBytes > m_maxDecoderMemory))) {
+    EvictReceiveGeneration ();
+  }
   
-  return innovative;
+  ReceiveGeneration &state = m_receiving[generationId];
+  state.decoder = AcquireDecoder (generationId);
+  state.packetsReceived = 0;
+  state.highestSequence = 0;
+  state.firstPacket = Simulator::Now ();
+  state.lru = m_receiveLru.insert (m_receiveLru.begin (), generationId);
+  return &state;
+}
+
+void
+NetworkCodingUdpApplication::EraseReceiveGeneration (uint32_t generationId)
+{
+  auto it = m_receiving.find (generationId);
+  if (it != m_receiving.end ()) {
+    m_receiveLru.erase (it->second.lru);
+    m_receiving.erase (it);
+  }
+}
+
+void
+NetworkCodingUdpApplication::EvictReceiveGeneration (void)
+{
+  // The generation quiet for the longest is the one the sender is least
+  // likely to still be sending; stragglers of a newer one are kept
+  uint32_t generationId = m_receiveLru.back ();
+  ReceiveGeneration &state = m_receiving[generationId];
+  NS_LOG_INFO ("Abandoning generation " << generationId << " at rank "
+               << state.decoder->GetRank () << " with "
+               << state.decoder->GetDecodedSymbolCount () << " symbols solved");
+  Simulator::Cancel (state.feedbackTimer);
+  ReleaseDecoder (state.decoder);
+  EraseReceiveGeneration (generationId);
+  m_decodingTrace (false, m_generationsDecoded);
+}
+
+uint32_t
+NetworkCodingUdpApplication::GetReceiveWindow (void) const
+{
+  return m_receiveGenerations > 0 ? m_receiveGenerations : m_maxGenerationsInFlight;
+}
+
+void
+NetworkCodingUdpApplication::RememberDecoded (uint32_t generationId)
+{
+  if (m_decodedGenerations.insert (generationId).second) {
+    m_decodedOrder.push_back (generationId);
+  }
+  while (m_decodedOrder.size () > m_decodedHistory) {
+    m_decodedGenerations.erase (m_decodedOrder.front ());
+    m_decodedOrder.pop_front ();
+  }
+}
+
+void
+NetworkCodingUdpApplication::CompleteGeneration (uint32_t generationId,
+                                                 const ReceiveGeneration &state)
+{
+  NS_LOG_FUNCTION (this << generationId);
+  
+  m_generationsDecoded++;
+  m_decodingTrace (true, m_generationsDecoded);
+  
+  NS_LOG_INFO ("*** GENERATION " << generationId << " SUCCESSFULLY DECODED! ***");
+  
+  VerifyDecodedPackets (state.decoder->GetDecodedPackets (), generationId);
+  
+  NetworkCodingControlHeader ack (NetworkCodingControlHeader::ACKNOWLEDGE, generationId);
+  ack.SetRank (state.decoder->GetRank ());
+  ack.SetPacketsReceived (state.packetsReceived);
+  ack.SetHopAckSequence (state.highestSequence);
+  SendFeedback (ack, state.sender);
+  
+  RememberDecoded (generationId);
+  ReleaseDecoder (state.decoder);
+}
+
+Ptr<NetworkCodingDecoder>
+NetworkCodingUdpApplication::AcquireDecoder (uint32_t generationId)
+{
+  Ptr<NetworkCodingDecoder> decoder;
+  if (m_spareDecoders.empty ()) {
+    decoder = CreateObject<NetworkCodingDecoder> (m_generationSize, m_packetSize);
+    decoder->TraceConnectWithoutContext ("SymbolDecoded",
+                                         MakeCallback (&NetworkCodingUdpApplication::HandleSymbolDecoded, this));
+  } else {
+    decoder = m_spareDecoders.back ();
+    m_spareDecoders.pop_back ();
+  }
+  decoder->SetField (static_cast<gf::FieldType> (m_fieldBits));
+  decoder->SetDeferredSubstitution (m_workerPool != nullptr);
+  decoder->SetPartialDecoding (m_partialDecoding);
+  decoder->SetInverseCache (m_inverseCache);
+  // Forgets the previous generation without touching its rows
+  decoder->SetCurrentGenerationId (generationId);
+  return decoder;
+}
+
+void
+NetworkCodingUdpApplication::ReleaseDecoder (Ptr<NetworkCodingDecoder> decoder)
+{
+  if (m_spareDecoders.size () < GetReceiveWindow ()) {
+    m_spareDecoders.push_back (decoder);
+  }
+}
+
+void
+NetworkCodingUdpApplication::HandleSymbolDecoded (uint32_t generationId, uint16_t index,
+                                                  Ptr<const Packet> symbol)
+{
+  NS_LOG_FUNCTION (this << generationId << index);
+  m_symbolDecodedTrace (generationId, index, symbol);
+}
+
+void
+NetworkCodingUdpApplication::FinishPendingDecode (uint32_t generationId)
+{
+  NS_LOG_FUNCTION (this << generationId);
+  
+  auto it = m_pendingDecodes.find (generationId);
+  if (it == m_pendingDecodes.end ()) {
+    return;
+  }
+  
+  // Blocks only if the worker is behind the simulation clock
+  it->second.solved.wait ();
+  ReceiveGeneration state = it->second.generation;
+  m_pendingDecodes.erase (it);
+  CompleteGeneration (generationId, state);
+}
+
+void
+NetworkCodingUdpApplication::WaitForPendingDecodes (void)
+{
+  // Decoders must not be touched or freed while a worker still solves them
+  for (auto &entry : m_pendingDecodes)
+    {
+      entry.second.solved.wait ();
+    }
+}
+
+void
+NetworkCodingUdpApplication::SendRankReport (uint32_t generationId)
+{
+  NS_LOG_FUNCTION (this << generationId);
+  
+  auto it = m_receiving.find (generationId);
+  if (it == m_receiving.end ()) {
+    return;
+  }
+  
+  const ReceiveGeneration &state = it->second;
+  NetworkCodingControlHeader report (NetworkCodingControlHeader::INNOVATIVE_ACK, generationId);
+  report.SetRank (state.decoder->GetRank ());
+  report.SetPacketsReceived (state.packetsReceived);
+  report.SetHopAckSequence (state.highestSequence);
+  
+  NS_LOG_INFO ("Reporting rank " << state.decoder->GetRank () << " for generation "
+               << generationId);
+  SendFeedback (report, state.sender);
 }
 
-// FIXED: Verify that decoded packets match original patterns
 void
 NetworkCodingUdpApplication::VerifyDecodedPackets (const std::vector<Ptr<Packet>>& decodedPackets,
                                                   uint32_t generationId)
@@ -433,55 +826,50 @@ NetworkCodingUdpApplication::VerifyDecodedPackets (const std::vector<Ptr<Packet>
                  << "): " << (matches ? "CORRECT" : "INCORRECT"));
     
     if (!matches) {
-      NS_LOG_ERROR ("VERIFICATION FAILED for packet " << originalSeq);
-      // Print first few bytes for debugging
-      std::cout << "Expected: [";
-      for (size_t k = 0; k < std::min(size_t(8), expectedData.size()); k++) {
-        std::cout << (int)expectedData[k];
-        if (k < 7 && k < expectedData.size() - 1) std::cout << ",";
+      // Log the first few bytes for debugging
+      std::ostringstream expected;
+      std::ostringstream decoded;
+      for (size_t k = 0; k < std::min (size_t (8), expectedData.size ()); k++) {
+        expected << (k ? "," : "") << (int)expectedData[k];
+        decoded << (k ? "," : "") << (int)decodedData[k];
       }
-      std::cout << "]" << std::endl;
-      
-      std::cout << "Decoded:  [";
-      for (size_t k = 0; k < std::min(size_t(8), decodedData.size()); k++) {
-        std::cout << (int)decodedData[k];
-        if (k < 7 && k < decodedData.size() - 1) std::cout << ",";
-      }
-      std::cout << "]" << std::endl;
+      NS_LOG_ERROR ("VERIFICATION FAILED for packet " << originalSeq
+                    << ": expected [" << expected.str () << "], decoded ["
+                    << decoded.str () << "]");
     }
   }
 }
 
+bool
+NetworkCodingUdpApplication::HasPacketsToSend (void) const
+{
+  for (const auto &entry : m_inFlight)
+    {
+      if (entry.second.packetsSent < entry.second.roundEnd)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
 void
 NetworkCodingUdpApplication::ScheduleNext (void)
 {
   NS_LOG_FUNCTION (this);
   
-  uint32_t totalGenerationsNeeded = (m_numPackets + m_generationSize - 1) / m_generationSize;
-  
-  bool hasMoreGenerations = (m_currentGenerationSent < totalGenerationsNeeded);
-  bool hasMorePacketsInCurrentGeneration = false;
-  
-  if (hasMoreGenerations) {
-    uint32_t packetsNeededInCurrentGeneration = m_generationSize;
-    if (m_currentGenerationSent == totalGenerationsNeeded - 1) {
-      uint32_t remainingPackets = m_numPackets - (m_currentGenerationSent * m_generationSize);
-      packetsNeededInCurrentGeneration = remainingPackets;
-    }
-    hasMorePacketsInCurrentGeneration = (m_packetsInCurrentGeneration < packetsNeededInCurrentGeneration);
+  // Generations that have sent their first round wait for an ACK or a
+  // timeout; the link stays busy as long as another one still has packets
+  if (!m_running || m_sendEvent.IsPending ()) {
+    return;
   }
-  
-  NS_LOG_INFO ("ScheduleNext: Generation " << m_currentGenerationSent 
-               << "/" << totalGenerationsNeeded 
-               << ", packets in current gen: " << m_packetsInCurrentGeneration
-               << ", waiting for ACK: " << m_waitingForGenerationAck);
-  
-  if (m_running && hasMoreGenerations && hasMorePacketsInCurrentGeneration && !m_waitingForGenerationAck) {
-    Time tNext = Seconds (m_packetSize * 8 / static_cast<double> (m_dataRate.GetBitRate ()));
+  if (HasPacketsToSend ()) {
+    Time tNext = m_rateController->GetSendInterval ();
     m_sendEvent = Simulator::Schedule (tNext, &NetworkCodingUdpApplication::SendPacket, this);
     NS_LOG_DEBUG ("Scheduled next REAL coded packet in " << tNext.GetSeconds () << " seconds");
-  } else if (!hasMoreGenerations) {
-    NS_LOG_INFO ("All " << totalGenerationsNeeded << " generations completed");
+  } else {
+    // Delivery rates measured across this gap say nothing about the path
+    m_appLimitedIndex = m_sendIndex;
   }
 }
 
@@ -490,30 +878,44 @@ NetworkCodingUdpApplication::SendPacket (void)
 {
   NS_LOG_FUNCTION (this);
   
-  uint32_t totalGenerationsNeeded = (m_numPackets + m_generationSize - 1) / m_generationSize;
-  
-  if (!m_running || !m_socket || m_currentGenerationSent >= totalGenerationsNeeded) {
+  if (!m_running || !m_socket) {
     return;
   }
   
-  if (m_waitingForGenerationAck && IsCurrentGenerationComplete ()) {
-    NS_LOG_INFO ("Waiting for ACK for generation " << m_currentGenerationSent);
+  // Interleave the generations in flight, round robin over those that
+  // still have packets left in their current round
+  auto it = m_inFlight.lower_bound (m_nextGenerationToServe);
+  bool found = false;
+  for (size_t n = 0; n < m_inFlight.size () && !found; n++) {
+    if (it == m_inFlight.end ()) {
+      it = m_inFlight.begin ();
+    }
+    if (it->second.packetsSent < it->second.roundEnd) {
+      found = true;
+    } else {
+      ++it;
+    }
+  }
+  if (!found) {
     return;
   }
   
-  SendRealCodedPacket (m_currentGenerationSent);
+  uint32_t generationId = it->first;
+  SendGeneration &state = it->second;
+  m_nextGenerationToServe = generationId + 1;
   
-  if (IsCurrentGenerationComplete ()) {
-    m_waitingForGenerationAck = true;
-    
-    m_retransmissionTimer = Simulator::Schedule (m_generationTimeout, 
-                                                 &NetworkCodingUdpApplication::HandleGenerationTimeout, 
-                                                 this);
-    
-    NS_LOG_INFO ("Completed generation " << m_currentGenerationSent << ", waiting for ACK");
-  } else {
-    ScheduleNext ();
+  SendRealCodedPacket (generationId);
+  state.packetsSent++;
+  state.sent.push_back ({Simulator::Now (), m_sendIndex++});
+  
+  if (state.packetsSent == state.roundEnd) {
+    state.timer = Simulator::Schedule (m_generationTimeout, 
+                                       &NetworkCodingUdpApplication::HandleGenerationTimeout, 
+                                       this, generationId);
+    NS_LOG_INFO ("Completed round of generation " << generationId << ", waiting for feedback");
   }
+  
+  ScheduleNext ();
 }
 
 // FIXED: Send REAL coded packets using encoder with correct generation
@@ -522,57 +924,72 @@ NetworkCodingUdpApplication::SendRealCodedPacket (uint32_t generationId)
 {
   NS_LOG_FUNCTION (this << generationId);
   
-  if (!m_encoder) {
-    NS_LOG_ERROR ("No encoder available for sending coded packets");
+  auto it = m_inFlight.find (generationId);
+  if (it == m_inFlight.end ()) {
+    NS_LOG_INFO ("Generation " << generationId << " is not in flight, not sending");
     return;
   }
   
-  uint32_t totalGenerationsNeeded = (m_numPackets + m_generationSize - 1) / m_generationSize;
-  if (generationId >= totalGenerationsNeeded) {
-    NS_LOG_INFO ("All generations completed, not sending more packets");
-    return;
+  // Generate REAL coded packets using encoder; in systematic mode the
+  // first packets of the generation are the uncoded source packets and the
+  // timeout retransmissions are coded repairs. The rest of the round is
+  // coded in one batch and paced out from the queue; the headers are
+  // stamped with our generation ID directly.
+  SendGeneration &state = it->second;
+  if (state.queued.empty ()) {
+    uint32_t count = std::max<uint32_t> (1, state.roundEnd - std::min (state.roundEnd, state.packetsSent));
+    std::vector<Ptr<Packet>> packets;
+    if (m_measureCodingTime) {
+      auto start = std::chrono::steady_clock::now ();
+      packets = state.encoder->GeneratePackets (count, generationId);
+      auto elapsed = std::chrono::steady_clock::now () - start;
+      Time perPacket = NanoSeconds (std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count ()
+                                    / static_cast<int64_t> (count));
+      for (uint32_t i = 0; i < count; i++) {
+        m_encodeTimeTrace (generationId, perPacket);
+      }
+    } else {
+      packets = state.encoder->GeneratePackets (count, generationId);
+    }
+    state.queued.insert (state.queued.end (), packets.begin (), packets.end ());
   }
-  
-  uint32_t packetsInThisGeneration = m_generationSize;
-  if (generationId == totalGenerationsNeeded - 1) {
-    uint32_t remainingPackets = m_numPackets - (generationId * m_generationSize);
-    packetsInThisGeneration = remainingPackets;
+  Ptr<Packet> codedPacket;
+  if (!state.queued.empty ()) {
+    codedPacket = state.queued.front ();
+    state.queued.pop_front ();
   }
   
-  // FIXED: Allow retransmissions even if initial packets were sent
-  // Remove this blocking condition:
-  // if (m_packetsInCurrentGeneration >= packetsInThisGeneration) {
-  //   NS_LOG_INFO ("Generation " << generationId << " already complete");
-  //   return;
-  // }
-  
-  // Generate REAL coded packet using encoder
-  Ptr<Packet> codedPacket = m_encoder->GenerateCodedPacket();
-  
   if (!codedPacket) {
     NS_LOG_ERROR ("Failed to generate coded packet from encoder");
     return;
   }
   
-  // Update generation ID in packet header
-  Ptr<Packet> packetCopy = codedPacket->Copy();
-  NetworkCodingHeader header;
-  packetCopy->RemoveHeader(header);
-  header.SetGenerationId(generationId);
-  packetCopy->AddHeader(header);
-  
-  NS_LOG_INFO ("Sending REAL coded packet for generation " << generationId
-               << " (retransmission allowed)");
+  NS_LOG_INFO ("Sending REAL coded packet for generation " << generationId);
   
   // Send the packet
-  int actual = m_socket->SendTo (packetCopy, 0, m_peer);
+  int actual = m_socket->SendTo (codedPacket, 0, m_peer);
   if (actual > 0) {
     m_packetsSent++;
-    // FIXED: Only count initial packets, not retransmissions
-    if (!m_waitingForGenerationAck) {
-      m_packetsInCurrentGeneration++;
-    }
-    m_txTrace (packetCopy);
+    m_txTrace (codedPacket);
+  }
+}
+
+void
+NetworkCodingUdpApplication::SendFeedback (const NetworkCodingControlHeader &feedback,
+                                           const Address &senderAddress)
+{
+  NS_LOG_FUNCTION (this << senderAddress);
+  
+  Ptr<Packet> feedbackPacket = Create<Packet> ();
+  feedbackPacket->AddHeader (feedback);
+  Ptr<Packet> controlPacket = Create<Packet> (CONTROL_MARKER, sizeof (CONTROL_MARKER));
+  controlPacket->AddAtEnd (feedbackPacket);
+  
+  if (m_socket && m_socket->SendTo (controlPacket, 0, senderAddress) > 0) {
+    NS_LOG_INFO ("Sent feedback for generation " << feedback.GetGenerationId ()
+                 << " at rank " << feedback.GetRank () << " to " << senderAddress);
+  } else {
+    NS_LOG_WARN ("Failed to send feedback for generation " << feedback.GetGenerationId ());
   }
 }
 
@@ -581,166 +998,312 @@ NetworkCodingUdpApplication::SendAck (uint32_t generationId, Address senderAddre
 {
   NS_LOG_FUNCTION (this << generationId << senderAddress);
   
-  uint8_t ackData[8];
-  ackData[0] = 0xFF;
-  ackData[1] = 0xFF;
-  ackData[2] = 0xFF;
-  ackData[3] = 0xFF;
-  ackData[4] = (generationId >> 24) & 0xFF;
-  ackData[5] = (generationId >> 16) & 0xFF;
-  ackData[6] = (generationId >> 8) & 0xFF;
-  ackData[7] = generationId & 0xFF;
+  NetworkCodingControlHeader ack (NetworkCodingControlHeader::ACKNOWLEDGE, generationId);
+  ack.SetRank (m_generationSize);
+  SendFeedback (ack, senderAddress);
+}
+
+void
+NetworkCodingUdpApplication::HandleGenerationTimeout (uint32_t generationId)
+{
+  NS_LOG_FUNCTION (this << generationId);
   
-  Ptr<Packet> ackPacket = Create<Packet> (ackData, 8);
+  auto it = m_inFlight.find (generationId);
+  if (it == m_inFlight.end ()) {
+    NS_LOG_INFO ("Generation " << generationId << " already complete");
+    return;
+  }
   
-  if (m_socket && m_socket->SendTo (ackPacket, 0, senderAddress) > 0) {
-    NS_LOG_INFO ("Sent ACK for DECODED generation " << generationId << " to " << senderAddress);
+  SendGeneration &state = it->second;
+  state.retransmissions++;
+  if (Simulator::Now () - m_lastFeedback >= m_generationTimeout) {
+    // Not a lost ACK: nothing came back at all
+    m_rateController->OnTimeout ();
+  }
+  NS_LOG_INFO ("Generation " << generationId << " timeout (attempt " 
+               << state.retransmissions << "/" << m_maxRetransmissions << ")");
+  
+  if (state.retransmissions < m_maxRetransmissions) {
+    // No feedback made it back; repair what was missing at the last report
+    uint32_t missing = GetRankDeficit (generationId, state, true);
+    NS_LOG_INFO ("Retransmitting " << missing + m_repairMargin << " packets for generation "
+                 << generationId);
+    ExtendRound (state, missing + m_repairMargin);
   } else {
-    NS_LOG_WARN ("Failed to send ACK for generation " << generationId);
+    NS_LOG_WARN ("Maximum retransmissions reached for generation " << generationId);
+    CloseGeneration (generationId);
   }
 }
 
 void
-NetworkCodingUdpApplication::HandleGenerationTimeout (void)
+NetworkCodingUdpApplication::CloseGeneration (uint32_t generationId)
 {
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (this << generationId);
   
-  if (!m_waitingForGenerationAck) {
-    NS_LOG_INFO ("Generation " << m_currentGenerationSent << " already complete");
+  auto it = m_inFlight.find (generationId);
+  if (it == m_inFlight.end ()) {
     return;
   }
+  Simulator::Cancel (it->second.timer);
+  ReleaseEncoder (it->second.encoder);
+  m_inFlight.erase (it);
   
-  m_retransmissionCount++;
-  NS_LOG_INFO ("Generation " << m_currentGenerationSent << " timeout (attempt " 
-               << m_retransmissionCount << "/" << m_maxRetransmissions << ")");
+  // Refill the window and restart the link if it went idle
+  OpenGenerations ();
+  ScheduleNext ();
   
-  if (m_retransmissionCount < m_maxRetransmissions) {
-    // FIXED: Send additional REAL coded packets for retransmission
-    NS_LOG_INFO ("Retransmitting packets for generation " << m_currentGenerationSent);
-    
-    // Send more coded packets to overcome packet loss
-    uint32_t packetsToSend = m_generationSize; // Send at least generation size packets
-    for (uint32_t i = 0; i < packetsToSend; i++) {
-      SendRealCodedPacket(m_currentGenerationSent);
-    }
-    
-    // Schedule next timeout
-    m_retransmissionTimer = Simulator::Schedule (m_generationTimeout, 
-                                                 &NetworkCodingUdpApplication::HandleGenerationTimeout, 
-                                                 this);
-  } else {
-    NS_LOG_WARN ("Maximum retransmissions reached for generation " << m_currentGenerationSent);
-    
-    m_waitingForGenerationAck = false;
-    m_retransmissionCount = 0;
-    
-    uint32_t totalGenerationsNeeded = (m_numPackets + m_generationSize - 1) / m_generationSize;
-    if (m_currentGenerationSent + 1 < totalGenerationsNeeded) {
-      MoveToNextGeneration ();
-      ScheduleNext ();
-    } else {
-      NS_LOG_INFO ("All generations attempted");
-    }
+  if (m_inFlight.empty ()) {
+    NS_LOG_INFO ("*** ALL " << GetTotalGenerations () << " GENERATIONS COMPLETED ***");
+  }
+}
+
+Ptr<NetworkCodingEncoder>
+NetworkCodingUdpApplication::AcquireEncoder (void)
+{
+  if (m_spareEncoders.empty ()) {
+    Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> (m_generationSize, m_packetSize);
+    encoder->SetSystematic (m_systematic);
+    encoder->SetRepeatCoefficients (m_repeatCoefficients);
+    encoder->SetField (static_cast<gf::FieldType> (m_fieldBits));
+    return encoder;
   }
+  // The source slab keeps its size; only the rows of the old generation go
+  Ptr<NetworkCodingEncoder> encoder = m_spareEncoders.back ();
+  m_spareEncoders.pop_back ();
+  encoder->NextGeneration ();
+  return encoder;
 }
 
-// FIXED: Move to next generation and set up encoder
 void
-NetworkCodingUdpApplication::MoveToNextGeneration (void)
+NetworkCodingUdpApplication::ReleaseEncoder (Ptr<NetworkCodingEncoder> encoder)
 {
-  NS_LOG_FUNCTION (this);
+  if (m_spareEncoders.size () < m_maxGenerationsInFlight) {
+    m_spareEncoders.push_back (encoder);
+  }
+}
+
+void
+NetworkCodingUdpApplication::ExtendRound (SendGeneration &state, uint32_t packets)
+{
+  // The timeout is re-armed once the new round has been sent
+  Simulator::Cancel (state.timer);
+  state.roundEnd = state.packetsSent + packets;
+  ScheduleNext ();
+}
+
+void
+NetworkCodingUdpApplication::UpdateLossEstimate (ReceiverReport &report, const Address &receiver,
+                                                 const NetworkCodingControlHeader &feedback)
+{
+  // Packets carry their index in the generation as hop sequence, and
+  // relays pass on the newest one they got, so the packets sent up to the
+  // newest one the receiver saw are known exactly
+  uint64_t sequence = feedback.GetHopAckSequence ();
+  if (sequence <= report.sequence || feedback.GetPacketsReceived () < report.packetsReceived) {
+    return;
+  }
   
-  m_currentGenerationSent++;
-  m_packetsInCurrentGeneration = 0;
+  double sent = static_cast<double> (sequence - report.sequence);
+  double received = feedback.GetPacketsReceived () - report.packetsReceived;
+  double sample = 1.0 - std::min (1.0, received / sent);
+  double &estimate = m_receiverLoss[receiver];
+  estimate += LOSS_ESTIMATE_WEIGHT * (sample - estimate);
   
-  // CRITICAL FIX: Advance encoder to next generation!
-  if (m_encoder) {
-    m_encoder->NextGeneration();
-    
-    // Add packets for the new generation
-    uint32_t totalGenerationsNeeded = (m_numPackets + m_generationSize - 1) / m_generationSize;
-    if (m_currentGenerationSent < totalGenerationsNeeded) {
-      AddPacketsToCurrentGeneration(m_currentGenerationSent);
+  report.sequence = sequence;
+  report.packetsReceived = feedback.GetPacketsReceived ();
+  
+  // Redundancy has to cover the receiver losing the most
+  m_lossEstimate = 0.0;
+  for (const auto &entry : m_receiverLoss) {
+    m_lossEstimate = std::max (m_lossEstimate, entry.second);
+  }
+  NS_LOG_DEBUG ("Loss sample " << sample << " from " << receiver << ", estimate " << estimate
+                << ", worst " << m_lossEstimate);
+}
+
+uint32_t
+NetworkCodingUdpApplication::GetRankDeficit (uint32_t generationId, const SendGeneration &state,
+                                             bool countUnheard) const
+{
+  // Every coded packet is innovative for every receiver still missing rank
+  // with high probability, so the receiver furthest behind sets the repair
+  uint32_t packets = GetPacketsInGeneration (generationId);
+  uint32_t lowestRank = packets;
+  uint32_t heard = 0;
+  for (const auto &entry : state.receivers) {
+    if (!entry.second.acknowledged) {
+      lowestRank = std::min<uint32_t> (lowestRank, entry.second.rank);
+    }
+    heard++;
+  }
+  if (countUnheard && heard < m_groupSize) {
+    lowestRank = 0;
+  }
+  return packets - lowestRank;
+}
+
+void
+NetworkCodingUdpApplication::SampleRate (const SendGeneration &state, const Address &receiver,
+                                         const NetworkCodingControlHeader &feedback)
+{
+  // Rank reports wait FeedbackDelay before they are sent, so only decode
+  // ACKs time the path. The ACK names the newest packet the receiver saw.
+  uint64_t sequence = feedback.GetHopAckSequence ();
+  if (sequence == 0 || sequence > state.sent.size ()) {
+    return;
+  }
+  const SentPacket &packet = state.sent[sequence - 1];
+  Time now = Simulator::Now ();
+  
+  NetworkCodingRateController::RateSample sample;
+  sample.rtt = now - packet.time;
+  sample.deliveryRate = DataRate (0);
+  sample.loss = m_lossEstimate;
+  sample.appLimited = false;
+  
+  // Everything sent between the receiver's previous ACKed packet and this
+  // one, less the losses, arrived between the two ACKs. Taking the longer
+  // of the send and ACK spacing keeps ACK compression from inflating it.
+  auto reference = m_deliveryReferences.find (receiver);
+  if (reference != m_deliveryReferences.end ()) {
+    const DeliveryReference &previous = reference->second;
+    if (packet.index <= previous.index) {
+      // Older than a packet already sampled; only the RTT is new
+      m_rateController->OnFeedback (sample);
+      return;
+    }
+    Time elapsed = std::max (now - previous.acknowledged, packet.time - previous.sent);
+    if (elapsed.IsStrictlyPositive ()) {
+      auto loss = m_receiverLoss.find (receiver);
+      double delivered = (packet.index - previous.index)
+        * (1.0 - (loss != m_receiverLoss.end () ? loss->second : 0.0));
+      sample.deliveryRate = DataRate (static_cast<uint64_t> (delivered * m_packetSize * 8 / elapsed.GetSeconds ()));
+      sample.appLimited = m_appLimitedIndex > previous.index;
     }
   }
+  m_deliveryReferences[receiver] = {packet.index, packet.time, now};
   
-  NS_LOG_INFO ("Moved to sending generation " << m_currentGenerationSent);
+  NS_LOG_DEBUG ("Rate sample from " << receiver << ": RTT " << sample.rtt.GetSeconds ()
+                << " s, delivery " << sample.deliveryRate
+                << (sample.appLimited ? " (application limited)" : ""));
+  m_rateController->OnFeedback (sample);
 }
 
 bool
 NetworkCodingUdpApplication::IsAckPacket (Ptr<Packet> packet)
 {
-  if (packet->GetSize () != 8) {
+  if (packet->GetSize () < sizeof (CONTROL_MARKER)) {
     return false;
   }
   
-  uint8_t buffer[8];
-  packet->CopyData (buffer, 8);
+  uint8_t buffer[sizeof (CONTROL_MARKER)];
+  packet->CopyData (buffer, sizeof (buffer));
   
-  return (buffer[0] == 0xFF && buffer[1] == 0xFF && 
-          buffer[2] == 0xFF && buffer[3] == 0xFF);
+  return std::equal (buffer, buffer + sizeof (buffer), CONTROL_MARKER);
 }
 
 void
-NetworkCodingUdpApplication::HandleAck (Ptr<Packet> packet)
+NetworkCodingUdpApplication::HandleAck (Ptr<Packet> packet, const Address &from)
 {
-  NS_LOG_FUNCTION (this << packet);
+  NS_LOG_FUNCTION (this << packet << from);
   
-  uint8_t buffer[8];
-  packet->CopyData (buffer, 8);
-  
-  uint32_t ackedGeneration = (buffer[4] << 24) | (buffer[5] << 16) | 
-                            (buffer[6] << 8) | buffer[7];
+  packet->RemoveAtStart (sizeof (CONTROL_MARKER));
+  NetworkCodingControlHeader feedback;
+  if (packet->RemoveHeader (feedback) == 0) {
+    NS_LOG_WARN ("Dropping malformed feedback packet");
+    return;
+  }
+  m_lastFeedback = Simulator::Now ();
   
-  NS_LOG_INFO ("Received ACK for DECODED generation " << ackedGeneration 
-               << ", current sending generation: " << m_currentGenerationSent);
+  uint32_t generationId = feedback.GetGenerationId ();
+  auto it = m_inFlight.find (generationId);
+  if (it == m_inFlight.end ()) {
+    NS_LOG_INFO ("Feedback for generation " << generationId << " which is no longer in flight");
+    return;
+  }
   
-  if (ackedGeneration == m_currentGenerationSent) {
-    m_waitingForGenerationAck = false;
-    m_retransmissionCount = 0;
-    
-    Simulator::Cancel (m_retransmissionTimer);
-    
-    uint32_t totalGenerationsNeeded = (m_numPackets + m_generationSize - 1) / m_generationSize;
-    
-    NS_LOG_INFO ("*** GENERATION " << ackedGeneration << " SUCCESSFULLY ACKNOWLEDGED ***");
-    
-    if (m_currentGenerationSent + 1 < totalGenerationsNeeded) {
-      MoveToNextGeneration ();
-      ScheduleNext ();
+  SendGeneration &state = it->second;
+  ReceiverReport &report = state.receivers[from];
+  UpdateLossEstimate (report, from, feedback);
+  
+  if (feedback.GetControlType () == NetworkCodingControlHeader::ACKNOWLEDGE) {
+    SampleRate (state, from, feedback);
+    report.acknowledged = true;
+    report.rank = std::max<uint16_t> (report.rank, feedback.GetRank ());
+    uint32_t acknowledged = 0;
+    for (const auto &entry : state.receivers) {
+      acknowledged += entry.second.acknowledged ? 1 : 0;
+    }
+    if (acknowledged >= m_groupSize) {
+      NS_LOG_INFO ("*** GENERATION " << generationId << " SUCCESSFULLY ACKNOWLEDGED ***");
+      CloseGeneration (generationId);
     } else {
-      NS_LOG_INFO ("*** ALL " << totalGenerationsNeeded 
-                   << " GENERATIONS SENT AND ACKNOWLEDGED! ***");
+      NS_LOG_INFO ("Generation " << generationId << " acknowledged by " << from << ", "
+                   << acknowledged << "/" << m_groupSize << " receivers done");
     }
+    return;
   }
-}
-
-bool
-NetworkCodingUdpApplication::IsCurrentGenerationComplete (void) const
-{
-  NS_LOG_FUNCTION (this);
-  
-  uint32_t totalGenerationsNeeded = (m_numPackets + m_generationSize - 1) / m_generationSize;
   
-  if (m_currentGenerationSent >= totalGenerationsNeeded) {
-    return true;
+  if (feedback.GetControlType () != NetworkCodingControlHeader::INNOVATIVE_ACK
+      || report.acknowledged || feedback.GetRank () < report.rank) {
+    return;
   }
-  
-  uint32_t packetsNeededInCurrentGeneration = m_generationSize;
-  if (m_currentGenerationSent == totalGenerationsNeeded - 1) {
-    uint32_t remainingPackets = m_numPackets - (m_currentGenerationSent * m_generationSize);
-    packetsNeededInCurrentGeneration = remainingPackets;
+  report.rank = feedback.GetRank ();
+  
+  // Send exactly what the furthest receiver is missing plus a margin, less
+  // what is still queued in the current round. Receivers that have not
+  // reported yet will do so on their own, or the timeout covers them.
+  uint32_t needed = GetRankDeficit (generationId, state, false) + m_repairMargin;
+  uint32_t queued = state.roundEnd - state.packetsSent;
+  NS_LOG_INFO ("Generation " << generationId << " at rank " << report.rank << " at " << from
+               << ", " << needed << " packets needed, " << queued << " queued");
+  if (needed > queued) {
+    ExtendRound (state, needed);
   }
-  
-  return m_packetsInCurrentGeneration >= packetsNeededInCurrentGeneration;
 }
 
 // Getter methods
 uint32_t NetworkCodingUdpApplication::GetPacketsSent (void) const { return m_packetsSent; }
 uint32_t NetworkCodingUdpApplication::GetPacketsReceived (void) const { return m_packetsReceived; }
 uint32_t NetworkCodingUdpApplication::GetInnovativePacketsReceived (void) const { return m_innovativePacketsReceived; }
+uint32_t NetworkCodingUdpApplication::GetNonInnovativePacketsReceived (void) const { return m_nonInnovativePacketsReceived; }
 uint32_t NetworkCodingUdpApplication::GetGenerationsDecoded (void) const { return m_generationsDecoded; }
-Ptr<NetworkCodingEncoder> NetworkCodingUdpApplication::GetEncoder (void) const { return m_encoder; }
-Ptr<NetworkCodingDecoder> NetworkCodingUdpApplication::GetDecoder (void) const { return m_decoder; }
+double NetworkCodingUdpApplication::GetLossEstimate (void) const { return m_lossEstimate; }
+
+void
+NetworkCodingUdpApplication::SetRateController (Ptr<NetworkCodingRateController> controller)
+{
+  NS_LOG_FUNCTION (this << controller);
+  m_rateController = controller;
+}
+
+Ptr<NetworkCodingRateController>
+NetworkCodingUdpApplication::GetRateController (void) const
+{
+  return m_rateController;
+}
+
+Ptr<NetworkCodingEncoder>
+NetworkCodingUdpApplication::GetEncoder (void) const
+{
+  return m_inFlight.empty () ? nullptr : m_inFlight.begin ()->second.encoder;
+}
+
+Ptr<NetworkCodingDecoder>
+NetworkCodingUdpApplication::GetDecoder (void) const
+{
+  // The table is unordered; report the lowest generation ID
+  const ReceiveGeneration *oldest = nullptr;
+  uint32_t oldestId = 0;
+  for (const auto &entry : m_receiving)
+    {
+      if (!oldest || entry.first < oldestId)
+        {
+          oldest = &entry.second;
+          oldestId = entry.first;
+        }
+    }
+  return oldest ? oldest->decoder : nullptr;
+}
 
-} // namespace ns3
\ No newline at end of file
+} // namespace ns3
@@ -23,14 +23,30 @@
 #include "ns3/socket.h"
 #include "ns3/data-rate.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
 #include "network-coding-encoder.h"
 #include "network-coding-decoder.h"
-#include "galois-field.h"
+#include "network-coding-packet.h"
+#include "decoding-worker-pool.h"
+#include "network-coding-rate-controller.h"
+#include <deque>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace ns3 {
 
 /**
  * \brief A UDP application that implements Random Linear Network Coding
+ *
+ * A sender can serve a multicast group: with Remote set to the group
+ * address and GroupSize to the number of receivers, one coded stream
+ * reaches all of them. Feedback is tracked per receiver, a generation is
+ * retired once every receiver has acknowledged it, and repairs cover the
+ * largest rank deficit, since each coded packet helps every receiver.
  */
 class NetworkCodingUdpApplication : public Application
 {
@@ -55,22 +71,177 @@ public:
   uint32_t GetPacketsSent (void) const;
   uint32_t GetPacketsReceived (void) const;
   uint32_t GetInnovativePacketsReceived (void) const;
+  uint32_t GetNonInnovativePacketsReceived (void) const;
   uint32_t GetGenerationsDecoded (void) const;
+
+  /**
+   * \brief Get the sender's current estimate of the path loss rate
+   * \return the smoothed fraction of packets lost, from receiver feedback;
+   *         with several receivers, that of the one losing the most
+   */
+  double GetLossEstimate (void) const;
+
+  /**
+   * \brief Get the encoder of the oldest generation in flight
+   * \return the encoder, or nullptr if nothing is in flight
+   */
   Ptr<NetworkCodingEncoder> GetEncoder (void) const;
+
+  /**
+   * \brief Get the decoder of the oldest generation being received
+   * \return the decoder, or nullptr if no generation is partially received
+   */
   Ptr<NetworkCodingDecoder> GetDecoder (void) const;
 
+  /**
+   * \brief Pace the sender with a given controller instead of one of
+   *        type RateController
+   * \param controller The controller; it is started with the application
+   */
+  void SetRateController (Ptr<NetworkCodingRateController> controller);
+
+  /**
+   * \brief Get the controller pacing the sender
+   * \return the controller, or nullptr before the application first started
+   */
+  Ptr<NetworkCodingRateController> GetRateController (void) const;
+
+  /**
+   * \brief TracedCallback signature for a per-generation duration
+   * \param [in] generationId The generation
+   * \param [in] duration Simulated latency or wall-clock time, per source
+   */
+  typedef void (*GenerationTimeTracedCallback) (uint32_t generationId, Time duration);
+
+  /**
+   * \brief TracedCallback signature for rank progression
+   * \param [in] generationId The generation the packet belongs to
+   * \param [in] rank Decoder rank after the packet
+   * \param [in] innovative Whether the packet raised the rank
+   */
+  typedef void (*RankTracedCallback) (uint32_t generationId, uint16_t rank, bool innovative);
+
 protected:
   virtual void DoDispose (void);
 
 private:
+  /**
+   * \brief What one receiver last reported about a generation
+   */
+  struct ReceiverReport
+  {
+    uint16_t rank = 0;                  //!< Highest rank the receiver reported
+    uint32_t packetsReceived = 0;       //!< Packets received as of the last feedback
+    uint64_t sequence = 0;              //!< Highest packet index seen as of the last feedback
+    bool acknowledged = false;          //!< The receiver has decoded the generation
+  };
+
+  /**
+   * \brief When a packet was sent, for RTT and delivery rate samples
+   */
+  struct SentPacket
+  {
+    Time time;                          //!< Send time
+    uint64_t index;                     //!< Position among all packets sent
+  };
+
+  /**
+   * \brief Newest packet a receiver has acknowledged, the start of its next
+   *        delivery rate sample
+   */
+  struct DeliveryReference
+  {
+    uint64_t index;                     //!< Position among all packets sent
+    Time sent;                          //!< When it was sent
+    Time acknowledged;                  //!< When its ACK arrived
+  };
+
+  /**
+   * \brief Sender state of one generation in flight
+   */
+  struct SendGeneration
+  {
+    Ptr<NetworkCodingEncoder> encoder;  //!< Encoder holding the source packets
+    uint32_t packetsSent;               //!< Packets sent so far, all rounds
+    uint32_t roundEnd;                  //!< Value of packetsSent that ends the current round
+    uint32_t retransmissions;           //!< Timeouts handled so far
+    std::map<Address, ReceiverReport> receivers; //!< Feedback of every receiver heard from
+    EventId timer;                      //!< ACK timeout, armed at the end of each round
+    std::deque<Ptr<Packet>> queued;     //!< Packets generated for the round, not yet sent
+    std::vector<SentPacket> sent;       //!< Entry s - 1 is the packet with hop sequence s
+  };
+
+  /**
+   * \brief Receiver state of one partially decoded generation
+   */
+  struct ReceiveGeneration
+  {
+    Ptr<NetworkCodingDecoder> decoder;  //!< Decoder of the generation
+    uint32_t packetsReceived;           //!< Packets received, innovative or not
+    uint64_t highestSequence;           //!< Highest packet index (hop sequence) seen
+    Address sender;                     //!< Where feedback is sent
+    EventId feedbackTimer;              //!< Sends a rank report once the sender goes quiet
+    Time firstPacket;                   //!< Arrival of the first packet, for the latency trace
+    std::list<uint32_t>::iterator lru;  //!< Position in m_receiveLru
+  };
+
+  /**
+   * \brief Full-rank generation being solved by the worker pool
+   */
+  struct PendingDecode
+  {
+    ReceiveGeneration generation;       //!< Receiver state, decoder included
+    std::future<void> solved;           //!< Ready once the decoder has been solved
+  };
+
   virtual void StartApplication (void);
   virtual void StopApplication (void);
   
-  // FIXED: Core methods with generation management
-  void GenerateOriginalPackets (void);
-  void AddPacketsToCurrentGeneration (uint32_t generationId);
+  // Sender
+  uint32_t GetTotalGenerations (void) const;
+  uint32_t GetPacketsInGeneration (uint32_t generationId) const;
+  void OpenGenerations (void);
+  void AddPacketsToGeneration (uint32_t generationId, Ptr<NetworkCodingEncoder> encoder);
   void SendRealCodedPacket (uint32_t generationId);
-  bool ProcessRealCodedPacket (Ptr<Packet> packet);
+  void CloseGeneration (uint32_t generationId);
+  Ptr<NetworkCodingEncoder> AcquireEncoder (void);
+  void ReleaseEncoder (Ptr<NetworkCodingEncoder> encoder);
+  void ExtendRound (SendGeneration &state, uint32_t packets);
+  void UpdateLossEstimate (ReceiverReport &report, const Address &receiver,
+                           const NetworkCodingControlHeader &feedback);
+  /**
+   * \brief Get the largest rank any receiver still misses for a generation
+   * \param generationId The generation
+   * \param state Its sender state
+   * \param countUnheard Count receivers not heard from as having rank 0
+   * \return the deficit of the receiver furthest behind
+   */
+  uint32_t GetRankDeficit (uint32_t generationId, const SendGeneration &state,
+                           bool countUnheard) const;
+  /**
+   * \brief Hand the RTT and delivery rate an ACK shows to the rate controller
+   * \param state Sender state of the acknowledged generation
+   * \param receiver Where the ACK came from
+   * \param feedback The ACK
+   */
+  void SampleRate (const SendGeneration &state, const Address &receiver,
+                   const NetworkCodingControlHeader &feedback);
+  bool HasPacketsToSend (void) const;
+  
+  // Receiver
+  bool ProcessRealCodedPacket (Ptr<Packet> packet, const Address &from);
+  ReceiveGeneration *GetReceiveGeneration (uint32_t generationId);
+  void EraseReceiveGeneration (uint32_t generationId);
+  void EvictReceiveGeneration (void);
+  uint32_t GetReceiveWindow (void) const;
+  void RememberDecoded (uint32_t generationId);
+  void SendRankReport (uint32_t generationId);
+  void CompleteGeneration (uint32_t generationId, const ReceiveGeneration &state);
+  void FinishPendingDecode (uint32_t generationId);
+  void WaitForPendingDecodes (void);
+  Ptr<NetworkCodingDecoder> AcquireDecoder (uint32_t generationId);
+  void ReleaseDecoder (Ptr<NetworkCodingDecoder> decoder);
+  void HandleSymbolDecoded (uint32_t generationId, uint16_t index, Ptr<const Packet> symbol);
   void VerifyDecodedPackets (const std::vector<Ptr<Packet>>& decodedPackets,
                            uint32_t generationId);
   
@@ -79,17 +250,14 @@ private:
   void ScheduleNext (void);
   void SendPacket (void);
   
-  // Generation management
-  void MoveToNextGeneration (void);
-  bool IsCurrentGenerationComplete (void) const;
-  
-  // ACK handling
+  // ACK and rank feedback handling
   bool IsAckPacket (Ptr<Packet> packet);
-  void HandleAck (Ptr<Packet> packet);
+  void HandleAck (Ptr<Packet> packet, const Address &from);
+  void SendFeedback (const NetworkCodingControlHeader &feedback, const Address &senderAddress);
   void SendAck (uint32_t generationId, Address senderAddress);
   
   // Reliability
-  void HandleGenerationTimeout (void);
+  void HandleGenerationTimeout (uint32_t generationId);
 
   // Socket and addressing
   Ptr<Socket> m_socket;
@@ -101,40 +269,78 @@ private:
   uint16_t m_generationSize;
   DataRate m_dataRate;
   double m_lossRate;
+  bool m_systematic;                    //!< Send source packets uncoded first
+  uint8_t m_fieldBits;                  //!< Bits per symbol of the coding field
+  uint32_t m_maxGenerationsInFlight;    //!< Generations sent or received concurrently
+  Time m_feedbackDelay;                 //!< Receiver silence before a rank report
+  uint32_t m_repairMargin;              //!< Repair packets sent beyond the missing rank
+  bool m_adaptiveRedundancy;            //!< Size the first round from the loss estimate
+  double m_maxRedundancy;               //!< Cap on proactive redundancy, as a fraction of g
+  uint32_t m_decoderThreads;            //!< Worker threads solving full-rank generations
+  uint32_t m_groupSize;                 //!< Receivers that must acknowledge every generation
+  Time m_decodeLatency;                 //!< Simulated time a generation takes to solve
+  bool m_measureCodingTime;             //!< Time encoder and decoder calls on the wall clock
+  bool m_partialDecoding;               //!< Deliver source symbols before full rank
+  uint32_t m_receiveGenerations;        //!< Live decoders at the receiver; 0 follows the sender window
+  uint64_t m_maxDecoderMemory;          //!< Cap on live decoder row storage, 0 for none
+  uint32_t m_decodedHistory;            //!< Decoded generation IDs kept for re-ACKs
+  TypeId m_rateControllerType;          //!< Type of the controller created on start
+  bool m_repeatCoefficients;            //!< Same coefficient rows in every generation
+  uint32_t m_inverseCacheSize;          //!< Patterns the receiver's inverse cache keeps, 0 for none
 
   // State
   bool m_running;
   uint32_t m_packetsSent;
   uint32_t m_packetsReceived;
-  uint32_t m_innovativePacketsReceived;
+  TracedValue<uint32_t> m_innovativePacketsReceived;
+  TracedValue<uint32_t> m_nonInnovativePacketsReceived;
   uint32_t m_generationsDecoded;
-  uint32_t m_nextSeq;
 
-  // REAL Network Coding components
-  Ptr<NetworkCodingEncoder> m_encoder;
-  Ptr<NetworkCodingDecoder> m_decoder;
+  // Sender: generations opened but not yet ACKed or abandoned
+  std::map<uint32_t, SendGeneration> m_inFlight;
+  uint32_t m_nextGenerationToOpen;      //!< Lowest generation not opened yet
+  uint32_t m_nextGenerationToServe;     //!< Round-robin position among m_inFlight
+  double m_lossEstimate;                //!< Loss estimate of the worst receiver
+  std::map<Address, double> m_receiverLoss; //!< Smoothed loss rate per receiver
+  Ptr<NetworkCodingRateController> m_rateController; //!< Sets the send interval
+  std::map<Address, DeliveryReference> m_deliveryReferences; //!< Per receiver
+  uint64_t m_sendIndex;                 //!< Packets sent, all generations
+  uint64_t m_appLimitedIndex;           //!< m_sendIndex when the sender last ran dry
+  Time m_lastFeedback;                  //!< When feedback last arrived
+
+  // Receiver: partially received generations, looked up by generation ID
+  // whatever order their packets arrive in. When the table is full the
+  // generation that has been quiet the longest is evicted.
+  std::unordered_map<uint32_t, ReceiveGeneration> m_receiving;
+  std::list<uint32_t> m_receiveLru;     //!< Generations in m_receiving, most recent packet first
+  std::unordered_set<uint32_t> m_decodedGenerations; //!< Generations to re-ACK on late packets
+  std::deque<uint32_t> m_decodedOrder;  //!< m_decodedGenerations, oldest decode first
+  std::unique_ptr<DecodingWorkerPool> m_workerPool; //!< Only with DecoderThreads > 0
+  Ptr<DecodingInverseCache> m_inverseCache; //!< Only with InverseCacheSize > 0
+  std::map<uint32_t, PendingDecode> m_pendingDecodes; //!< Completion queue of the pool
 
-  // Generation tracking
-  uint32_t m_currentGeneration;
-  uint32_t m_generationPacketCount;
-  uint32_t m_currentGenerationSent;
-  uint32_t m_packetsInCurrentGeneration;
+  // Retired coders kept for the next generation, so a long transfer does
+  // not allocate and free coefficient and payload slabs per generation.
+  // At most MaxGenerationsInFlight of each are kept.
+  std::vector<Ptr<NetworkCodingEncoder>> m_spareEncoders;
+  std::vector<Ptr<NetworkCodingDecoder>> m_spareDecoders;
 
   // Reliability
-  bool m_waitingForGenerationAck;
   Time m_generationTimeout;
   uint32_t m_maxRetransmissions;
-  uint32_t m_retransmissionCount;
-  Ptr<GaloisField> m_galoisField;
 
   // Events
   EventId m_sendEvent;
-  EventId m_retransmissionTimer;
 
   // Tracing
   TracedCallback<Ptr<const Packet>> m_txTrace;
   TracedCallback<Ptr<const Packet>> m_rxTrace;
   TracedCallback<bool, uint32_t> m_decodingTrace;
+  TracedCallback<uint32_t, Time> m_generationLatencyTrace;  //!< First packet to full rank
+  TracedCallback<uint32_t, uint16_t, bool> m_rankTrace;     //!< Every coded packet received
+  TracedCallback<uint32_t, Time> m_encodeTimeTrace;         //!< Wall clock per packet encoded
+  TracedCallback<uint32_t, Time> m_decodeTimeTrace;         //!< Wall clock per packet decoded
+  TracedCallback<uint32_t, uint16_t, Ptr<const Packet>> m_symbolDecodedTrace; //!< With PartialDecoding
 };
 
 } // namespace ns3
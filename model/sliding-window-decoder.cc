@@ -0,0 +1,365 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "sliding-window-decoder.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SlidingWindowDecoder");
+NS_OBJECT_ENSURE_REGISTERED (SlidingWindowDecoder);
+
+TypeId
+SlidingWindowDecoder::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SlidingWindowDecoder")
+    .SetParent<Object> ()
+    .SetGroupName ("NetworkCoding")
+    .AddConstructor<SlidingWindowDecoder> ()
+  ;
+  return tid;
+}
+
+SlidingWindowDecoder::SlidingWindowDecoder ()
+  : SlidingWindowDecoder (16, 1024)
+{
+}
+
+SlidingWindowDecoder::SlidingWindowDecoder (uint16_t windowSize, uint16_t packetSize)
+  : m_windowSize (windowSize),
+    m_packetSize (packetSize),
+    m_base (0),
+    m_nextDelivery (0),
+    m_lost (0),
+    m_rank (0)
+{
+  NS_LOG_FUNCTION (this << windowSize << packetSize);
+  NS_ASSERT_MSG (m_windowSize > 0 && m_packetSize > 0, "Invalid window or packet size");
+  
+  // One row per ring column plus a scratch row for the incoming packet
+  m_matrix.Resize (m_windowSize + 1, m_windowSize, m_packetSize);
+  m_hasPivot.assign (m_windowSize, false);
+}
+
+SlidingWindowDecoder::~SlidingWindowDecoder ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint16_t
+SlidingWindowDecoder::GetWindowSize (void) const
+{
+  return m_windowSize;
+}
+
+uint16_t
+SlidingWindowDecoder::GetPacketSize (void) const
+{
+  return m_packetSize;
+}
+
+uint32_t
+SlidingWindowDecoder::Column (uint32_t seqNum) const
+{
+  return seqNum % m_windowSize;
+}
+
+bool
+SlidingWindowDecoder::ProcessCodedPacket (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  
+  if (!packet)
+    {
+      NS_LOG_ERROR ("Null packet received");
+      return false;
+    }
+  
+  Ptr<Packet> packetCopy = packet->Copy ();
+  NetworkCodingWindowHeader header;
+  if (packetCopy->RemoveHeader (header) == 0)
+    {
+      NS_LOG_ERROR ("Failed to remove window header");
+      return false;
+    }
+  
+  uint32_t start = header.GetWindowStart ();
+  uint32_t end = header.GetWindowEnd ();
+  if (end - start > m_windowSize)
+    {
+      NS_LOG_WARN ("Coding window [" << start << ", " << end << ") is larger than "
+                   << m_windowSize);
+      return false;
+    }
+  if (end <= m_base)
+    {
+      NS_LOG_INFO ("Packet only covers released packets, ignoring");
+      return false;
+    }
+  
+  // Nothing before the sender's window start will be coded again
+  if (start > m_base)
+    {
+      AdvanceWindow (start);
+    }
+  
+  // Stage the row in the scratch slot
+  const uint32_t scratch = m_windowSize;
+  m_matrix.ZeroRow (scratch);
+  uint8_t *rowCoeffs = m_matrix.GetCoefficients (scratch);
+  const std::vector<uint8_t> &coefficients = header.GetCoefficients ();
+  for (uint32_t k = 0; k < coefficients.size (); k++)
+    {
+      if (coefficients[k] == 0)
+        {
+          continue;
+        }
+      if (start + k < m_base)
+        {
+          // Combines a packet whose column is gone; it cannot be cancelled
+          NS_LOG_INFO ("Packet depends on released packet " << start + k << ", ignoring");
+          return false;
+        }
+      rowCoeffs[Column (start + k)] = coefficients[k];
+    }
+  
+  uint32_t actualSize = std::min (packetCopy->GetSize (), (uint32_t)m_packetSize);
+  packetCopy->CopyData (m_matrix.GetPayload (scratch), actualSize);
+  
+  if (!EliminateRow ())
+    {
+      NS_LOG_INFO ("Received non-innovative packet for window [" << start << ", " << end << ")");
+      return false;
+    }
+  
+  Deliver ();
+  return true;
+}
+
+bool
+SlidingWindowDecoder::EliminateRow (void)
+{
+  NS_LOG_FUNCTION (this);
+  
+  const uint32_t scratch = m_windowSize;
+  uint8_t *coefficients = m_matrix.GetCoefficients (scratch);
+  uint8_t *payload = m_matrix.GetPayload (scratch);
+  
+  // Forward reduction: cancel every column that already has a pivot. The
+  // pivot columns form an identity, so each subtraction clears exactly one
+  // of them; unlike the block decoder the pivot rows are not in echelon
+  // order, so whole rows are combined.
+  for (uint32_t c = 0; c < m_windowSize; c++)
+    {
+      uint8_t factor = coefficients[c];
+      if (factor != 0 && m_hasPivot[c])
+        {
+          gf::MultiplyAddRegion (coefficients, m_matrix.GetCoefficients (c), factor, m_windowSize);
+          gf::MultiplyAddRegion (payload, m_matrix.GetPayload (c), factor, m_packetSize);
+        }
+    }
+  
+  // The new pivot is the oldest packet the row still depends on, which
+  // keeps the head of the window the first to be solved
+  int32_t lead = -1;
+  for (uint32_t seq = m_base; seq < m_base + m_windowSize; seq++)
+    {
+      if (coefficients[Column (seq)] != 0)
+        {
+          lead = Column (seq);
+          break;
+        }
+    }
+  if (lead < 0)
+    {
+      return false;
+    }
+  
+  // Normalize the new pivot to 1
+  uint8_t pivotInv = gf::Inverse (coefficients[lead]);
+  gf::MultiplyRegion (coefficients, pivotInv, m_windowSize);
+  gf::MultiplyRegion (payload, pivotInv, m_packetSize);
+  
+  // Back-substitution: clear the new pivot column from the existing rows
+  for (uint32_t i = 0; i < m_windowSize; i++)
+    {
+      if (!m_hasPivot[i])
+        {
+          continue;
+        }
+      uint8_t *pivotCoeffs = m_matrix.GetCoefficients (i);
+      uint8_t factor = pivotCoeffs[lead];
+      if (factor != 0)
+        {
+          gf::MultiplyAddRegion (pivotCoeffs, coefficients, factor, m_windowSize);
+          gf::MultiplyAddRegion (m_matrix.GetPayload (i), payload, factor, m_packetSize);
+        }
+    }
+  
+  m_matrix.SwapRows (lead, scratch);
+  m_hasPivot[lead] = true;
+  m_rank++;
+  
+  NS_LOG_INFO ("Stored innovative packet as pivot for column " << lead << ", rank " << m_rank);
+  
+  return true;
+}
+
+bool
+SlidingWindowDecoder::IsSolved (uint32_t column) const
+{
+  const uint8_t *coefficients = m_matrix.GetCoefficients (column);
+  for (uint32_t c = 0; c < m_windowSize; c++)
+    {
+      if (c != column && coefficients[c] != 0)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+SlidingWindowDecoder::Deliver (void)
+{
+  while (m_nextDelivery < m_base + m_windowSize)
+    {
+      uint32_t c = Column (m_nextDelivery);
+      if (!m_hasPivot[c] || !IsSolved (c))
+        {
+          break;
+        }
+      m_delivered.push_back (Create<Packet> (m_matrix.GetPayload (c), m_packetSize));
+      NS_LOG_INFO ("Delivered packet " << m_nextDelivery);
+      m_nextDelivery++;
+    }
+}
+
+void
+SlidingWindowDecoder::AdvanceWindow (uint32_t start)
+{
+  NS_LOG_FUNCTION (this << start);
+  
+  Deliver ();
+  
+  uint32_t releaseEnd = std::min (start, m_base + m_windowSize);
+  for (uint32_t seq = m_base; seq < releaseEnd; seq++)
+    {
+      uint32_t c = Column (seq);
+      
+      // Last chance to deliver the packet; earlier ones were settled by
+      // previous iterations, so delivery stays in order
+      if (seq >= m_nextDelivery)
+        {
+          if (m_hasPivot[c] && IsSolved (c))
+            {
+              m_delivered.push_back (Create<Packet> (m_matrix.GetPayload (c), m_packetSize));
+              NS_LOG_INFO ("Delivered packet " << seq);
+            }
+          else
+            {
+              m_lost++;
+              NS_LOG_INFO ("Packet " << seq << " left the window unsolved");
+            }
+          m_nextDelivery = seq + 1;
+        }
+      
+      // Eliminate the column from the other rows using one row that holds
+      // it, then drop that row. This keeps whatever the remaining rows say
+      // about the packets still in the window.
+      int32_t reference = -1;
+      if (m_hasPivot[c])
+        {
+          reference = c;
+        }
+      else
+        {
+          for (uint32_t i = 0; i < m_windowSize; i++)
+            {
+              if (m_hasPivot[i] && m_matrix.GetCoefficients (i)[c] != 0)
+                {
+                  reference = i;
+                  break;
+                }
+            }
+        }
+      if (reference < 0)
+        {
+          continue;
+        }
+      
+      const uint8_t *refCoeffs = m_matrix.GetCoefficients (reference);
+      const uint8_t *refPayload = m_matrix.GetPayload (reference);
+      uint8_t refInv = gf::Inverse (refCoeffs[c]);
+      for (uint32_t i = 0; i < m_windowSize; i++)
+        {
+          if (!m_hasPivot[i] || i == (uint32_t)reference)
+            {
+              continue;
+            }
+          uint8_t *rowCoeffs = m_matrix.GetCoefficients (i);
+          if (rowCoeffs[c] != 0)
+            {
+              uint8_t factor = gf::Multiply (rowCoeffs[c], refInv);
+              gf::MultiplyAddRegion (rowCoeffs, refCoeffs, factor, m_windowSize);
+              gf::MultiplyAddRegion (m_matrix.GetPayload (i), refPayload, factor, m_packetSize);
+            }
+        }
+      m_hasPivot[reference] = false;
+      m_rank--;
+    }
+  
+  // Packets the window jumped over entirely never had a column
+  if (m_nextDelivery < start)
+    {
+      m_lost += start - m_nextDelivery;
+      m_nextDelivery = start;
+    }
+  m_base = start;
+  
+  Deliver ();
+}
+
+std::vector<Ptr<Packet>>
+SlidingWindowDecoder::TakeDeliveredPackets (void)
+{
+  std::vector<Ptr<Packet>> delivered;
+  delivered.swap (m_delivered);
+  return delivered;
+}
+
+uint32_t
+SlidingWindowDecoder::GetNextDeliverySequence (void) const
+{
+  return m_nextDelivery;
+}
+
+uint32_t
+SlidingWindowDecoder::GetLostPacketCount (void) const
+{
+  return m_lost;
+}
+
+uint16_t
+SlidingWindowDecoder::GetRank (void) const
+{
+  return m_rank;
+}
+
+} // namespace ns3
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SLIDING_WINDOW_DECODER_H
+#define SLIDING_WINDOW_DECODER_H
+
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "network-coding-packet.h"
+#include "galois-field-simd.h"
+#include "generation-buffer.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief On-the-fly (sliding-window) network coding decoder
+ *
+ * Counterpart of SlidingWindowEncoder. The decoder keeps one column per
+ * source sequence number in [base, base + WindowSize), stored in a ring
+ * (column seq % WindowSize), and eliminates every received packet
+ * progressively so the pivot columns always form an identity. A source
+ * packet is solved as soon as its pivot row has no other nonzero
+ * coefficient, and solved packets are delivered strictly in sequence
+ * order without waiting for the rest of the window.
+ *
+ * Delivered packets stay in the ring because the sender keeps coding
+ * them until it sees the acknowledgment. Columns are only released when
+ * the window start in a received header moves past them; a packet whose
+ * column is released unsolved is declared lost and delivery skips it.
+ */
+class SlidingWindowDecoder : public Object
+{
+public:
+  /**
+   * \brief Get the TypeId
+   * \return the TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  SlidingWindowDecoder ();
+
+  /**
+   * \brief Constructor with parameters
+   * \param windowSize Largest coding window the sender uses
+   * \param packetSize Size of the source packets
+   */
+  SlidingWindowDecoder (uint16_t windowSize, uint16_t packetSize);
+  virtual ~SlidingWindowDecoder ();
+
+  uint16_t GetWindowSize (void) const;
+  uint16_t GetPacketSize (void) const;
+
+  /**
+   * \brief Process a packet carrying a NetworkCodingWindowHeader
+   * \param packet The received packet
+   * \return true if the packet increased the rank
+   */
+  bool ProcessCodedPacket (Ptr<const Packet> packet);
+
+  /**
+   * \brief Get the source packets delivered since the last call, in order
+   * \return the packets; their sequence numbers are consecutive except
+   * where packets were lost
+   */
+  std::vector<Ptr<Packet>> TakeDeliveredPackets (void);
+
+  /**
+   * \brief Get the sequence number of the next packet to be delivered
+   * \return every packet before it has been delivered or declared lost
+   */
+  uint32_t GetNextDeliverySequence (void) const;
+
+  /**
+   * \brief Get the number of packets that left the window unsolved
+   * \return the lost packet count
+   */
+  uint32_t GetLostPacketCount (void) const;
+
+  /**
+   * \brief Get the number of pivot rows held
+   * \return the rank of the window
+   */
+  uint16_t GetRank (void) const;
+
+private:
+  /**
+   * \brief Release the columns before a new window start
+   * \param start First sequence number that may still be coded
+   */
+  void AdvanceWindow (uint32_t start);
+
+  /**
+   * \brief Reduce the row staged in the scratch slot and store it if innovative
+   * \return true if the row increased the rank
+   */
+  bool EliminateRow (void);
+
+  /**
+   * \brief Check that a pivot row no longer depends on unknown packets
+   * \param column Ring column of the pivot
+   * \return true if the row holds the source packet itself
+   */
+  bool IsSolved (uint32_t column) const;
+
+  /**
+   * \brief Deliver solved packets in order starting at m_nextDelivery
+   */
+  void Deliver (void);
+
+  uint32_t Column (uint32_t seqNum) const;
+
+  uint16_t m_windowSize;
+  uint16_t m_packetSize;
+  uint32_t m_base;                         //!< Oldest sequence number with a column
+  uint32_t m_nextDelivery;                 //!< Next sequence number to deliver
+  uint32_t m_lost;                         //!< Packets released unsolved
+  uint16_t m_rank;                         //!< Number of pivot rows held
+
+  /**
+   * \brief One [coefficients | payload] row per ring column plus a scratch row
+   *
+   * Row c is the pivot row for ring column c when m_hasPivot[c] is set;
+   * coefficients are indexed by ring column as well.
+   */
+  GenerationBuffer m_matrix;
+  std::vector<bool> m_hasPivot;
+  std::vector<Ptr<Packet>> m_delivered;    //!< Delivered, not yet taken
+};
+
+} // namespace ns3
+
+#endif /* SLIDING_WINDOW_DECODER_H */
@@ -0,0 +1,217 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "sliding-window-encoder.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SlidingWindowEncoder");
+NS_OBJECT_ENSURE_REGISTERED (SlidingWindowEncoder);
+
+TypeId
+SlidingWindowEncoder::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SlidingWindowEncoder")
+    .SetParent<Object> ()
+    .SetGroupName ("NetworkCoding")
+    .AddConstructor<SlidingWindowEncoder> ()
+  ;
+  return tid;
+}
+
+SlidingWindowEncoder::SlidingWindowEncoder ()
+  : SlidingWindowEncoder (16, 1024)
+{
+}
+
+SlidingWindowEncoder::SlidingWindowEncoder (uint16_t windowSize, uint16_t packetSize)
+  : m_windowSize (windowSize),
+    m_packetSize (packetSize),
+    m_windowStart (0),
+    m_windowEnd (0)
+{
+  NS_LOG_FUNCTION (this << windowSize << packetSize);
+  NS_ASSERT_MSG (m_windowSize > 0 && m_packetSize > 0, "Invalid window or packet size");
+  m_coefficientRng = CreateObject<UniformRandomVariable> ();
+  Reset ();
+}
+
+SlidingWindowEncoder::~SlidingWindowEncoder ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint16_t
+SlidingWindowEncoder::GetWindowSize (void) const
+{
+  return m_windowSize;
+}
+
+void
+SlidingWindowEncoder::SetWindowSize (uint16_t windowSize)
+{
+  NS_LOG_FUNCTION (this << windowSize);
+  NS_ASSERT_MSG (windowSize > 0, "Invalid window size");
+  m_windowSize = windowSize;
+  Reset ();
+}
+
+uint16_t
+SlidingWindowEncoder::GetPacketSize (void) const
+{
+  return m_packetSize;
+}
+
+void
+SlidingWindowEncoder::SetPacketSize (uint16_t packetSize)
+{
+  NS_LOG_FUNCTION (this << packetSize);
+  NS_ASSERT_MSG (packetSize > 0, "Invalid packet size");
+  m_packetSize = packetSize;
+  Reset ();
+}
+
+void
+SlidingWindowEncoder::Reset (void)
+{
+  // Sequence numbers keep counting so a receiver never sees one reused
+  m_sources.Resize (m_windowSize, 0, m_packetSize);
+  m_windowStart = m_windowEnd;
+}
+
+uint8_t *
+SlidingWindowEncoder::GetSourcePayload (uint32_t seqNum)
+{
+  return m_sources.GetPayload (seqNum % m_windowSize);
+}
+
+uint32_t
+SlidingWindowEncoder::AddPacket (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  NS_ASSERT_MSG (packet, "Cannot add null packet");
+  
+  if (m_windowEnd - m_windowStart == m_windowSize)
+    {
+      NS_LOG_INFO ("Window full, packet " << m_windowStart << " leaves the window unacknowledged");
+      m_windowStart++;
+    }
+  
+  // The new packet reuses the ring row of the one that left the window
+  uint32_t seqNum = m_windowEnd++;
+  uint8_t *payload = GetSourcePayload (seqNum);
+  uint32_t copySize = std::min (packet->GetSize (), (uint32_t)m_packetSize);
+  packet->CopyData (payload, copySize);
+  std::memset (payload + copySize, 0, m_packetSize - copySize);
+  
+  NS_LOG_INFO ("Added packet " << seqNum << ", window [" << m_windowStart
+               << ", " << m_windowEnd << ")");
+  
+  return seqNum;
+}
+
+void
+SlidingWindowEncoder::Acknowledge (uint32_t seqNum)
+{
+  NS_LOG_FUNCTION (this << seqNum);
+  
+  if (seqNum > m_windowStart)
+    {
+      m_windowStart = std::min (seqNum, m_windowEnd);
+      NS_LOG_INFO ("Window start moved to " << m_windowStart);
+    }
+}
+
+Ptr<Packet>
+SlidingWindowEncoder::GenerateCodedPacket (void)
+{
+  NS_LOG_FUNCTION (this);
+  
+  if (m_windowStart == m_windowEnd)
+    {
+      NS_LOG_WARN ("Cannot generate coded packet: window is empty");
+      return nullptr;
+    }
+  
+  uint32_t span = m_windowEnd - m_windowStart;
+  std::vector<uint8_t> coefficients (span);
+  std::vector<uint8_t> payload (m_packetSize, 0);
+  for (uint32_t i = 0; i < span; i++)
+    {
+      coefficients[i] = m_coefficientRng->GetInteger (1, 255);
+      gf::MultiplyAddRegion (payload.data (), GetSourcePayload (m_windowStart + i),
+                             coefficients[i], m_packetSize);
+    }
+  
+  Ptr<Packet> packet = Create<Packet> (payload.data (), m_packetSize);
+  NetworkCodingWindowHeader header;
+  header.SetWindow (m_windowStart, coefficients);
+  packet->AddHeader (header);
+  
+  NS_LOG_INFO ("Generated coded packet over window [" << m_windowStart
+               << ", " << m_windowEnd << ")");
+  
+  return packet;
+}
+
+Ptr<Packet>
+SlidingWindowEncoder::GenerateSourcePacket (uint32_t seqNum)
+{
+  NS_LOG_FUNCTION (this << seqNum);
+  
+  if (seqNum < m_windowStart || seqNum >= m_windowEnd)
+    {
+      NS_LOG_WARN ("Cannot generate source packet: " << seqNum << " is not in the window");
+      return nullptr;
+    }
+  
+  // The header still spans the whole window so the receiver learns where it starts
+  std::vector<uint8_t> coefficients (m_windowEnd - m_windowStart, 0);
+  coefficients[seqNum - m_windowStart] = 1;
+  
+  Ptr<Packet> packet = Create<Packet> (GetSourcePayload (seqNum), m_packetSize);
+  NetworkCodingWindowHeader header;
+  header.SetWindow (m_windowStart, coefficients);
+  packet->AddHeader (header);
+  
+  return packet;
+}
+
+uint32_t
+SlidingWindowEncoder::GetWindowStart (void) const
+{
+  return m_windowStart;
+}
+
+uint32_t
+SlidingWindowEncoder::GetWindowEnd (void) const
+{
+  return m_windowEnd;
+}
+
+int64_t
+SlidingWindowEncoder::AssignStreams (int64_t stream)
+{
+  m_coefficientRng->SetStream (stream);
+  return 1;
+}
+
+} // namespace ns3
@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SLIDING_WINDOW_ENCODER_H
+#define SLIDING_WINDOW_ENCODER_H
+
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+#include "network-coding-packet.h"
+#include "galois-field-simd.h"
+#include "generation-buffer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network-coding
+ * \brief On-the-fly (sliding-window) network coding encoder
+ *
+ * Source packets get consecutive sequence numbers and enter a coding
+ * window of at most WindowSize packets. A coded packet is a random linear
+ * combination of every packet currently in the window and carries the
+ * window bounds in a NetworkCodingWindowHeader, so there are no
+ * generations to complete. The window start moves forward when the
+ * receiver acknowledges in-order delivery, or when a new packet is added
+ * to a full window (the oldest packet then stops being protected).
+ */
+class SlidingWindowEncoder : public Object
+{
+public:
+  /**
+   * \brief Get the TypeId
+   * \return the TypeId for this class
+   */
+  static TypeId GetTypeId (void);
+
+  SlidingWindowEncoder ();
+
+  /**
+   * \brief Constructor with parameters
+   * \param windowSize Maximum number of source packets in the window
+   * \param packetSize Size of the source packets
+   */
+  SlidingWindowEncoder (uint16_t windowSize, uint16_t packetSize);
+  virtual ~SlidingWindowEncoder ();
+
+  uint16_t GetWindowSize (void) const;
+  void SetWindowSize (uint16_t windowSize);
+
+  uint16_t GetPacketSize (void) const;
+  void SetPacketSize (uint16_t packetSize);
+
+  /**
+   * \brief Append a source packet to the window
+   * \param packet The source packet (truncated or zero-padded to the packet size)
+   * \return the sequence number assigned to the packet
+   */
+  uint32_t AddPacket (Ptr<const Packet> packet);
+
+  /**
+   * \brief Remove acknowledged packets from the window
+   * \param seqNum The receiver has delivered every packet before this one
+   */
+  void Acknowledge (uint32_t seqNum);
+
+  /**
+   * \brief Combine the packets in the window
+   * \return the coded packet, or nullptr if the window is empty
+   */
+  Ptr<Packet> GenerateCodedPacket (void);
+
+  /**
+   * \brief Send one packet of the window uncoded
+   * \param seqNum Sequence number of a packet in the window
+   * \return the packet with a unit coefficient vector, or nullptr
+   */
+  Ptr<Packet> GenerateSourcePacket (uint32_t seqNum);
+
+  uint32_t GetWindowStart (void) const;
+  uint32_t GetWindowEnd (void) const;
+
+  /**
+   * \brief Assign a fixed random variable stream number
+   * \param stream First stream index to use
+   * \return the number of streams assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+private:
+  /**
+   * \brief Size the ring of source rows and empty the window
+   */
+  void Reset (void);
+
+  /**
+   * \brief Get the row holding a source packet of the window
+   * \param seqNum Sequence number, within [m_windowStart, m_windowEnd)
+   * \return the payload pointer
+   */
+  uint8_t *GetSourcePayload (uint32_t seqNum);
+
+  uint16_t m_windowSize;
+  uint16_t m_packetSize;
+  uint32_t m_windowStart;                  //!< Oldest sequence number in the window
+  uint32_t m_windowEnd;                    //!< Next sequence number to assign
+
+  GenerationBuffer m_sources;              //!< Ring of source payloads, row seq % window size
+  Ptr<UniformRandomVariable> m_coefficientRng; //!< Draws the coding coefficients
+};
+
+} // namespace ns3
+
+#endif /* SLIDING_WINDOW_ENCODER_H */
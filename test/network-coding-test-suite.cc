@@ -19,10 +19,26 @@
  */
 
 #include "network-coding-test-suite.h"
+#include "../model/galois-field-simd.h"
+#include "../model/network-coding-relay-application.h"
+#include "../helper/network-coding-helper.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/log.h"
 #include "ns3/packet.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/pointer.h"
 #include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
+#include <cstdio>
 #include <random>
+#include <sstream>
 
 namespace ns3 {
 
@@ -53,6 +69,42 @@ GaloisFieldTestCase::DoRun (void)
   TestMultiplication (gf);
   TestDivision (gf);
   TestInverse (gf);
+  TestTables ();
+}
+
+// The scalar arithmetic is usable in constant expressions
+static_assert (gf::Multiply (0x02, 0x80) == 0x1d, "GF(2^8) tables use the wrong polynomial");
+static_assert (gf::Multiply (0x57, gf::Inverse (0x57)) == 0x01, "GF(2^8) inverse failed");
+
+void
+GaloisFieldTestCase::TestTables (void)
+{
+  for (uint16_t a = 0; a < 256; a++)
+    {
+      for (uint16_t b = 0; b < 256; b++)
+        {
+          // Shift-and-add multiply with the module polynomial 0x11d
+          uint8_t x = a;
+          uint8_t product = 0;
+          for (uint8_t y = b; y != 0; y >>= 1)
+            {
+              if (y & 1)
+                {
+                  product ^= x;
+                }
+              x = (x & 0x80) ? static_cast<uint8_t> ((x << 1) ^ 0x1d) : static_cast<uint8_t> (x << 1);
+            }
+          NS_TEST_ASSERT_MSG_EQ (gf::Multiply (a, b), product, "GF(2^8) product " << a << " * " << b << " wrong");
+          if (b != 0)
+            {
+              NS_TEST_ASSERT_MSG_EQ (gf::Divide (product, b), a, "GF(2^8) quotient " << (int) product << " / " << b << " wrong");
+            }
+        }
+      if (a != 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (gf::Multiply (a, gf::Inverse (a)), 1, "GF(2^8) inverse of " << a << " wrong");
+        }
+    }
 }
 
 void
@@ -158,6 +210,309 @@ GaloisFieldTestCase::TestInverse (Ptr<GaloisField> gf)
     }
 }
 
+//-----------------------------------------------------------------------------
+// GaloisFieldRegionTestCase implementation
+//-----------------------------------------------------------------------------
+
+GaloisFieldRegionTestCase::GaloisFieldRegionTestCase ()
+  : TestCase ("GaloisField region kernels test case")
+{
+}
+
+GaloisFieldRegionTestCase::~GaloisFieldRegionTestCase ()
+{
+}
+
+void
+GaloisFieldRegionTestCase::DoRun (void)
+{
+  Ptr<GaloisField> gf = CreateObject<GaloisField> ();
+  gf::RegionKernel previous = gf::GetRegionKernel ();
+
+  const gf::RegionKernel kernels[] = {gf::KERNEL_SCALAR, gf::KERNEL_SSSE3, gf::KERNEL_AVX2,
+                                      gf::KERNEL_AVX512, gf::KERNEL_NEON};
+  // Lengths around the 16/32/64 byte vector widths, offset by one byte
+  // so that the vector loads are unaligned
+  const size_t lengths[] = {0, 1, 15, 16, 17, 33, 64, 127, 1400};
+  const uint8_t coeffs[] = {0, 1, 2, 0x53, 0xCA, 0xFF};
+
+  for (gf::RegionKernel kernel : kernels)
+    {
+      if (!gf::SelectRegionKernel (kernel))
+        {
+          continue;
+        }
+      for (size_t len : lengths)
+        {
+          std::vector<uint8_t> src (len + 1);
+          std::vector<uint8_t> dst (len + 1);
+          for (size_t i = 0; i <= len; i++)
+            {
+              src[i] = rand () % 256;
+              dst[i] = rand () % 256;
+            }
+          for (uint8_t c : coeffs)
+            {
+              std::vector<uint8_t> mulAdd (dst);
+              std::vector<uint8_t> mul (dst);
+              std::vector<uint8_t> add (dst);
+              gf::MultiplyAddRegion (mulAdd.data () + 1, src.data () + 1, c, len);
+              gf::MultiplyRegion (mul.data () + 1, c, len);
+              gf::AddRegion (add.data () + 1, src.data () + 1, len);
+
+              bool ok = (mulAdd[0] == dst[0] && mul[0] == dst[0] && add[0] == dst[0]);
+              for (size_t i = 1; i <= len; i++)
+                {
+                  ok = ok && mulAdd[i] == gf->Add (dst[i], gf->Multiply (c, src[i]));
+                  ok = ok && mul[i] == gf->Multiply (c, dst[i]);
+                  ok = ok && add[i] == gf->Add (dst[i], src[i]);
+                }
+              NS_TEST_ASSERT_MSG_EQ (ok, true, "Region kernel " << gf::GetRegionKernelName (kernel)
+                                     << " mismatch for length " << len
+                                     << " and coefficient " << (int) c);
+            }
+          for (uint8_t c = 0; c < 16; c++)
+            {
+              std::vector<uint8_t> mulAdd (dst);
+              std::vector<uint8_t> mul (dst);
+              gf::MultiplyAddRegion4 (mulAdd.data () + 1, src.data () + 1, c, len);
+              gf::MultiplyRegion4 (mul.data () + 1, c, len);
+
+              bool ok = (mulAdd[0] == dst[0] && mul[0] == dst[0]);
+              for (size_t i = 1; i <= len; i++)
+                {
+                  uint8_t lo = gf::Multiply4 (c, src[i] & 0x0f);
+                  uint8_t hi = gf::Multiply4 (c, src[i] >> 4);
+                  ok = ok && mulAdd[i] == (dst[i] ^ (hi << 4 | lo));
+                  lo = gf::Multiply4 (c, dst[i] & 0x0f);
+                  hi = gf::Multiply4 (c, dst[i] >> 4);
+                  ok = ok && mul[i] == (hi << 4 | lo);
+                }
+              NS_TEST_ASSERT_MSG_EQ (ok, true, "GF(2^4) region kernel " << gf::GetRegionKernelName (kernel)
+                                     << " mismatch for length " << len
+                                     << " and coefficient " << (int) c);
+            }
+        }
+    }
+
+  gf::SelectRegionKernel (previous);
+
+  // Striped batches give the same result as running them on one thread,
+  // including operations that read rows updated earlier in the batch
+  const size_t rowLength = 9001;
+  const uint32_t rows = 8;
+  std::vector<std::vector<uint8_t>> serial (rows, std::vector<uint8_t> (rowLength));
+  for (uint32_t r = 0; r < rows; r++)
+    {
+      for (size_t i = 0; i < rowLength; i++)
+        {
+          serial[r][i] = (r * 131 + i * 29 + (i >> 7)) & 0xff;
+        }
+    }
+  std::vector<std::vector<uint8_t>> striped (serial);
+  auto makeOps = [rows] (std::vector<std::vector<uint8_t>> &data) {
+    std::vector<gf::RegionOp> ops;
+    for (uint32_t r = 1; r < rows; r++)
+      {
+        ops.push_back ({data[r].data (), data[r - 1].data (), static_cast<uint8_t> (17 * r)});
+        ops.push_back ({data[r].data (), nullptr, static_cast<uint8_t> (r + 2)});
+      }
+    ops.push_back ({data[0].data (), data[rows - 1].data (), 0x53});
+    return ops;
+  };
+  std::vector<gf::RegionOp> serialOps = makeOps (serial);
+  gf::ApplyRegionOps<gf::Binary8> (serialOps.data (), serialOps.size (), rowLength);
+
+  size_t previousThreshold = gf::GetParallelRegionThreshold ();
+  gf::SetParallelRegionThreads (4);
+  gf::SetParallelRegionThreshold (0);
+  NS_TEST_ASSERT_MSG_EQ (gf::GetParallelRegionThreads (), 4, "Striping should use four threads");
+  std::vector<gf::RegionOp> stripedOps = makeOps (striped);
+  gf::ApplyRegionOps<gf::Binary8> (stripedOps.data (), stripedOps.size (), rowLength);
+  gf::SetParallelRegionThreads (0);
+  gf::SetParallelRegionThreshold (previousThreshold);
+  NS_TEST_ASSERT_MSG_EQ ((striped == serial), true, "Striped batch should match the serial result");
+}
+
+//-----------------------------------------------------------------------------
+// GenerationBufferTestCase implementation
+//-----------------------------------------------------------------------------
+
+GenerationBufferTestCase::GenerationBufferTestCase ()
+  : TestCase ("GenerationBuffer test case")
+{
+}
+
+GenerationBufferTestCase::~GenerationBufferTestCase ()
+{
+}
+
+void
+GenerationBufferTestCase::DoRun (void)
+{
+  GenerationBuffer buffer (5, 5, 100);
+  
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetStride () % GenerationBuffer::ALIGNMENT, 0, "Stride should be a multiple of the alignment");
+  for (uint32_t i = 0; i < buffer.GetRows (); i++)
+    {
+      uintptr_t coeffs = reinterpret_cast<uintptr_t> (buffer.GetCoefficients (i));
+      uintptr_t payload = reinterpret_cast<uintptr_t> (buffer.GetPayload (i));
+      NS_TEST_ASSERT_MSG_EQ (coeffs % GenerationBuffer::ALIGNMENT, 0, "Coefficients should be aligned");
+      NS_TEST_ASSERT_MSG_EQ (payload % GenerationBuffer::ALIGNMENT, 0, "Payload should be aligned");
+      NS_TEST_ASSERT_MSG_EQ (buffer.GetPayload (i)[buffer.GetPayloadSize () - 1], 0, "New rows should be zeroed");
+      
+      buffer.GetCoefficients (i)[0] = i;
+      buffer.GetPayload (i)[0] = 100 + i;
+    }
+  
+  // Swapping exchanges logical rows without touching their contents
+  uint8_t *row1 = buffer.GetPayload (1);
+  buffer.SwapRows (1, 3);
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetCoefficients (1)[0], 3, "Swapped row should have moved");
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetPayload (3)[0], 101, "Swapped row should have moved");
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetPayload (3), row1, "Swapping should not move row data");
+  
+  buffer.ZeroRow (3);
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetPayload (3)[0], 0, "Row should be zeroed");
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetPayload (1)[0], 103, "Other rows should be untouched");
+  
+  buffer.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetPayload (1), buffer.GetPayload (0) + buffer.GetStride (), "Clear should reset the permutation");
+}
+
+//-----------------------------------------------------------------------------
+// NetworkCodingHeaderTestCase implementation
+//-----------------------------------------------------------------------------
+
+NetworkCodingHeaderTestCase::NetworkCodingHeaderTestCase ()
+  : TestCase ("NetworkCodingHeader test case")
+{
+}
+
+NetworkCodingHeaderTestCase::~NetworkCodingHeaderTestCase ()
+{
+}
+
+void
+NetworkCodingHeaderTestCase::DoRun (void)
+{
+  const uint16_t generationSize = 128;
+  
+  // Seeded coefficients survive a round trip and cost a constant 23 bytes
+  NetworkCodingHeader seeded;
+  seeded.SetGenerationId (7);
+  seeded.SetGenerationSize (generationSize);
+  seeded.SetCoefficientSeed (0xdeadbeef, generationSize);
+  NS_TEST_ASSERT_MSG_EQ (seeded.GetSerializedSize (), 23, "Seeded header size should not depend on the generation size");
+  
+  Ptr<Packet> packet = Create<Packet> (100);
+  packet->AddHeader (seeded);
+  NetworkCodingHeader received;
+  packet->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetCoefficientFormat (), NetworkCodingHeader::SEEDED_COEFFICIENTS, "Format should be preserved");
+  NS_TEST_ASSERT_MSG_EQ (received.GetCoefficientSeed (), 0xdeadbeef, "Seed should be preserved");
+  NS_TEST_ASSERT_MSG_EQ (received.GetGenerationId (), 7, "Generation ID should be preserved");
+  NS_TEST_ASSERT_MSG_EQ ((received.GetCoefficients () == seeded.GetCoefficients ()), true, "Receiver should regenerate the same coefficients");
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 100, "Payload should be untouched");
+  
+  bool allNonZero = true;
+  for (uint8_t c : received.GetCoefficients ())
+    {
+      allNonZero = allNonZero && c != 0;
+    }
+  NS_TEST_ASSERT_MSG_EQ (allNonZero, true, "Dense coefficients should all be nonzero");
+  
+  // A partial generation only gets coefficients for the packets it has
+  seeded.SetCoefficientSeed (1, 5);
+  packet = Create<Packet> (10);
+  packet->AddHeader (seeded);
+  packet->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetCoefficients ().size (), generationSize, "Coefficients should be padded to the generation size");
+  NS_TEST_ASSERT_MSG_EQ ((int)received.GetCoefficients ()[5], 0, "Coefficients past the count should be zero");
+
+  // A seeded header cut short before its seed and density is rejected
+  Buffer truncated;
+  truncated.AddAtStart (seeded.GetSerializedSize ());
+  seeded.Serialize (truncated.Begin ());
+  truncated.RemoveAtEnd (3);
+  NS_TEST_ASSERT_MSG_EQ (received.Deserialize (truncated.Begin ()), 0, "Truncated seeded header should be rejected");
+  
+  // Explicit coefficients (e.g. from a recoding relay) still work
+  std::vector<uint8_t> coefficients (generationSize);
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      coefficients[i] = i * 3;
+    }
+  NetworkCodingHeader explicitHeader;
+  explicitHeader.SetGenerationSize (generationSize);
+  explicitHeader.SetCoefficients (coefficients);
+  NS_TEST_ASSERT_MSG_EQ (explicitHeader.GetSerializedSize (), 18u + generationSize, "Explicit header carries one byte per packet");
+  packet = Create<Packet> (10);
+  packet->AddHeader (explicitHeader);
+  packet->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetCoefficientFormat (), NetworkCodingHeader::EXPLICIT_COEFFICIENTS, "Format should be preserved");
+  NS_TEST_ASSERT_MSG_EQ ((received.GetCoefficients () == coefficients), true, "Explicit coefficients should be preserved");
+  
+  // Small fields pack their explicit coefficients
+  std::vector<uint8_t> bits (generationSize);
+  std::vector<uint8_t> nibbles (generationSize);
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      bits[i] = (i * 7 / 3) & 1;
+      nibbles[i] = (i * 5) & 0x0f;
+    }
+  explicitHeader.SetField (gf::FIELD_BINARY);
+  explicitHeader.SetCoefficients (bits);
+  NS_TEST_ASSERT_MSG_EQ (explicitHeader.GetSerializedSize (), 18u + generationSize / 8, "GF(2) coefficients should be bit-packed");
+  packet = Create<Packet> (10);
+  packet->AddHeader (explicitHeader);
+  packet->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetField (), gf::FIELD_BINARY, "Field should be preserved");
+  NS_TEST_ASSERT_MSG_EQ ((received.GetCoefficients () == bits), true, "GF(2) coefficients should be preserved");
+  
+  explicitHeader.SetField (gf::FIELD_BINARY4);
+  explicitHeader.SetCoefficients (nibbles);
+  NS_TEST_ASSERT_MSG_EQ (explicitHeader.GetSerializedSize (), 18u + generationSize / 2, "GF(2^4) coefficients should be nibble-packed");
+  packet = Create<Packet> (10);
+  packet->AddHeader (explicitHeader);
+  packet->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ ((received.GetCoefficients () == nibbles), true, "GF(2^4) coefficients should be preserved");
+  
+  // Rank feedback survives the control header round trip
+  NetworkCodingControlHeader report (NetworkCodingControlHeader::INNOVATIVE_ACK, 7);
+  report.SetRank (13);
+  report.SetPacketsReceived (15);
+  report.SetHopAckSequence (18);
+  report.SetHopAckBitmap (0x8000000000000005ull);
+  packet = Create<Packet> ();
+  packet->AddHeader (report);
+  NetworkCodingControlHeader feedback;
+  packet->RemoveHeader (feedback);
+  NS_TEST_ASSERT_MSG_EQ (feedback.GetControlType (), NetworkCodingControlHeader::INNOVATIVE_ACK, "Control type should be preserved");
+  NS_TEST_ASSERT_MSG_EQ (feedback.GetGenerationId (), 7, "Generation ID should be preserved");
+  NS_TEST_ASSERT_MSG_EQ (feedback.GetRank (), 13, "Rank should be preserved");
+  NS_TEST_ASSERT_MSG_EQ (feedback.GetPacketsReceived (), 15, "Received count should be preserved");
+  NS_TEST_ASSERT_MSG_EQ (feedback.GetHopAckSequence (), 18, "Highest sequence should be preserved");
+  NS_TEST_ASSERT_MSG_EQ (feedback.GetHopAckBitmap (), 0x8000000000000005ull, "Hop ACK bitmap should be preserved");
+  
+  // Sparse draws honour the density on average
+  std::vector<uint8_t> sparse (10000);
+  CoefficientGenerator::Generate (42, 51, sparse.data (), sparse.size ());
+  uint32_t nonZero = 0;
+  for (uint8_t c : sparse)
+    {
+      nonZero += (c != 0);
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (nonZero / 10000.0, 0.2, 0.02, "Density 51/255 should give about 20% nonzero coefficients");
+
+  // The Density attribute only accepts densities a header can carry
+  Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> ();
+  NS_TEST_ASSERT_MSG_EQ (encoder->SetAttributeFailSafe ("Density", DoubleValue (0.0)), false,
+                         "Density 0 should be rejected");
+  NS_TEST_ASSERT_MSG_EQ (encoder->SetAttributeFailSafe ("Density", DoubleValue (1.0 / 255)), true,
+                         "Density 1/255 should be accepted");
+}
+
 //-----------------------------------------------------------------------------
 // NetworkCodingTestCase implementation
 //-----------------------------------------------------------------------------
@@ -178,6 +533,61 @@ NetworkCodingTestCase::DoRun (void)
   TestCoding (64, 4);
   TestCoding (1024, 8);
   TestCoding (1500, 16);
+  TestCoding (1400, 128);
+  
+  // Test generations beyond 255 packets, with tiled payload elimination
+  TestCoding (8192, 300);
+  TestParsedHeader (1400, 300);
+  TestDeferredSubstitution (8192, 300, gf::FIELD_BINARY8);
+  
+  // Test rank tracking with redundant packets
+  TestRedundantPackets (256, 6);
+  
+  // Test systematic transmission with coded repairs
+  TestSystematic (512, 8);
+  
+  // Test sparse codes
+  TestSparseCoding (256, 64, 0.1);
+  TestSparseCoding (256, 128, 0.03);
+  
+  // Test the pre-parsed header path
+  TestParsedHeader (1024, 16);
+  
+  // Test the small fields
+  TestFieldCoding (1024, 16, gf::FIELD_BINARY);
+  TestFieldCoding (1024, 16, gf::FIELD_BINARY4);
+  TestFieldCoding (1400, 64, gf::FIELD_BINARY);
+  
+  // Test deferred substitution on worker threads
+  TestDeferredSubstitution (1024, 16, gf::FIELD_BINARY8);
+  TestDeferredSubstitution (512, 64, gf::FIELD_BINARY);
+  TestDeferredSubstitution (512, 32, gf::FIELD_BINARY4);
+  
+  // Test coder reuse across generations
+  TestReuse (256, 16);
+  
+  // Test batched generation, including payloads spanning several blocks
+  TestBatchedCoding (1024, 16, gf::FIELD_BINARY8);
+  TestBatchedCoding (9001, 8, gf::FIELD_BINARY8);
+  TestBatchedCoding (1000, 32, gf::FIELD_BINARY4);
+  TestBatchedCoding (1000, 32, gf::FIELD_BINARY);
+  
+  // Test partial decoding before full rank
+  TestPartialDecoding (512, 8, false);
+  TestPartialDecoding (512, 8, true);
+  
+  // Test decoding recurring coefficient patterns with cached inverses
+  TestInverseCache (512, 16, gf::FIELD_BINARY8, false);
+  TestInverseCache (512, 16, gf::FIELD_BINARY8, true);
+  TestInverseCache (300, 32, gf::FIELD_BINARY4, false);
+  TestInverseCache (300, 32, gf::FIELD_BINARY, true);
+  
+  // Test the codecs specialized for fixed sizes
+  TestFixedCodec<gf::Binary8, 32, 1400> ();
+  TestFixedCodec<gf::Binary4, 16, 1024> ();
+  TestFixedCodec<gf::Binary, 64, 1400> ();
+  TestCoding (1400, 32);
+  TestFieldCoding (1024, 32, gf::FIELD_BINARY4);
   
   // Test with packet loss
   TestCodingWithLoss (1024, 8, 0.1);
@@ -334,6 +744,1866 @@ NetworkCodingTestCase::TestCodingWithLoss (uint32_t packetSize, uint16_t generat
   NS_TEST_ASSERT_MSG_EQ (decodedPackets.size (), generationSize, "Number of decoded packets doesn't match generation size");
 }
 
+void
+NetworkCodingTestCase::TestRedundantPackets (uint32_t packetSize, uint16_t generationSize)
+{
+  Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> (generationSize, packetSize);
+  Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      for (uint32_t j = 0; j < packetSize; j++)
+        {
+          buffer[j] = (i * 31 + j) % 256;
+        }
+      encoder->AddPacket (Create<Packet> (buffer.data (), packetSize), i);
+    }
+  
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      Ptr<Packet> codedPacket = encoder->GenerateCodedPacket ();
+      
+      bool innovative = decoder->ProcessCodedPacket (codedPacket);
+      NS_TEST_ASSERT_MSG_EQ (innovative, true, "First copy of a coded packet should be innovative");
+      NS_TEST_ASSERT_MSG_EQ (decoder->GetRank (), i + 1, "Rank should grow with each innovative packet");
+      
+      if (!decoder->CanDecode ())
+        {
+          // The same packet again carries no new information
+          innovative = decoder->ProcessCodedPacket (codedPacket);
+          NS_TEST_ASSERT_MSG_EQ (innovative, false, "Duplicate coded packet should not be innovative");
+          NS_TEST_ASSERT_MSG_EQ (decoder->GetRank (), i + 1, "Duplicate packet should not change the rank");
+        }
+    }
+  
+  NS_TEST_ASSERT_MSG_EQ (decoder->CanDecode (), true, "Decoder should reach full rank");
+  NS_TEST_ASSERT_MSG_EQ (decoder->GetDecodedPackets ().size (), generationSize, "Number of decoded packets doesn't match generation size");
+}
+
+void
+NetworkCodingTestCase::TestSystematic (uint32_t packetSize, uint16_t generationSize)
+{
+  Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> (generationSize, packetSize);
+  Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  encoder->SetSystematic (true);
+  
+  std::vector<std::vector<uint8_t>> originalData;
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      for (uint32_t j = 0; j < packetSize; j++)
+        {
+          buffer[j] = (i * 53 + j * 3) % 256;
+        }
+      originalData.push_back (buffer);
+      encoder->AddPacket (Create<Packet> (buffer.data (), packetSize), i);
+    }
+  
+  // The first generationSize packets are the sources with identity coefficients
+  std::vector<Ptr<Packet>> uncoded;
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      Ptr<Packet> packet = encoder->GeneratePacket ();
+      NetworkCodingHeader header;
+      packet->PeekHeader (header);
+      const std::vector<uint8_t> &coefficients = header.GetCoefficients ();
+      for (uint16_t j = 0; j < generationSize; j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ ((int)coefficients[j], (i == j) ? 1 : 0, "Systematic packet should carry a unit vector");
+        }
+      uncoded.push_back (packet);
+    }
+  
+  // Lose every third uncoded packet
+  uint16_t expectedRank = 0;
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      if (i % 3 == 1)
+        {
+          continue;
+        }
+      NS_TEST_ASSERT_MSG_EQ (decoder->ProcessCodedPacket (uncoded[i]), true, "Uncoded packet should be innovative");
+      expectedRank++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (decoder->GetRank (), expectedRank, "Rank should count the uncoded packets received");
+  
+  // A duplicate uncoded packet is rejected without changing the state
+  NS_TEST_ASSERT_MSG_EQ (decoder->ProcessCodedPacket (uncoded[0]), false, "Duplicate uncoded packet should not be innovative");
+  NS_TEST_ASSERT_MSG_EQ (decoder->GetRank (), expectedRank, "Duplicate uncoded packet should not change the rank");
+  
+  // Coded repair packets fill the gaps
+  uint32_t repairs = 0;
+  while (!decoder->CanDecode () && repairs < 4u * generationSize)
+    {
+      decoder->ProcessCodedPacket (encoder->GeneratePacket ());
+      repairs++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (decoder->CanDecode (), true, "Repair packets should complete the generation");
+  
+  // Uncoded packets arriving after coded ones still decode correctly
+  Ptr<NetworkCodingDecoder> mixed = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  mixed->ProcessCodedPacket (encoder->GenerateCodedPacket ());
+  for (uint16_t i = 0; i < generationSize && !mixed->CanDecode (); i++)
+    {
+      mixed->ProcessCodedPacket (uncoded[i]);
+    }
+  NS_TEST_ASSERT_MSG_EQ (mixed->CanDecode (), true, "Coded plus uncoded packets should complete the generation");
+  
+  std::vector<Ptr<Packet>> decodedPackets = decoder->GetDecodedPackets ();
+  std::vector<Ptr<Packet>> mixedPackets = mixed->GetDecodedPackets ();
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      decodedPackets[i]->CopyData (buffer.data (), packetSize);
+      NS_TEST_ASSERT_MSG_EQ ((buffer == originalData[i]), true, "Decoded packet " << i << " doesn't match original");
+      mixedPackets[i]->CopyData (buffer.data (), packetSize);
+      NS_TEST_ASSERT_MSG_EQ ((buffer == originalData[i]), true, "Decoded packet " << i << " doesn't match original after mixed reception");
+    }
+}
+
+void
+NetworkCodingTestCase::TestSparseCoding (uint32_t packetSize, uint16_t generationSize, double density)
+{
+  Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> (generationSize, packetSize);
+  Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  encoder->SetDensity (density);
+  
+  std::vector<std::vector<uint8_t>> originalData;
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      for (uint32_t j = 0; j < packetSize; j++)
+        {
+          buffer[j] = (i * 7 + j * 11) % 256;
+        }
+      originalData.push_back (buffer);
+      encoder->AddPacket (Create<Packet> (buffer.data (), packetSize), i);
+    }
+  
+  uint32_t sent = 0;
+  uint32_t nonZero = 0;
+  while (!decoder->CanDecode () && sent < 4u * generationSize)
+    {
+      Ptr<Packet> codedPacket = encoder->GenerateCodedPacket ();
+      NetworkCodingHeader header;
+      codedPacket->PeekHeader (header);
+      for (uint8_t c : header.GetCoefficients ())
+        {
+          nonZero += (c != 0);
+        }
+      decoder->ProcessCodedPacket (codedPacket);
+      sent++;
+    }
+  
+  NS_TEST_ASSERT_MSG_EQ (decoder->CanDecode (), true, "Sparse code should decode");
+  NS_TEST_ASSERT_MSG_LT (nonZero, sent * generationSize * std::max (2 * density, 0.05) + sent,
+                         "Coded packets should be sparse");
+  
+  std::vector<Ptr<Packet>> decodedPackets = decoder->GetDecodedPackets ();
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      decodedPackets[i]->CopyData (buffer.data (), packetSize);
+      NS_TEST_ASSERT_MSG_EQ ((buffer == originalData[i]), true, "Decoded packet " << i << " doesn't match original");
+    }
+}
+
+void
+NetworkCodingTestCase::TestFieldCoding (uint32_t packetSize, uint16_t generationSize, gf::FieldType field)
+{
+  Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> (generationSize, packetSize);
+  Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  encoder->SetField (field);
+  decoder->SetField (field);
+  
+  std::vector<std::vector<uint8_t>> originalData;
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      for (uint32_t j = 0; j < packetSize; j++)
+        {
+          buffer[j] = (i * 13 + j * 5) % 256;
+        }
+      originalData.push_back (buffer);
+      encoder->AddPacket (Create<Packet> (buffer.data (), packetSize), i);
+    }
+  
+  // Small fields see more linearly dependent packets, GF(2) about two extra
+  uint32_t sent = 0;
+  while (!decoder->CanDecode () && sent < 4u * generationSize)
+    {
+      Ptr<Packet> codedPacket = encoder->GenerateCodedPacket ();
+      NetworkCodingHeader header;
+      codedPacket->PeekHeader (header);
+      NS_TEST_ASSERT_MSG_EQ (header.GetField (), field, "Header should carry the encoder's field");
+      decoder->ProcessCodedPacket (codedPacket);
+      sent++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (decoder->CanDecode (), true, "Should decode in GF(2^" << field << ")");
+  
+  std::vector<Ptr<Packet>> decodedPackets = decoder->GetDecodedPackets ();
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      decodedPackets[i]->CopyData (buffer.data (), packetSize);
+      NS_TEST_ASSERT_MSG_EQ ((buffer == originalData[i]), true, "Decoded packet " << i << " doesn't match original");
+    }
+  
+  // A decoder in another field must not take the packets
+  Ptr<NetworkCodingDecoder> other = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  NS_TEST_ASSERT_MSG_EQ (other->ProcessCodedPacket (encoder->GenerateCodedPacket ()), false,
+                         "Field mismatch should be rejected");
+}
+
+template <class Field, uint16_t GenSize, uint16_t SymbolSize>
+void
+NetworkCodingTestCase::TestFixedCodec (void)
+{
+  typedef gf::CodecT<Field, GenSize, SymbolSize> Fixed;
+  typedef gf::CodecT<Field> Generic;
+  
+  uint32_t sizes = gf::DispatchCodec (Field::TYPE, GenSize, SymbolSize, [] (auto codec) {
+    return decltype (codec)::GENERATION_SIZE * 100000u + decltype (codec)::SYMBOL_SIZE;
+  });
+  NS_TEST_ASSERT_MSG_EQ (sizes, GenSize * 100000u + SymbolSize, "The fixed codec should be picked");
+  sizes = gf::DispatchCodec (Field::TYPE, GenSize + 1, SymbolSize, [] (auto codec) {
+    return decltype (codec)::GENERATION_SIZE * 100000u + decltype (codec)::SYMBOL_SIZE;
+  });
+  NS_TEST_ASSERT_MSG_EQ (sizes, 0, "Other sizes should get the generic codec");
+  
+  // Whole-row coefficient updates match the span ones for rows that are
+  // zero outside their span
+  std::mt19937 rng (GenSize + SymbolSize);
+  GenerationBuffer rows (4, GenSize, SymbolSize);
+  for (uint32_t trial = 0; trial < 50; trial++)
+    {
+      uint32_t begin = rng () % GenSize;
+      uint32_t end = begin + 1 + rng () % (GenSize - begin);
+      uint8_t coeff = rng () % (Field::MAX_ELEMENT + 1);
+      for (uint32_t r = 0; r < 4; r++)
+        {
+          rows.ZeroRow (r);
+        }
+      for (uint32_t j = 0; j < GenSize; j++)
+        {
+          uint8_t value = rng () % (Field::MAX_ELEMENT + 1);
+          rows.GetCoefficients (0)[j] = value;
+          rows.GetCoefficients (1)[j] = value;
+          if (j >= begin && j < end)
+            {
+              rows.GetCoefficients (2)[j] = rng () % (Field::MAX_ELEMENT + 1);
+              rows.GetCoefficients (3)[j] = rows.GetCoefficients (2)[j];
+            }
+        }
+      Fixed::MultiplyAddCoefficients (rows.GetCoefficients (0), rows.GetCoefficients (2), coeff, begin, end);
+      Generic::MultiplyAddCoefficients (rows.GetCoefficients (1), rows.GetCoefficients (2), coeff, begin, end);
+      Fixed::MultiplyCoefficients (rows.GetCoefficients (2), coeff, begin, end);
+      Generic::MultiplyCoefficients (rows.GetCoefficients (3), coeff, begin, end);
+      NS_TEST_ASSERT_MSG_EQ (std::equal (rows.GetCoefficients (0), rows.GetCoefficients (0) + GenSize,
+                                         rows.GetCoefficients (1)), true,
+                             "Fixed and generic multiply-add differ");
+      NS_TEST_ASSERT_MSG_EQ (std::equal (rows.GetCoefficients (2), rows.GetCoefficients (2) + GenSize,
+                                         rows.GetCoefficients (3)), true,
+                             "Fixed and generic multiply differ");
+      
+      // Payload batches over the padded rows leave the same packets
+      for (uint32_t j = 0; j < SymbolSize; j++)
+        {
+          rows.GetPayload (0)[j] = rows.GetPayload (1)[j] = rng ();
+          rows.GetPayload (2)[j] = rng ();
+        }
+      gf::RegionOp fixedOps[] = {{rows.GetPayload (0), rows.GetPayload (2), coeff}, {rows.GetPayload (0), nullptr, 3}};
+      gf::RegionOp genericOps[] = {{rows.GetPayload (1), rows.GetPayload (2), coeff}, {rows.GetPayload (1), nullptr, 3}};
+      Fixed::ApplyPayloadOps (fixedOps, 2, SymbolSize);
+      Generic::ApplyPayloadOps (genericOps, 2, SymbolSize);
+      NS_TEST_ASSERT_MSG_EQ (std::equal (rows.GetPayload (0), rows.GetPayload (0) + SymbolSize, rows.GetPayload (1)),
+                             true, "Fixed and generic payload batches differ");
+    }
+}
+
+void
+NetworkCodingTestCase::TestParsedHeader (uint32_t packetSize, uint16_t generationSize)
+{
+  const uint32_t generationId = 5;
+  Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> (generationSize, packetSize);
+  Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  encoder->SetSystematic (true);
+  for (uint32_t i = 0; i < generationId; i++)
+    {
+      decoder->NextGeneration ();
+    }
+  
+  std::vector<std::vector<uint8_t>> originalData;
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      for (uint32_t j = 0; j < packetSize; j++)
+        {
+          buffer[j] = (i * 17 + j * 3) % 256;
+        }
+      originalData.push_back (buffer);
+      encoder->AddPacket (Create<Packet> (buffer.data (), packetSize), i);
+    }
+  
+  // The encoder itself is still at generation 0; the ID comes from the caller.
+  // Drop every other source packet so that coded repairs are needed too.
+  uint32_t sent = 0;
+  while (!decoder->CanDecode () && sent < 4u * generationSize)
+    {
+      Ptr<Packet> packet = encoder->GeneratePacket (generationId);
+      sent++;
+      if (sent <= generationSize && sent % 2 == 0)
+        {
+          continue;
+        }
+      NetworkCodingHeader header;
+      packet->RemoveHeader (header);
+      NS_TEST_ASSERT_MSG_EQ (header.GetGenerationId (), generationId, "Header should carry the requested generation ID");
+      NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), packetSize, "Only the payload should be left");
+      decoder->ProcessCodedPacket (packet, header);
+    }
+  NS_TEST_ASSERT_MSG_EQ (decoder->CanDecode (), true, "Should decode from pre-parsed headers");
+  
+  std::vector<Ptr<Packet>> decodedPackets = decoder->GetDecodedPackets ();
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      decodedPackets[i]->CopyData (buffer.data (), packetSize);
+      NS_TEST_ASSERT_MSG_EQ ((buffer == originalData[i]), true, "Decoded packet " << i << " doesn't match original");
+    }
+}
+
+void
+NetworkCodingTestCase::TestDeferredSubstitution (uint32_t packetSize, uint16_t generationSize,
+                                                 gf::FieldType field)
+{
+  // Several generations, each systematic with a few source packets lost so
+  // that unit and coded pivot rows are mixed
+  const uint32_t generations = 6;
+  std::mt19937 gen (7);
+  std::vector<std::vector<std::vector<uint8_t>>> originalData (generations);
+  std::vector<Ptr<NetworkCodingDecoder>> decoders;
+  for (uint32_t g = 0; g < generations; g++)
+    {
+      Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> (generationSize, packetSize);
+      Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+      encoder->SetField (field);
+      encoder->SetSystematic (true);
+      decoder->SetField (field);
+      decoder->SetDeferredSubstitution (true);
+      for (uint16_t i = 0; i < generationSize; i++)
+        {
+          std::vector<uint8_t> buffer (packetSize);
+          for (uint32_t j = 0; j < packetSize; j++)
+            {
+              buffer[j] = (g * 31 + i * 13 + j * 5) % 256;
+            }
+          originalData[g].push_back (buffer);
+          encoder->AddPacket (Create<Packet> (buffer.data (), packetSize), i);
+        }
+      
+      uint32_t sent = 0;
+      while (!decoder->CanDecode () && sent < 4u * generationSize)
+        {
+          Ptr<Packet> packet = encoder->GeneratePacket ();
+          if (gen () % 4 != 0)
+            {
+              decoder->ProcessCodedPacket (packet);
+            }
+          sent++;
+        }
+      NS_TEST_ASSERT_MSG_EQ (decoder->CanDecode (), true, "Generation " << g << " should reach full rank");
+      decoders.push_back (decoder);
+    }
+  
+  // Solve all generations concurrently; the pool finishes its queue
+  // before the destructor joins the workers
+  {
+    DecodingWorkerPool pool (3);
+    std::vector<std::future<void>> solved;
+    for (Ptr<NetworkCodingDecoder> decoder : decoders)
+      {
+        NetworkCodingDecoder *solver = PeekPointer (decoder);
+        solved.push_back (pool.Submit ([solver] () { solver->Solve (); }));
+      }
+    for (std::future<void> &done : solved)
+      {
+        done.wait ();
+      }
+  }
+  
+  for (uint32_t g = 0; g < generations; g++)
+    {
+      std::vector<Ptr<Packet>> decodedPackets = decoders[g]->GetDecodedPackets ();
+      NS_TEST_ASSERT_MSG_EQ (decodedPackets.size (), generationSize, "Generation " << g << " should decode");
+      for (uint16_t i = 0; i < generationSize; i++)
+        {
+          std::vector<uint8_t> buffer (packetSize);
+          decodedPackets[i]->CopyData (buffer.data (), packetSize);
+          NS_TEST_ASSERT_MSG_EQ ((buffer == originalData[g][i]), true,
+                                 "Packet " << i << " of generation " << g << " doesn't match original");
+        }
+    }
+}
+
+void
+NetworkCodingTestCase::TestReuse (uint32_t packetSize, uint16_t generationSize)
+{
+  // Stale pivot rows from the previous generation must not leak into the
+  // next one, so every generation is decoded from coded packets only
+  Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> (generationSize, packetSize);
+  Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  for (uint32_t g = 0; g < 4; g++)
+    {
+      if (g > 0)
+        {
+          encoder->NextGeneration ();
+          decoder->NextGeneration ();
+        }
+      NS_TEST_ASSERT_MSG_EQ (decoder->GetRank (), 0, "Reused decoder should start empty");
+      
+      std::vector<std::vector<uint8_t>> originalData;
+      for (uint16_t i = 0; i < generationSize; i++)
+        {
+          std::vector<uint8_t> buffer (packetSize);
+          for (uint32_t j = 0; j < packetSize; j++)
+            {
+              buffer[j] = (g * 59 + i * 17 + j * 3) % 256;
+            }
+          originalData.push_back (buffer);
+          encoder->AddPacket (Create<Packet> (buffer.data (), packetSize), i);
+        }
+      
+      uint32_t sent = 0;
+      while (!decoder->CanDecode () && sent < 4u * generationSize)
+        {
+          decoder->ProcessCodedPacket (encoder->GenerateCodedPacket ());
+          sent++;
+        }
+      
+      std::vector<Ptr<Packet>> decodedPackets = decoder->GetDecodedPackets ();
+      NS_TEST_ASSERT_MSG_EQ (decodedPackets.size (), generationSize, "Generation " << g << " should decode");
+      for (uint16_t i = 0; i < generationSize; i++)
+        {
+          std::vector<uint8_t> buffer (packetSize);
+          decodedPackets[i]->CopyData (buffer.data (), packetSize);
+          NS_TEST_ASSERT_MSG_EQ ((buffer == originalData[i]), true,
+                                 "Packet " << i << " of generation " << g << " doesn't match original");
+        }
+    }
+}
+
+void
+NetworkCodingTestCase::TestBatchedCoding (uint32_t packetSize, uint16_t generationSize,
+                                          gf::FieldType field)
+{
+  // Two encoders with the same sources and random stream must produce the
+  // same packets whether they are generated one by one or in a batch
+  Ptr<NetworkCodingEncoder> single = CreateObject<NetworkCodingEncoder> (generationSize, packetSize);
+  Ptr<NetworkCodingEncoder> batched = CreateObject<NetworkCodingEncoder> (generationSize, packetSize);
+  Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  single->AssignStreams (11);
+  batched->AssignStreams (11);
+  single->SetField (field);
+  batched->SetField (field);
+  decoder->SetField (field);
+  std::vector<std::vector<uint8_t>> originalData;
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      for (uint32_t j = 0; j < packetSize; j++)
+        {
+          buffer[j] = (i * 29 + j * 11) % 256;
+        }
+      originalData.push_back (buffer);
+      single->AddPacket (Create<Packet> (buffer.data (), packetSize), i);
+      batched->AddPacket (Create<Packet> (buffer.data (), packetSize), i);
+    }
+  
+  uint32_t count = 2u * generationSize;
+  std::vector<Ptr<Packet>> packets = batched->GenerateCodedPackets (count);
+  NS_TEST_ASSERT_MSG_EQ (packets.size (), count, "Batch should hold the requested packets");
+  for (uint32_t k = 0; k < count; k++)
+    {
+      Ptr<Packet> expected = single->GenerateCodedPacket ();
+      NS_TEST_ASSERT_MSG_EQ (packets[k]->GetSize (), expected->GetSize (), "Batched packet " << k << " has the wrong size");
+      std::vector<uint8_t> a (expected->GetSize ());
+      std::vector<uint8_t> b (packets[k]->GetSize ());
+      expected->CopyData (a.data (), a.size ());
+      packets[k]->CopyData (b.data (), b.size ());
+      NS_TEST_ASSERT_MSG_EQ ((a == b), true, "Batched packet " << k << " differs from the single one");
+      decoder->ProcessCodedPacket (packets[k]);
+    }
+  
+  NS_TEST_ASSERT_MSG_EQ (decoder->CanDecode (), true, "Batched packets should decode");
+  std::vector<Ptr<Packet>> decodedPackets = decoder->GetDecodedPackets ();
+  NS_TEST_ASSERT_MSG_EQ (decodedPackets.size (), generationSize, "Number of decoded packets doesn't match generation size");
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      decodedPackets[i]->CopyData (buffer.data (), packetSize);
+      NS_TEST_ASSERT_MSG_EQ ((buffer == originalData[i]), true, "Packet " << i << " doesn't match original");
+    }
+}
+
+void
+NetworkCodingTestCase::TestPartialDecoding (uint32_t packetSize, uint16_t generationSize, bool deferred)
+{
+  Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  decoder->SetPartialDecoding (true);
+  decoder->SetDeferredSubstitution (deferred);
+  
+  std::vector<std::vector<uint8_t>> originalData;
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      for (uint32_t j = 0; j < packetSize; j++)
+        {
+          buffer[j] = (i * 41 + j * 7) % 256;
+        }
+      originalData.push_back (buffer);
+    }
+  
+  // Hand-built GF(2^8) combinations, so it is known which rows are solved
+  auto send = [&] (const std::vector<uint8_t> &coeffs) {
+    std::vector<uint8_t> payload (packetSize, 0);
+    for (uint16_t i = 0; i < generationSize; i++)
+      {
+        for (uint32_t j = 0; coeffs[i] && j < packetSize; j++)
+          {
+            payload[j] ^= gf::Multiply (coeffs[i], originalData[i][j]);
+          }
+      }
+    NetworkCodingHeader header;
+    header.SetGenerationId (0);
+    header.SetCoefficients (coeffs);
+    return decoder->ProcessCodedPacket (Create<Packet> (payload.data (), packetSize), header);
+  };
+  auto matches = [&] (uint16_t index) {
+    Ptr<Packet> symbol = decoder->GetDecodedSymbol (index);
+    if (!symbol)
+      {
+        return false;
+      }
+    std::vector<uint8_t> buffer (packetSize);
+    symbol->CopyData (buffer.data (), packetSize);
+    return buffer == originalData[index];
+  };
+  
+  // A scaled uncoded packet is solved on arrival
+  std::vector<uint8_t> coeffs (generationSize, 0);
+  coeffs[0] = 3;
+  send (coeffs);
+  NS_TEST_ASSERT_MSG_EQ (decoder->GetDecodedSymbolCount (), 1, "Uncoded packet should be solved at once");
+  NS_TEST_ASSERT_MSG_EQ (matches (0), true, "Symbol 0 should be the source packet");
+  
+  // x1 + x2 alone solves nothing
+  coeffs.assign (generationSize, 0);
+  coeffs[1] = 1;
+  coeffs[2] = 1;
+  send (coeffs);
+  NS_TEST_ASSERT_MSG_EQ (decoder->GetDecodedSymbolCount (), 1, "A mixture of two unknowns is not solved");
+  NS_TEST_ASSERT_MSG_EQ (decoder->IsSymbolDecoded (1), false, "Symbol 1 is not known yet");
+  NS_TEST_ASSERT_MSG_EQ ((decoder->GetDecodedSymbol (1) == nullptr), true, "Unknown symbols are not returned");
+  
+  // 5 x2 solves x2 and, once substituted, x1
+  coeffs.assign (generationSize, 0);
+  coeffs[2] = 5;
+  send (coeffs);
+  NS_TEST_ASSERT_MSG_EQ (decoder->IsSymbolDecoded (2), true, "Symbol 2 should be solved");
+  NS_TEST_ASSERT_MSG_EQ (matches (2), true, "Symbol 2 should be the source packet");
+  if (deferred)
+    {
+      NS_TEST_ASSERT_MSG_EQ (decoder->IsSymbolDecoded (1), false, "Deferred rows are not substituted");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_EQ (decoder->IsSymbolDecoded (1), true, "Substitution should solve symbol 1");
+      NS_TEST_ASSERT_MSG_EQ (matches (1), true, "Symbol 1 should be the source packet");
+    }
+  
+  // A mixture of the rest, then the rest uncoded but the last one
+  coeffs.assign (generationSize, 0);
+  for (uint16_t i = 3; i < generationSize; i++)
+    {
+      coeffs[i] = i;
+    }
+  send (coeffs);
+  uint16_t known = decoder->GetDecodedSymbolCount ();
+  for (uint16_t i = 3; i + 1 < generationSize; i++)
+    {
+      coeffs.assign (generationSize, 0);
+      coeffs[i] = 1;
+      send (coeffs);
+    }
+  NS_TEST_ASSERT_MSG_EQ (decoder->CanDecode (), true, "Generation should have full rank");
+  if (!deferred)
+    {
+      NS_TEST_ASSERT_MSG_EQ (known, 3, "The mixture solves nothing");
+      NS_TEST_ASSERT_MSG_EQ (decoder->GetDecodedSymbolCount (), generationSize, "Every symbol should be solved");
+      NS_TEST_ASSERT_MSG_EQ (matches (generationSize - 1), true, "Last symbol should be the source packet");
+    }
+  std::vector<Ptr<Packet>> decodedPackets = decoder->GetDecodedPackets ();
+  NS_TEST_ASSERT_MSG_EQ (decodedPackets.size (), generationSize, "Generation should decode");
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (matches (i), true, "Decoded symbol " << i << " doesn't match original");
+    }
+  
+  // Nothing carries over to the next generation
+  decoder->NextGeneration ();
+  NS_TEST_ASSERT_MSG_EQ (decoder->GetDecodedSymbolCount (), 0, "New generation starts with no symbols");
+  NS_TEST_ASSERT_MSG_EQ (decoder->IsSymbolDecoded (0), false, "Symbols of the old generation are forgotten");
+}
+
+//-----------------------------------------------------------------------------
+// SlidingWindowTestCase implementation
+//-----------------------------------------------------------------------------
+
+SlidingWindowTestCase::SlidingWindowTestCase ()
+  : TestCase ("Sliding-window network coding test case")
+{
+}
+
+SlidingWindowTestCase::~SlidingWindowTestCase ()
+{
+}
+
+void
+NetworkCodingTestCase::TestInverseCache (uint32_t packetSize, uint16_t generationSize,
+                                         gf::FieldType field, bool deferred)
+{
+  // Generations 0-3 and 5 lose the same coded packets and so receive the
+  // same matrix; generation 4 loses others, which leaves the cached pattern
+  // after its first row
+  Ptr<DecodingInverseCache> cache = Create<DecodingInverseCache> (4);
+  Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> (generationSize, packetSize);
+  Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  encoder->SetField (field);
+  encoder->SetRepeatCoefficients (true);
+  decoder->SetField (field);
+  decoder->SetDeferredSubstitution (deferred);
+  decoder->SetInverseCache (cache);
+  const uint32_t generations = 6;
+  for (uint32_t g = 0; g < generations; g++)
+    {
+      if (g > 0)
+        {
+          encoder->NextGeneration ();
+          decoder->NextGeneration ();
+        }
+      std::vector<std::vector<uint8_t>> originalData;
+      for (uint16_t i = 0; i < generationSize; i++)
+        {
+          std::vector<uint8_t> buffer (packetSize);
+          for (uint32_t j = 0; j < packetSize; j++)
+            {
+              buffer[j] = (g * 41 + i * 7 + j * 11) % 256;
+            }
+          originalData.push_back (buffer);
+          encoder->AddPacket (Create<Packet> (buffer.data (), packetSize), i);
+        }
+      
+      uint32_t sent = 0;
+      while (!decoder->CanDecode () && sent < 8u * generationSize)
+        {
+          Ptr<Packet> packet = encoder->GenerateCodedPacket ();
+          sent++;
+          bool lost = (g == 4) ? (sent == 2 || sent == 3) : (sent == 3 || sent == 6);
+          if (!lost)
+            {
+              decoder->ProcessCodedPacket (packet);
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (decoder->CanDecode (), true, "Generation " << g << " should reach full rank");
+      decoder->Solve ();
+      
+      std::vector<Ptr<Packet>> decodedPackets = decoder->GetDecodedPackets ();
+      NS_TEST_ASSERT_MSG_EQ (decodedPackets.size (), generationSize, "Generation " << g << " should decode");
+      for (uint16_t i = 0; i < decodedPackets.size (); i++)
+        {
+          std::vector<uint8_t> buffer (packetSize);
+          decodedPackets[i]->CopyData (buffer.data (), packetSize);
+          NS_TEST_ASSERT_MSG_EQ ((buffer == originalData[i]), true,
+                                 "Packet " << i << " of generation " << g << " doesn't match original");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (cache->GetMisses (), 2, "Only the two distinct patterns should be inverted");
+  NS_TEST_ASSERT_MSG_EQ (cache->GetHits (), 4, "Every repeated pattern should be a hit");
+  NS_TEST_ASSERT_MSG_EQ (cache->GetSize (), 2, "Both patterns should be cached");
+}
+
+void
+SlidingWindowTestCase::DoRun (void)
+{
+  TestStreaming (200, 8);
+  TestStreaming (1024, 32);
+  TestUnrecoverableLoss (100, 4);
+}
+
+static std::vector<uint8_t>
+MakeStreamPayload (uint32_t seq, uint32_t packetSize)
+{
+  std::vector<uint8_t> buffer (packetSize);
+  for (uint32_t j = 0; j < packetSize; j++)
+    {
+      buffer[j] = (seq * 17 + j * 5) % 256;
+    }
+  return buffer;
+}
+
+void
+SlidingWindowTestCase::TestStreaming (uint32_t packetSize, uint16_t windowSize)
+{
+  Ptr<SlidingWindowEncoder> encoder = CreateObject<SlidingWindowEncoder> (windowSize, packetSize);
+  Ptr<SlidingWindowDecoder> decoder = CreateObject<SlidingWindowDecoder> (windowSize, packetSize);
+  
+  const uint32_t numPackets = 100;
+  uint32_t expectedSeq = 0;
+  auto checkDelivered = [&] () {
+    for (Ptr<Packet> p : decoder->TakeDeliveredPackets ())
+      {
+        std::vector<uint8_t> buffer (packetSize);
+        p->CopyData (buffer.data (), packetSize);
+        NS_TEST_ASSERT_MSG_EQ ((buffer == MakeStreamPayload (expectedSeq, packetSize)), true,
+                               "Packet " << expectedSeq << " delivered out of order or corrupted");
+        expectedSeq++;
+      }
+    encoder->Acknowledge (decoder->GetNextDeliverySequence ());
+  };
+  
+  for (uint32_t i = 0; i < numPackets; i++)
+    {
+      std::vector<uint8_t> data = MakeStreamPayload (i, packetSize);
+      uint32_t seq = encoder->AddPacket (Create<Packet> (data.data (), packetSize));
+      NS_TEST_ASSERT_MSG_EQ (seq, i, "Sequence numbers should be consecutive");
+      
+      // Every fifth source packet is lost
+      Ptr<Packet> source = encoder->GenerateSourcePacket (seq);
+      if (i % 5 != 2)
+        {
+          decoder->ProcessCodedPacket (source);
+        }
+      
+      // Packets are delivered as soon as they arrive until the first loss
+      if (i < 2)
+        {
+          NS_TEST_ASSERT_MSG_EQ (decoder->GetNextDeliverySequence (), i + 1, "Lossless prefix should be delivered immediately");
+        }
+      
+      // One repair per four source packets covers the losses, and everything
+      // held back behind a loss is released by it
+      if (i % 4 == 3)
+        {
+          decoder->ProcessCodedPacket (encoder->GenerateCodedPacket ());
+          NS_TEST_ASSERT_MSG_EQ (decoder->GetNextDeliverySequence (), i + 1, "Repair should release the packets behind the loss");
+        }
+      checkDelivered ();
+    }
+  
+  // Flush the tail of the stream
+  for (int k = 0; k < 4 * windowSize && decoder->GetNextDeliverySequence () < numPackets; k++)
+    {
+      decoder->ProcessCodedPacket (encoder->GenerateCodedPacket ());
+      checkDelivered ();
+    }
+  
+  NS_TEST_ASSERT_MSG_EQ (expectedSeq, numPackets, "All packets should be delivered");
+  NS_TEST_ASSERT_MSG_EQ (decoder->GetLostPacketCount (), 0, "No packet should be lost");
+}
+
+void
+SlidingWindowTestCase::TestUnrecoverableLoss (uint32_t packetSize, uint16_t windowSize)
+{
+  Ptr<SlidingWindowEncoder> encoder = CreateObject<SlidingWindowEncoder> (windowSize, packetSize);
+  Ptr<SlidingWindowDecoder> decoder = CreateObject<SlidingWindowDecoder> (windowSize, packetSize);
+  
+  // Packet 1 is lost and never repaired; without feedback the window keeps
+  // sliding as new packets are added
+  const uint32_t numPackets = 3 * windowSize;
+  for (uint32_t i = 0; i < numPackets; i++)
+    {
+      std::vector<uint8_t> data = MakeStreamPayload (i, packetSize);
+      uint32_t seq = encoder->AddPacket (Create<Packet> (data.data (), packetSize));
+      if (seq != 1)
+        {
+          decoder->ProcessCodedPacket (encoder->GenerateSourcePacket (seq));
+        }
+    }
+  
+  NS_TEST_ASSERT_MSG_EQ (decoder->GetLostPacketCount (), 1, "Exactly one packet should be lost");
+  NS_TEST_ASSERT_MSG_EQ (decoder->GetNextDeliverySequence (), numPackets, "Delivery should skip the lost packet");
+  
+  std::vector<Ptr<Packet>> delivered = decoder->TakeDeliveredPackets ();
+  NS_TEST_ASSERT_MSG_EQ (delivered.size (), numPackets - 1, "Every other packet should be delivered");
+  std::vector<uint8_t> buffer (packetSize);
+  delivered[1]->CopyData (buffer.data (), packetSize);
+  NS_TEST_ASSERT_MSG_EQ ((buffer == MakeStreamPayload (2, packetSize)), true, "Packet after the loss should follow packet 0");
+}
+
+//-----------------------------------------------------------------------------
+// RecoderTestCase implementation
+//-----------------------------------------------------------------------------
+
+RecoderTestCase::RecoderTestCase ()
+  : TestCase ("Network coding recoder test case")
+{
+}
+
+RecoderTestCase::~RecoderTestCase ()
+{
+}
+
+void
+RecoderTestCase::DoRun (void)
+{
+  TestRecoding (512, 16, gf::FIELD_BINARY8);
+  TestRecoding (512, 16, gf::FIELD_BINARY);
+  TestRecoding (1400, 64, gf::FIELD_BINARY4);
+}
+
+void
+RecoderTestCase::TestRecoding (uint32_t packetSize, uint16_t generationSize, gf::FieldType field)
+{
+  Ptr<NetworkCodingEncoder> encoder = CreateObject<NetworkCodingEncoder> (generationSize, packetSize);
+  Ptr<NetworkCodingRecoder> recoder = CreateObject<NetworkCodingRecoder> (generationSize, packetSize);
+  Ptr<NetworkCodingDecoder> decoder = CreateObject<NetworkCodingDecoder> (generationSize, packetSize);
+  encoder->SetField (field);
+  recoder->SetField (field);
+  decoder->SetField (field);
+  
+  std::vector<std::vector<uint8_t>> originalData;
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      for (uint32_t j = 0; j < packetSize; j++)
+        {
+          buffer[j] = (i * 29 + j * 13) % 256;
+        }
+      originalData.push_back (buffer);
+      encoder->AddPacket (Create<Packet> (buffer.data (), packetSize), i);
+    }
+  
+  // Fill the relay halfway
+  const uint16_t half = generationSize / 2;
+  Ptr<Packet> last;
+  for (uint32_t sent = 0; recoder->GetRank () < half && sent < 4u * generationSize; sent++)
+    {
+      last = encoder->GenerateCodedPacket ();
+      recoder->ProcessCodedPacket (last);
+    }
+  NS_TEST_ASSERT_MSG_EQ (recoder->GetRank (), half, "Relay should hold half the generation");
+  NS_TEST_ASSERT_MSG_EQ (recoder->ProcessCodedPacket (last), false, "Duplicate should be dropped at the relay");
+  NetworkCodingHeader sentHeader;
+  NetworkCodingHeader recodedHeader;
+  last->PeekHeader (sentHeader);
+  recoder->GenerateRecodedPacket ()->PeekHeader (recodedHeader);
+  NS_TEST_ASSERT_MSG_EQ (recodedHeader.GetHopSequence (), sentHeader.GetHopSequence (),
+                         "Recoded packets should carry the newest sender index");
+  
+  // Whatever the relay sends can only span what it holds
+  for (uint32_t i = 0; i < 2u * generationSize; i++)
+    {
+      decoder->ProcessCodedPacket (recoder->GenerateRecodedPacket ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (decoder->GetRank (), half, "Recoded packets should not exceed the relay's rank");
+  
+  // Recoded packets are re-dropped by a second relay that already has them
+  Ptr<NetworkCodingRecoder> second = CreateObject<NetworkCodingRecoder> (generationSize, packetSize);
+  second->SetField (field);
+  for (uint32_t i = 0; i < 2u * generationSize; i++)
+    {
+      second->ProcessCodedPacket (recoder->GenerateRecodedPacket ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (second->GetRank (), half, "Second relay should reach the first one's rank");
+  
+  // Complete the relay and decode from recoded packets only
+  for (uint32_t sent = 0; !recoder->IsFullRank () && sent < 4u * generationSize; sent++)
+    {
+      recoder->ProcessCodedPacket (encoder->GenerateCodedPacket ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (recoder->IsFullRank (), true, "Relay should reach full rank");
+  for (uint32_t sent = 0; !decoder->CanDecode () && sent < 4u * generationSize; sent++)
+    {
+      decoder->ProcessCodedPacket (recoder->GenerateRecodedPacket ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (decoder->CanDecode (), true, "Should decode from recoded packets");
+  
+  std::vector<Ptr<Packet>> decodedPackets = decoder->GetDecodedPackets ();
+  for (uint16_t i = 0; i < generationSize; i++)
+    {
+      std::vector<uint8_t> buffer (packetSize);
+      decodedPackets[i]->CopyData (buffer.data (), packetSize);
+      NS_TEST_ASSERT_MSG_EQ ((buffer == originalData[i]), true, "Decoded packet " << i << " doesn't match original");
+    }
+  
+  // Other generations are not mixed in
+  encoder->NextGeneration ();
+  encoder->AddPacket (Create<Packet> (packetSize), 0);
+  NS_TEST_ASSERT_MSG_EQ (recoder->ProcessCodedPacket (encoder->GenerateCodedPacket ()), false,
+                         "Packets of another generation should be rejected");
+  recoder->Reset (1);
+  NS_TEST_ASSERT_MSG_EQ (recoder->GetRank (), 0, "Reset should drop all rows");
+  NS_TEST_ASSERT_MSG_EQ (recoder->ProcessCodedPacket (encoder->GenerateCodedPacket ()), true,
+                         "Reset recoder should take the new generation");
+}
+
+//-----------------------------------------------------------------------------
+// HopReliabilityTestCase implementation
+//-----------------------------------------------------------------------------
+
+HopReliabilityTestCase::HopReliabilityTestCase ()
+  : TestCase ("Hop-by-hop reliability test case")
+{
+}
+
+HopReliabilityTestCase::~HopReliabilityTestCase ()
+{
+}
+
+void
+HopReliabilityTestCase::DoRun (void)
+{
+  TestAckTracker ();
+  TestRetransmissions (10);
+  TestRetransmissions (300);
+}
+
+void
+HopReliabilityTestCase::Resend (Ptr<Packet> packet, const Address &nextHop)
+{
+  m_resentSizes.push_back (packet->GetSize ());
+  m_resentTimes.push_back (Simulator::Now ());
+}
+
+void
+HopReliabilityTestCase::TestAckTracker (void)
+{
+  HopAckTracker tracker;
+  for (uint64_t sequence = 1; sequence <= 10; sequence++)
+    {
+      if (sequence != 4)
+        {
+          NS_TEST_ASSERT_MSG_EQ (tracker.Receive (sequence), true, "Sequence " << sequence << " is new");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (tracker.Receive (7), false, "Repeated sequence should be a duplicate");
+
+  // Bit i stands for 10 - 1 - i: 9 down to 1, without 4
+  NetworkCodingControlHeader ack (NetworkCodingControlHeader::HOP_ACK, 0);
+  tracker.FillHopAck (ack, 10);
+  NS_TEST_ASSERT_MSG_EQ (ack.GetHopAckSequence (), 10, "ACK should carry the highest sequence");
+  NS_TEST_ASSERT_MSG_EQ (ack.GetHopAckBitmap (), 0x1dfull, "ACK bitmap should hold 1-9 except 4");
+
+  NS_TEST_ASSERT_MSG_EQ (tracker.Receive (4), true, "Late sequence is new");
+  tracker.FillHopAck (ack, 4);
+  NS_TEST_ASSERT_MSG_EQ (ack.GetHopAckSequence (), 10, "Late packet is acknowledged through the bitmap");
+  NS_TEST_ASSERT_MSG_EQ (ack.GetHopAckBitmap (), 0x1ffull, "ACK bitmap should hold 1-9");
+
+  // A jump beyond the bitmap forgets the old window
+  NS_TEST_ASSERT_MSG_EQ (tracker.Receive (74), true, "Sequence 74 is new");
+  tracker.FillHopAck (ack, 74);
+  NS_TEST_ASSERT_MSG_EQ (ack.GetHopAckBitmap (), 0x8000000000000000ull, "Only 10 is within 64 of 74");
+  NS_TEST_ASSERT_MSG_EQ (tracker.Receive (100), true, "Sequence 100 is new");
+  NS_TEST_ASSERT_MSG_EQ (tracker.GetHighestSequence (), 100, "Highest sequence should advance");
+  tracker.Receive (30);
+  tracker.FillHopAck (ack, 30);
+  NS_TEST_ASSERT_MSG_EQ (ack.GetHopAckSequence (), 30, "Old retransmission is acknowledged on its own");
+  NS_TEST_ASSERT_MSG_EQ (ack.GetHopAckBitmap (), 0, "Old retransmission gets no bitmap");
+}
+
+void
+HopReliabilityTestCase::TestRetransmissions (uint32_t packets)
+{
+  const Time timeout = MilliSeconds (100);
+  m_resentSizes.clear ();
+  m_resentTimes.clear ();
+
+  HopRetransmissionQueue queue;
+  queue.SetTimeout (timeout);
+  queue.SetMaxRetransmissions (2);
+  queue.SetResendCallback (MakeCallback (&HopReliabilityTestCase::Resend, this));
+
+  // Packet i is i bytes long, so retransmissions can be told apart
+  for (uint32_t i = 1; i <= packets; i++)
+    {
+      uint64_t sequence = queue.AllocateSequence ();
+      NS_TEST_ASSERT_MSG_EQ (sequence, i, "Sequences should count from 1");
+      queue.Track (sequence, Create<Packet> (i), Address ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (queue.GetOutstanding (), packets, "Every packet should be outstanding");
+
+  // The receiver loses 3 and 7 and acknowledges everything else, with one
+  // HOP_ACK per in-order packet
+  HopAckTracker tracker;
+  uint32_t acknowledged = 0;
+  for (uint64_t sequence = 1; sequence <= packets; sequence++)
+    {
+      if (sequence == 3 || sequence == 7)
+        {
+          continue;
+        }
+      tracker.Receive (sequence);
+      NetworkCodingControlHeader ack (NetworkCodingControlHeader::HOP_ACK, 0);
+      tracker.FillHopAck (ack, sequence);
+      acknowledged += queue.HandleHopAck (ack);
+    }
+  NS_TEST_ASSERT_MSG_EQ (acknowledged, packets - 2, "Every received packet is acknowledged once");
+  NS_TEST_ASSERT_MSG_EQ (queue.IsOutstanding (3), true, "Lost packet 3 should be outstanding");
+  NS_TEST_ASSERT_MSG_EQ (queue.IsOutstanding (8), false, "Packet 8 should be acknowledged");
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_resentSizes.size (), 4, "Two lost packets resent twice each");
+  NS_TEST_ASSERT_MSG_EQ (queue.GetRetransmissions (), 4, "Retransmissions should be counted");
+  NS_TEST_ASSERT_MSG_EQ (queue.GetOutstanding (), 0, "Packets are given up after two retransmissions");
+  for (uint32_t i = 0; i < m_resentSizes.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_resentSizes[i], (i % 2 == 0) ? 3u : 7u, "Only lost packets should be resent");
+      // Each wheel slot is 12.5 ms, allow two slots late
+      Time due = MilliSeconds (100 * (i / 2 + 1));
+      NS_TEST_ASSERT_MSG_EQ ((m_resentTimes[i] >= due && m_resentTimes[i] <= due + MilliSeconds (25)),
+                             true, "Retransmission " << i << " at " << m_resentTimes[i] << " should be close to " << due);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// NetworkCodingTraceTestCase implementation
+//-----------------------------------------------------------------------------
+
+NetworkCodingTraceTestCase::NetworkCodingTraceTestCase ()
+  : TestCase ("Binary trace test case")
+{
+}
+
+NetworkCodingTraceTestCase::~NetworkCodingTraceTestCase ()
+{
+}
+
+void
+NetworkCodingTraceTestCase::DoRun (void)
+{
+  TestRoundTrip (0, false);
+  TestRoundTrip (10000, false);
+  TestRoundTrip (10000, true);
+}
+
+void
+NetworkCodingTraceTestCase::TestRoundTrip (uint32_t records, bool memoryMapped)
+{
+  std::string filename = CreateTempDirFilename (memoryMapped ? "trace-mapped.nctr" : "trace.nctr");
+  Ptr<NetworkCodingTraceWriter> writer = CreateObject<NetworkCodingTraceWriter> ();
+  // Small buffers, so the records span many buffers or mapping steps
+  writer->SetAttribute ("BufferRecords", UintegerValue (100));
+  writer->SetAttribute ("BufferCount", UintegerValue (2));
+  writer->SetAttribute ("MemoryMapped", BooleanValue (memoryMapped));
+  NS_TEST_ASSERT_MSG_EQ (writer->Open (filename), true, "Trace file should be created");
+
+  for (uint32_t i = 0; i < records; i++)
+    {
+      NetworkCodingTraceRecord record;
+      record.time = 1000 * int64_t (i);
+      record.value = -int64_t (i) * 7;
+      record.generation = i / 16;
+      record.source = i % 3;
+      record.type = i % 9;
+      record.flags = i & 1;
+      writer->Write (record);
+    }
+  NS_TEST_ASSERT_MSG_EQ (writer->GetRecordCount (), records, "Writer should count every record");
+  writer->Close ();
+  NS_TEST_ASSERT_MSG_EQ (writer->IsOpen (), false, "Writer should be closed");
+
+  NetworkCodingTraceReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (filename), true, "Trace file should be readable");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetRecordCount (), records, "Reader should see every record");
+  NetworkCodingTraceRecord record;
+  uint32_t read = 0;
+  bool match = true;
+  while (reader.Next (record))
+    {
+      match = match && record.time == 1000 * int64_t (read) && record.value == -int64_t (read) * 7
+              && record.generation == read / 16 && record.source == read % 3
+              && record.type == read % 9 && record.flags == (read & 1);
+      read++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (read, records, "Every record should be read back");
+  NS_TEST_ASSERT_MSG_EQ (match, true, "Records should read back as written");
+  std::remove (filename.c_str ());
+}
+
+//-----------------------------------------------------------------------------
+// RateControllerTestCase implementation
+//-----------------------------------------------------------------------------
+
+static const Time RATE_TEST_RTT = MilliSeconds (40);
+
+RateControllerTestCase::RateControllerTestCase ()
+  : TestCase ("Rate controller test case")
+{
+}
+
+RateControllerTestCase::~RateControllerTestCase ()
+{
+}
+
+void
+RateControllerTestCase::DoRun (void)
+{
+  TestFixedRate ();
+  TestBbr (DataRate (5000000));
+  TestBbr (DataRate (40000000));
+}
+
+void
+RateControllerTestCase::TestFixedRate (void)
+{
+  Ptr<NetworkCodingRateController> controller = CreateObject<NetworkCodingRateController> ();
+  controller->Start (DataRate (1000000), 1000);
+  NS_TEST_ASSERT_MSG_EQ (controller->GetPacingRate ().GetBitRate (), 1000000, "Should pace at the start rate");
+  NS_TEST_ASSERT_MSG_EQ (controller->GetSendInterval (), MilliSeconds (8), "1000 bytes at 1 Mbps take 8 ms");
+
+  NetworkCodingRateController::RateSample sample;
+  sample.rtt = RATE_TEST_RTT;
+  sample.deliveryRate = DataRate (100000);
+  sample.loss = 0.5;
+  sample.appLimited = false;
+  controller->OnFeedback (sample);
+  controller->OnTimeout ();
+  NS_TEST_ASSERT_MSG_EQ (controller->GetPacingRate ().GetBitRate (), 1000000, "Feedback should not change the rate");
+}
+
+void
+RateControllerTestCase::TestBbr (DataRate bottleneck)
+{
+  const DataRate initial (1000000);
+  m_controller = CreateObject<NetworkCodingBbrRateController> ();
+  m_bottleneck = bottleneck;
+  m_highestRate = initial;
+  m_controller->Start (initial, 1000);
+  NS_TEST_ASSERT_MSG_EQ (m_controller->GetState (), NetworkCodingBbrRateController::STARTUP,
+                         "Should start in STARTUP");
+  NS_TEST_ASSERT_MSG_EQ (m_controller->GetPacingRate ().GetBitRate (), initial.GetBitRate (),
+                         "Should pace at the start rate before any feedback");
+
+  Simulator::Schedule (RATE_TEST_RTT, &RateControllerTestCase::Feedback, this);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_GT (m_highestRate.GetBitRate (), bottleneck.GetBitRate (),
+                         "STARTUP should grow the rate past the bottleneck");
+  NS_TEST_ASSERT_MSG_EQ (m_controller->GetState (), NetworkCodingBbrRateController::PROBE_BW,
+                         "Should settle in PROBE_BW");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_controller->GetBandwidth ().GetBitRate () / double (bottleneck.GetBitRate ()),
+                             1.0, 0.01, "Bandwidth estimate should match the bottleneck");
+  NS_TEST_ASSERT_MSG_EQ (m_controller->GetMinRtt (), RATE_TEST_RTT, "Minimum RTT should match the path");
+  double gain = m_controller->GetPacingRate ().GetBitRate () / double (bottleneck.GetBitRate ());
+  NS_TEST_ASSERT_MSG_GT (gain, 0.7, "PROBE_BW paces near the bottleneck");
+  NS_TEST_ASSERT_MSG_LT (gain, 1.3, "PROBE_BW paces near the bottleneck");
+
+  // Without any feedback the estimate is halved
+  m_controller->OnTimeout ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_controller->GetBandwidth ().GetBitRate () / double (bottleneck.GetBitRate ()),
+                             0.5, 0.01, "A timeout should halve the estimate");
+  Simulator::Destroy ();
+  m_controller = nullptr;
+}
+
+void
+RateControllerTestCase::Feedback (void)
+{
+  DataRate pacing = m_controller->GetPacingRate ();
+  if (m_highestRate < pacing)
+    {
+      m_highestRate = pacing;
+    }
+
+  // The path delivers what is sent, up to the bottleneck
+  NetworkCodingRateController::RateSample sample;
+  sample.rtt = RATE_TEST_RTT;
+  sample.deliveryRate = pacing < m_bottleneck ? pacing : m_bottleneck;
+  sample.loss = 0.0;
+  sample.appLimited = false;
+  m_controller->OnFeedback (sample);
+  Simulator::Schedule (RATE_TEST_RTT, &RateControllerTestCase::Feedback, this);
+}
+
+//-----------------------------------------------------------------------------
+// NetworkCodingTestErrorModel implementation
+//-----------------------------------------------------------------------------
+
+NS_OBJECT_ENSURE_REGISTERED (NetworkCodingTestErrorModel);
+
+TypeId
+NetworkCodingTestErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NetworkCodingTestErrorModel")
+    .SetParent<ErrorModel> ()
+    .SetGroupName ("NetworkCoding")
+    .AddConstructor<NetworkCodingTestErrorModel> ()
+  ;
+  return tid;
+}
+
+NetworkCodingTestErrorModel::NetworkCodingTestErrorModel ()
+  : m_period (0),
+    m_arrivals (0)
+{
+}
+
+void
+NetworkCodingTestErrorModel::SetPeriod (uint32_t period)
+{
+  m_period = period;
+}
+
+void
+NetworkCodingTestErrorModel::SetDropped (const std::set<uint32_t> &indices)
+{
+  m_dropped = indices;
+}
+
+bool
+NetworkCodingTestErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  uint32_t index = m_arrivals++;
+  return (m_period > 0 && index % m_period == m_period - 1) || m_dropped.count (index) > 0;
+}
+
+void
+NetworkCodingTestErrorModel::DoReset (void)
+{
+  m_arrivals = 0;
+}
+
+//-----------------------------------------------------------------------------
+// NetworkCodingApplicationTestCase implementation
+//-----------------------------------------------------------------------------
+
+static const uint16_t APP_TEST_PORT = 9;
+static const uint32_t APP_TEST_PACKET_SIZE = 256;
+static const uint16_t APP_TEST_GENERATION_SIZE = 8;
+static const uint16_t INJECT_GENERATION_SIZE = 4;
+
+/**
+ * \brief Join two nodes with a 10 Mb/s, 2 ms link
+ * \param a First node, given 10.1.subnet.1
+ * \param b Second node, given 10.1.subnet.2
+ * \param subnet Third byte of the link's /24
+ * \return the interfaces of a and b
+ */
+static Ipv4InterfaceContainer
+ConnectNodes (Ptr<Node> a, Ptr<Node> b, uint32_t subnet)
+{
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  NetDeviceContainer devices = p2p.Install (a, b);
+
+  std::ostringstream base;
+  base << "10.1." << subnet << ".0";
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase (base.str ().c_str (), "255.255.255.0");
+  return ipv4.Assign (devices);
+}
+
+/**
+ * \brief Get the device at one end of a link
+ * \param link The link's interfaces
+ * \param end 0 or 1
+ * \return the device
+ */
+static Ptr<NetDevice>
+GetLinkDevice (const Ipv4InterfaceContainer &link, uint32_t end)
+{
+  std::pair<Ptr<Ipv4>, uint32_t> interface = link.Get (end);
+  return interface.first->GetNetDevice (interface.second);
+}
+
+/**
+ * \brief Lose packets arriving at one end of a link
+ * \param link The link's interfaces
+ * \param end 0 or 1, the end that loses packets
+ * \param model Decides which packets are lost
+ */
+static void
+SetReceiveLoss (const Ipv4InterfaceContainer &link, uint32_t end, Ptr<ErrorModel> model)
+{
+  GetLinkDevice (link, end)->SetAttribute ("ReceiveErrorModel", PointerValue (model));
+}
+
+/**
+ * \brief Run a sender, a relay and a receiver in a line
+ * \param numPackets Packets the sender sends
+ * \param lossPeriod Every lossPeriod-th packet the relay sends is lost
+ * \return the sender, the relay and the receiver, not yet started
+ */
+static ApplicationContainer
+InstallRelayPath (uint32_t numPackets, uint32_t lossPeriod)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4InterfaceContainer first = ConnectNodes (nodes.Get (0), nodes.Get (1), 1);
+  Ipv4InterfaceContainer second = ConnectNodes (nodes.Get (1), nodes.Get (2), 2);
+  Ptr<NetworkCodingTestErrorModel> loss = CreateObject<NetworkCodingTestErrorModel> ();
+  loss->SetPeriod (lossPeriod);
+  SetReceiveLoss (second, 1, loss);
+
+  ApplicationContainer apps;
+  NetworkCodingHelper sender (InetSocketAddress (first.GetAddress (1), APP_TEST_PORT), APP_TEST_PORT);
+  sender.ConfigureSender (APP_TEST_PACKET_SIZE, numPackets, APP_TEST_GENERATION_SIZE, DataRate ("1Mbps"));
+  apps.Add (sender.Install (nodes.Get (0)));
+  NetworkCodingRelayHelper relay (InetSocketAddress (second.GetAddress (1), APP_TEST_PORT), APP_TEST_PORT);
+  relay.SetAttribute ("PacketSize", UintegerValue (APP_TEST_PACKET_SIZE));
+  relay.SetAttribute ("GenerationSize", UintegerValue (APP_TEST_GENERATION_SIZE));
+  apps.Add (relay.Install (nodes.Get (1)));
+  NetworkCodingHelper receiver (InetSocketAddress (second.GetAddress (1), APP_TEST_PORT), APP_TEST_PORT);
+  receiver.ConfigureReceiver (APP_TEST_PACKET_SIZE, APP_TEST_GENERATION_SIZE);
+  apps.Add (receiver.Install (nodes.Get (2)));
+
+  apps.Get (0)->SetStartTime (Seconds (0.1));
+  apps.Stop (Seconds (20.0));
+  Simulator::Stop (Seconds (20.0));
+  return apps;
+}
+
+/**
+ * \brief Check whether a packet is an ACK
+ * \param packet The packet, as received by a sender or relay
+ * \param generationId Set to the generation ACKed
+ * \return true for an ACKNOWLEDGE, false for rank reports and coded packets
+ */
+static bool
+PeekAck (Ptr<const Packet> packet, uint32_t &generationId)
+{
+  uint8_t marker[4];
+  if (packet->GetSize () <= 4 || packet->CopyData (marker, 4) != 4
+      || marker[0] != 0xFF || marker[1] != 0xFF || marker[2] != 0xFF || marker[3] != 0xFF)
+    {
+      return false;
+    }
+  Ptr<Packet> control = packet->Copy ();
+  control->RemoveAtStart (4);
+  NetworkCodingControlHeader feedback;
+  if (control->RemoveHeader (feedback) == 0
+      || feedback.GetControlType () != NetworkCodingControlHeader::ACKNOWLEDGE)
+    {
+      return false;
+    }
+  generationId = feedback.GetGenerationId ();
+  return true;
+}
+
+NetworkCodingApplicationTestCase::NetworkCodingApplicationTestCase ()
+  : TestCase ("Network coding application test case"),
+    m_evictions (0),
+    m_nonInnovativeRanks (0),
+    m_innovativeTraced (0),
+    m_nonInnovativeTraced (0),
+    m_encodeTimes (0),
+    m_decodeTimes (0)
+{
+}
+
+NetworkCodingApplicationTestCase::~NetworkCodingApplicationTestCase ()
+{
+}
+
+void
+NetworkCodingApplicationTestCase::DoRun (void)
+{
+  TestRelayRepairs ();
+  TestRelayFeedback ();
+  TestReceiveWindow ();
+  TestGroupFeedback ();
+  TestPipelinedGenerations ();
+  TestTraceSources ();
+}
+
+void
+NetworkCodingApplicationTestCase::TestRelayRepairs (void)
+{
+  // The relay reaches full rank on every generation, so the repairs for
+  // what its own hop loses are all non-innovative there
+  ApplicationContainer apps = InstallRelayPath (2 * APP_TEST_GENERATION_SIZE, 3);
+  Ptr<NetworkCodingRelayApplication> relay = DynamicCast<NetworkCodingRelayApplication> (apps.Get (1));
+  Ptr<NetworkCodingUdpApplication> receiver = DynamicCast<NetworkCodingUdpApplication> (apps.Get (2));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (receiver->GetGenerationsDecoded (), 2, "Both generations should decode behind the relay");
+  NS_TEST_ASSERT_MSG_GT (relay->GetPacketsDropped (), 0, "Repairs should reach the relay at full rank");
+  NS_TEST_ASSERT_MSG_GT (relay->GetPacketsForwarded (), 2 * APP_TEST_GENERATION_SIZE,
+                         "The relay should forward for the repairs it could not store");
+  Simulator::Destroy ();
+}
+
+void
+NetworkCodingApplicationTestCase::TestRelayFeedback (void)
+{
+  // A quarter of what the relay sends is lost; the sender only sees it
+  // through the packet indices the relay passes on
+  const uint32_t generations = 8;
+  ApplicationContainer apps = InstallRelayPath (generations * APP_TEST_GENERATION_SIZE, 4);
+  Ptr<NetworkCodingUdpApplication> sender = DynamicCast<NetworkCodingUdpApplication> (apps.Get (0));
+  Ptr<NetworkCodingUdpApplication> receiver = DynamicCast<NetworkCodingUdpApplication> (apps.Get (2));
+  Ptr<NetworkCodingBbrRateController> controller = CreateObject<NetworkCodingBbrRateController> ();
+  sender->SetRateController (controller);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (receiver->GetGenerationsDecoded (), generations, "Every generation should decode");
+  NS_TEST_ASSERT_MSG_GT (sender->GetLossEstimate (), 0.1, "Losses behind the relay should be estimated");
+  NS_TEST_ASSERT_MSG_LT (sender->GetLossEstimate (), 0.5, "Loss estimate should stay near a quarter");
+  NS_TEST_ASSERT_MSG_GT (controller->GetMinRtt (), Seconds (0), "ACKs through the relay should time the path");
+  Simulator::Destroy ();
+}
+
+Ptr<NetworkCodingUdpApplication>
+NetworkCodingApplicationTestCase::InstallInjection (uint32_t receiveGenerations,
+                                                    uint64_t maxDecoderMemory,
+                                                    uint32_t decoderThreads)
+{
+  m_encoders.clear ();
+  m_decoded.clear ();
+  m_latencies.clear ();
+  m_acked.clear ();
+  m_evictions = 0;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4InterfaceContainer link = ConnectNodes (nodes.Get (0), nodes.Get (1), 1);
+  m_receiverAddress = InetSocketAddress (link.GetAddress (1), APP_TEST_PORT);
+
+  NetworkCodingHelper helper (m_receiverAddress, APP_TEST_PORT);
+  helper.ConfigureReceiver (APP_TEST_PACKET_SIZE, INJECT_GENERATION_SIZE);
+  helper.SetAttribute ("ReceiveGenerations", UintegerValue (receiveGenerations));
+  helper.SetAttribute ("MaxDecoderMemory", UintegerValue (maxDecoderMemory));
+  helper.SetAttribute ("DecoderThreads", UintegerValue (decoderThreads));
+  helper.SetAttribute ("DecodeLatency", TimeValue (MilliSeconds (50)));
+  helper.SetAttribute ("DecodedHistory", UintegerValue (1));
+  helper.SetAttribute ("FeedbackDelay", TimeValue (Seconds (0)));
+  ApplicationContainer apps = helper.Install (nodes.Get (1));
+  apps.Stop (Seconds (5.0));
+  Ptr<NetworkCodingUdpApplication> receiver = DynamicCast<NetworkCodingUdpApplication> (apps.Get (0));
+  receiver->TraceConnectWithoutContext ("GenerationLatency",
+                                        MakeCallback (&NetworkCodingApplicationTestCase::GenerationDecoded, this));
+  receiver->TraceConnectWithoutContext ("Decoding",
+                                        MakeCallback (&NetworkCodingApplicationTestCase::Decoding, this));
+
+  m_injector = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  m_injector->Bind ();
+  m_injector->SetRecvCallback (MakeCallback (&NetworkCodingApplicationTestCase::HandleFeedback, this));
+  Simulator::Stop (Seconds (5.0));
+  return receiver;
+}
+
+void
+NetworkCodingApplicationTestCase::Inject (uint32_t generationId)
+{
+  Ptr<NetworkCodingEncoder> &encoder = m_encoders[generationId];
+  if (!encoder)
+    {
+      // Same payloads as a NetworkCodingUdpApplication sender, so the
+      // receiver's check of what it decodes passes
+      encoder = CreateObject<NetworkCodingEncoder> (INJECT_GENERATION_SIZE, APP_TEST_PACKET_SIZE);
+      encoder->SetSystematic (true);
+      for (uint32_t i = 0; i < INJECT_GENERATION_SIZE; i++)
+        {
+          uint32_t sequence = generationId * INJECT_GENERATION_SIZE + i;
+          std::vector<uint8_t> data (APP_TEST_PACKET_SIZE);
+          for (uint32_t j = 0; j < APP_TEST_PACKET_SIZE; j++)
+            {
+              data[j] = (sequence * 123 + j * 7) % 256;
+            }
+          encoder->AddPacket (Create<Packet> (data.data (), APP_TEST_PACKET_SIZE), i);
+        }
+    }
+  m_injector->SendTo (encoder->GeneratePacket (generationId), 0, m_receiverAddress);
+}
+
+void
+NetworkCodingApplicationTestCase::HandleFeedback (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      // Skip the control marker
+      packet->RemoveAtStart (4);
+      NetworkCodingControlHeader feedback;
+      packet->RemoveHeader (feedback);
+      if (feedback.GetControlType () == NetworkCodingControlHeader::ACKNOWLEDGE)
+        {
+          m_acked.push_back (feedback.GetGenerationId ());
+        }
+    }
+}
+
+void
+NetworkCodingApplicationTestCase::GenerationDecoded (uint32_t generationId, Time latency)
+{
+  m_decoded.push_back (generationId);
+  m_latencies.push_back (latency);
+}
+
+void
+NetworkCodingApplicationTestCase::Decoding (bool decoded, uint32_t total)
+{
+  if (!decoded)
+    {
+      m_evictions++;
+    }
+}
+
+void
+NetworkCodingApplicationTestCase::TestReceiveWindow (void)
+{
+  // Two generations kept. Generation 0 is touched after 1, so 2 evicts 1,
+  // the least recently heard from, although 0 is older.
+  Ptr<NetworkCodingUdpApplication> receiver = InstallInjection (2, 0, 0);
+  const uint32_t lru[] = {0, 0, 1, 1, 1, 0, 2, 0, 0, 1, 2, 2, 2, 2, 0};
+  for (uint32_t i = 0; i < sizeof (lru) / sizeof (lru[0]); i++)
+    {
+      Simulator::Schedule (Seconds (1.0) + MilliSeconds (10 * i),
+                           &NetworkCodingApplicationTestCase::Inject, this, lru[i]);
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_decoded.size (), 2, "Generations 0 and 2 should decode");
+  NS_TEST_ASSERT_MSG_EQ (m_decoded[0], 0, "Recently heard from generation 0 should be kept");
+  NS_TEST_ASSERT_MSG_EQ (m_decoded[1], 2, "Generation 2 should decode");
+  NS_TEST_ASSERT_MSG_EQ (m_evictions, 1, "Only generation 1 should be evicted");
+  // DecodedHistory is 1: the extra packet of 0 right after it decoded is
+  // re-ACKed, the one after 2 decoded starts 0 over instead
+  const uint32_t acked[] = {0, 0, 2, 2};
+  NS_TEST_ASSERT_MSG_EQ (m_acked.size (), 4, "Two decodes and two re-ACKs expected");
+  for (uint32_t i = 0; i < m_acked.size () && i < 4; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_acked[i], acked[i], "ACK " << i << " is for the wrong generation");
+    }
+  Simulator::Destroy ();
+
+  // Room for two decoders, and a decode handed to a worker still holds
+  // one: generation 2 evicts 1 while 0 is being solved, although only 1
+  // is being received
+  uint64_t decoderBytes = static_cast<uint64_t> (INJECT_GENERATION_SIZE + 1)
+    * (GenerationBuffer::Align (INJECT_GENERATION_SIZE) + GenerationBuffer::Align (APP_TEST_PACKET_SIZE));
+  receiver = InstallInjection (8, 2 * decoderBytes, 1);
+  const std::pair<uint32_t, uint32_t> memory[] = {
+    {1000, 0}, {1001, 0}, {1002, 0}, {1003, 0}, {1010, 1}, {1020, 2},
+    {1100, 2}, {1101, 2}, {1102, 2}, {1110, 1}, {1111, 1}, {1112, 1}};
+  for (const auto &packet : memory)
+    {
+      Simulator::Schedule (MilliSeconds (packet.first), &NetworkCodingApplicationTestCase::Inject,
+                           this, packet.second);
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (receiver->GetGenerationsDecoded (), 2, "Generations 0 and 2 should decode");
+  NS_TEST_ASSERT_MSG_EQ (m_decoded.size (), 2, "Generation 1 should restart and stay short");
+  NS_TEST_ASSERT_MSG_EQ (m_decoded.back (), 2, "Generation 2 should decode");
+  NS_TEST_ASSERT_MSG_EQ (m_evictions, 1, "The pending decode should evict generation 1");
+  Simulator::Destroy ();
+
+  // A memory bound below one decoder still keeps the newest generation
+  receiver = InstallInjection (8, 1, 0);
+  const uint32_t single[] = {5, 5, 6, 6, 6, 6, 5, 5};
+  for (uint32_t i = 0; i < sizeof (single) / sizeof (single[0]); i++)
+    {
+      Simulator::Schedule (Seconds (1.0) + MilliSeconds (10 * i),
+                           &NetworkCodingApplicationTestCase::Inject, this, single[i]);
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_decoded.size (), 1, "Only generation 6 should decode");
+  NS_TEST_ASSERT_MSG_EQ (m_decoded.front (), 6, "Generation 6 should decode on its own");
+  NS_TEST_ASSERT_MSG_EQ (m_evictions, 1, "Generation 5 should be evicted once");
+  Simulator::Destroy ();
+  m_injector = nullptr;
+  m_encoders.clear ();
+}
+
+void
+NetworkCodingApplicationTestCase::GroupFeedback (Ptr<const Packet> packet)
+{
+  uint32_t generationId;
+  if (PeekAck (packet, generationId))
+    {
+      // The trace fires before the sender handles the packet
+      Simulator::ScheduleNow (&NetworkCodingApplicationTestCase::SampleGroup, this);
+    }
+}
+
+void
+NetworkCodingApplicationTestCase::SampleGroup (void)
+{
+  m_openAfterAck.push_back (m_groupSender->GetEncoder () != nullptr);
+  m_slowDecodedAtAck.push_back (m_slowReceiver->GetGenerationsDecoded ());
+}
+
+void
+NetworkCodingApplicationTestCase::TestGroupFeedback (void)
+{
+  // The sender multicasts through a router to two receivers
+  NodeContainer nodes;
+  nodes.Create (4);
+  Ptr<Node> source = nodes.Get (0);
+  Ptr<Node> router = nodes.Get (1);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4InterfaceContainer up = ConnectNodes (source, router, 1);
+  Ipv4InterfaceContainer fast = ConnectNodes (router, nodes.Get (2), 2);
+  Ipv4InterfaceContainer slow = ConnectNodes (router, nodes.Get (3), 3);
+
+  Ipv4Address group ("225.1.2.4");
+  Ipv4StaticRoutingHelper routing;
+  NetDeviceContainer down;
+  down.Add (GetLinkDevice (fast, 0));
+  down.Add (GetLinkDevice (slow, 0));
+  routing.AddMulticastRoute (router, up.GetAddress (0), group, GetLinkDevice (up, 1), down);
+  routing.SetDefaultMulticastRoute (source, GetLinkDevice (up, 0));
+  // Feedback goes back to the sender by unicast
+  routing.GetStaticRouting (fast.Get (1).first)->SetDefaultRoute (fast.GetAddress (0), fast.Get (1).second);
+  routing.GetStaticRouting (slow.Get (1).first)->SetDefaultRoute (slow.GetAddress (0), slow.Get (1).second);
+
+  // One receiver misses one packet of the first round, the other three and
+  // then the second repair, so it only decodes on the last one
+  Ptr<NetworkCodingTestErrorModel> fastLoss = CreateObject<NetworkCodingTestErrorModel> ();
+  fastLoss->SetDropped ({1});
+  SetReceiveLoss (fast, 1, fastLoss);
+  Ptr<NetworkCodingTestErrorModel> slowLoss = CreateObject<NetworkCodingTestErrorModel> ();
+  slowLoss->SetDropped ({2, 4, 6, 9});
+  SetReceiveLoss (slow, 1, slowLoss);
+
+  // Slow enough that the faster receiver's ACKs arrive well before the
+  // slower one decodes
+  Address groupAddress = InetSocketAddress (group, APP_TEST_PORT);
+  NetworkCodingHelper sender (groupAddress, APP_TEST_PORT);
+  sender.ConfigureSender (APP_TEST_PACKET_SIZE, APP_TEST_GENERATION_SIZE, APP_TEST_GENERATION_SIZE,
+                          DataRate ("200kbps"));
+  sender.SetGroupSize (2);
+  ApplicationContainer apps = sender.Install (source);
+  NetworkCodingHelper receiver (groupAddress, APP_TEST_PORT);
+  receiver.ConfigureReceiver (APP_TEST_PACKET_SIZE, APP_TEST_GENERATION_SIZE);
+  apps.Add (receiver.Install (nodes.Get (2)));
+  apps.Add (receiver.Install (nodes.Get (3)));
+  apps.Get (0)->SetStartTime (Seconds (0.1));
+  apps.Stop (Seconds (10.0));
+  Simulator::Stop (Seconds (10.0));
+
+  m_groupSender = DynamicCast<NetworkCodingUdpApplication> (apps.Get (0));
+  Ptr<NetworkCodingUdpApplication> fastReceiver = DynamicCast<NetworkCodingUdpApplication> (apps.Get (1));
+  m_slowReceiver = DynamicCast<NetworkCodingUdpApplication> (apps.Get (2));
+  m_openAfterAck.clear ();
+  m_slowDecodedAtAck.clear ();
+  m_groupSender->TraceConnectWithoutContext ("Rx", MakeCallback (&NetworkCodingApplicationTestCase::GroupFeedback, this));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (fastReceiver->GetGenerationsDecoded (), 1, "Faster receiver should decode");
+  NS_TEST_ASSERT_MSG_EQ (m_slowReceiver->GetGenerationsDecoded (), 1, "Slower receiver should decode");
+  NS_TEST_ASSERT_MSG_GT (m_openAfterAck.size (), 3, "Every receiver should ACK");
+  for (uint32_t i = 0; i < 3 && i < m_openAfterAck.size (); i++)
+    {
+      // The ACK the faster receiver sends on decoding and the ones it
+      // repeats for the next two repairs
+      NS_TEST_ASSERT_MSG_EQ (m_slowDecodedAtAck[i], 0, "ACK " << i << " should come from the faster receiver");
+      NS_TEST_ASSERT_MSG_EQ (m_openAfterAck[i], true, "One receiver's ACKs should not close the generation");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_openAfterAck.back (), false, "Both ACKs should close the generation");
+  // Both rank reports arrive together: the repairs cover the three
+  // packets the slower receiver is missing, not the four missing in all
+  uint32_t repairMargin = 1;
+  NS_TEST_ASSERT_MSG_EQ (m_groupSender->GetPacketsSent (), APP_TEST_GENERATION_SIZE + 3 + repairMargin,
+                         "Repairs should match the largest deficit");
+  Simulator::Destroy ();
+  m_groupSender = nullptr;
+  m_slowReceiver = nullptr;
+}
+
+void
+NetworkCodingApplicationTestCase::RecordSent (Ptr<const Packet> packet)
+{
+  NetworkCodingHeader header;
+  packet->PeekHeader (header);
+  m_sent.push_back (header.GetGenerationId ());
+}
+
+void
+NetworkCodingApplicationTestCase::RecordAck (Ptr<const Packet> packet)
+{
+  uint32_t generationId;
+  if (PeekAck (packet, generationId))
+    {
+      m_acked.push_back (generationId);
+    }
+}
+
+void
+NetworkCodingApplicationTestCase::TestPipelinedGenerations (void)
+{
+  // Three generations in flight and a last one of 5 packets; every fifth
+  // packet is lost
+  const uint32_t window = 3;
+  const uint32_t generations = 4;
+  const uint32_t numPackets = (generations - 1) * APP_TEST_GENERATION_SIZE + 5;
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4InterfaceContainer link = ConnectNodes (nodes.Get (0), nodes.Get (1), 1);
+  Ptr<NetworkCodingTestErrorModel> loss = CreateObject<NetworkCodingTestErrorModel> ();
+  loss->SetPeriod (5);
+  SetReceiveLoss (link, 1, loss);
+
+  Address destination = InetSocketAddress (link.GetAddress (1), APP_TEST_PORT);
+  NetworkCodingHelper sender (destination, APP_TEST_PORT);
+  sender.ConfigureSender (APP_TEST_PACKET_SIZE, numPackets, APP_TEST_GENERATION_SIZE, DataRate ("1Mbps"));
+  sender.SetAttribute ("MaxGenerationsInFlight", UintegerValue (window));
+  ApplicationContainer apps = sender.Install (nodes.Get (0));
+  NetworkCodingHelper receiver (destination, APP_TEST_PORT);
+  receiver.ConfigureReceiver (APP_TEST_PACKET_SIZE, APP_TEST_GENERATION_SIZE);
+  receiver.SetAttribute ("MaxGenerationsInFlight", UintegerValue (window));
+  apps.Add (receiver.Install (nodes.Get (1)));
+  apps.Get (0)->SetStartTime (Seconds (0.1));
+  // Abandoning a generation takes five 2 s timeouts, so whatever closes
+  // before the end was ACKed
+  apps.Stop (Seconds (8.0));
+  Simulator::Stop (Seconds (8.0));
+
+  Ptr<NetworkCodingUdpApplication> source = DynamicCast<NetworkCodingUdpApplication> (apps.Get (0));
+  Ptr<NetworkCodingUdpApplication> sink = DynamicCast<NetworkCodingUdpApplication> (apps.Get (1));
+  m_sent.clear ();
+  m_acked.clear ();
+  source->TraceConnectWithoutContext ("Tx", MakeCallback (&NetworkCodingApplicationTestCase::RecordSent, this));
+  source->TraceConnectWithoutContext ("Rx", MakeCallback (&NetworkCodingApplicationTestCase::RecordAck, this));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_GT (m_sent.size (), window, "Sender should send");
+  for (uint32_t i = 0; i < window && i < m_sent.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_sent[i], i, "The first round should interleave the generations in flight");
+    }
+  NS_TEST_ASSERT_MSG_EQ (sink->GetGenerationsDecoded (), generations, "Every generation should decode");
+  std::set<uint32_t> acked (m_acked.begin (), m_acked.end ());
+  NS_TEST_ASSERT_MSG_EQ (acked.size (), generations, "Every generation should be ACKed");
+  NS_TEST_ASSERT_MSG_EQ ((source->GetEncoder () == nullptr), true, "No generation should be left in flight");
+  Simulator::Destroy ();
+}
+
+void
+NetworkCodingApplicationTestCase::RecordRank (uint32_t generationId, uint16_t rank, bool innovative)
+{
+  if (innovative)
+    {
+      m_ranks[generationId].push_back (rank);
+    }
+  else
+    {
+      m_nonInnovativeRanks++;
+    }
+}
+
+void
+NetworkCodingApplicationTestCase::InnovativeChanged (uint32_t oldValue, uint32_t newValue)
+{
+  m_innovativeTraced = newValue;
+}
+
+void
+NetworkCodingApplicationTestCase::NonInnovativeChanged (uint32_t oldValue, uint32_t newValue)
+{
+  m_nonInnovativeTraced = newValue;
+}
+
+void
+NetworkCodingApplicationTestCase::EncodeTimed (uint32_t generationId, Time elapsed)
+{
+  m_encodeTimes++;
+}
+
+void
+NetworkCodingApplicationTestCase::DecodeTimed (uint32_t generationId, Time elapsed)
+{
+  m_decodeTimes++;
+}
+
+void
+NetworkCodingApplicationTestCase::TestTraceSources (void)
+{
+  // Systematic and lossless: every packet raises the rank by one and
+  // nothing is repaired
+  const uint32_t generations = 2;
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4InterfaceContainer link = ConnectNodes (nodes.Get (0), nodes.Get (1), 1);
+
+  Address destination = InetSocketAddress (link.GetAddress (1), APP_TEST_PORT);
+  NetworkCodingHelper sender (destination, APP_TEST_PORT);
+  sender.ConfigureSender (APP_TEST_PACKET_SIZE, generations * APP_TEST_GENERATION_SIZE,
+                          APP_TEST_GENERATION_SIZE, DataRate ("1Mbps"));
+  sender.SetAttribute ("Systematic", BooleanValue (true));
+  sender.SetAttribute ("MeasureCodingTime", BooleanValue (true));
+  ApplicationContainer apps = sender.Install (nodes.Get (0));
+  NetworkCodingHelper receiver (destination, APP_TEST_PORT);
+  receiver.ConfigureReceiver (APP_TEST_PACKET_SIZE, APP_TEST_GENERATION_SIZE);
+  receiver.SetAttribute ("MeasureCodingTime", BooleanValue (true));
+  apps.Add (receiver.Install (nodes.Get (1)));
+  apps.Get (0)->SetStartTime (Seconds (0.1));
+  apps.Stop (Seconds (5.0));
+  Simulator::Stop (Seconds (5.0));
+
+  Ptr<NetworkCodingUdpApplication> source = DynamicCast<NetworkCodingUdpApplication> (apps.Get (0));
+  Ptr<NetworkCodingUdpApplication> sink = DynamicCast<NetworkCodingUdpApplication> (apps.Get (1));
+  m_decoded.clear ();
+  m_latencies.clear ();
+  m_ranks.clear ();
+  m_nonInnovativeRanks = 0;
+  m_innovativeTraced = 0;
+  m_nonInnovativeTraced = 0;
+  m_encodeTimes = 0;
+  m_decodeTimes = 0;
+  source->TraceConnectWithoutContext ("EncodeTime", MakeCallback (&NetworkCodingApplicationTestCase::EncodeTimed, this));
+  sink->TraceConnectWithoutContext ("DecodeTime", MakeCallback (&NetworkCodingApplicationTestCase::DecodeTimed, this));
+  sink->TraceConnectWithoutContext ("Rank", MakeCallback (&NetworkCodingApplicationTestCase::RecordRank, this));
+  sink->TraceConnectWithoutContext ("GenerationLatency",
+                                    MakeCallback (&NetworkCodingApplicationTestCase::GenerationDecoded, this));
+  sink->TraceConnectWithoutContext ("InnovativePackets",
+                                    MakeCallback (&NetworkCodingApplicationTestCase::InnovativeChanged, this));
+  sink->TraceConnectWithoutContext ("NonInnovativePackets",
+                                    MakeCallback (&NetworkCodingApplicationTestCase::NonInnovativeChanged, this));
+  Simulator::Run ();
+
+  const uint32_t packets = generations * APP_TEST_GENERATION_SIZE;
+  NS_TEST_ASSERT_MSG_EQ (source->GetPacketsSent (), packets, "A lossless run needs no repairs");
+  NS_TEST_ASSERT_MSG_EQ (m_ranks.size (), generations, "Every generation should trace its rank");
+  for (const auto &entry : m_ranks)
+    {
+      NS_TEST_ASSERT_MSG_EQ (entry.second.size (), APP_TEST_GENERATION_SIZE,
+                             "Generation " << entry.first << " should trace every packet");
+      for (uint32_t i = 0; i < entry.second.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (entry.second[i], i + 1, "Rank should grow by one per packet");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_nonInnovativeRanks, 0, "No packet should be non-innovative");
+  NS_TEST_ASSERT_MSG_EQ (m_innovativeTraced, packets, "InnovativePackets should count every packet");
+  NS_TEST_ASSERT_MSG_EQ (m_innovativeTraced, sink->GetInnovativePacketsReceived (), "Traced and counted should match");
+  NS_TEST_ASSERT_MSG_EQ (m_nonInnovativeTraced, 0, "NonInnovativePackets should stay at zero");
+  NS_TEST_ASSERT_MSG_EQ (sink->GetNonInnovativePacketsReceived (), 0, "Nothing should be non-innovative");
+  NS_TEST_ASSERT_MSG_EQ (m_decoded.size (), generations, "GenerationLatency should fire per generation");
+  for (uint32_t i = 0; i < m_decoded.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_decoded[i], i, "Generations should decode in order");
+      NS_TEST_ASSERT_MSG_GT (m_latencies[i], Seconds (0), "A generation takes several packets to arrive");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_encodeTimes, packets, "EncodeTime should fire per packet sent");
+  NS_TEST_ASSERT_MSG_EQ (m_decodeTimes, packets, "DecodeTime should fire per packet received");
+  Simulator::Destroy ();
+}
+
 //-----------------------------------------------------------------------------
 // NetworkCodingTestSuite implementation
 //-----------------------------------------------------------------------------
@@ -342,7 +2612,16 @@ NetworkCodingTestSuite::NetworkCodingTestSuite ()
   : TestSuite ("network-coding", Type::UNIT)
 {
   AddTestCase (new GaloisFieldTestCase, Duration::QUICK);
+  AddTestCase (new GaloisFieldRegionTestCase, Duration::QUICK);
+  AddTestCase (new GenerationBufferTestCase, Duration::QUICK);
+  AddTestCase (new NetworkCodingHeaderTestCase, Duration::QUICK);
   AddTestCase (new NetworkCodingTestCase, Duration::QUICK);
+  AddTestCase (new SlidingWindowTestCase, Duration::QUICK);
+  AddTestCase (new RecoderTestCase, Duration::QUICK);
+  AddTestCase (new HopReliabilityTestCase, Duration::QUICK);
+  AddTestCase (new NetworkCodingTraceTestCase, Duration::QUICK);
+  AddTestCase (new RateControllerTestCase, Duration::QUICK);
+  AddTestCase (new NetworkCodingApplicationTestCase, Duration::QUICK);
 }
 
 } // namespace ns3
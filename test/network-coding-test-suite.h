@@ -22,10 +22,23 @@
 #define NETWORK_CODING_TEST_SUITE_H
 
 #include "ns3/test.h"
+#include "ns3/error-model.h"
+#include "ns3/socket.h"
 #include "../model/galois-field.h"
+#include "../model/generation-buffer.h"
 #include "../model/network-coding-encoder.h"
 #include "../model/network-coding-decoder.h"
+#include "../model/decoding-worker-pool.h"
+#include "../model/sliding-window-encoder.h"
+#include "../model/sliding-window-decoder.h"
+#include "../model/network-coding-recoder.h"
 #include "../model/network-coding-udp-application.h"
+#include "../model/hop-reliability.h"
+#include "../model/network-coding-trace.h"
+#include "../model/network-coding-rate-controller.h"
+#include <map>
+#include <set>
+#include <vector>
 
 namespace ns3 {
 
@@ -75,6 +88,86 @@ private:
    * \param gf GaloisField object
    */
   void TestInverse (Ptr<GaloisField> gf);
+
+  /**
+   * \brief Test the compile-time tables against shift-and-add arithmetic
+   */
+  void TestTables (void);
+};
+
+/**
+ * \ingroup network-coding-test
+ * \brief Test case for the GF(2^8) region kernels
+ *
+ * Checks every kernel supported on the running CPU against the scalar
+ * GaloisField::Multiply, including unaligned buffers and odd lengths.
+ */
+class GaloisFieldRegionTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  GaloisFieldRegionTestCase ();
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~GaloisFieldRegionTestCase ();
+
+private:
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+};
+
+/**
+ * \ingroup network-coding-test
+ * \brief Test case for the GenerationBuffer row storage
+ */
+class GenerationBufferTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  GenerationBufferTestCase ();
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~GenerationBufferTestCase ();
+
+private:
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+};
+
+/**
+ * \ingroup network-coding-test
+ * \brief Test case for the NetworkCodingHeader coefficient formats
+ */
+class NetworkCodingHeaderTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  NetworkCodingHeaderTestCase ();
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~NetworkCodingHeaderTestCase ();
+
+private:
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
 };
 
 /**
@@ -114,6 +207,505 @@ private:
    * \param lossRate Packet loss rate
    */
   void TestCodingWithLoss (uint32_t packetSize, uint16_t generationSize, double lossRate);
+
+  /**
+   * \brief Test that duplicate coded packets are rejected by the decoder
+   * \param packetSize Size of packets
+   * \param generationSize Size of generation
+   */
+  void TestRedundantPackets (uint32_t packetSize, uint16_t generationSize);
+
+  /**
+   * \brief Test systematic coding with some uncoded packets lost
+   * \param packetSize Size of packets
+   * \param generationSize Size of generation
+   */
+  void TestSystematic (uint32_t packetSize, uint16_t generationSize);
+
+  /**
+   * \brief Test decoding of sparse random codes
+   * \param packetSize Size of packets
+   * \param generationSize Size of generation
+   * \param density Probability that a coefficient is nonzero
+   */
+  void TestSparseCoding (uint32_t packetSize, uint16_t generationSize, double density);
+
+  /**
+   * \brief Test stamped generation IDs and decoding from a pre-parsed header
+   * \param packetSize Size of packets
+   * \param generationSize Size of generation
+   */
+  void TestParsedHeader (uint32_t packetSize, uint16_t generationSize);
+
+  /**
+   * \brief Test coding in a field other than GF(2^8)
+   * \param packetSize Size of packets
+   * \param generationSize Size of generation
+   * \param field Field used by both encoder and decoder
+   */
+  void TestFieldCoding (uint32_t packetSize, uint16_t generationSize, gf::FieldType field);
+
+  /**
+   * \brief Test deferred back-substitution, solved on a worker pool
+   * \param packetSize Size of packets
+   * \param generationSize Size of generation
+   * \param field Field used by both encoder and decoder
+   */
+  void TestDeferredSubstitution (uint32_t packetSize, uint16_t generationSize, gf::FieldType field);
+
+  /**
+   * \brief Test one encoder and decoder reused for several generations
+   * \param packetSize Size of packets
+   * \param generationSize Size of generation
+   */
+  void TestReuse (uint32_t packetSize, uint16_t generationSize);
+
+  /**
+   * \brief Test that batched packet generation matches one-by-one generation
+   * \param packetSize Size of packets
+   * \param generationSize Size of generation
+   * \param field Field used by both encoder and decoder
+   */
+  void TestBatchedCoding (uint32_t packetSize, uint16_t generationSize, gf::FieldType field);
+
+  /**
+   * \brief Test that source symbols are reported as soon as they are solved
+   * \param packetSize Size of packets
+   * \param generationSize Size of generation, at least 4
+   * \param deferred Use deferred substitution
+   */
+  void TestPartialDecoding (uint32_t packetSize, uint16_t generationSize, bool deferred);
+
+  /**
+   * \brief Test that generations repeating a coefficient pattern are decoded
+   * with the cached inverse, and that new patterns are eliminated and cached
+   * \param packetSize Size of packets
+   * \param generationSize Size of generation, at least 6
+   * \param field Field to code in
+   * \param deferred Use deferred substitution
+   */
+  void TestInverseCache (uint32_t packetSize, uint16_t generationSize, gf::FieldType field,
+                         bool deferred);
+
+  /**
+   * \brief Test that a fixed codec is dispatched to and computes what the
+   * generic one does
+   * \tparam Field Field to code in
+   * \tparam GenSize Generation size of the fixed codec
+   * \tparam SymbolSize Packet size of the fixed codec
+   */
+  template <class Field, uint16_t GenSize, uint16_t SymbolSize>
+  void TestFixedCodec (void);
+};
+
+/**
+ * \ingroup network-coding-test
+ * \brief Test case for the sliding-window encoder and decoder
+ */
+class SlidingWindowTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  SlidingWindowTestCase ();
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~SlidingWindowTestCase ();
+
+private:
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * \brief Stream packets over a lossy link with periodic repairs and feedback
+   * \param packetSize Size of packets
+   * \param windowSize Size of the coding window
+   */
+  void TestStreaming (uint32_t packetSize, uint16_t windowSize);
+
+  /**
+   * \brief Check that an unrepaired loss is skipped once it leaves the window
+   * \param packetSize Size of packets
+   * \param windowSize Size of the coding window
+   */
+  void TestUnrecoverableLoss (uint32_t packetSize, uint16_t windowSize);
+};
+
+/**
+ * \ingroup network-coding-test
+ * \brief Test case for recoding at intermediate nodes
+ */
+class RecoderTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  RecoderTestCase ();
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~RecoderTestCase ();
+
+private:
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * \brief Relay a generation through a recoder and decode the recoded packets
+   * \param packetSize Size of packets
+   * \param generationSize Size of generation
+   * \param field Field used end to end
+   */
+  void TestRecoding (uint32_t packetSize, uint16_t generationSize, gf::FieldType field);
+};
+
+/**
+ * \ingroup network-coding-test
+ * \brief Test case for hop-by-hop acknowledgments and retransmissions
+ */
+class HopReliabilityTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  HopReliabilityTestCase ();
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~HopReliabilityTestCase ();
+
+private:
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * \brief Test the receiver's highest sequence and bitmap
+   */
+  void TestAckTracker (void);
+
+  /**
+   * \brief Test that only unacknowledged packets are resent, on time
+   * \param packets Number of packets in flight at once
+   */
+  void TestRetransmissions (uint32_t packets);
+
+  /**
+   * \brief Resend callback recording what the queue sends
+   * \param packet The retransmitted packet
+   * \param nextHop Its next hop
+   */
+  void Resend (Ptr<Packet> packet, const Address &nextHop);
+
+  std::vector<uint32_t> m_resentSizes;  //!< Size of each retransmission
+  std::vector<Time> m_resentTimes;      //!< Time of each retransmission
+};
+
+/**
+ * \ingroup network-coding-test
+ * \brief Test case for the binary trace writer and reader
+ */
+class NetworkCodingTraceTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  NetworkCodingTraceTestCase ();
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~NetworkCodingTraceTestCase ();
+
+private:
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * \brief Test that records read back exactly as written
+   * \param records Number of records written
+   * \param memoryMapped Whether the writer maps the file
+   */
+  void TestRoundTrip (uint32_t records, bool memoryMapped);
+};
+
+/**
+ * \ingroup network-coding-test
+ * \brief Test case for the sender's rate controllers
+ */
+class RateControllerTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  RateControllerTestCase ();
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~RateControllerTestCase ();
+
+private:
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * \brief Test that the base controller keeps the rate it was started with
+   */
+  void TestFixedRate (void);
+
+  /**
+   * \brief Test that the BBR controller finds the bottleneck and backs off
+   * after a timeout
+   * \param bottleneck Rate the simulated path delivers at most
+   */
+  void TestBbr (DataRate bottleneck);
+
+  /**
+   * \brief Feed the controller one ACK of a path that delivers at most
+   * m_bottleneck, then schedule the next one an RTT later
+   */
+  void Feedback (void);
+
+  Ptr<NetworkCodingBbrRateController> m_controller; //!< Controller under test
+  DataRate m_bottleneck;                //!< Rate of the simulated path
+  DataRate m_highestRate;               //!< Largest pacing rate seen
+};
+
+/**
+ * \ingroup network-coding-test
+ * \brief Error model that drops packets by their arrival order, so
+ * simulated losses are the same in every run
+ */
+class NetworkCodingTestErrorModel : public ErrorModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  NetworkCodingTestErrorModel ();
+
+  /**
+   * \brief Drop every period-th packet
+   * \param period Packets per loss; 0 drops none
+   */
+  void SetPeriod (uint32_t period);
+
+  /**
+   * \brief Drop the packets with these arrival indices, counted from 0
+   * \param indices The indices
+   */
+  void SetDropped (const std::set<uint32_t> &indices);
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  uint32_t m_period;                    //!< Packets per periodic loss
+  std::set<uint32_t> m_dropped;         //!< Arrival indices to drop
+  uint32_t m_arrivals;                  //!< Packets seen so far
+};
+
+/**
+ * \ingroup network-coding-test
+ * \brief Test case for the sender, receiver and relay applications in
+ * small simulated networks
+ */
+class NetworkCodingApplicationTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  NetworkCodingApplicationTestCase ();
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~NetworkCodingApplicationTestCase ();
+
+private:
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * \brief Test that a relay at full rank still forwards the sender's
+   * repairs for losses on the hop after it
+   */
+  void TestRelayRepairs (void);
+
+  /**
+   * \brief Test that the sender estimates losses and samples the path
+   * rate from the feedback of a receiver behind a relay
+   */
+  void TestRelayFeedback (void);
+
+  /**
+   * \brief Test which generations a receiver keeps, evicts and re-ACKs
+   * when packets of more generations than it keeps are interleaved
+   */
+  void TestReceiveWindow (void);
+
+  /**
+   * \brief Test a sender serving two multicast receivers that lose
+   * different packets
+   */
+  void TestGroupFeedback (void);
+
+  /**
+   * \brief Test a sender with several generations in flight, the last
+   * one short, over a lossy link
+   */
+  void TestPipelinedGenerations (void);
+
+  /**
+   * \brief Test the receiver's rank, latency, counter and coding time
+   * traces on a lossless run
+   */
+  void TestTraceSources (void);
+
+  /**
+   * \brief Start a receiver of INJECT_GENERATION_SIZE-packet generations
+   * fed by Inject, with rank reports off and DecodedHistory 1
+   * \param receiveGenerations ReceiveGenerations of the receiver
+   * \param maxDecoderMemory MaxDecoderMemory of the receiver
+   * \param decoderThreads DecoderThreads of the receiver; decodes handed
+   * to them finish 50 ms later
+   * \return the receiver
+   */
+  Ptr<NetworkCodingUdpApplication> InstallInjection (uint32_t receiveGenerations,
+                                                     uint64_t maxDecoderMemory,
+                                                     uint32_t decoderThreads);
+
+  /**
+   * \brief Send the receiver the next packet of a generation; the first
+   * INJECT_GENERATION_SIZE are uncoded
+   * \param generationId The generation
+   */
+  void Inject (uint32_t generationId);
+
+  /**
+   * \brief Count the ACKs the receiver sends back to Inject
+   * \param socket The injecting socket
+   */
+  void HandleFeedback (Ptr<Socket> socket);
+
+  /**
+   * \brief GenerationLatency trace sink
+   * \param generationId The generation that reached full rank
+   * \param latency Time since its first packet
+   */
+  void GenerationDecoded (uint32_t generationId, Time latency);
+
+  /**
+   * \brief Decoding trace sink
+   * \param decoded true for a decoded generation, false for an evicted one
+   * \param total Generations decoded so far
+   */
+  void Decoding (bool decoded, uint32_t total);
+
+  /**
+   * \brief Sender Rx trace sink; samples the sender once every ACK it
+   * gets has been handled
+   * \param packet The packet received
+   */
+  void GroupFeedback (Ptr<const Packet> packet);
+
+  /**
+   * \brief Record whether the sender still has the generation in flight
+   * and whether the slower receiver has decoded it
+   */
+  void SampleGroup (void);
+
+  /**
+   * \brief Sender Tx trace sink; records the generation of every packet
+   * \param packet The packet sent
+   */
+  void RecordSent (Ptr<const Packet> packet);
+
+  /**
+   * \brief Sender Rx trace sink; records the generation of every ACK
+   * \param packet The packet received
+   */
+  void RecordAck (Ptr<const Packet> packet);
+
+  /**
+   * \brief Rank trace sink
+   * \param generationId The generation
+   * \param rank Its decoder's rank after the packet
+   * \param innovative Whether the packet raised the rank
+   */
+  void RecordRank (uint32_t generationId, uint16_t rank, bool innovative);
+
+  /**
+   * \brief InnovativePackets trace sink
+   * \param oldValue The previous count
+   * \param newValue The new count
+   */
+  void InnovativeChanged (uint32_t oldValue, uint32_t newValue);
+
+  /**
+   * \brief NonInnovativePackets trace sink
+   * \param oldValue The previous count
+   * \param newValue The new count
+   */
+  void NonInnovativeChanged (uint32_t oldValue, uint32_t newValue);
+
+  /**
+   * \brief EncodeTime trace sink
+   * \param generationId The generation
+   * \param elapsed Wall-clock time of the packet
+   */
+  void EncodeTimed (uint32_t generationId, Time elapsed);
+
+  /**
+   * \brief DecodeTime trace sink
+   * \param generationId The generation
+   * \param elapsed Wall-clock time of the packet
+   */
+  void DecodeTimed (uint32_t generationId, Time elapsed);
+
+  Ptr<Socket> m_injector;               //!< Sends the injected packets
+  Address m_receiverAddress;            //!< Where injected packets go
+  std::map<uint32_t, Ptr<NetworkCodingEncoder>> m_encoders; //!< Source of every injected generation
+  std::vector<uint32_t> m_decoded;      //!< Generations that reached full rank, in order
+  std::vector<Time> m_latencies;        //!< GenerationLatency of every generation in m_decoded
+  std::vector<uint32_t> m_acked;        //!< Generations ACKed, in order, repeats included
+  std::vector<uint32_t> m_sent;         //!< Generation of every packet sent, in order
+  uint32_t m_evictions;                 //!< Generations evicted
+  Ptr<NetworkCodingUdpApplication> m_groupSender;       //!< Multicast sender
+  Ptr<NetworkCodingUdpApplication> m_slowReceiver;      //!< Receiver losing the most
+  std::vector<bool> m_openAfterAck;     //!< Generation still in flight after each ACK
+  std::vector<uint32_t> m_slowDecodedAtAck; //!< Slower receiver's decodes at each ACK
+  std::map<uint32_t, std::vector<uint16_t>> m_ranks; //!< Ranks traced for every generation
+  uint32_t m_nonInnovativeRanks;        //!< Rank traces of non-innovative packets
+  uint32_t m_innovativeTraced;          //!< Last InnovativePackets value
+  uint32_t m_nonInnovativeTraced;       //!< Last NonInnovativePackets value
+  uint32_t m_encodeTimes;               //!< EncodeTime traces
+  uint32_t m_decodeTimes;               //!< DecodeTime traces
 };
 
 /**